@@ -0,0 +1,444 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "AllocationTracker.h"
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+	#include <execinfo.h>
+#elif defined(_WIN32)
+	extern "C" __declspec(dllimport) unsigned short __stdcall RtlCaptureStackBackTrace(unsigned long frames_to_skip, unsigned long frames_to_capture, void** trace, unsigned long* hash);
+#endif
+
+namespace Neshny {
+
+namespace AllocationTracking {
+
+	constexpr int MAX_TAGS = AllocationTracker::MAX_TAGS;
+
+	// sits just before every block handed out
+	struct Header {
+		uint64_t	p_Size;
+		uint16_t	p_Tag;
+		uint16_t	p_Sample;		// slot plus one, zero when not sampled
+		uint32_t	p_Offset;		// back to what malloc returned
+	};
+	static_assert(sizeof(Header) == 16, "Header keeps blocks 16 byte aligned");
+
+	// written by one thread and read by any, so plain loads and stores of atomics without any locked instructions
+	struct ThreadCounters {
+		std::atomic<int64_t>	p_Allocations[MAX_TAGS];
+		std::atomic<int64_t>	p_Frees[MAX_TAGS];
+		std::atomic<int64_t>	p_AllocatedBytes[MAX_TAGS];
+		std::atomic<int64_t>	p_FreedBytes[MAX_TAGS];
+		int64_t					p_Unflushed[MAX_TAGS];		// change in live bytes not yet added to g_Live
+		int64_t					p_UntilSample;
+	};
+
+	struct SampleSlot {
+		void*		p_Address;		// nullptr once freed
+		int64_t		p_Size;
+		int			p_Tag;
+		int			p_FrameCount;
+		uint64_t	p_Sequence;
+		void*		p_Frames[AllocationTracker::MAX_SAMPLE_FRAMES];
+	};
+
+	// all constant initialised, so usable from the first allocation before any constructors have run
+	ThreadCounters			g_Threads[AllocationTracker::MAX_THREADS];
+	ThreadCounters			g_Retired;		// what threads that have exited counted, so their slots can be reused
+	std::atomic_int			g_ThreadCount = 0;
+	int						g_FreeSlots[AllocationTracker::MAX_THREADS];
+	int						g_FreeSlotCount = 0;
+	std::atomic_flag		g_SlotLock;
+	std::atomic<int64_t>	g_Live[MAX_TAGS];
+	std::atomic<int64_t>	g_Peak[MAX_TAGS];
+	char					g_TagNames[MAX_TAGS][AllocationTracker::MAX_TAG_LENGTH] = { "Untagged" };
+	std::atomic_int			g_TagCount = 1;
+	std::atomic_flag		g_TagLock;
+	std::atomic<int64_t>	g_SampleInterval = 512 * 1024;
+	SampleSlot				g_Samples[AllocationTracker::MAX_SAMPLES];
+	uint64_t				g_SampleSequence = 0;
+	std::atomic_flag		g_SampleLock;
+
+	thread_local ThreadCounters*	t_Counters = nullptr;
+	thread_local bool				t_Shared = false;		// the last slot is shared by every thread past MAX_THREADS, and by threads that are exiting
+	thread_local int				t_Tag = 0;
+	thread_local bool				t_InSample = false;
+
+	////////////////////////////////////////////////////////////////////////////////
+	inline void Lock(std::atomic_flag& flag) {
+		while (flag.test_and_set(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	inline void Unlock(std::atomic_flag& flag) {
+		flag.clear(std::memory_order_release);
+	}
+
+	void FlushLive(int tag, int64_t change);
+
+	////////////////////////////////////////////////////////////////////////////////
+	// hands the thread's counts over to g_Retired when it exits and frees up its slot
+	struct SlotRelease {
+		~SlotRelease(void) {
+			if (!t_Counters || t_Shared) {
+				return;
+			}
+			ThreadCounters& counters = *t_Counters;
+			for (int tag = 0; tag < MAX_TAGS; tag++) {
+				FlushLive(tag, counters.p_Unflushed[tag]);
+				counters.p_Unflushed[tag] = 0;
+				g_Retired.p_Allocations[tag].fetch_add(counters.p_Allocations[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+				g_Retired.p_Frees[tag].fetch_add(counters.p_Frees[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+				g_Retired.p_AllocatedBytes[tag].fetch_add(counters.p_AllocatedBytes[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+				g_Retired.p_FreedBytes[tag].fetch_add(counters.p_FreedBytes[tag].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			Lock(g_SlotLock);
+			g_FreeSlots[g_FreeSlotCount++] = (int)(t_Counters - g_Threads);
+			Unlock(g_SlotLock);
+			// anything freed by later thread local destructors still needs counting somewhere
+			t_Counters = &g_Threads[AllocationTracker::MAX_THREADS - 1];
+			t_Shared = true;
+		}
+	};
+	thread_local SlotRelease		t_SlotRelease;
+
+	////////////////////////////////////////////////////////////////////////////////
+	inline ThreadCounters& GetCounters(void) {
+		if (!t_Counters) {
+			Lock(g_SlotLock);
+			int slot = (g_FreeSlotCount > 0) ? g_FreeSlots[--g_FreeSlotCount] : std::min(g_ThreadCount.load(std::memory_order_relaxed), AllocationTracker::MAX_THREADS - 1);
+			if (slot == g_ThreadCount.load(std::memory_order_relaxed)) {
+				g_ThreadCount.store(slot + 1, std::memory_order_release);
+			}
+			Unlock(g_SlotLock);
+			t_Shared = slot == AllocationTracker::MAX_THREADS - 1;
+			t_Counters = &g_Threads[slot];
+			if (!t_Shared) {
+				t_Counters->p_UntilSample = g_SampleInterval.load(std::memory_order_relaxed);
+				(void)&t_SlotRelease; // first use registers its destructor
+			}
+		}
+		return *t_Counters;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	inline void Add(std::atomic<int64_t>& counter, int64_t value) {
+		if (t_Shared) {
+			counter.fetch_add(value, std::memory_order_relaxed);
+		} else {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void FlushLive(int tag, int64_t change) {
+		if (change == 0) {
+			return;
+		}
+		int64_t live = g_Live[tag].fetch_add(change, std::memory_order_relaxed) + change;
+		int64_t peak = g_Peak[tag].load(std::memory_order_relaxed);
+		while ((live > peak) && !g_Peak[tag].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	inline void Count(int tag, int64_t size, bool allocated) {
+		ThreadCounters& counters = GetCounters();
+		if (allocated) {
+			Add(counters.p_Allocations[tag], 1);
+			Add(counters.p_AllocatedBytes[tag], size);
+		} else {
+			Add(counters.p_Frees[tag], 1);
+			Add(counters.p_FreedBytes[tag], size);
+		}
+		if (t_Shared) {
+			FlushLive(tag, allocated ? size : -size);
+			return;
+		}
+		int64_t& unflushed = counters.p_Unflushed[tag];
+		unflushed += allocated ? size : -size;
+		if ((unflushed >= AllocationTracker::PEAK_FLUSH_BYTES) || (unflushed <= -AllocationTracker::PEAK_FLUSH_BYTES)) {
+			FlushLive(tag, unflushed);
+			unflushed = 0;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// returns the slot, the stack is captured before locking since the platform may allocate the first time
+	int TakeSample(void* address, int64_t size, int tag) {
+		t_InSample = true;
+		void* frames[AllocationTracker::MAX_SAMPLE_FRAMES + 2];
+		int frame_count = 0;
+#if defined(__GLIBC__) || defined(__APPLE__)
+		frame_count = backtrace(frames, AllocationTracker::MAX_SAMPLE_FRAMES + 2);
+#elif defined(_WIN32)
+		frame_count = RtlCaptureStackBackTrace(0, AllocationTracker::MAX_SAMPLE_FRAMES + 2, frames, nullptr);
+#endif
+		// leaves out this and Allocate
+		const int skip = std::min(frame_count, 2);
+
+		Lock(g_SampleLock);
+		int slot = (int)(g_SampleSequence % AllocationTracker::MAX_SAMPLES);
+		SampleSlot& sample = g_Samples[slot];
+		sample.p_Address = address;
+		sample.p_Size = size;
+		sample.p_Tag = tag;
+		sample.p_Sequence = g_SampleSequence++;
+		sample.p_FrameCount = std::min(frame_count - skip, AllocationTracker::MAX_SAMPLE_FRAMES);
+		memcpy(sample.p_Frames, frames + skip, sample.p_FrameCount * sizeof(void*));
+		Unlock(g_SampleLock);
+		t_InSample = false;
+		return slot;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int AllocationTracker::RegisterTag(const char* name) {
+	using namespace AllocationTracking;
+	Lock(g_TagLock);
+	const int count = g_TagCount.load(std::memory_order_relaxed);
+	int tag = -1;
+	for (int i = 0; (i < count) && (tag < 0); i++) {
+		tag = (strncmp(g_TagNames[i], name, MAX_TAG_LENGTH - 1) == 0) ? i : -1;
+	}
+	if ((tag < 0) && (count < MAX_TAGS)) {
+		strncpy(g_TagNames[count], name, MAX_TAG_LENGTH - 1);
+		tag = count;
+		g_TagCount.store(count + 1, std::memory_order_release);
+	}
+	Unlock(g_TagLock);
+	return std::max(tag, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int AllocationTracker::SetCurrentTag(int tag) {
+	int previous = AllocationTracking::t_Tag;
+	AllocationTracking::t_Tag = ((tag >= 0) && (tag < MAX_TAGS)) ? tag : 0;
+	return previous;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int AllocationTracker::GetCurrentTag(void) {
+	return AllocationTracking::t_Tag;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void* AllocationTracker::Allocate(size_t size, size_t alignment) {
+	using namespace AllocationTracking;
+
+	// malloc already gives 16 byte alignment, so the header alone keeps the block aligned unless more is asked for
+	const bool over_aligned = alignment > sizeof(Header);
+	if (size > std::numeric_limits<size_t>::max() - sizeof(Header) - alignment) {
+		return nullptr;
+	}
+	unsigned char* raw = (unsigned char*)malloc(size + sizeof(Header) + (over_aligned ? alignment : 0));
+	if (!raw) {
+		return nullptr;
+	}
+	unsigned char* block = raw + sizeof(Header);
+	if (over_aligned) {
+		block = (unsigned char*)(((uintptr_t)block + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	const int tag = t_Tag;
+	Header* header = (Header*)(block - sizeof(Header));
+	header->p_Size = size;
+	header->p_Tag = (uint16_t)tag;
+	header->p_Sample = 0;
+	header->p_Offset = (uint32_t)(block - raw);
+	Count(tag, (int64_t)size, true);
+
+	const int64_t interval = g_SampleInterval.load(std::memory_order_relaxed);
+	if ((interval > 0) && !t_Shared && !t_InSample) {
+		int64_t& until = t_Counters->p_UntilSample;
+		until -= (int64_t)size;
+		if (until <= 0) {
+			until = interval;
+			header->p_Sample = (uint16_t)(TakeSample(block, (int64_t)size, tag) + 1);
+		}
+	}
+	return block;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AllocationTracker::Free(void* ptr) {
+	using namespace AllocationTracking;
+	if (!ptr) {
+		return;
+	}
+	Header* header = (Header*)((unsigned char*)ptr - sizeof(Header));
+	Count(header->p_Tag, (int64_t)header->p_Size, false);
+	if (header->p_Sample) {
+		Lock(g_SampleLock);
+		// the slot may have been reused by a newer sample since
+		SampleSlot& sample = g_Samples[header->p_Sample - 1];
+		if (sample.p_Address == ptr) {
+			sample.p_Address = nullptr;
+		}
+		Unlock(g_SampleLock);
+	}
+	free((unsigned char*)ptr - header->p_Offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AllocationTracker::SetSampleInterval(int64_t bytes) {
+	using namespace AllocationTracking;
+	g_SampleInterval = std::max(bytes, (int64_t)0);
+	// other threads pick it up after their next sample
+	if (t_Counters && !t_Shared) {
+		t_Counters->p_UntilSample = std::min(t_Counters->p_UntilSample, g_SampleInterval.load());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AllocationTracker::ResetPeaks(void) {
+	auto snapshot = GetSnapshot();
+	for (int tag = 0; tag < (int)snapshot.p_Tags.size(); tag++) {
+		AllocationTracking::g_Peak[tag] = snapshot.p_Tags[tag].p_LiveBytes;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MemorySnapshot AllocationTracker::GetSnapshot(void) {
+	using namespace AllocationTracking;
+
+	// everything the snapshot allocates is done before the counters are read, so taking one does not show up in it
+	const int num_tags = g_TagCount.load(std::memory_order_acquire);
+	MemorySnapshot snapshot;
+	snapshot.p_Tags.resize(num_tags);
+	for (auto& tag : snapshot.p_Tags) {
+		tag.p_Name.reserve(MAX_TAG_LENGTH);
+	}
+
+	const int num_threads = std::min(g_ThreadCount.load(std::memory_order_relaxed), MAX_THREADS);
+	for (int tag = 0; tag < num_tags; tag++) {
+		MemoryTagStats& stats = snapshot.p_Tags[tag];
+		int64_t frees = 0;
+		int64_t freed_bytes = 0;
+		for (int t = -1; t < num_threads; t++) {
+			const ThreadCounters& counters = (t < 0) ? g_Retired : g_Threads[t];
+			stats.p_Allocations += counters.p_Allocations[tag].load(std::memory_order_relaxed);
+			stats.p_AllocatedBytes += counters.p_AllocatedBytes[tag].load(std::memory_order_relaxed);
+			frees += counters.p_Frees[tag].load(std::memory_order_relaxed);
+			freed_bytes += counters.p_FreedBytes[tag].load(std::memory_order_relaxed);
+		}
+		stats.p_LiveAllocations = stats.p_Allocations - frees;
+		stats.p_LiveBytes = stats.p_AllocatedBytes - freed_bytes;
+		stats.p_PeakBytes = std::max(g_Peak[tag].load(std::memory_order_relaxed), stats.p_LiveBytes);
+	}
+	for (int tag = 0; tag < num_tags; tag++) {
+		snapshot.p_Tags[tag].p_Name = g_TagNames[tag];
+		snapshot.p_LiveBytes += snapshot.p_Tags[tag].p_LiveBytes;
+		snapshot.p_LiveAllocations += snapshot.p_Tags[tag].p_LiveAllocations;
+	}
+	return snapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MemorySnapshot AllocationTracker::Diff(const MemorySnapshot& before, const MemorySnapshot& after) {
+	MemorySnapshot diff = after;
+	for (int tag = 0; tag < (int)std::min(before.p_Tags.size(), after.p_Tags.size()); tag++) {
+		MemoryTagStats& stats = diff.p_Tags[tag];
+		const MemoryTagStats& earlier = before.p_Tags[tag];
+		stats.p_LiveBytes -= earlier.p_LiveBytes;
+		stats.p_LiveAllocations -= earlier.p_LiveAllocations;
+		stats.p_Allocations -= earlier.p_Allocations;
+		stats.p_AllocatedBytes -= earlier.p_AllocatedBytes;
+	}
+	diff.p_LiveBytes -= before.p_LiveBytes;
+	diff.p_LiveAllocations -= before.p_LiveAllocations;
+	return diff;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<MemorySample> AllocationTracker::GetLiveSamples(int tag) {
+	using namespace AllocationTracking;
+
+	// copied out whole so nothing allocates or frees while the lock is held
+	std::vector<SampleSlot> slots(MAX_SAMPLES);
+	Lock(g_SampleLock);
+	memcpy(slots.data(), g_Samples, sizeof(g_Samples));
+	Unlock(g_SampleLock);
+
+	std::vector<MemorySample> result;
+	for (const auto& slot : slots) {
+		if (slot.p_Address && ((tag < 0) || (slot.p_Tag == tag))) {
+			result.push_back({ slot.p_Size, slot.p_Tag, slot.p_Sequence, std::vector<void*>(slot.p_Frames, slot.p_Frames + slot.p_FrameCount) });
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const MemorySample& a, const MemorySample& b) { return a.p_Sequence < b.p_Sequence; });
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> AllocationTracker::DescribeFrames(const std::vector<void*>& frames) {
+	std::vector<std::string> result;
+#if defined(__GLIBC__) || defined(__APPLE__)
+	char** symbols = backtrace_symbols(frames.data(), (int)frames.size());
+	if (symbols) {
+		for (int i = 0; i < (int)frames.size(); i++) {
+			result.push_back(symbols[i]);
+		}
+		free(symbols);
+		return result;
+	}
+#endif
+	for (void* frame : frames) {
+		result.push_back(std::format("{}", frame));
+	}
+	return result;
+}
+
+} // namespace Neshny
+
+#ifdef NESHNY_TRACK_ALLOCATIONS
+
+////////////////////////////////////////////////////////////////////////////////
+// every form of the global operators, so nothing slips past the tracker or reaches free without its header
+void* operator new(std::size_t size) {
+	void* ptr = Neshny::AllocationTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	void* ptr = Neshny::AllocationTracker::Allocate(size, (size_t)alignment);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return Neshny::AllocationTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return Neshny::AllocationTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return Neshny::AllocationTracker::Allocate(size, (size_t)alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return Neshny::AllocationTracker::Allocate(size, (size_t)alignment);
+}
+void operator delete(void* ptr) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Neshny::AllocationTracker::Free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Neshny::AllocationTracker::Free(ptr); }
+
+#endif
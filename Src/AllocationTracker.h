@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// with NESHNY_TRACK_ALLOCATIONS defined every operator new and delete in the program goes through AllocationTracker
+// and NESHNY_MEMORY_SCOPE("Physics") charges everything allocated until the end of the enclosing block to that tag
+// without it neither is compiled in, though AllocationTracker can still be called directly
+#define NESHNY_MEMORY_CONCAT2(a, b) a##b
+#define NESHNY_MEMORY_CONCAT(a, b) NESHNY_MEMORY_CONCAT2(a, b)
+#ifdef NESHNY_TRACK_ALLOCATIONS
+	#define NESHNY_MEMORY_SCOPE(name) \
+		static const int NESHNY_MEMORY_CONCAT(neshny_memory_tag_, __LINE__) = Neshny::AllocationTracker::RegisterTag(name); \
+		Neshny::AllocationTracker::Scope NESHNY_MEMORY_CONCAT(neshny_memory_scope_, __LINE__)(NESHNY_MEMORY_CONCAT(neshny_memory_tag_, __LINE__))
+#else
+	#define NESHNY_MEMORY_SCOPE(name)
+#endif
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+struct MemoryTagStats {
+	std::string		p_Name;
+	int64_t			p_LiveBytes = 0;
+	int64_t			p_PeakBytes = 0;
+	int64_t			p_LiveAllocations = 0;
+	int64_t			p_Allocations = 0;		// ever made
+	int64_t			p_AllocatedBytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct MemorySnapshot {
+	std::vector<MemoryTagStats>	p_Tags;		// indexed by tag, the first is everything outside a scope
+	int64_t						p_LiveBytes = 0;
+	int64_t						p_LiveAllocations = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// one allocation picked by sampling, with the call stack that made it
+struct MemorySample {
+	int64_t				p_Size = 0;
+	int					p_Tag = 0;
+	uint64_t			p_Sequence = 0;		// order the samples were taken in
+	std::vector<void*>	p_Frames;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// measures real heap use per subsystem, as opposed to the estimates resources give Core
+// each thread counts into its own slot of a fixed table so allocating costs a few uncontended adds, reading the stats sums every slot
+// peaks need one total across threads, so each thread only adds its change to it once that reaches PEAK_FLUSH_BYTES, and peaks can be under by that much per thread
+// one allocation in roughly every sample interval's worth of bytes has its call stack kept, and keeps it until freed, which is enough to find where a leak comes from
+// nothing here allocates, so it is safe to call from inside operator new before main has started
+////////////////////////////////////////////////////////////////////////////////
+class AllocationTracker {
+public:
+
+	static constexpr int		MAX_TAGS = 64;
+	static constexpr int		MAX_TAG_LENGTH = 32;
+	static constexpr int		MAX_THREADS = 128;		// threads past this share one slot, which still counts correctly but is contended
+	static constexpr int		MAX_SAMPLES = 1024;		// once full the oldest samples are dropped, freed or not
+	static constexpr int		MAX_SAMPLE_FRAMES = 16;
+	static constexpr int64_t	PEAK_FLUSH_BYTES = 64 * 1024;
+
+	// charges allocations on this thread to a tag until destroyed
+	class Scope {
+	public:
+						Scope				( int tag ) : m_Previous(SetCurrentTag(tag)) {}
+						~Scope				( void ) { SetCurrentTag(m_Previous); }
+	private:
+		int				m_Previous;
+	};
+
+	inline static constexpr bool	IsCompiledIn		( void ) {
+#ifdef NESHNY_TRACK_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// the same name always gives the same tag, names past MAX_TAGS all get the untagged tag 0
+	static int					RegisterTag			( const char* name );
+	// returns the tag that was current
+	static int					SetCurrentTag		( int tag );
+	static int					GetCurrentTag		( void );
+
+	// what the replaced operator new and delete call, nullptr when out of memory
+	static void*				Allocate			( size_t size, size_t alignment );
+	static void					Free				( void* ptr );
+
+	// 0 turns sampling off, the interval applies to each thread separately and other threads only see a change after their next sample
+	static void					SetSampleInterval	( int64_t bytes );
+	// peaks start again from what is live now
+	static void					ResetPeaks			( void );
+
+	static MemorySnapshot		GetSnapshot			( void );
+	// after minus before, except peaks which are the peaks in after
+	static MemorySnapshot		Diff				( const MemorySnapshot& before, const MemorySnapshot& after );
+	// samples not yet freed, of one tag or all of them when tag is negative, oldest first
+	static std::vector<MemorySample>	GetLiveSamples	( int tag = -1 );
+	// a line per frame, with symbol names where the platform can give them
+	static std::vector<std::string>		DescribeFrames	( const std::vector<void*>& frames );
+};
+
+} // namespace Neshny
+
+namespace meta {
+	template<> inline auto registerMembers<Neshny::MemoryTagStats>() {
+		return members(
+			member("Name", &Neshny::MemoryTagStats::p_Name)
+			,member("LiveBytes", &Neshny::MemoryTagStats::p_LiveBytes)
+			,member("PeakBytes", &Neshny::MemoryTagStats::p_PeakBytes)
+			,member("LiveAllocations", &Neshny::MemoryTagStats::p_LiveAllocations)
+			,member("Allocations", &Neshny::MemoryTagStats::p_Allocations)
+			,member("AllocatedBytes", &Neshny::MemoryTagStats::p_AllocatedBytes)
+		);
+	}
+	template<> inline auto registerMembers<Neshny::MemorySnapshot>() {
+		return members(
+			member("Tags", &Neshny::MemorySnapshot::p_Tags)
+			,member("LiveBytes", &Neshny::MemorySnapshot::p_LiveBytes)
+			,member("LiveAllocations", &Neshny::MemorySnapshot::p_LiveAllocations)
+		);
+	}
+}
@@ -0,0 +1,515 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Audio.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+bool ReadWavFormat(std::istream& stream, WavFormat& format, std::string& err) {
+
+	auto read_u32 = [&stream]() {
+		unsigned char bytes[4] = { 0, 0, 0, 0 };
+		stream.read((char*)bytes, 4);
+		return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	};
+	auto read_id = [&stream]() {
+		char id[4] = { 0, 0, 0, 0 };
+		stream.read(id, 4);
+		return std::string(id, 4);
+	};
+
+	format = {};
+	if (read_id() != "RIFF") {
+		err = "Not a RIFF file";
+		return false;
+	}
+	read_u32();
+	if (read_id() != "WAVE") {
+		err = "Not a WAVE file";
+		return false;
+	}
+
+	bool found_format = false;
+	while (stream) {
+		std::string id = read_id();
+		uint32_t size = read_u32();
+		if (!stream) {
+			break;
+		}
+		std::streampos start = stream.tellg();
+		if (id == "fmt ") {
+			if (size < 16) {
+				err = "Format chunk is too small";
+				return false;
+			}
+			unsigned char fmt[40] = {};
+			stream.read((char*)fmt, std::min<uint32_t>(size, sizeof(fmt)));
+			uint16_t tag = fmt[0] | (fmt[1] << 8);
+			format.p_Channels = fmt[2] | (fmt[3] << 8);
+			format.p_Frequency = (int)(fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24));
+			format.p_BitsPerSample = fmt[14] | (fmt[15] << 8);
+			// extensible format keeps the real tag at the start of the sub format guid
+			if ((tag == 0xFFFE) && (size >= 26)) {
+				tag = fmt[24] | (fmt[25] << 8);
+			}
+			if ((tag != 1) && (tag != 3)) {
+				err = std::format("Unsupported WAV encoding {}, only PCM and float can be streamed", tag);
+				return false;
+			}
+			format.p_Float = tag == 3;
+			bool valid_bits = format.p_Float ? (format.p_BitsPerSample == 32) : ((format.p_BitsPerSample == 8) || (format.p_BitsPerSample == 16) || (format.p_BitsPerSample == 24) || (format.p_BitsPerSample == 32));
+			if ((!valid_bits) || (format.p_Channels <= 0) || (format.p_Frequency <= 0)) {
+				err = std::format("Unsupported WAV format, {} channels of {} bit samples at {}hz", format.p_Channels, format.p_BitsPerSample, format.p_Frequency);
+				return false;
+			}
+			found_format = true;
+		} else if (id == "data") {
+			if (!found_format) {
+				err = "Sample data comes before the format";
+				return false;
+			}
+			format.p_DataOffset = (uint64_t)start;
+			format.p_DataBytes = size;
+			return true;
+		}
+		// chunks are padded to an even size
+		stream.seekg(start + std::streamoff(size + (size & 1)));
+	}
+	err = found_format ? "No sample data" : "No format chunk";
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool WavStreamDecoder::Open(std::string_view path, std::string& err) {
+	m_File.open(std::string(path), std::ios::in | std::ios::binary);
+	if (!m_File.is_open()) {
+		err = std::format("Could not open {} for reading", path);
+		return false;
+	}
+	if (!ReadWavFormat(m_File, m_Format, err)) {
+		return false;
+	}
+	return Rewind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int WavStreamDecoder::Decode(float* out, int frames) {
+
+	const int frame_bytes = m_Format.GetFrameBytes();
+	frames = (int)std::min<uint64_t>(frames, m_FramesLeft);
+	if (frames <= 0) {
+		return 0;
+	}
+	m_Raw.resize((size_t)frames * frame_bytes);
+	m_File.read((char*)m_Raw.data(), m_Raw.size());
+	// a file cut short just ends early
+	int got = (int)(m_File.gcount() / frame_bytes);
+	m_FramesLeft = got < frames ? 0 : m_FramesLeft - got;
+
+	const int samples = got * m_Format.p_Channels;
+	const unsigned char* raw = m_Raw.data();
+	if (m_Format.p_Float) {
+		memcpy(out, raw, (size_t)samples * sizeof(float));
+	} else if (m_Format.p_BitsPerSample == 8) {
+		for (int i = 0; i < samples; i++) {
+			out[i] = ((int)raw[i] - 128) * (1.0f / 128.0f);
+		}
+	} else if (m_Format.p_BitsPerSample == 16) {
+		for (int i = 0; i < samples; i++) {
+			out[i] = (int16_t)(raw[i * 2] | (raw[i * 2 + 1] << 8)) * (1.0f / 32768.0f);
+		}
+	} else if (m_Format.p_BitsPerSample == 24) {
+		for (int i = 0; i < samples; i++) {
+			// into the top of an int so the sign comes along
+			int32_t value = (int32_t)(((uint32_t)raw[i * 3] << 8) | ((uint32_t)raw[i * 3 + 1] << 16) | ((uint32_t)raw[i * 3 + 2] << 24));
+			out[i] = (value >> 8) * (1.0f / 8388608.0f);
+		}
+	} else {
+		for (int i = 0; i < samples; i++) {
+			int32_t value = (int32_t)((uint32_t)raw[i * 4] | ((uint32_t)raw[i * 4 + 1] << 8) | ((uint32_t)raw[i * 4 + 2] << 16) | ((uint32_t)raw[i * 4 + 3] << 24));
+			out[i] = (float)(value * (1.0 / 2147483648.0));
+		}
+	}
+	return got;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool WavStreamDecoder::Rewind(void) {
+	m_File.clear();
+	m_File.seekg((std::streamoff)m_Format.p_DataOffset);
+	m_FramesLeft = m_Format.GetFrames();
+	return m_File.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AudioRing::AudioRing(int block_count, int block_bytes) :
+	m_BlockCount	( block_count )
+	,m_BlockBytes	( block_bytes )
+	,m_Data			( (size_t)block_count * block_bytes )
+	,m_Filled		( block_count, 0 )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+unsigned char* AudioRing::BeginWrite(void) {
+	uint64_t written = m_Written.load(std::memory_order_relaxed);
+	if (written - m_Consumed.load(std::memory_order_acquire) >= (uint64_t)m_BlockCount) {
+		return nullptr;
+	}
+	return m_Data.data() + (size_t)(written % m_BlockCount) * m_BlockBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AudioRing::EndWrite(int bytes) {
+	uint64_t written = m_Written.load(std::memory_order_relaxed);
+	m_Filled[written % m_BlockCount] = std::clamp(bytes, 0, m_BlockBytes);
+	m_Written.store(written + 1, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int AudioRing::Read(unsigned char* out, int bytes) {
+	int copied = 0;
+	while (copied < bytes) {
+		uint64_t consumed = m_Consumed.load(std::memory_order_relaxed);
+		if (m_Written.load(std::memory_order_acquire) == consumed) {
+			break;
+		}
+		int block = (int)(consumed % m_BlockCount);
+		int amount = std::min(bytes - copied, m_Filled[block] - m_ReadOffset);
+		memcpy(out + copied, m_Data.data() + (size_t)block * m_BlockBytes + m_ReadOffset, amount);
+		copied += amount;
+		m_ReadOffset += amount;
+		if (m_ReadOffset >= m_Filled[block]) {
+			m_ReadOffset = 0;
+			m_Consumed.store(consumed + 1, std::memory_order_release);
+		}
+	}
+	return copied;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int VoiceAllocator::Allocate(int priority, bool* stolen) {
+	int best = -1;
+	for (int i = 0; i < (int)m_Voices.size(); i++) {
+		const Voice& voice = m_Voices[i];
+		if (!voice.p_Active) {
+			best = i;
+			break;
+		}
+		if ((best < 0) || (voice.p_Priority < m_Voices[best].p_Priority) || ((voice.p_Priority == m_Voices[best].p_Priority) && (voice.p_Started < m_Voices[best].p_Started))) {
+			best = i;
+		}
+	}
+	if ((best < 0) || (m_Voices[best].p_Active && (m_Voices[best].p_Priority > priority))) {
+		return -1;
+	}
+	if (stolen) {
+		*stolen = m_Voices[best].p_Active;
+	}
+	m_Voices[best] = Voice{ true, priority, m_Counter++ };
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int VoiceAllocator::GetActiveCount(void) const {
+	int count = 0;
+	for (const auto& voice : m_Voices) {
+		count += voice.p_Active ? 1 : 0;
+	}
+	return count;
+}
+
+#ifdef SDL_h_
+////////////////////////////////////////////////////////////////////////////////
+bool StreamingSoundFile::Init(std::string_view path, Params params, std::string& err) {
+	m_Path = path;
+	std::ifstream file(m_Path, std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		err = std::format("Could not open {} for reading", path);
+		return false;
+	}
+	return ReadWavFormat(file, m_Format, err);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::unique_ptr<AudioDecoder> StreamingSoundFile::CreateDecoder(std::string& err) const {
+	auto decoder = std::make_unique<WavStreamDecoder>();
+	if (!decoder->Open(m_Path, err)) {
+		return nullptr;
+	}
+	return decoder;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SoundMixer::Init(int max_voices, std::string& err) {
+
+	Shutdown();
+	if (!Mix_QuerySpec(&m_Frequency, &m_Format, &m_Channels)) {
+		err = "Audio is not open, call Mix_OpenAudio first";
+		return false;
+	}
+	Mix_AllocateChannels(max_voices);
+	m_Voices.SetCount(max_voices);
+	m_Streams.clear();
+	m_Streams.resize(max_voices);
+
+	// the chunk a stream's channel loops, its samples are replaced by the stream's before they are mixed
+	const int frame_bytes = (SDL_AUDIO_BITSIZE(m_Format) / 8) * m_Channels;
+	m_SilenceData.assign((size_t)1024 * frame_bytes, SDL_AUDIO_ISSIGNED(m_Format) ? 0x00 : 0x80);
+	m_Silence = Mix_QuickLoad_RAW(m_SilenceData.data(), (Uint32)m_SilenceData.size());
+	if (!m_Silence) {
+		err = std::format("Could not create the stream chunk: {}", Mix_GetError());
+		return false;
+	}
+
+	m_Dropped = 0;
+	m_Stolen = 0;
+	m_FinishedUnderruns = 0;
+	m_FinishedBytes = 0;
+	m_StopRequested = false;
+	m_Thread = new std::thread([this]() { DecodeLoop(); });
+	m_Initialised = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SoundMixer::Shutdown(void) {
+	if (!m_Initialised) {
+		return;
+	}
+	m_StopRequested = true;
+	m_Wake.notify_all();
+	m_Thread->join();
+	delete m_Thread;
+	m_Thread = nullptr;
+
+	for (int voice = 0; voice < m_Voices.GetCount(); voice++) {
+		Stop(voice);
+	}
+	m_Streams.clear();
+	Mix_FreeChunk(m_Silence);
+	m_Silence = nullptr;
+	m_Initialised = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SoundMixer::HaltVoice(int voice) {
+	// halting waits for the audio thread and removes the stream's effect, so after this nothing reads the stream
+	Mix_HaltChannel(voice);
+	const std::lock_guard<std::mutex> lock(m_Lock);
+	auto& stream = m_Streams[voice];
+	if (stream) {
+		m_FinishedUnderruns += stream->p_Underruns;
+		m_FinishedBytes += stream->p_PlayedBytes;
+		stream.reset();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SoundMixer::AllocateVoice(int priority) {
+	Update();
+	bool stolen = false;
+	int voice = m_Voices.Allocate(priority, &stolen);
+	if (voice < 0) {
+		m_Dropped++;
+		return -1;
+	}
+	if (stolen) {
+		m_Stolen++;
+		HaltVoice(voice);
+	}
+	return voice;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SoundMixer::PlayEffect(const SoundFile& sound, int priority, int volume) {
+	if (!m_Initialised) {
+		return -1;
+	}
+	int voice = AllocateVoice(priority);
+	if (voice < 0) {
+		return -1;
+	}
+	Mix_Volume(voice, volume);
+	if (Mix_PlayChannel(voice, const_cast<Mix_Chunk*>(sound.GetChunk()), 0) < 0) {
+		m_Voices.Release(voice);
+		return -1;
+	}
+	return voice;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SoundMixer::PlayStream(const StreamingSoundFile& sound, bool loop, int priority, int volume) {
+	if (!m_Initialised) {
+		return -1;
+	}
+	std::string err;
+	auto decoder = sound.CreateDecoder(err);
+	if (!decoder) {
+		return -1;
+	}
+
+	auto stream = std::make_shared<Stream>();
+	stream->p_Converter = SDL_NewAudioStream(AUDIO_F32SYS, (Uint8)decoder->GetChannels(), decoder->GetFrequency(), m_Format, (Uint8)m_Channels, m_Frequency);
+	if (!stream->p_Converter) {
+		return -1;
+	}
+	const int frame_bytes = (SDL_AUDIO_BITSIZE(m_Format) / 8) * m_Channels;
+	stream->p_Ring = std::make_unique<AudioRing>(AUDIO_RING_BLOCKS, AUDIO_RING_BLOCK_FRAMES * frame_bytes);
+	stream->p_Scratch.resize((size_t)AUDIO_RING_BLOCK_FRAMES * decoder->GetChannels());
+	stream->p_Decoder = std::move(decoder);
+	stream->p_Loop = loop;
+	stream->p_Silence = SDL_AUDIO_ISSIGNED(m_Format) ? 0x00 : 0x80;
+
+	int voice = AllocateVoice(priority);
+	if (voice < 0) {
+		return -1;
+	}
+	// filled before it starts so it never opens with an underrun, the decode thread cannot see it yet
+	FillStream(*stream);
+	Stream* raw_stream = stream.get();
+	{
+		const std::lock_guard<std::mutex> lock(m_Lock);
+		m_Streams[voice] = std::move(stream);
+	}
+
+	Mix_Volume(voice, volume);
+	if ((Mix_PlayChannel(voice, m_Silence, -1) < 0) || (!Mix_RegisterEffect(voice, StreamEffect, nullptr, raw_stream))) {
+		Stop(voice);
+		return -1;
+	}
+	m_Wake.notify_one();
+	return voice;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SoundMixer::Stop(int voice) {
+	if ((voice < 0) || (voice >= m_Voices.GetCount())) {
+		return;
+	}
+	HaltVoice(voice);
+	m_Voices.Release(voice);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SoundMixer::Update(void) {
+	// m_Streams is only ever changed on this thread, so it can be looked at without the lock
+	for (int voice = 0; voice < m_Voices.GetCount(); voice++) {
+		if (!m_Voices.IsActive(voice)) {
+			continue;
+		}
+		const auto& stream = m_Streams[voice];
+		if ((!Mix_Playing(voice)) || (stream && stream->p_Drained)) {
+			Stop(voice);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SoundMixerStats SoundMixer::GetStats(void) {
+	SoundMixerStats stats;
+	stats.p_Voices = m_Voices.GetCount();
+	stats.p_ActiveVoices = m_Voices.GetActiveCount();
+	stats.p_Dropped = m_Dropped;
+	stats.p_Stolen = m_Stolen;
+	stats.p_Underruns = m_FinishedUnderruns;
+	stats.p_StreamedBytes = m_FinishedBytes;
+	for (const auto& stream : m_Streams) {
+		if (stream) {
+			stats.p_ActiveStreams++;
+			stats.p_Underruns += stream->p_Underruns;
+			stats.p_StreamedBytes += stream->p_PlayedBytes;
+		}
+	}
+	return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// runs on the audio thread, so it only ever reads from the ring
+void SoundMixer::StreamEffect(int channel, void* data, int length, void* user_data) {
+	Stream* stream = (Stream*)user_data;
+	// checked before reading, so the last block is always read before the stream counts as drained
+	bool end_of_data = stream->p_EndOfData;
+	int read = stream->p_Ring->Read((unsigned char*)data, length);
+	if (read < length) {
+		memset((unsigned char*)data + read, stream->p_Silence, length - read);
+		if (end_of_data) {
+			stream->p_Drained = true;
+		} else {
+			stream->p_Underruns++;
+		}
+	}
+	stream->p_PlayedBytes += read;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// fills every free block in the ring, converting to the device format as it goes, returns whether anything was written
+bool SoundMixer::FillStream(Stream& stream) {
+
+	const int block_bytes = stream.p_Ring->GetBlockBytes();
+	const int channels = stream.p_Decoder->GetChannels();
+	const int scratch_frames = (int)stream.p_Scratch.size() / channels;
+	bool wrote = false;
+	while (!stream.p_EndOfData) {
+		unsigned char* block = stream.p_Ring->BeginWrite();
+		if (!block) {
+			break;
+		}
+		while ((!stream.p_DecodeFinished) && (SDL_AudioStreamAvailable(stream.p_Converter) < block_bytes)) {
+			int frames = stream.p_Decoder->Decode(stream.p_Scratch.data(), scratch_frames);
+			if (frames > 0) {
+				SDL_AudioStreamPut(stream.p_Converter, stream.p_Scratch.data(), frames * channels * (int)sizeof(float));
+			}
+			stream.p_FramesSinceRewind += frames;
+			if (frames < scratch_frames) {
+				// a loop that got nothing since the last rewind would spin forever
+				bool rewound = stream.p_Loop && (stream.p_FramesSinceRewind > 0) && stream.p_Decoder->Rewind();
+				stream.p_FramesSinceRewind = 0;
+				if (!rewound) {
+					SDL_AudioStreamFlush(stream.p_Converter);
+					stream.p_DecodeFinished = true;
+				}
+			}
+		}
+		int bytes = SDL_AudioStreamGet(stream.p_Converter, block, block_bytes);
+		if (bytes > 0) {
+			stream.p_Ring->EndWrite(bytes);
+			wrote = true;
+		}
+		if ((bytes < 0) || ((bytes < block_bytes) && stream.p_DecodeFinished && (SDL_AudioStreamAvailable(stream.p_Converter) <= 0))) {
+			stream.p_EndOfData = true;
+		}
+	}
+	return wrote;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SoundMixer::DecodeLoop(void) {
+	std::vector<std::shared_ptr<Stream>> streams;
+	std::unique_lock<std::mutex> lock(m_Lock);
+	while (!m_StopRequested) {
+		// the file reads happen without the lock, so stopping or starting a sound never waits on the disk
+		// a stream halted meanwhile stays alive through this copy, and since its effect is gone nothing reads what is written to it
+		streams.clear();
+		for (const auto& stream : m_Streams) {
+			if (stream) {
+				streams.push_back(stream);
+			}
+		}
+		lock.unlock();
+		bool wrote = false;
+		for (auto& stream : streams) {
+			wrote = FillStream(*stream) || wrote;
+		}
+		streams.clear();
+		lock.lock();
+		// every ring is full, wait for the mixer to use some up
+		if ((!wrote) && (!m_StopRequested)) {
+			m_Wake.wait_for(lock, std::chrono::milliseconds(AUDIO_DECODE_WAIT_MS));
+		}
+	}
+}
+#endif
+
+} // namespace Neshny
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// each stream keeps this many blocks decoded ahead of what is playing
+constexpr int AUDIO_RING_BLOCKS = 4;
+constexpr int AUDIO_RING_BLOCK_FRAMES = 4096;
+// how long the decode thread sleeps when every ring is full
+constexpr int AUDIO_DECODE_WAIT_MS = 5;
+
+////////////////////////////////////////////////////////////////////////////////
+struct WavFormat {
+	inline int			GetFrameBytes		( void ) const { return p_Channels * (p_BitsPerSample / 8); }
+	inline uint64_t		GetFrames			( void ) const { return GetFrameBytes() > 0 ? p_DataBytes / GetFrameBytes() : 0; }
+
+	int					p_Channels = 0;
+	int					p_Frequency = 0;
+	int					p_BitsPerSample = 0;
+	bool				p_Float = false;
+	uint64_t			p_DataOffset = 0;		// from the start of the file
+	uint64_t			p_DataBytes = 0;
+};
+
+// reads the chunks up to the sample data, 8, 16, 24 and 32 bit integer PCM and 32 bit float are understood
+bool ReadWavFormat(std::istream& stream, WavFormat& format, std::string& err);
+
+////////////////////////////////////////////////////////////////////////////////
+// hands out a sound's samples a piece at a time, so none of it has to be held in memory for long
+// implement this to stream formats other than WAV
+////////////////////////////////////////////////////////////////////////////////
+class AudioDecoder {
+public:
+	virtual				~AudioDecoder		( void ) {}
+
+	virtual int			GetChannels			( void ) const = 0;
+	virtual int			GetFrequency		( void ) const = 0;
+	// interleaved floats from -1 to 1, returns the frames written, which is only fewer than asked for at the end
+	virtual int			Decode				( float* out, int frames ) = 0;
+	virtual bool		Rewind				( void ) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+class WavStreamDecoder : public AudioDecoder {
+public:
+
+	bool				Open				( std::string_view path, std::string& err );
+
+	virtual int			GetChannels			( void ) const { return m_Format.p_Channels; }
+	virtual int			GetFrequency		( void ) const { return m_Format.p_Frequency; }
+	virtual int			Decode				( float* out, int frames );
+	virtual bool		Rewind				( void );
+
+	inline const WavFormat&	GetFormat		( void ) const { return m_Format; }
+
+private:
+
+	std::ifstream				m_File;
+	WavFormat					m_Format;
+	uint64_t					m_FramesLeft = 0;
+	std::vector<unsigned char>	m_Raw;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// a fixed set of blocks passed from one producer thread to one consumer thread without locking
+// the consumer can read any amount, a block is only handed back to the producer once all of it has been read
+////////////////////////////////////////////////////////////////////////////////
+class AudioRing {
+public:
+						AudioRing			( int block_count, int block_bytes );
+
+	// the producer fills the block returned and then ends the write, nullptr when every block is still waiting to be read
+	unsigned char*		BeginWrite			( void );
+	void				EndWrite			( int bytes );
+	// the consumer copies out as much as is ready, up to bytes, and returns how much that was
+	int					Read				( unsigned char* out, int bytes );
+
+	inline int			GetBlockBytes		( void ) const { return m_BlockBytes; }
+	inline int			GetQueuedBlocks		( void ) const { return (int)(m_Written.load(std::memory_order_acquire) - m_Consumed.load(std::memory_order_acquire)); }
+
+private:
+
+	int							m_BlockCount;
+	int							m_BlockBytes;
+	std::vector<unsigned char>	m_Data;
+	std::vector<int>			m_Filled;			// bytes written to each block
+	std::atomic<uint64_t>		m_Written = 0;		// only the producer changes this
+	std::atomic<uint64_t>		m_Consumed = 0;		// only the consumer changes this
+	int							m_ReadOffset = 0;	// into the oldest block, consumer only
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// picks the voice for a new sound, when none are free the lowest priority one is stolen, the oldest of those if there is a tie
+// a new sound never steals from a voice of higher priority than itself, it is dropped instead
+////////////////////////////////////////////////////////////////////////////////
+class VoiceAllocator {
+public:
+
+	struct Voice {
+		bool		p_Active = false;
+		int			p_Priority = 0;
+		uint64_t	p_Started = 0;
+	};
+
+	void				SetCount			( int count ) { m_Voices.assign(count, {}); }
+	// -1 when the sound is dropped, stolen is set when the voice returned was already playing something
+	int					Allocate			( int priority, bool* stolen = nullptr );
+	void				Release				( int voice ) { m_Voices[voice].p_Active = false; }
+
+	inline int			GetCount			( void ) const { return (int)m_Voices.size(); }
+	inline bool			IsActive			( int voice ) const { return m_Voices[voice].p_Active; }
+	int					GetActiveCount		( void ) const;
+
+private:
+
+	std::vector<Voice>	m_Voices;
+	uint64_t			m_Counter = 0;
+};
+
+#ifdef SDL_h_
+////////////////////////////////////////////////////////////////////////////////
+// a long sound such as music or an ambient loop, nothing is decoded until it is played through a SoundMixer
+// only the format is read on load, so the resource manager sees the small amount it really costs
+// short effects should stay as a SoundFile, which decodes the whole thing once
+////////////////////////////////////////////////////////////////////////////////
+class StreamingSoundFile : public Resource {
+public:
+	struct Params {};
+
+	virtual				~StreamingSoundFile		( void ) {}
+	bool				Init					( std::string_view path, Params params, std::string& err );
+
+	virtual uint64_t	GetMemoryEstimate		( void ) const { return sizeof(StreamingSoundFile) + m_Path.size(); }
+	virtual uint64_t	GetGPUMemoryEstimate	( void ) const { return 0; }
+
+	std::unique_ptr<AudioDecoder>	CreateDecoder	( std::string& err ) const;
+	inline double		GetDuration				( void ) const { return m_Format.p_Frequency > 0 ? (double)m_Format.GetFrames() / m_Format.p_Frequency : 0.0; }
+
+protected:
+	std::string		m_Path;
+	WavFormat		m_Format;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct SoundMixerStats {
+	int			p_Voices = 0;
+	int			p_ActiveVoices = 0;
+	int			p_ActiveStreams = 0;
+	uint64_t	p_Dropped = 0;			// sounds that found no voice
+	uint64_t	p_Stolen = 0;			// sounds cut off early for one of higher or equal priority
+	uint64_t	p_Underruns = 0;		// times a stream had nothing ready when the mixer asked for more
+	uint64_t	p_StreamedBytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// front end to SDL_mixer that limits how many sounds play at once, and plays StreamingSoundFiles
+// streams are decoded on a background thread into a small ring each, and played by overwriting a looping silent chunk on their channel
+// call Init after Mix_OpenAudio, it takes over all the mixer channels, then Update once a frame
+////////////////////////////////////////////////////////////////////////////////
+class SoundMixer {
+public:
+								~SoundMixer			( void ) { Shutdown(); }
+
+	bool						Init				( int max_voices, std::string& err );
+	void						Shutdown			( void );
+
+	// each returns the voice, or -1 when the sound was dropped
+	int							PlayEffect			( const SoundFile& sound, int priority = 0, int volume = MIX_MAX_VOLUME );
+	int							PlayStream			( const StreamingSoundFile& sound, bool loop, int priority = 0, int volume = MIX_MAX_VOLUME );
+	void						Stop				( int voice );
+	// frees the voices of sounds that have finished
+	void						Update				( void );
+
+	SoundMixerStats				GetStats			( void );
+
+private:
+
+	struct Stream {
+		std::unique_ptr<AudioDecoder>	p_Decoder;
+		SDL_AudioStream*				p_Converter = nullptr;
+		std::unique_ptr<AudioRing>		p_Ring;
+		std::vector<float>				p_Scratch;
+		bool							p_Loop = false;
+		bool							p_DecodeFinished = false;	// decode thread only
+		uint64_t						p_FramesSinceRewind = 0;	// decode thread only
+		std::atomic_bool				p_EndOfData = false;		// nothing more will be written to the ring
+		std::atomic_bool				p_Drained = false;			// and the ring has been played out
+		std::atomic<uint64_t>			p_Underruns = 0;
+		std::atomic<uint64_t>			p_PlayedBytes = 0;
+		unsigned char					p_Silence = 0;
+
+										~Stream				( void ) { if (p_Converter) { SDL_FreeAudioStream(p_Converter); } }
+	};
+
+	static void					StreamEffect		( int channel, void* data, int length, void* user_data );
+	int							AllocateVoice		( int priority );
+	void						HaltVoice			( int voice );
+	bool						FillStream			( Stream& stream );
+	void						DecodeLoop			( void );
+
+	bool						m_Initialised = false;
+	VoiceAllocator				m_Voices;
+	std::vector<std::shared_ptr<Stream>>	m_Streams;		// by voice, empty for effects, the decode thread holds its own reference while it fills one
+
+	int							m_Frequency = 0;
+	int							m_Channels = 0;
+	Uint16						m_Format = 0;
+	std::vector<unsigned char>	m_SilenceData;
+	Mix_Chunk*					m_Silence = nullptr;
+
+	std::thread*				m_Thread = nullptr;
+	std::atomic_bool			m_StopRequested = false;
+	std::mutex					m_Lock;				// guards m_Streams against the decode thread, never held while decoding
+	std::condition_variable		m_Wake;
+
+	uint64_t					m_Dropped = 0;
+	uint64_t					m_Stolen = 0;
+	uint64_t					m_FinishedUnderruns = 0;
+	uint64_t					m_FinishedBytes = 0;
+};
+#endif
+
+} // namespace Neshny
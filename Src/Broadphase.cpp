@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Broadphase.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+typename SweepAndPrune<D>::Box SweepAndPrune<D>::ToBox(VecType min_pos, VecType max_pos) {
+	if constexpr (D == 2) {
+		return Box{ { min_pos.x, min_pos.y }, { max_pos.x, max_pos.y } };
+	} else {
+		return Box{ { min_pos.x, min_pos.y, min_pos.z }, { max_pos.x, max_pos.y, max_pos.z } };
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+int SweepAndPrune<D>::Add(VecType min_pos, VecType max_pos) {
+	int handle;
+	if (m_FreeHandles.empty()) {
+		handle = (int)m_Boxes.size();
+		m_Boxes.push_back(ToBox(min_pos, max_pos));
+		m_Alive.push_back(true);
+	} else {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_Boxes[handle] = ToBox(min_pos, max_pos);
+		m_Alive[handle] = true;
+	}
+	m_Added.push_back(handle);
+	m_Count++;
+	return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void SweepAndPrune<D>::Move(int handle, VecType min_pos, VecType max_pos) {
+	if (!IsValid(handle)) {
+		return;
+	}
+	m_Boxes[handle] = ToBox(min_pos, max_pos);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void SweepAndPrune<D>::Remove(int handle) {
+	if (!IsValid(handle)) {
+		return;
+	}
+	m_Alive[handle] = false;
+	m_PendingFree.push_back(handle);
+	m_Count--;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void SweepAndPrune<D>::Clear(void) {
+	for (int handle = 0; handle < (int)m_Alive.size(); handle++) {
+		Remove(handle);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// gives up part way and returns false once it has gone over budget, the proxies are all still there just not in order
+template<int D>
+bool SweepAndPrune<D>::InsertionSort(int& swaps) {
+	const int64_t budget = std::max<int64_t>(64, (int64_t)m_Proxies.size() * SWEEP_INSERTION_BUDGET);
+	int64_t moved = 0;
+	for (int i = 1; i < (int)m_Proxies.size(); i++) {
+		if (m_Proxies[i - 1].p_Key <= m_Proxies[i].p_Key) {
+			continue;
+		}
+		Proxy proxy = m_Proxies[i];
+		int j = i;
+		for (; (j > 0) && (m_Proxies[j - 1].p_Key > proxy.p_Key); j--) {
+			m_Proxies[j] = m_Proxies[j - 1];
+		}
+		m_Proxies[j] = proxy;
+		moved += i - j;
+		if (moved > budget) {
+			swaps = (int)std::min<int64_t>(moved, INT_MAX);
+			return false;
+		}
+	}
+	swaps = (int)moved;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void SweepAndPrune<D>::FullSort(int thread_count) {
+	const int count = (int)m_Proxies.size();
+	std::vector<double> keys(count);
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++) {
+		keys[i] = m_Proxies[i].p_Key;
+		order[i] = i;
+	}
+	RadixSort(keys, order, thread_count);
+	std::vector<Proxy> sorted(count);
+	for (int i = 0; i < count; i++) {
+		sorted[i] = m_Proxies[order[i]];
+	}
+	m_Proxies.swap(sorted);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// every proxy from begin to end checks the ones after it that start before it finishes along the sweep axis
+template<int D>
+void SweepAndPrune<D>::Sweep(int begin, int end, std::vector<uint64_t>& out) const {
+	const int count = (int)m_Proxies.size();
+	for (int i = begin; i < end; i++) {
+		const double sweep_max = m_SweepMax[i];
+		const CrossBounds cross = m_Cross[i];
+		for (int j = i + 1; (j < count) && (m_SweepMin[j] <= sweep_max); j++) {
+			const CrossBounds& other = m_Cross[j];
+			// & rather than && so there is only one branch
+			bool overlaps = true;
+			for (int a = 0; a < D - 1; a++) {
+				overlaps = overlaps & (cross.p_Min[a] <= other.p_Max[a]) & (other.p_Min[a] <= cross.p_Max[a]);
+			}
+			if (overlaps) {
+				uint32_t handle_a = (uint32_t)m_Proxies[i].p_Handle;
+				uint32_t handle_b = (uint32_t)m_Proxies[j].p_Handle;
+				out.push_back(handle_a < handle_b ? (((uint64_t)handle_a << 32) | handle_b) : (((uint64_t)handle_b << 32) | handle_a));
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+SweepAndPruneStats SweepAndPrune<D>::Update(int thread_count) {
+
+	SweepAndPruneStats stats;
+
+	// drop the removed, pick up the moved, and append the added to be sorted into place
+	const int axis = m_SweepAxis;
+	int write = 0;
+	for (int i = 0; i < (int)m_Proxies.size(); i++) {
+		int handle = m_Proxies[i].p_Handle;
+		if (m_Alive[handle]) {
+			m_Proxies[write].p_Key = m_Boxes[handle].p_Min[axis];
+			m_Proxies[write].p_Handle = handle;
+			write++;
+		}
+	}
+	m_Proxies.resize(write);
+	for (int handle : m_Added) {
+		// a handle only goes back on the free list after an update, so an added handle that is dead was removed again before now
+		if (m_Alive[handle]) {
+			m_Proxies.push_back(Proxy{ m_Boxes[handle].p_Min[axis], handle });
+		}
+	}
+	m_Added.clear();
+	const int count = (int)m_Proxies.size();
+	stats.p_Objects = count;
+
+	if (!InsertionSort(stats.p_Swaps)) {
+		stats.p_FullSort = true;
+		FullSort(thread_count);
+	}
+
+	m_SweepMin.resize(count);
+	m_SweepMax.resize(count);
+	m_Cross.resize(count);
+	for (int i = 0; i < count; i++) {
+		const Box& box = m_Boxes[m_Proxies[i].p_Handle];
+		m_SweepMin[i] = box.p_Min[axis];
+		m_SweepMax[i] = box.p_Max[axis];
+		for (int a = 0, cross_axis = 0; a < D; a++) {
+			if (a != axis) {
+				m_Cross[i].p_Min[cross_axis] = box.p_Min[a];
+				m_Cross[i].p_Max[cross_axis] = box.p_Max[a];
+				cross_axis++;
+			}
+		}
+	}
+
+	// the sweep only reads, so each thread takes a contiguous range of proxies and collects its own pairs
+#ifdef __EMSCRIPTEN__
+	int num_threads = 1;
+#else
+	int num_threads = std::clamp(std::min(thread_count, count / SWEEP_MIN_PER_THREAD), 1, 64);
+#endif
+	stats.p_Threads = num_threads;
+	m_NewPairKeys.clear();
+	if (num_threads == 1) {
+		Sweep(0, count, m_NewPairKeys);
+	} else {
+		std::vector<std::vector<uint64_t>> thread_keys(num_threads);
+		ParallelFor(num_threads, [this, num_threads, count, &thread_keys](int t) {
+			Sweep((int)((int64_t)count * t / num_threads), (int)((int64_t)count * (t + 1) / num_threads), t == 0 ? m_NewPairKeys : thread_keys[t]);
+		});
+		for (int t = 1; t < num_threads; t++) {
+			m_NewPairKeys.insert(m_NewPairKeys.end(), thread_keys[t].begin(), thread_keys[t].end());
+		}
+	}
+	RadixSort(m_NewPairKeys, thread_count);
+
+	// both key lists are sorted, so one merge splits them into begun, persisting and ended
+	m_Pairs.clear();
+	m_Begun.clear();
+	m_Persisting.clear();
+	m_Ended.clear();
+	auto to_pair = [](uint64_t key) { return BroadphasePair{ (int)(key >> 32), (int)(key & 0xFFFFFFFF) }; };
+	size_t old_index = 0;
+	size_t new_index = 0;
+	while ((old_index < m_PairKeys.size()) || (new_index < m_NewPairKeys.size())) {
+		if ((new_index >= m_NewPairKeys.size()) || ((old_index < m_PairKeys.size()) && (m_PairKeys[old_index] < m_NewPairKeys[new_index]))) {
+			m_Ended.push_back(to_pair(m_PairKeys[old_index++]));
+		} else if ((old_index >= m_PairKeys.size()) || (m_NewPairKeys[new_index] < m_PairKeys[old_index])) {
+			m_Begun.push_back(to_pair(m_NewPairKeys[new_index]));
+			m_Pairs.push_back(to_pair(m_NewPairKeys[new_index++]));
+		} else {
+			m_Persisting.push_back(to_pair(m_NewPairKeys[new_index]));
+			m_Pairs.push_back(to_pair(m_NewPairKeys[new_index++]));
+			old_index++;
+		}
+	}
+	m_PairKeys.swap(m_NewPairKeys);
+
+	// only now can removed handles be handed out again, their ended pairs have been reported
+	m_FreeHandles.insert(m_FreeHandles.end(), m_PendingFree.begin(), m_PendingFree.end());
+	m_PendingFree.clear();
+
+	stats.p_Pairs = (int)m_Pairs.size();
+	stats.p_Begun = (int)m_Begun.size();
+	stats.p_Ended = (int)m_Ended.size();
+	return stats;
+}
+
+template class SweepAndPrune<2>;
+template class SweepAndPrune<3>;
+
+} // namespace Neshny
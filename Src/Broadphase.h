@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// when the insertion sort has to move more than this many places per object, a full radix sort is cheaper
+constexpr int SWEEP_INSERTION_BUDGET = 32;
+// below this many objects per thread the sweep is not split up
+constexpr int SWEEP_MIN_PER_THREAD = 2048;
+
+////////////////////////////////////////////////////////////////////////////////
+struct BroadphasePair {
+	inline bool		operator==		( const BroadphasePair& other ) const { return (p_A == other.p_A) && (p_B == other.p_B); }
+
+	int				p_A;		// always the lower handle
+	int				p_B;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct SweepAndPruneStats {
+	int		p_Objects = 0;
+	int		p_Swaps = 0;			// places moved by the insertion sort
+	bool	p_FullSort = false;		// too much changed since last time, so everything was radix sorted instead
+	int		p_Threads = 1;
+	int		p_Pairs = 0;
+	int		p_Begun = 0;
+	int		p_Ended = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// sort and sweep broadphase for axis aligned boxes of any mix of sizes, in 2D or 3D
+// objects stay sorted along the sweep axis between updates, so when little has moved the insertion sort barely does anything
+// the overlapping pairs are kept from one update to the next, so each update reports which pairs began, persisted and ended
+// boxes that only touch count as overlapping
+// handles of removed objects are not reused until after the next update, so a pair can never persist across a remove and add
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+class SweepAndPrune {
+	static_assert((D == 2) || (D == 3), "Sweep and prune only supports 2D and 3D");
+
+public:
+
+	using VecType = std::conditional_t<D == 2, Vec2, Vec3>;
+
+								SweepAndPrune		( int sweep_axis = 0 ) : m_SweepAxis(sweep_axis) {}
+
+	int							Add					( VecType min_pos, VecType max_pos );
+	void						Move				( int handle, VecType min_pos, VecType max_pos );
+	void						Remove				( int handle );
+	// removes every object, their pairs are reported as ended on the next update
+	void						Clear				( void );
+
+	inline int					Size				( void ) const { return m_Count; }
+	inline bool					IsValid				( int handle ) const { return (handle >= 0) && (handle < (int)m_Alive.size()) && m_Alive[handle]; }
+
+	// brings the sort up to date and finds every overlapping pair, the sweep is split over thread_count threads when there are enough objects
+	SweepAndPruneStats			Update				( int thread_count = 1 );
+
+	// all of these are sorted by p_A then p_B, whatever the thread count
+	inline const std::vector<BroadphasePair>&	GetPairs			( void ) const { return m_Pairs; }
+	inline const std::vector<BroadphasePair>&	GetBegun			( void ) const { return m_Begun; }
+	inline const std::vector<BroadphasePair>&	GetPersisting		( void ) const { return m_Persisting; }
+	inline const std::vector<BroadphasePair>&	GetEnded			( void ) const { return m_Ended; }
+
+private:
+
+	struct Box {
+		std::array<double, D>	p_Min;
+		std::array<double, D>	p_Max;
+	};
+
+	struct Proxy {
+		double					p_Key;				// minimum along the sweep axis
+		int						p_Handle;
+	};
+
+	// the other axes of a sorted proxy, kept apart so the sweep only reads what it needs
+	struct CrossBounds {
+		std::array<double, D - 1>	p_Min;
+		std::array<double, D - 1>	p_Max;
+	};
+
+	static Box					ToBox				( VecType min_pos, VecType max_pos );
+	bool						InsertionSort		( int& swaps );
+	void						FullSort			( int thread_count );
+	void						Sweep				( int begin, int end, std::vector<uint64_t>& out ) const;
+
+	int							m_SweepAxis;
+	int							m_Count = 0;
+
+	std::vector<Box>			m_Boxes;			// indexed by handle
+	std::vector<bool>			m_Alive;
+	std::vector<int>			m_FreeHandles;
+	std::vector<int>			m_PendingFree;		// removed since the last update
+	std::vector<int>			m_Added;			// added since the last update
+
+	std::vector<Proxy>			m_Proxies;			// sorted by minimum along the sweep axis
+	// the sorted proxies again as structure of arrays, for the sweep
+	std::vector<double>			m_SweepMin;
+	std::vector<double>			m_SweepMax;
+	std::vector<CrossBounds>	m_Cross;
+
+	std::vector<uint64_t>		m_PairKeys;
+	std::vector<uint64_t>		m_NewPairKeys;
+	std::vector<BroadphasePair>	m_Pairs;
+	std::vector<BroadphasePair>	m_Begun;
+	std::vector<BroadphasePair>	m_Persisting;
+	std::vector<BroadphasePair>	m_Ended;
+};
+
+using SweepAndPrune2D = SweepAndPrune<2>;
+using SweepAndPrune3D = SweepAndPrune<3>;
+
+} // namespace Neshny
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// assembles generated shader code in one growable buffer instead of a std::format and a temporary string per fragment
+// numbers are written with std::to_chars, which gives exactly the text std::format("{}") does, so swapping one for the other never changes the output
+// Clear keeps the capacity, so a builder reused for many pipelines stops allocating once it has grown to fit the largest
+////////////////////////////////////////////////////////////////////////////////
+class CodeBuilder {
+public:
+
+	// returns nothing the first time and between every time after, for joining items as they are generated
+	class Separator {
+	public:
+								Separator		( std::string_view between ) : m_Between(between) {}
+		inline std::string_view	operator()		( void ) { std::string_view result = m_First ? std::string_view() : m_Between; m_First = false; return result; }
+	private:
+		std::string_view		m_Between;
+		bool					m_First = true;
+	};
+
+	class ScopedIndent {
+	public:
+								ScopedIndent	( CodeBuilder& builder ) : m_Builder(builder) { m_Builder.Indent(); }
+								~ScopedIndent	( void ) { m_Builder.Unindent(); }
+	private:
+		CodeBuilder&			m_Builder;
+	};
+
+								CodeBuilder		( std::size_t reserve_bytes = 0 ) { m_Buffer.reserve(reserve_bytes); }
+
+	// strings, chars and numbers in any mix, numbers formatted the same as std::format("{}")
+	template<typename... Args>
+	inline CodeBuilder&			Add				( const Args&... args ) { (Append(args), ...); return *this; }
+	// the current indentation, then the arguments, then a newline
+	template<typename... Args>
+	inline CodeBuilder&			Line			( const Args&... args ) { m_Buffer.append(m_IndentLevel, '\t'); (Append(args), ...); m_Buffer.push_back('\n'); return *this; }
+	template<typename Container>
+	CodeBuilder&				Join			( const Container& items, std::string_view between );
+
+	inline void					Indent			( void ) { m_IndentLevel++; }
+	inline void					Unindent		( void ) { m_IndentLevel = std::max(0, m_IndentLevel - 1); }
+	inline ScopedIndent			Indented		( void ) { return ScopedIndent(*this); }
+	inline int					GetIndentLevel	( void ) const { return m_IndentLevel; }
+
+	inline void					Clear			( void ) { m_Buffer.clear(); m_IndentLevel = 0; }
+	inline void					Reserve			( std::size_t bytes ) { m_Buffer.reserve(bytes); }
+	inline std::size_t			Size			( void ) const { return m_Buffer.size(); }
+	inline std::size_t			Capacity		( void ) const { return m_Buffer.capacity(); }
+	inline std::string_view		View			( void ) const { return m_Buffer; }
+	inline std::string			ToString		( void ) const { return m_Buffer; }
+	// hands the buffer over without a copy, leaving the builder empty and without its capacity
+	inline std::string			Take			( void ) { std::string result = std::move(m_Buffer); m_Buffer.clear(); m_IndentLevel = 0; return result; }
+
+private:
+
+	template<typename T>
+	void						Append			( const T& value );
+
+	std::string					m_Buffer;
+	int							m_IndentLevel = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+void CodeBuilder::Append(const T& value) {
+	if constexpr (std::is_same_v<T, char>) {
+		m_Buffer.push_back(value);
+	} else if constexpr (std::is_same_v<T, bool>) {
+		m_Buffer.append(value ? "true" : "false");
+	} else if constexpr (std::is_arithmetic_v<T>) {
+		// enough for any integer and the longest shortest-round-trip double
+		char digits[32];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		m_Buffer.append(digits, result.ptr);
+	} else {
+		m_Buffer.append(std::string_view(value));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename Container>
+CodeBuilder& CodeBuilder::Join(const Container& items, std::string_view between) {
+	Separator separator(between);
+	for (const auto& item : items) {
+		Append(separator());
+		Append(item);
+	}
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// generated code that only depends on a few inputs, made once per key and handed back as a copy afterwards
+// safe to use from several threads, the first result stored for a key is the one everyone gets
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class GeneratedCodeCache {
+public:
+
+	template<typename Func>
+	T							Get				( const std::string& key, Func&& generate );
+	void						Clear			( void ) { std::lock_guard<std::mutex> lock(m_Lock); m_Cache.clear(); }
+	std::size_t					Size			( void ) { std::lock_guard<std::mutex> lock(m_Lock); return m_Cache.size(); }
+
+private:
+	std::mutex							m_Lock;
+	std::unordered_map<std::string, T>	m_Cache;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+template<typename Func>
+T GeneratedCodeCache<T>::Get(const std::string& key, Func&& generate) {
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		auto found = m_Cache.find(key);
+		if (found != m_Cache.end()) {
+			return found->second;
+		}
+	}
+	// generated outside the lock so one slow struct does not hold up the others
+	T value = generate();
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Cache.try_emplace(key, std::move(value)).first->second;
+}
+
+} // namespace Neshny
@@ -0,0 +1,363 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// items per chunk of each component, chunks are never reallocated so pointers into them stay put while the store grows
+constexpr int COMPONENT_CHUNK_SIZE = 1024;
+// below this many items per thread a query is not split up
+constexpr int COMPONENT_MIN_PER_THREAD = 4096;
+// loaded handles may point at most this many slots per item past the start (plus a chunk), so damaged data cannot ask for a huge slot table
+constexpr int COMPONENT_MAX_SLOTS_PER_ITEM = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+struct ComponentHandle {
+	inline bool				operator==		( const ComponentHandle& other ) const { return (p_Index == other.p_Index) && (p_Generation == other.p_Generation); }
+	inline uint64_t			ToInt			( void ) const { return ((uint64_t)p_Generation << 32) | p_Index; }
+	inline static ComponentHandle	FromInt	( uint64_t val ) { return { (uint32_t)(val & 0xFFFFFFFF), (uint32_t)(val >> 32) }; }
+
+	uint32_t		p_Index = 0xFFFFFFFF;
+	uint32_t		p_Generation = 0;		// bumped each time the slot is freed, so handles to removed items never find whatever replaced them
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// holds many items of one registered struct for gameplay logic that runs on the CPU, stored as an array per member rather than an array of structs
+// each member listed in registerMembers is a component, a query names the members it needs and only touches those arrays
+// handles stay valid until their item is removed, the items themselves are kept packed so removing swaps the last one into the hole
+// dense indices therefore change when anything is removed, handles do not
+// GetItems and SetItems give a std::vector of the struct, which the Json and Binary serialisers already handle
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class ComponentStore {
+
+	using Members = std::decay_t<decltype(meta::getMembers<T>())>;
+	template <typename A>
+	using Column = std::vector<std::vector<A>>;
+
+	template <typename M>
+	struct MemberInfo;
+	template <typename C, typename A>
+	struct MemberInfo<A C::*> {
+		using Type = A;
+	};
+	template <typename M>
+	struct ColumnsOf;
+	template <typename... Ms>
+	struct ColumnsOf<std::tuple<Ms...>> {
+		using Type = std::tuple<Column<meta::get_member_type<Ms>>...>;
+	};
+
+	static constexpr uint32_t NO_ITEM = 0xFFFFFFFF;
+	static constexpr size_t NUM_COMPONENTS = std::tuple_size_v<Members>;
+
+public:
+
+	template <auto MEMBER>
+	using ComponentType = typename MemberInfo<decltype(MEMBER)>::Type;
+
+								ComponentStore		( void ) { static_assert(meta::isRegistered<T>(), "Components come from the registered members of the struct"); }
+
+	ComponentHandle				Add					( const T& item = {} );
+	// false when the handle is not valid, the last item takes the removed one's place
+	bool						Remove				( ComponentHandle handle );
+	void						Clear				( void );
+
+	inline bool					IsValid				( ComponentHandle handle ) const { return (handle.p_Index < m_Slots.size()) && (m_Slots[handle.p_Index].p_Generation == handle.p_Generation) && (m_Slots[handle.p_Index].p_Dense != NO_ITEM); }
+	inline int					GetCount			( void ) const { return m_Count; }
+	// -1 when the handle is not valid
+	inline int					GetIndex			( ComponentHandle handle ) const { return IsValid(handle) ? (int)m_Slots[handle.p_Index].p_Dense : -1; }
+	inline ComponentHandle		GetHandle			( int index ) const { uint32_t slot = m_DenseSlots[index]; return { slot, m_Slots[slot].p_Generation }; }
+
+	// gathers every component into a struct, the handle must be valid
+	T							Get					( ComponentHandle handle ) const;
+	void						Set					( ComponentHandle handle, const T& item );
+	template <auto MEMBER>
+	inline ComponentType<MEMBER>&	GetComponent	( ComponentHandle handle ) { uint32_t index = m_Slots[handle.p_Index].p_Dense; return GetColumn<MEMBER>()[index / COMPONENT_CHUNK_SIZE][index % COMPONENT_CHUNK_SIZE]; }
+
+	// calls fn(first_index, count, pointers...) with a pointer into each named component per chunk, chunks are shared out over thread_count threads
+	template <auto... MEMBERS, typename F>
+	void						ForEachChunk		( F&& fn, int thread_count = 1 );
+	// calls fn(components...) or fn(handle, components...) for every item
+	// with more than one thread fn is called concurrently, and nothing may be added or removed until it returns
+	template <auto... MEMBERS, typename F>
+	void						ForEach				( F&& fn, int thread_count = 1 );
+
+	// in order of dense index, handles are filled in when asked for so SetItems can give them back
+	std::vector<T>				GetItems			( std::vector<uint64_t>* handles = nullptr ) const;
+	// replaces the contents, with no handles the items are given new ones in order, false if the handles do not match the items
+	bool						SetItems			( const std::vector<T>& items, const std::vector<uint64_t>* handles = nullptr );
+
+private:
+
+	struct Slot {
+		uint32_t		p_Dense = NO_ITEM;
+		uint32_t		p_Generation = 1;
+	};
+
+	template <typename F, size_t... I>
+	inline void					ForColumnsImpl		( F& fn, std::index_sequence<I...> ) { const auto& members = meta::getMembers<T>(); (fn(std::get<I>(members), std::get<I>(m_Columns)), ...); }
+	template <typename F, size_t... I>
+	inline void					ForColumnsImpl		( F& fn, std::index_sequence<I...> ) const { const auto& members = meta::getMembers<T>(); (fn(std::get<I>(members), std::get<I>(m_Columns)), ...); }
+	// calls fn(member, column) for every component
+	template <typename F>
+	inline void					ForColumns			( F&& fn ) { ForColumnsImpl(fn, std::make_index_sequence<NUM_COMPONENTS>{}); }
+	template <typename F>
+	inline void					ForColumns			( F&& fn ) const { ForColumnsImpl(fn, std::make_index_sequence<NUM_COMPONENTS>{}); }
+
+	template <auto MEMBER>
+	Column<ComponentType<MEMBER>>&	GetColumn		( void );
+	void						PushItem			( const T& item );
+
+	typename ColumnsOf<Members>::Type	m_Columns;
+	std::vector<Slot>			m_Slots;
+	std::vector<uint32_t>		m_DenseSlots;		// slot of each item by dense index
+	std::vector<uint32_t>		m_FreeSlots;
+	int							m_Count = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+template <auto MEMBER>
+typename ComponentStore<T>::template Column<typename ComponentStore<T>::template ComponentType<MEMBER>>& ComponentStore<T>::GetColumn(void) {
+
+	using A = ComponentType<MEMBER>;
+	Column<A>* result = nullptr;
+	ForColumns([&result](const auto& member, auto& column) {
+		if constexpr (std::is_same_v<meta::get_member_type<decltype(member)>, A> && std::is_same_v<decltype(member.getPtr()), decltype(MEMBER)>) {
+			if (member.hasPtr() && (member.getPtr() == MEMBER)) {
+				result = &column;
+			}
+		}
+	});
+	assert(result && "Only registered members are components");
+	return *result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void ComponentStore<T>::PushItem(const T& item) {
+
+	const int chunk = m_Count / COMPONENT_CHUNK_SIZE;
+	ForColumns([chunk, &item](const auto& member, auto& column) {
+		if (chunk >= (int)column.size()) {
+			column.emplace_back();
+			column.back().reserve(COMPONENT_CHUNK_SIZE);
+		}
+		column[chunk].push_back(member.get(item));
+	});
+	m_Count++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+ComponentHandle ComponentStore<T>::Add(const T& item) {
+
+	uint32_t slot;
+	if (m_FreeSlots.empty()) {
+		slot = (uint32_t)m_Slots.size();
+		m_Slots.push_back({});
+	} else {
+		slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	m_Slots[slot].p_Dense = (uint32_t)m_Count;
+	m_DenseSlots.push_back(slot);
+	PushItem(item);
+	return { slot, m_Slots[slot].p_Generation };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+bool ComponentStore<T>::Remove(ComponentHandle handle) {
+
+	if (!IsValid(handle)) {
+		return false;
+	}
+	Slot& slot = m_Slots[handle.p_Index];
+	const int index = (int)slot.p_Dense;
+	const int last = m_Count - 1;
+	ForColumns([index, last](const auto&, auto& column) {
+		auto& last_chunk = column[last / COMPONENT_CHUNK_SIZE];
+		if (index != last) {
+			column[index / COMPONENT_CHUNK_SIZE][index % COMPONENT_CHUNK_SIZE] = std::move(last_chunk.back());
+		}
+		last_chunk.pop_back();
+	});
+	if (index != last) {
+		m_DenseSlots[index] = m_DenseSlots[last];
+		m_Slots[m_DenseSlots[index]].p_Dense = (uint32_t)index;
+	}
+	m_DenseSlots.pop_back();
+	m_Count--;
+
+	slot.p_Dense = NO_ITEM;
+	slot.p_Generation = std::max(slot.p_Generation + 1, 1u);
+	m_FreeSlots.push_back(handle.p_Index);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void ComponentStore<T>::Clear(void) {
+
+	// chunks keep their memory for whatever is added next
+	ForColumns([](const auto&, auto& column) {
+		for (auto& chunk : column) {
+			chunk.clear();
+		}
+	});
+	m_FreeSlots.clear();
+	for (int i = (int)m_Slots.size() - 1; i >= 0; i--) {
+		if (m_Slots[i].p_Dense != NO_ITEM) {
+			m_Slots[i].p_Dense = NO_ITEM;
+			m_Slots[i].p_Generation = std::max(m_Slots[i].p_Generation + 1, 1u);
+		}
+		m_FreeSlots.push_back((uint32_t)i);
+	}
+	m_DenseSlots.clear();
+	m_Count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+T ComponentStore<T>::Get(ComponentHandle handle) const {
+
+	T item;
+	const uint32_t index = m_Slots[handle.p_Index].p_Dense;
+	ForColumns([index, &item](const auto& member, const auto& column) {
+		member.set(item, column[index / COMPONENT_CHUNK_SIZE][index % COMPONENT_CHUNK_SIZE]);
+	});
+	return item;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void ComponentStore<T>::Set(ComponentHandle handle, const T& item) {
+
+	const uint32_t index = m_Slots[handle.p_Index].p_Dense;
+	ForColumns([index, &item](const auto& member, auto& column) {
+		column[index / COMPONENT_CHUNK_SIZE][index % COMPONENT_CHUNK_SIZE] = member.get(item);
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+template <auto... MEMBERS, typename F>
+void ComponentStore<T>::ForEachChunk(F&& fn, int thread_count) {
+
+	auto columns = std::make_tuple(&GetColumn<MEMBERS>()...);
+	const int count = m_Count;
+	const int chunk_count = (count + COMPONENT_CHUNK_SIZE - 1) / COMPONENT_CHUNK_SIZE;
+	auto run = [&columns, &fn, count](int begin, int end) {
+		for (int chunk = begin; chunk < end; chunk++) {
+			const int first = chunk * COMPONENT_CHUNK_SIZE;
+			const int size = std::min(COMPONENT_CHUNK_SIZE, count - first);
+			std::apply([&fn, chunk, first, size](auto*... column) { fn(first, size, (*column)[chunk].data()...); }, columns);
+		}
+	};
+
+#ifdef __EMSCRIPTEN__
+	int num_threads = 1;
+#else
+	int num_threads = std::clamp(std::min(std::min(thread_count, count / COMPONENT_MIN_PER_THREAD), chunk_count), 1, 64);
+#endif
+	if (num_threads == 1) {
+		run(0, chunk_count);
+		return;
+	}
+	ParallelFor(num_threads, [&run, num_threads, chunk_count](int t) {
+		run(chunk_count * t / num_threads, chunk_count * (t + 1) / num_threads);
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+template <auto... MEMBERS, typename F>
+void ComponentStore<T>::ForEach(F&& fn, int thread_count) {
+
+	ForEachChunk<MEMBERS...>([this, &fn](int first, int size, auto*... components) {
+		for (int i = 0; i < size; i++) {
+			if constexpr (std::is_invocable_v<F&, ComponentHandle, decltype(*components)...>) {
+				fn(GetHandle(first + i), components[i]...);
+			} else {
+				fn(components[i]...);
+			}
+		}
+	}, thread_count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+std::vector<T> ComponentStore<T>::GetItems(std::vector<uint64_t>* handles) const {
+
+	std::vector<T> items(m_Count);
+	ForColumns([&items](const auto& member, const auto& column) {
+		for (int i = 0; i < (int)items.size(); i++) {
+			member.set(items[i], column[i / COMPONENT_CHUNK_SIZE][i % COMPONENT_CHUNK_SIZE]);
+		}
+	});
+	if (handles) {
+		handles->resize(m_Count);
+		for (int i = 0; i < m_Count; i++) {
+			(*handles)[i] = GetHandle(i).ToInt();
+		}
+	}
+	return items;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+bool ComponentStore<T>::SetItems(const std::vector<T>& items, const std::vector<uint64_t>* handles) {
+
+	std::vector<Slot> slots;
+	if (handles) {
+		if (handles->size() != items.size()) {
+			return false;
+		}
+		const uint64_t max_slots = (uint64_t)items.size() * COMPONENT_MAX_SLOTS_PER_ITEM + COMPONENT_CHUNK_SIZE;
+		for (int i = 0; i < (int)handles->size(); i++) {
+			ComponentHandle handle = ComponentHandle::FromInt((*handles)[i]);
+			if ((handle.p_Index == NO_ITEM) || (handle.p_Index >= max_slots) || (handle.p_Generation == 0)) {
+				return false;
+			}
+			if (handle.p_Index >= slots.size()) {
+				slots.resize(handle.p_Index + 1);
+			}
+			if (slots[handle.p_Index].p_Dense != NO_ITEM) {
+				return false;
+			}
+			slots[handle.p_Index] = { (uint32_t)i, handle.p_Generation };
+		}
+	}
+
+	Clear();
+	ForColumns([](const auto&, auto& column) {
+		column.clear();
+	});
+	if (handles) {
+		// slots not in use start over at the first generation, so handles removed before the save are not guaranteed to stay invalid
+		m_Slots = std::move(slots);
+		m_FreeSlots.clear();
+		for (int i = (int)m_Slots.size() - 1; i >= 0; i--) {
+			if (m_Slots[i].p_Dense == NO_ITEM) {
+				m_FreeSlots.push_back((uint32_t)i);
+			}
+		}
+		m_DenseSlots.resize(items.size());
+		for (int i = 0; i < (int)handles->size(); i++) {
+			m_DenseSlots[i] = ComponentHandle::FromInt((*handles)[i]).p_Index;
+		}
+		for (const auto& item : items) {
+			PushItem(item);
+		}
+	} else {
+		m_Slots.clear();
+		m_FreeSlots.clear();
+		for (const auto& item : items) {
+			Add(item);
+		}
+	}
+	return true;
+}
+
+} // namespace Neshny
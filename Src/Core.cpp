@@ -140,6 +140,252 @@ void WorkerThreadPool::Sync(void) {
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+MainThreadQueue::~MainThreadQueue(void) {
+	// any task still waiting is dropped without running - futures waiting on them will see a broken promise
+	for (int i = 0; i < (int)Priority::COUNT; i++) {
+		Node* node = m_Incoming[i].exchange(ClosedMarker());
+		while (node && (node != ClosedMarker())) {
+			Node* next = node->p_Next;
+			delete node;
+			node = next;
+		}
+		for (Node* ready : m_Ready[i]) {
+			delete ready;
+		}
+		m_Ready[i].clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MainThreadQueue::Push(std::function<void()> task, Priority priority) {
+
+	Node* node = new Node{ std::move(task), std::chrono::steady_clock::now() };
+	std::atomic<Node*>& head = m_Incoming[(int)priority];
+	// counted before the node is visible, otherwise a drain could run it first and the count would dip below zero
+	m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+	Node* expected = head.load(std::memory_order_relaxed);
+	do {
+		if (expected == ClosedMarker()) {
+			m_PendingCount.fetch_add(-1, std::memory_order_relaxed);
+			delete node;
+			return false;
+		}
+		node->p_Next = expected;
+	} while (!head.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed));
+
+	m_SubmittedCount.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MainThreadQueue::CollectIncoming(void) {
+
+	Node* replacement = IsClosed() ? ClosedMarker() : nullptr;
+	for (int i = 0; i < (int)Priority::COUNT; i++) {
+		Node* node = m_Incoming[i].exchange(replacement, std::memory_order_acquire);
+		if (node == ClosedMarker()) {
+			continue;
+		}
+		// the stack is newest first, so reverse it to keep submission order
+		Node* reversed = nullptr;
+		while (node) {
+			Node* next = node->p_Next;
+			node->p_Next = reversed;
+			reversed = node;
+			node = next;
+		}
+		for (; reversed; reversed = reversed->p_Next) {
+			m_Ready[i].push_back(reversed);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int MainThreadQueue::Drain(TimerNanos budget) {
+
+	TimerPoint start = std::chrono::steady_clock::now();
+	CollectIncoming();
+
+	FrameStats stats;
+	stats.p_Submitted = m_SubmittedCount.exchange(0, std::memory_order_relaxed);
+
+	bool budget_exceeded = false;
+	for (int i = 0; i < (int)Priority::COUNT; i++) {
+		auto& ready = m_Ready[i];
+		while (!ready.empty()) {
+			TimerPoint now = std::chrono::steady_clock::now();
+			if ((i != (int)Priority::HIGH) && (stats.p_Executed > 0) && (now - start >= budget)) {
+				budget_exceeded = true;
+				break;
+			}
+			Node* node = ready.front();
+			ready.pop_front();
+			stats.p_MaxLatencyMilliseconds = std::max(stats.p_MaxLatencyMilliseconds, TimerSeconds(now - node->p_Queued).count() * 1000.0);
+			m_PendingCount.fetch_add(-1, std::memory_order_relaxed);
+			node->p_Task();
+			delete node;
+			stats.p_Executed++;
+		}
+		if (budget_exceeded) {
+			break;
+		}
+	}
+
+	stats.p_Remaining = GetPendingCount();
+	stats.p_Milliseconds = TimerSeconds(std::chrono::steady_clock::now() - start).count() * 1000.0;
+	m_LastFrameStats = stats;
+	return stats.p_Executed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MainThreadQueue::Close(void) {
+	m_Closed.store(true, std::memory_order_release);
+	DrainAll();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool FileWatcher::Start(const std::vector<std::string>& dirs, TimerNanos poll_interval) {
+#ifdef __EMSCRIPTEN__
+	return false;
+#else
+	Stop();
+	m_Dirs = dirs;
+	m_PollInterval = poll_interval;
+	m_StopRequested = false;
+	m_Thread = new std::thread([this]() {
+		if (!WatchInotify()) {
+			WatchPolling();
+		}
+	});
+	return true;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FileWatcher::Stop(void) {
+	if (!m_Thread) {
+		return;
+	}
+	m_StopRequested = true;
+	m_Thread->join();
+	delete m_Thread;
+	m_Thread = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FileWatcher::NotifyChanged(std::string_view relative_path, TimerPoint when) {
+	const std::lock_guard<std::mutex> lock(m_Lock);
+	m_Changes.insert_or_assign(std::string(relative_path), when);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> FileWatcher::TakeSettledChanges(TimerNanos quiet_period, TimerPoint now) {
+	std::vector<std::string> settled;
+	const std::lock_guard<std::mutex> lock(m_Lock);
+	for (auto iter = m_Changes.begin(); iter != m_Changes.end(); ) {
+		if (now - iter->second >= quiet_period) {
+			settled.push_back(iter->first);
+			iter = m_Changes.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+	return settled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool FileWatcher::WatchInotify(void) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY;
+	std::map<int, std::string> watch_prefixes; // relative directory for every watch descriptor
+	for (const auto& dir : m_Dirs) {
+		int wd = inotify_add_watch(fd, dir.c_str(), mask);
+		if (wd >= 0) {
+			watch_prefixes[wd] = "";
+		}
+		std::error_code err;
+		for (auto iter = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, err); (!err) && (iter != std::filesystem::recursive_directory_iterator()); iter.increment(err)) {
+			if (!iter->is_directory()) {
+				continue;
+			}
+			int sub_wd = inotify_add_watch(fd, iter->path().string().c_str(), mask);
+			if (sub_wd >= 0) {
+				watch_prefixes[sub_wd] = std::filesystem::relative(iter->path(), dir).generic_string() + "/";
+			}
+		}
+	}
+	if (watch_prefixes.empty()) {
+		close(fd);
+		return false;
+	}
+
+	alignas(inotify_event) char buffer[4096];
+	int timeout_ms = std::max(1, (int)std::chrono::duration_cast<std::chrono::milliseconds>(m_PollInterval).count());
+	while (!m_StopRequested) {
+		pollfd pfd = { fd, POLLIN, 0 };
+		if (poll(&pfd, 1, timeout_ms) <= 0) {
+			continue;
+		}
+		while (true) {
+			ssize_t len = read(fd, buffer, sizeof(buffer));
+			if (len <= 0) {
+				break;
+			}
+			for (char* ptr = buffer; ptr < buffer + len; ) {
+				const inotify_event* event = (const inotify_event*)ptr;
+				ptr += sizeof(inotify_event) + event->len;
+				if ((event->len == 0) || (event->mask & IN_ISDIR)) {
+					continue;
+				}
+				auto found = watch_prefixes.find(event->wd);
+				if (found != watch_prefixes.end()) {
+					NotifyChanged(found->second + event->name);
+				}
+			}
+		}
+	}
+	close(fd);
+	return true;
+#else
+	return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FileWatcher::WatchPolling(void) {
+
+	auto scan = [this]() {
+		std::map<std::string, std::filesystem::file_time_type> times;
+		for (const auto& dir : m_Dirs) {
+			std::error_code err;
+			for (auto iter = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, err); (!err) && (iter != std::filesystem::recursive_directory_iterator()); iter.increment(err)) {
+				if (iter->is_regular_file(err)) {
+					times.insert_or_assign(std::filesystem::relative(iter->path(), dir).generic_string(), iter->last_write_time(err));
+				}
+			}
+		}
+		return times;
+	};
+
+	auto previous = scan();
+	while (!m_StopRequested) {
+		std::this_thread::sleep_for(m_PollInterval);
+		auto current = scan();
+		for (const auto& [path, time] : current) {
+			auto found = previous.find(path);
+			if ((found == previous.end()) || (found->second != time)) {
+				NotifyChanged(path);
+			}
+		}
+		previous = std::move(current);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -161,13 +407,15 @@ Core::Core(void) {
 ////////////////////////////////////////////////////////////////////////////////
 Core::~Core(void) {
 
+	// anything still queued runs now, and producers arriving afterwards execute on their own thread
+	m_MainThreadTasks.Close();
 	m_ResourceThreads.Stop();
+	m_ShaderWatcher.Stop();
 
 	for (auto& resource : m_Resources) {
 		delete resource.second.m_Resource;
 	}
 	m_Resources.clear();
-	m_SyncLock.unlock();
 
 	Core::SaveJSON(m_Interface, EDITOR_INTERFACE_FILENAME);
 	//Core::SaveBinary(m_Interface, EDITOR_INTERFACE_FILENAME);
@@ -190,11 +438,20 @@ Token Core::SyncWithMainThread(void) {
 	if (ignore) {
 		return Token([this]() {}, true);
 	}
-	m_SyncsRequested.fetch_add(1, std::memory_order_relaxed);
-	m_SyncLock.lock();
-	return Token([this] () {
-		m_SyncsRequested.fetch_add(-1, std::memory_order_relaxed);
-		m_SyncLock.unlock();
+	// the main thread parks inside a high priority task until the token is released, giving the caller exclusive access
+	auto entered = std::make_shared<std::promise<void>>();
+	auto release = std::make_shared<std::promise<void>>();
+	std::future<void> entered_future = entered->get_future();
+	bool queued = m_MainThreadTasks.Push([entered, released = release->get_future().share()]() {
+		entered->set_value();
+		released.wait();
+	}, MainThreadQueue::Priority::HIGH);
+	if (!queued) { // main loop has shut down
+		return Token([this]() {}, true);
+	}
+	entered_future.wait();
+	return Token([release]() {
+		release->set_value();
 	}, true);
 }
 
@@ -287,15 +544,14 @@ void Core::LoopInner(IEngine* engine, int width, int height) {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 #endif
 
+	ProcessShaderHotReload();
+
 	engine->Render(width, height);
 
-	// open up lock for sync across resource threads
-	int requests = m_SyncsRequested.load(std::memory_order_relaxed);
-	if(requests > 0) {
-		DebugTiming dt0("Core::SyncRequest");
-		m_SyncLock.unlock();
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		m_SyncLock.lock();
+	// run work handed over from resource threads, spreading it across frames when it exceeds the budget
+	{
+		DebugTiming dt0("Core::MainThreadTasks");
+		m_MainThreadTasks.Drain(m_MainThreadBudget);
 	}
 }
 
@@ -329,7 +585,6 @@ bool Core::SDLLoop(SDL_Window* window, IEngine* engine) {
 
 	m_Window = window;
 	if (!LoopInit(engine)) {
-		m_SyncLock.lock();
 		return false;
 	}
 
@@ -345,10 +600,10 @@ bool Core::SDLLoop(SDL_Window* window, IEngine* engine) {
 
 	// Main loop
 	DebugTiming::MainLoopTimer(); // init to zero
-	m_SyncLock.lock();
 	while (!engine->ShouldExit()) {
 
 		TimerNanos loop_nanos = DebugTiming::MainLoopTimer();
+		FrameStats::Singleton().EndFrame(loop_nanos);
 #ifdef NESHNY_EDITOR_VIEWERS
 		InfoViewer::LoopTime(loop_nanos);
 #endif
@@ -661,6 +916,7 @@ void Core::SyncResolution(void) {
 ////////////////////////////////////////////////////////////////////////////////
 void Core::SDLLoopInner() {
 	TimerNanos loop_nanos = DebugTiming::MainLoopTimer();
+	FrameStats::Singleton().EndFrame(loop_nanos);
 #ifdef NESHNY_EDITOR_VIEWERS
 	InfoViewer::LoopTime(loop_nanos);
 #endif
@@ -697,6 +953,9 @@ void Core::SDLLoopInner() {
 
 	SyncResolution();
 #ifdef NESHNY_WEBGPU
+	// the frame's small readbacks all get mapped together, before the device tick that completes them
+	WebGPUBuffer::GetStagingPool().Flush();
+	WebGPUBuffer::GetStagingPool().EndFrame();
 
 #ifndef __EMSCRIPTEN__
 	wgpuDeviceTick(Core::Singleton().GetWebGPUDevice());
@@ -844,7 +1103,6 @@ bool Core::WebGPUSDLLoop(WebGPUNativeBackend backend, SDL_Window* window, IEngin
 
 	// Main loop
 	DebugTiming::MainLoopTimer(); // init to zero
-	m_SyncLock.lock();
 
 	m_FrameTimer = std::chrono::steady_clock::now();
 
@@ -901,6 +1159,10 @@ void Core::IRenderEditor(void) {
 		m_Interface.p_ResourceView.p_Visible = !m_Interface.p_ResourceView.p_Visible;
 	}
 	ImGui::SameLine();
+	if (ImGui::Button((std::format("{} Memory", m_Interface.p_MemoryView.p_Visible ? close_string : open_string)).c_str())) {
+		m_Interface.p_MemoryView.p_Visible = !m_Interface.p_MemoryView.p_Visible;
+	}
+	ImGui::SameLine();
 	if (ImGui::Button((std::format("{} 2D Scrapbook", m_Interface.p_Scrapbook2D.p_Visible ? close_string : open_string)).c_str())) {
 		m_Interface.p_Scrapbook2D.p_Visible = !m_Interface.p_Scrapbook2D.p_Visible;
 	}
@@ -926,6 +1188,7 @@ void Core::IRenderEditor(void) {
 	PipelineViewer::RenderImGui(m_Interface.p_PipelineView);
 #endif
 	ResourceViewer::RenderImGui(m_Interface.p_ResourceView);
+	MemoryViewer::RenderImGui(m_Interface.p_MemoryView);
 	Scrapbook2D::RenderImGui(m_Interface.p_Scrapbook2D);
 	Scrapbook3D::RenderImGui(m_Interface.p_Scrapbook3D);
 
@@ -959,26 +1222,166 @@ void Core::EnsureEmbeddableLoaderInit(void) {
 	m_EmbeddableLoader = [this] (std::string_view path, std::string& err_msg) -> std::string {
 		std::string path_str(path);
 		auto found = m_EmbeddedFiles.find(path_str);
-		if (found != m_EmbeddedFiles.end()) {
+		// embedded copies never change, so while hot reloading the files on disk come first
+		bool prefer_disk = m_ShaderWatcher.IsRunning();
+		if ((found != m_EmbeddedFiles.end()) && !prefer_disk) {
 			return std::string((char*)found->second.data(), (int)found->second.size());
 		}
 
 		for (auto prefix : m_ResourceDirs) {
 			std::string filename = std::format("{}/{}", prefix, path);
-			std::ifstream file(filename, std::ios::in | std::ios::binary);
-			if (file) {
-				std::ostringstream data_stream;
-				data_stream << file.rdbuf();
-				std::string data = data_stream.str();
-				file.close();
-				return data;
+			MappedFile file(filename);
+			if (file.IsValid()) {
+				return std::string(file.GetString());
 			}
 		}
+		if (found != m_EmbeddedFiles.end()) {
+			return std::string((char*)found->second.data(), (int)found->second.size());
+		}
 		err_msg = "Could not open file";
 		return std::string();
 	};
 }
 
+////////////////////////////////////////////////////////////////////////////////
+Shader* Core::CreateShaderInstance(std::string_view name, std::string_view start_insert, std::string_view end_insert, bool is_compute, int shader_id, bool& valid) {
+
+	EnsureEmbeddableLoaderInit();
+
+	// every file pulled in while preprocessing, including nested includes, becomes a dependency of this instance
+	std::vector<std::string> loaded_files;
+	auto recording_loader = [this, &loaded_files](std::string_view path, std::string& err_msg) -> std::string {
+		loaded_files.emplace_back(path);
+		return (*m_EmbeddableLoader)(path, err_msg);
+	};
+
+	Shader* new_shader = new Shader();
+#if defined(NESHNY_GL)
+	std::string err_msg;
+	if (is_compute) {
+		valid = new_shader->InitCompute(err_msg, recording_loader, std::format("{}.comp", name), start_insert);
+	} else {
+		std::string name_str(name);
+		valid = new_shader->Init(err_msg, recording_loader, name_str + ".vert", name_str + ".frag", "", start_insert);
+	}
+	if (!valid) {
+		Core::Log(err_msg);
+		m_Interface.p_ShaderView.p_Visible = true;
+	}
+#elif defined(NESHNY_WEBGPU)
+	valid = new_shader->Init(recording_loader, std::format("{}.wgsl", name), start_insert, end_insert);
+	if (!valid) {
+		for (auto err : new_shader->GetErrors()) {
+			Core::Log(std::format("COMPILE ERROR on line {}: {}", err.m_LineNum, err.m_Message));
+		}
+		m_Interface.p_ShaderView.p_Visible = true;
+	}
+#endif
+	m_ShaderDependencies.SetDependencies(shader_id, loaded_files);
+	return new_shader;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Core::EnableShaderHotReload(bool enable) {
+	if (!enable) {
+		m_ShaderWatcher.Stop();
+		return true;
+	}
+	return m_ShaderWatcher.Start(m_ResourceDirs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Core::ProcessShaderHotReload(void) {
+
+#if defined(NESHNY_WEBGPU)
+	std::erase_if(m_RetiredShaders, [](const RetiredShader& retired) {
+		if (std::any_of(retired.p_Users.begin(), retired.p_Users.end(), [](const std::weak_ptr<CachedPipeline>& user) { return !user.expired(); })) {
+			return false;
+		}
+		delete retired.p_Shader;
+		return true;
+	});
+#endif
+
+	if (m_ShaderWatcher.IsRunning()) {
+		auto changed = m_ShaderWatcher.TakeSettledChanges(m_ShaderReloadDebounce);
+		for (int shader_id : m_ShaderDependencies.GetAffectedShaders(changed)) {
+			if (std::find(m_PendingShaderReloads.begin(), m_PendingShaderReloads.end(), shader_id) == m_PendingShaderReloads.end()) {
+				m_PendingShaderReloads.push_back(shader_id);
+			}
+		}
+	}
+	if (m_PendingShaderReloads.empty()) {
+		return;
+	}
+
+	// spread recompilation across frames so touching a widely included file does not cause one giant hitch
+	DebugTiming dt0("Core::ShaderHotReload");
+	for (int i = 0; (i < m_ShaderReloadsPerFrame) && (!m_PendingShaderReloads.empty()); i++) {
+		int shader_id = m_PendingShaderReloads.front();
+		m_PendingShaderReloads.pop_front();
+		ReloadShaderInstance(shader_id);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Core::ReloadShaderInstance(int shader_id) {
+
+	auto reload = [this, shader_id](std::vector<ShaderGroup>& groups, bool is_compute) -> std::optional<bool> {
+		for (auto& group : groups) {
+			for (auto& instance : group.p_Instances) {
+				if (instance.p_Id != shader_id) {
+					continue;
+				}
+				bool valid;
+				Shader* new_shader = CreateShaderInstance(group.p_Name, instance.m_StartInsert, instance.m_EndInsert, is_compute, shader_id, valid);
+				if (!valid) { // keep running the last good version until the error is fixed
+					delete new_shader;
+					return false;
+				}
+#if defined(NESHNY_WEBGPU)
+				// pipelines hold onto the old module, so they need to be rebuilt
+				// ones handed out before can still be held outside the cache, so they are marked stale and the old shader is kept until they are gone
+				Shader* old_shader = instance.p_Shader;
+				RetiredShader retired = { old_shader, {} };
+				std::erase_if(m_LivePipelines, [](const std::weak_ptr<CachedPipeline>& live) { return live.expired(); });
+				for (const auto& live : m_LivePipelines) {
+					auto pipeline = live.lock();
+					if (pipeline && (pipeline->GetPipeline()->GetShader() == old_shader)) {
+						pipeline->m_Stale = true;
+						retired.p_Users.push_back(live);
+					}
+				}
+				std::erase_if(m_PreparedPipelines, [](const std::shared_ptr<CachedPipeline>& cached) { return cached->IsStale(); });
+				if (retired.p_Users.empty()) {
+					delete old_shader;
+				} else {
+					m_RetiredShaders.push_back(std::move(retired));
+				}
+#else
+				delete instance.p_Shader;
+#endif
+				instance.p_Shader = new_shader;
+				Core::Log(std::format("Reloaded shader {}", group.p_Name));
+				return true;
+			}
+		}
+		return std::nullopt;
+	};
+
+	std::optional<bool> result = reload(m_ShaderGroups, false);
+#if defined(NESHNY_GL)
+	if (!result.has_value()) {
+		result = reload(m_ComputeShaderGroups, true);
+	}
+#endif
+	if (!result.has_value()) { // shader was unloaded since the change was detected
+		m_ShaderDependencies.RemoveShader(shader_id);
+		return false;
+	}
+	return *result;
+}
+
 #if defined(NESHNY_GL)
 ////////////////////////////////////////////////////////////////////////////////
 void Core::DispatchMultiple(GLShader* prog, int count, int total_local_groups, bool mem_barrier) {
@@ -1015,16 +1418,10 @@ GLShader* Core::IGetShader(std::string_view name, std::string_view insertion) {
 		found_group = &m_ShaderGroups.back();
 	}
 
-	std::string name_str(name);
-	std::string vertex_name = name_str + ".vert", fragment_name = name_str + ".frag", geometry_name = "";
-
-	GLShader* new_shader = new GLShader();
-	found_group->p_Instances.push_back({ new_shader, std::string(insertion) });
-	std::string err_msg = "";
-	if (!new_shader->Init(err_msg, m_EmbeddableLoader.value(), vertex_name, fragment_name, geometry_name, insertion)) {
-		Core::Log(err_msg);
-		m_Interface.p_ShaderView.p_Visible = true;
-	}
+	int shader_id = m_NextShaderId++;
+	bool valid;
+	GLShader* new_shader = CreateShaderInstance(name, insertion, std::string_view(), false, shader_id, valid);
+	found_group->p_Instances.push_back({ new_shader, std::string(insertion), std::string(), shader_id });
 	return new_shader;
 }
 
@@ -1050,15 +1447,10 @@ GLShader* Core::IGetComputeShader(std::string_view name, std::string_view insert
 		found_group = &m_ComputeShaderGroups.back();
 	}
 
-	std::string shader_name = std::format("{}.comp", name);
-
-	GLShader* new_shader = new GLShader();
-	found_group->p_Instances.push_back({ new_shader, std::string(insertion) });
-	std::string err_msg;
-	if (!new_shader->InitCompute(err_msg, m_EmbeddableLoader.value(), shader_name, insertion)) {
-		m_Interface.p_ShaderView.p_Visible = true;
-		Core::Log(err_msg);
-	}
+	int shader_id = m_NextShaderId++;
+	bool valid;
+	GLShader* new_shader = CreateShaderInstance(name, insertion, std::string_view(), true, shader_id, valid);
+	found_group->p_Instances.push_back({ new_shader, std::string(insertion), std::string(), shader_id });
 	return new_shader;
 }
 
@@ -1228,16 +1620,10 @@ WebGPUShader* Core::IGetShader(std::string_view name, std::string_view start_ins
 		m_ShaderGroups.push_back({ std::string(name), {} });
 		found_group = &m_ShaderGroups.back();
 	}
-	WebGPUShader* new_shader = new WebGPUShader();
-	found_group->p_Instances.push_back({ new_shader, std::string(start_insert), std::string(end_insert) });
-
-	std::string wgsl_name = std::format("{}.wgsl", name);
-	if (!new_shader->Init(m_EmbeddableLoader.value(), wgsl_name, start_insert, end_insert)) {
-		for (auto err : new_shader->GetErrors()) {
-			Core::Log(std::format("COMPILE ERROR on line {}: {}", err.m_LineNum, err.m_Message));
-		}
-		m_Interface.p_ShaderView.p_Visible = true;
-	}
+	int shader_id = m_NextShaderId++;
+	bool valid;
+	WebGPUShader* new_shader = CreateShaderInstance(name, start_insert, end_insert, false, shader_id, valid);
+	found_group->p_Instances.push_back({ new_shader, std::string(start_insert), std::string(end_insert), shader_id });
 	return new_shader;
 }
 
@@ -1446,6 +1832,19 @@ void Core::UnloadPipeline(std::string_view identifier) {
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void Core::UnloadPipelinesUsingEntity(std::string_view entity_name) {
+	// ones held outside the cache are marked stale too, so they get rebuilt the next time they are prepared
+	std::erase_if(m_LivePipelines, [](const std::weak_ptr<CachedPipeline>& live) { return live.expired(); });
+	for (const auto& live : m_LivePipelines) {
+		auto pipeline = live.lock();
+		if (pipeline && (std::find(pipeline->m_EntityNames.begin(), pipeline->m_EntityNames.end(), entity_name) != pipeline->m_EntityNames.end())) {
+			pipeline->m_Stale = true;
+		}
+	}
+	std::erase_if(m_PreparedPipelines, [](const std::shared_ptr<CachedPipeline>& cached) { return cached->IsStale(); });
+}
+
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1457,6 +1856,15 @@ void Core::UnloadAllShaders(void) {
 		}
 	}
 	m_ShaderGroups.clear();
+	m_ShaderDependencies.Clear();
+	m_PendingShaderReloads.clear();
+
+#if defined(NESHNY_WEBGPU)
+	for (auto& retired : m_RetiredShaders) {
+		delete retired.p_Shader;
+	}
+	m_RetiredShaders.clear();
+#endif
 
 #if defined NESHNY_GL
 	for (auto& group : m_ComputeShaderGroups) {
@@ -1,6 +1,12 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
 namespace Neshny {
 
 using TimerPoint = std::chrono::time_point<std::chrono::steady_clock>;
@@ -83,6 +89,9 @@ struct Camera3DOrbit {
 		Matrix4 orthoMatrix = Matrix4::Ortho(-horizontal_size, horizontal_size, -vertical_size, vertical_size, -p_FarPlane, p_FarPlane);
 		return orthoMatrix * GetViewMatrix();
 	}
+	Frustum GetFrustum(int width, int height) const {
+		return Frustum::FromMatrix(GetViewPerspectiveMatrix(width, height));
+	}
 	Vec3 GetCamRealPos(void) const {
 		return (GetViewMatrix().Inverse() * Vec4(0, 0, 0, 1)).ToVec3();
 	}
@@ -107,6 +116,9 @@ struct Camera3DFPS {
 		Matrix4 perspectiveMatrix = Matrix4::Perspective(p_FovDegrees, (float)width / height, p_NearPlane, p_FarPlane);
 		return perspectiveMatrix * GetViewMatrix();
 	}
+	Frustum GetFrustum(int width, int height) const {
+		return Frustum::FromMatrix(GetViewPerspectiveMatrix(width, height));
+	}
 	void GetDirections(Vec3* forward = nullptr, Vec3* up = nullptr, Vec3* side = nullptr) {
 		auto inv = p_Direction.Inverse();
 		if (forward) { *forward = inv * Vec3(0, 0, -1); forward->Normalize(); }
@@ -226,6 +238,11 @@ struct InterfaceResourceViewer {
 	bool			p_Visible = false;
 };
 
+struct InterfaceMemoryViewer {
+	bool			p_Visible = false;
+	bool			p_ShowDiff = false;
+};
+
 struct InterfaceScrapbook2D {
 	bool			p_Visible = false;
 	Camera2D		p_Cam = Camera2D{};
@@ -245,6 +262,7 @@ struct InterfaceCore {
 	InterfaceShaderViewer	p_ShaderView;
 	InterfacePipelineViewer	p_PipelineView;
 	InterfaceResourceViewer	p_ResourceView;
+	InterfaceMemoryViewer	p_MemoryView;
 	InterfaceScrapbook2D	p_Scrapbook2D;
 	InterfaceScrapbook3D	p_Scrapbook3D;
 };
@@ -261,6 +279,7 @@ namespace meta {
 			,member("BufferView", &Neshny::InterfaceCore::p_BufferView)
 			,member("ShaderView", &Neshny::InterfaceCore::p_ShaderView)
 			,member("ResourceView", &Neshny::InterfaceCore::p_ResourceView)
+			,member("MemoryView", &Neshny::InterfaceCore::p_MemoryView)
 			,member("Scrapbook2D", &Neshny::InterfaceCore::p_Scrapbook2D)
 			,member("Scrapbook3D", &Neshny::InterfaceCore::p_Scrapbook3D)
 		);
@@ -303,6 +322,12 @@ namespace meta {
 			member("Visible", &Neshny::InterfaceResourceViewer::p_Visible)
 		);
 	}
+	template<> inline auto registerMembers<Neshny::InterfaceMemoryViewer>() {
+		return members(
+			member("Visible", &Neshny::InterfaceMemoryViewer::p_Visible)
+			,member("ShowDiff", &Neshny::InterfaceMemoryViewer::p_ShowDiff)
+		);
+	}
 	template<> inline auto registerMembers<Neshny::InterfaceScrapbook2D>() {
 		return members(
 			member("Visible", &Neshny::InterfaceScrapbook2D::p_Visible)
@@ -381,6 +406,106 @@ private:
 	std::vector<Task*>		m_FinishedTasks;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////
+// multi-producer, single-consumer queue of closures that the main thread drains each frame
+// producers never block - each priority level is an intrusive lock-free stack that the consumer swaps out whole
+class MainThreadQueue {
+public:
+
+	enum class Priority {
+		HIGH, // always drained in full, ignoring the frame budget - use when a worker is blocked waiting on the result
+		NORMAL,
+		LOW,
+		COUNT
+	};
+
+	struct FrameStats {
+		int		p_Submitted = 0;
+		int		p_Executed = 0;
+		int		p_Remaining = 0; // everything still pending when the drain finished, left over for lack of budget or pushed while it ran
+		double	p_Milliseconds = 0.0;
+		double	p_MaxLatencyMilliseconds = 0.0;
+	};
+
+						MainThreadQueue		( void ) {}
+						~MainThreadQueue	( void );
+
+	bool				Push				( std::function<void()> task, Priority priority = Priority::NORMAL );
+	template <class F>
+	auto				Submit				( F&& func, Priority priority = Priority::NORMAL ) -> std::future<std::invoke_result_t<F>> {
+		using R = std::invoke_result_t<F>;
+		auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+		std::future<R> result = packaged->get_future();
+		if (!Push([packaged]() { (*packaged)(); }, priority)) {
+			(*packaged)(); // queue has been closed, so execute immediately on the caller
+		}
+		return result;
+	}
+
+	int					Drain				( TimerNanos budget );
+	int					DrainAll			( void ) { return Drain(TimerNanos::max()); }
+	void				Close				( void );
+
+	inline bool			IsClosed			( void ) const { return m_Closed.load(std::memory_order_acquire); }
+	inline int			GetPendingCount		( void ) const { return m_PendingCount.load(std::memory_order_relaxed); }
+	inline FrameStats	GetLastFrameStats	( void ) const { return m_LastFrameStats; }
+
+private:
+
+	struct Node {
+		std::function<void()>	p_Task;
+		TimerPoint				p_Queued;
+		Node*					p_Next = nullptr;
+	};
+
+	void				CollectIncoming		( void );
+	// placed at the head of every incoming stack once closed, so late producers can detect it without a race
+	static inline Node*	ClosedMarker		( void ) { return (Node*)(uintptr_t)1; }
+
+	std::atomic<Node*>	m_Incoming[(int)Priority::COUNT] = {};
+	std::atomic_bool	m_Closed = false;
+	std::atomic_int		m_PendingCount = 0;
+	std::atomic_int		m_SubmittedCount = 0;
+
+	// only ever touched by the consuming thread
+	std::deque<Node*>	m_Ready[(int)Priority::COUNT];
+	FrameStats			m_LastFrameStats;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////
+// watches directories on a background thread - inotify on linux, polling modification times elsewhere
+// changes are debounced so an editor writing a file several times in a row only reports it once
+class FileWatcher {
+public:
+
+								FileWatcher			( void ) {}
+								~FileWatcher		( void ) { Stop(); }
+
+	bool						Start				( const std::vector<std::string>& dirs, TimerNanos poll_interval = std::chrono::milliseconds(250) );
+	void						Stop				( void );
+	inline bool					IsRunning			( void ) const { return m_Thread != nullptr; }
+
+	void						NotifyChanged		( std::string_view relative_path, TimerPoint when = std::chrono::steady_clock::now() );
+	std::vector<std::string>	TakeSettledChanges	( TimerNanos quiet_period, TimerPoint now = std::chrono::steady_clock::now() );
+
+private:
+
+	bool						WatchInotify		( void );
+	void						WatchPolling		( void );
+
+	std::thread*						m_Thread = nullptr;
+	std::atomic_bool					m_StopRequested = false;
+	std::vector<std::string>			m_Dirs;
+	TimerNanos							m_PollInterval;
+
+	std::mutex							m_Lock;
+	std::map<std::string, TimerPoint>	m_Changes;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -472,6 +597,7 @@ public:
 		Shader*			p_Shader = nullptr;
 		std::string		m_StartInsert;
 		std::string		m_EndInsert;
+		int				p_Id = -1;
 	};
 
 	struct ShaderGroup {
@@ -499,6 +625,15 @@ public:
 
 	inline void							SetTicksOverride			( int ticks ) { m_Ticks = ticks; }
 	Token								SyncWithMainThread			( void );
+	inline MainThreadQueue&				GetMainThreadQueue			( void ) { return m_MainThreadTasks; }
+
+	bool								EnableShaderHotReload		( bool enable );
+	inline void							SetShaderReloadsPerFrame	( int count ) { m_ShaderReloadsPerFrame = std::max(1, count); }
+	inline const ShaderDependencyGraph&	GetShaderDependencies		( void ) const { return m_ShaderDependencies; }
+	inline int							GetPendingShaderReloads		( void ) const { return (int)m_PendingShaderReloads.size(); }
+	inline void							SetMainThreadBudget			( double milliseconds ) { m_MainThreadBudget = std::chrono::duration_cast<TimerNanos>(std::chrono::duration<double, std::milli>(milliseconds)); }
+	template <class F>
+	static auto							RunOnMainThread				( F&& func, MainThreadQueue::Priority priority = MainThreadQueue::Priority::NORMAL ) { return Singleton().m_MainThreadTasks.Submit(std::forward<F>(func), priority); }
 
 	inline static void					Log							( std::string_view message, ImVec4 col = ImVec4(0.8f, 0.8f, 0.8f, 1) ) { Singleton().ILog(message, col); }
 
@@ -531,13 +666,23 @@ public:
 		bool							m_UsingRandom;
 		bool							m_ReadRequired = false;
 		std::shared_ptr<SSBO>			m_TemporaryFrame; // used for time travel feature
+		bool							m_Stale = false; // its shader was hot reloaded or an entity's layout changed, so the next Prepare builds a new one
+		std::vector<std::string>		m_EntityNames; // entities whose insertions are baked into the shader
 
 		friend class EntityPipeline;
+		friend class Core;
 	public:
 										~CachedPipeline	( void ) { delete m_Pipeline; delete m_UniformBuffer; }
 
 		std::string_view				GetIdentifier	( void ) const { return m_Identifier; }
 		WebGPUPipeline*					GetPipeline		( void ) const { return m_Pipeline; }
+		inline bool						IsStale			( void ) const { return m_Stale; }
+	};
+
+	// a hot reloaded shader that pipelines handed out earlier still point at, deleted once they are all gone
+	struct RetiredShader {
+		Shader*										p_Shader = nullptr;
+		std::vector<std::weak_ptr<CachedPipeline>>	p_Users;
 	};
 
 	void								SDLLoopInner				( void );
@@ -560,8 +705,9 @@ public:
 	static WebGPUSampler*				GetSampler					( WGPUAddressMode mode, WGPUFilterMode filter = WGPUFilterMode_Linear, bool linear_mipmaps = true, unsigned int max_anisotropy = 1 ) { return Singleton().IGetSampler(mode, filter, linear_mipmaps, max_anisotropy); }
 	static void							WaitForCommandsToFinish		( void );
 	inline const auto&					GetPreparedPipelines		( void ) { return m_PreparedPipelines; }
-	inline void							CachePreparedPipeline		( std::shared_ptr<CachedPipeline> pipeline ) { m_PreparedPipelines.push_back({ pipeline }); }
+	inline void							CachePreparedPipeline		( std::shared_ptr<CachedPipeline> pipeline ) { m_PreparedPipelines.push_back({ pipeline }); m_LivePipelines.push_back(pipeline); }
 	void								UnloadPipeline				( std::string_view identifier );
+	void								UnloadPipelinesUsingEntity	( std::string_view entity_name );
 	inline void							UnloadAllPipelines			( void ) { m_PreparedPipelines.clear(); }
 	inline void							UnloadAllPipelinesShaders	( void ) { UnloadAllShaders(); UnloadAllPipelines(); }
 	inline bool							GetPipelinePrepareOnlyMode	( void ) { return m_PrepareOnlyMode; }
@@ -582,7 +728,7 @@ public:
 	static bool							SaveBinary					( const T& item, std::string_view filename ) {
 
 		std::ofstream file;
-		file.open(filename, std::ios::in | std::ios::binary | std::ios::trunc);
+		file.open(std::string(filename), std::ios::in | std::ios::binary | std::ios::trunc);
 		if (!file.is_open()) {
 			return false;
 		}
@@ -602,45 +748,33 @@ public:
 	template <class T>
 	static bool							LoadBinary					( T& item, std::string_view filename ) {
 
-		std::ifstream file(std::string(filename), std::ios::in | std::ios::binary);
-		if (!file.is_open()) {
+		MappedFile file(filename);
+		if (!file.IsValid()) {
 			return false;
 		}
-		std::ostringstream data_stream;
-		data_stream << file.rdbuf();
-		std::string data = data_stream.str();
-
 		Binary::ParseError err;
-		Binary::FromBinary<T>(data, item, err);
+		Binary::FromBinary<T>(file.GetString(), item, err);
 		return !err;
 	}
 
 	template <class T>
 	static bool							LoadJSON					( std::vector<T>& items, std::string_view filename ) {
-		std::ifstream file(std::string(filename), std::ios::in);
-		if (!file.is_open()) {
+		MappedFile file(filename);
+		if (!file.IsValid()) {
 			return false;
 		}
-		std::ostringstream data_stream;
-		data_stream << file.rdbuf();
-		std::string data = data_stream.str();
-
 		Json::ParseError err;
-		Json::FromJson<T>(data, items, err);
+		Json::FromJson<T>(file.GetString(), items, err);
 		return !err;
 	}
 	template <class T>
 	static bool							LoadJSON					( T& item, std::string_view filename ) {
-		std::ifstream file(std::string(filename), std::ios::in);
-		if (!file.is_open()) {
+		MappedFile file(filename);
+		if (!file.IsValid()) {
 			return false;
 		}
-		std::ostringstream data_stream;
-		data_stream << file.rdbuf();
-		std::string data = data_stream.str();
-
 		Json::ParseError err;
-		Json::FromJson<T>(data, item, err);
+		Json::FromJson<T>(file.GetString(), item, err);
 		return !err;
 	}
 
@@ -648,7 +782,7 @@ public:
 	static bool							SaveJSON					( std::vector<T>& items, std::string_view filename ) {
 
 		std::ofstream file;
-		file.open(filename, std::ios::in | std::ios::trunc);
+		file.open(std::string(filename), std::ios::in | std::ios::trunc);
 		if (!file.is_open()) {
 			return false;
 		}
@@ -668,7 +802,7 @@ public:
 	template <class T>
 	static bool							SaveJSON					( T& item, std::string_view filename, bool pretty_print = false ) {
 		std::ofstream file;
-		file.open(filename, std::ios::in | std::ios::trunc);
+		file.open(std::string(filename), std::ios::in | std::ios::trunc);
 		if (!file.is_open()) {
 			return false;
 		}
@@ -730,6 +864,9 @@ private:
 	void								WebGPUErrorCallback			( WGPUErrorType type, std::string message );
 #endif
 	void								EnsureEmbeddableLoaderInit	( void );
+	Shader*								CreateShaderInstance		( std::string_view name, std::string_view start_insert, std::string_view end_insert, bool is_compute, int shader_id, bool& valid );
+	void								ProcessShaderHotReload		( void );
+	bool								ReloadShaderInstance		( int shader_id );
 
 	template<class T, typename P = typename T::Params>
 	inline const ResourceResult<T>		IGetResource				( std::string path, const P& params ) {
@@ -779,14 +916,21 @@ private:
 	TimerPoint							m_FrameTimer;
 	bool								m_FullScreenHover = true;
 	std::thread::id						m_MainThreadId;
-	std::mutex							m_SyncLock;
-	std::atomic_int						m_SyncsRequested = 0;
+	MainThreadQueue						m_MainThreadTasks;
+	TimerNanos							m_MainThreadBudget = std::chrono::milliseconds(4);
 
 	std::ofstream						m_LogFile;
 
 	InterfaceCore						m_Interface;
 	WorkerThreadPool					m_ResourceThreads;
 
+	FileWatcher							m_ShaderWatcher;
+	ShaderDependencyGraph				m_ShaderDependencies;
+	std::deque<int>						m_PendingShaderReloads;
+	int									m_NextShaderId = 0;
+	int									m_ShaderReloadsPerFrame = 2;
+	TimerNanos							m_ShaderReloadDebounce = std::chrono::milliseconds(150);
+
 	std::vector<std::string>													m_ResourceDirs;
 	std::unordered_map<std::string, std::span<const unsigned char>>				m_EmbeddedFiles;
 	std::optional<std::function<std::string(std::string_view, std::string&)>>	m_EmbeddableLoader;
@@ -805,6 +949,8 @@ private:
 #elif defined(NESHNY_WEBGPU)
 	std::vector<ShaderGroup>						m_ShaderGroups;
 	std::vector<std::shared_ptr<CachedPipeline>>	m_PreparedPipelines;
+	std::vector<std::weak_ptr<CachedPipeline>>		m_LivePipelines; // every prepared pipeline, including ones unloaded from the cache but still held elsewhere
+	std::vector<RetiredShader>						m_RetiredShaders;
 	std::map<std::string, WebGPURenderBuffer*>		m_Buffers;
 	std::vector<WebGPUSampler*>						m_Samplers;
 	bool											m_PrepareOnlyMode = false;
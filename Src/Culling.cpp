@@ -0,0 +1,338 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Culling.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+	#define NESHNY_CULL_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// the per bound loops, shared by the flat culls and the grid
+// each writes the index of everything visible to out, which must have room for end - begin, and returns how many it wrote
+// the SSE and scalar versions do the same float operations in the same order, so give identical results
+////////////////////////////////////////////////////////////////////////////////
+namespace CullKernels {
+
+////////////////////////////////////////////////////////////////////////////////
+struct Planes {
+	Planes(const Frustum& frustum) {
+		for (int p = 0; p < 6; p++) {
+			p_NX[p] = (float)frustum.p_Planes[p].x;
+			p_NY[p] = (float)frustum.p_Planes[p].y;
+			p_NZ[p] = (float)frustum.p_Planes[p].z;
+			p_W[p] = (float)frustum.p_Planes[p].w;
+		}
+	}
+	float p_NX[6];
+	float p_NY[6];
+	float p_NZ[6];
+	float p_W[6];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+int Spheres(const Planes& planes, const float* x, const float* y, const float* z, const float* radius, int begin, int end, int* out) {
+	int* write = out;
+	int i = begin;
+#ifdef NESHNY_CULL_SSE
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4) {
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 neg_radius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+		__m128 visible = _mm_cmpeq_ps(zero, zero);
+		for (int p = 0; p < 6; p++) {
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(planes.p_NX[p])), _mm_mul_ps(vy, _mm_set1_ps(planes.p_NY[p]))), _mm_mul_ps(vz, _mm_set1_ps(planes.p_NZ[p]))), _mm_set1_ps(planes.p_W[p]));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(dist, neg_radius));
+		}
+		// branchless compaction - always write, only move on past the ones that are visible
+		int mask = _mm_movemask_ps(visible);
+		*write = i; write += mask & 1;
+		*write = i + 1; write += (mask >> 1) & 1;
+		*write = i + 2; write += (mask >> 2) & 1;
+		*write = i + 3; write += (mask >> 3) & 1;
+	}
+#endif
+	for (; i < end; i++) {
+		bool visible = true;
+		for (int p = 0; p < 6; p++) {
+			float dist = ((x[i] * planes.p_NX[p] + y[i] * planes.p_NY[p]) + z[i] * planes.p_NZ[p]) + planes.p_W[p];
+			visible = visible && (dist >= 0.0f - radius[i]);
+		}
+		*write = i;
+		write += visible ? 1 : 0;
+	}
+	return (int)(write - out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// a box is outside a plane when its corner furthest along the plane normal is, which corner that is only depends on the plane
+int AABBs(const Planes& planes, const AABBBoundsSoA& boxes, int begin, int end, int* out) {
+	const float* corner_x[6];
+	const float* corner_y[6];
+	const float* corner_z[6];
+	for (int p = 0; p < 6; p++) {
+		corner_x[p] = planes.p_NX[p] >= 0.0f ? boxes.p_MaxX.data() : boxes.p_MinX.data();
+		corner_y[p] = planes.p_NY[p] >= 0.0f ? boxes.p_MaxY.data() : boxes.p_MinY.data();
+		corner_z[p] = planes.p_NZ[p] >= 0.0f ? boxes.p_MaxZ.data() : boxes.p_MinZ.data();
+	}
+	int* write = out;
+	int i = begin;
+#ifdef NESHNY_CULL_SSE
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4) {
+		__m128 visible = _mm_cmpeq_ps(zero, zero);
+		for (int p = 0; p < 6; p++) {
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(corner_x[p] + i), _mm_set1_ps(planes.p_NX[p])), _mm_mul_ps(_mm_loadu_ps(corner_y[p] + i), _mm_set1_ps(planes.p_NY[p]))), _mm_mul_ps(_mm_loadu_ps(corner_z[p] + i), _mm_set1_ps(planes.p_NZ[p]))), _mm_set1_ps(planes.p_W[p]));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(dist, zero));
+		}
+		int mask = _mm_movemask_ps(visible);
+		*write = i; write += mask & 1;
+		*write = i + 1; write += (mask >> 1) & 1;
+		*write = i + 2; write += (mask >> 2) & 1;
+		*write = i + 3; write += (mask >> 3) & 1;
+	}
+#endif
+	for (; i < end; i++) {
+		bool visible = true;
+		for (int p = 0; p < 6; p++) {
+			float dist = ((corner_x[p][i] * planes.p_NX[p] + corner_y[p][i] * planes.p_NY[p]) + corner_z[p][i] * planes.p_NZ[p]) + planes.p_W[p];
+			visible = visible && (dist >= 0.0f);
+		}
+		*write = i;
+		write += visible ? 1 : 0;
+	}
+	return (int)(write - out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// splits count items into contiguous chunks, one per thread with the first on the calling thread
+// each chunk writes its results to the start of its own range of out, then they are shuffled down so the result is the same as one thread
+// align moves a chunk boundary onto the next position a chunk is allowed to start at
+template<typename Func, typename Align>
+void RunChunks(int thread_count, int count, std::vector<int>& out, Func&& cull_chunk, Align&& align) {
+	constexpr int MIN_PER_THREAD = 1 << 14;
+	thread_count = std::clamp(std::min(thread_count, count / MIN_PER_THREAD), 1, 64);
+	out.resize(count);
+	std::vector<int> found(thread_count, 0);
+	std::vector<int> starts(thread_count + 1);
+	for (int t = 0; t <= thread_count; t++) {
+		starts[t] = (t == thread_count) ? count : align((int)((int64_t)count * t / thread_count));
+	}
+	ParallelFor(thread_count, [&](int t) { found[t] = cull_chunk(starts[t], starts[t + 1], out.data() + starts[t]); });
+	int total = found[0];
+	for (int t = 1; t < thread_count; t++) {
+		std::memmove(out.data() + total, out.data() + starts[t], found[t] * sizeof(int));
+		total += found[t];
+	}
+	out.resize(total);
+}
+
+} // namespace CullKernels
+
+////////////////////////////////////////////////////////////////////////////////
+Frustum Frustum::FromMatrix(const Matrix4& view_perspective, bool zero_to_one_depth) {
+	// Gribb and Hartmann - clip space x, y and z are each bounded by w, so each plane is the last row plus or minus another
+	const auto& m = view_perspective.m;
+	auto row = [&m](int r) { return Vec4(m[r][0], m[r][1], m[r][2], m[r][3]); };
+	Vec4 w_row = row(3);
+	Frustum frustum;
+	frustum.p_Planes[(int)Plane::LEFT] = w_row + row(0);
+	frustum.p_Planes[(int)Plane::RIGHT] = w_row - row(0);
+	frustum.p_Planes[(int)Plane::BOTTOM] = w_row + row(1);
+	frustum.p_Planes[(int)Plane::TOP] = w_row - row(1);
+	frustum.p_Planes[(int)Plane::NEAR_PLANE] = zero_to_one_depth ? row(2) : w_row + row(2);
+	frustum.p_Planes[(int)Plane::FAR_PLANE] = w_row - row(2);
+	for (auto& plane : frustum.p_Planes) {
+		double len = sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (len > 0.0) {
+			plane = plane * (1.0 / len);
+		}
+	}
+	return frustum;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Frustum::ContainsPoint(Vec3 pos) const {
+	return IntersectsSphere(pos, 0.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Frustum::IntersectsSphere(Vec3 centre, double radius) const {
+	for (int p = 0; p < 6; p++) {
+		if (Distance((Plane)p, centre) < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Frustum::IntersectsAABB(Vec3 min_pos, Vec3 max_pos) const {
+	return ClassifyAABB(min_pos, max_pos) != Result::OUTSIDE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Frustum::Result Frustum::ClassifyAABB(Vec3 min_pos, Vec3 max_pos) const {
+	Result result = Result::INSIDE;
+	for (const auto& plane : p_Planes) {
+		// the corners furthest along and furthest against the normal
+		Vec3 far_corner(plane.x >= 0.0 ? max_pos.x : min_pos.x, plane.y >= 0.0 ? max_pos.y : min_pos.y, plane.z >= 0.0 ? max_pos.z : min_pos.z);
+		Vec3 near_corner(plane.x >= 0.0 ? min_pos.x : max_pos.x, plane.y >= 0.0 ? min_pos.y : max_pos.y, plane.z >= 0.0 ? min_pos.z : max_pos.z);
+		if (plane.x * far_corner.x + plane.y * far_corner.y + plane.z * far_corner.z + plane.w < 0.0) {
+			return Result::OUTSIDE;
+		}
+		if (plane.x * near_corner.x + plane.y * near_corner.y + plane.z * near_corner.z + plane.w < 0.0) {
+			result = Result::INTERSECTING;
+		}
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrustumCullSpheres(const Frustum& frustum, const SphereBoundsSoA& spheres, std::vector<int>& visible, int thread_count) {
+	CullKernels::Planes planes(frustum);
+	CullKernels::RunChunks(thread_count, spheres.Size(), visible, [&planes, &spheres](int begin, int end, int* out) {
+		return CullKernels::Spheres(planes, spheres.p_X.data(), spheres.p_Y.data(), spheres.p_Z.data(), spheres.p_Radius.data(), begin, end, out);
+	}, [](int pos) { return pos; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrustumCullAABBs(const Frustum& frustum, const AABBBoundsSoA& boxes, std::vector<int>& visible, int thread_count) {
+	CullKernels::Planes planes(frustum);
+	CullKernels::RunChunks(thread_count, boxes.Size(), visible, [&planes, &boxes](int begin, int end, int* out) {
+		return CullKernels::AABBs(planes, boxes, begin, end, out);
+	}, [](int pos) { return pos; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CullGrid::CullGrid(double cell_size, int max_cells_per_axis) :
+	m_CellSize(cell_size)
+	,m_MaxCellsPerAxis(std::max(1, max_cells_per_axis))
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CullGrid::Build(const SphereBoundsSoA& spheres) {
+	const int count = spheres.Size();
+	m_Cells.clear();
+	m_Sorted.Clear();
+	m_SortedIndices.clear();
+	if (count <= 0) {
+		return;
+	}
+
+	Vec3 min_pos(spheres.p_X[0], spheres.p_Y[0], spheres.p_Z[0]);
+	Vec3 max_pos = min_pos;
+	for (int i = 1; i < count; i++) {
+		min_pos = Vec3(std::min(min_pos.x, (double)spheres.p_X[i]), std::min(min_pos.y, (double)spheres.p_Y[i]), std::min(min_pos.z, (double)spheres.p_Z[i]));
+		max_pos = Vec3(std::max(max_pos.x, (double)spheres.p_X[i]), std::max(max_pos.y, (double)spheres.p_Y[i]), std::max(max_pos.z, (double)spheres.p_Z[i]));
+	}
+	// past the cap the cells just get bigger than asked for, so a huge world does not end up with millions of cells
+	Vec3 extent = max_pos - min_pos;
+	double cell_size = std::max({ m_CellSize, extent.x / m_MaxCellsPerAxis, extent.y / m_MaxCellsPerAxis, extent.z / m_MaxCellsPerAxis, 1e-6 });
+	double inv_cell_size = 1.0 / cell_size;
+	iVec3 dims(
+		std::clamp((int)(extent.x * inv_cell_size) + 1, 1, m_MaxCellsPerAxis)
+		,std::clamp((int)(extent.y * inv_cell_size) + 1, 1, m_MaxCellsPerAxis)
+		,std::clamp((int)(extent.z * inv_cell_size) + 1, 1, m_MaxCellsPerAxis)
+	);
+
+	// counting sort into cell order
+	std::vector<int> cell_ids(count);
+	std::vector<int> offsets(dims.x * dims.y * dims.z + 1, 0);
+	for (int i = 0; i < count; i++) {
+		int cx = std::min((int)((spheres.p_X[i] - min_pos.x) * inv_cell_size), dims.x - 1);
+		int cy = std::min((int)((spheres.p_Y[i] - min_pos.y) * inv_cell_size), dims.y - 1);
+		int cz = std::min((int)((spheres.p_Z[i] - min_pos.z) * inv_cell_size), dims.z - 1);
+		cell_ids[i] = (cz * dims.y + cy) * dims.x + cx;
+		offsets[cell_ids[i] + 1]++;
+	}
+	for (int c = 1; c < (int)offsets.size(); c++) {
+		offsets[c] += offsets[c - 1];
+	}
+	m_Sorted.p_X.resize(count);
+	m_Sorted.p_Y.resize(count);
+	m_Sorted.p_Z.resize(count);
+	m_Sorted.p_Radius.resize(count);
+	m_SortedIndices.resize(count);
+	std::vector<int> write = offsets;
+	for (int i = 0; i < count; i++) {
+		int dest = write[cell_ids[i]]++;
+		m_Sorted.p_X[dest] = spheres.p_X[i];
+		m_Sorted.p_Y[dest] = spheres.p_Y[i];
+		m_Sorted.p_Z[dest] = spheres.p_Z[i];
+		m_Sorted.p_Radius[dest] = spheres.p_Radius[i];
+		m_SortedIndices[dest] = i;
+	}
+
+	for (int c = 0; c + 1 < (int)offsets.size(); c++) {
+		int start = offsets[c];
+		int cell_count = offsets[c + 1] - start;
+		if (cell_count <= 0) {
+			continue;
+		}
+		Cell cell{ start, cell_count, Vec3(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()), Vec3(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()) };
+		for (int i = start; i < start + cell_count; i++) {
+			double rad = m_Sorted.p_Radius[i];
+			cell.p_Min = Vec3(std::min(cell.p_Min.x, m_Sorted.p_X[i] - rad), std::min(cell.p_Min.y, m_Sorted.p_Y[i] - rad), std::min(cell.p_Min.z, m_Sorted.p_Z[i] - rad));
+			cell.p_Max = Vec3(std::max(cell.p_Max.x, m_Sorted.p_X[i] + rad), std::max(cell.p_Max.y, m_Sorted.p_Y[i] + rad), std::max(cell.p_Max.z, m_Sorted.p_Z[i] + rad));
+		}
+		m_Cells.push_back(cell);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CullGridStats CullGrid::Cull(const Frustum& frustum, std::vector<int>& visible, int thread_count) const {
+	CullKernels::Planes planes(frustum);
+	std::vector<CullGridStats> thread_stats(std::max(1, std::min(thread_count, 64)));
+	std::atomic_int next_stats = 0;
+
+	// chunks are ranges of sorted spheres that only ever split between cells, so no cell writes past the end of its chunk
+	auto first_cell_from = [this](int pos) {
+		return std::lower_bound(m_Cells.begin(), m_Cells.end(), pos, [](const Cell& cell, int start) { return cell.p_Start < start; });
+	};
+	CullKernels::RunChunks(thread_count, GetNumSpheres(), visible, [this, &planes, &frustum, &thread_stats, &next_stats, &first_cell_from](int begin, int end, int* out) {
+		CullGridStats& stats = thread_stats[next_stats++];
+		int* write = out;
+		for (auto cell = first_cell_from(begin); (cell != m_Cells.end()) && (cell->p_Start < end); cell++) {
+			auto result = frustum.ClassifyAABB(cell->p_Min, cell->p_Max);
+			if (result == Frustum::Result::OUTSIDE) {
+				stats.p_CellsOutside++;
+			} else if (result == Frustum::Result::INSIDE) {
+				stats.p_CellsInside++;
+				std::memcpy(write, m_SortedIndices.data() + cell->p_Start, cell->p_Count * sizeof(int));
+				write += cell->p_Count;
+			} else {
+				stats.p_CellsIntersecting++;
+				stats.p_SpheresTested += cell->p_Count;
+				int found = CullKernels::Spheres(planes, m_Sorted.p_X.data(), m_Sorted.p_Y.data(), m_Sorted.p_Z.data(), m_Sorted.p_Radius.data(), cell->p_Start, cell->p_Start + cell->p_Count, write);
+				for (int i = 0; i < found; i++) {
+					write[i] = m_SortedIndices[write[i]];
+				}
+				write += found;
+			}
+		}
+		stats.p_Visible = (int)(write - out);
+		return stats.p_Visible;
+	}, [this, &first_cell_from](int pos) {
+		auto cell = first_cell_from(pos);
+		return cell == m_Cells.end() ? GetNumSpheres() : cell->p_Start;
+	});
+
+	CullGridStats total;
+	for (const auto& stats : thread_stats) {
+		total.p_CellsOutside += stats.p_CellsOutside;
+		total.p_CellsIntersecting += stats.p_CellsIntersecting;
+		total.p_CellsInside += stats.p_CellsInside;
+		total.p_SpheresTested += stats.p_SpheresTested;
+		total.p_Visible += stats.p_Visible;
+	}
+	return total;
+}
+
+} // namespace Neshny
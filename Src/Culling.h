@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// six planes pulled out of a view perspective matrix, each facing inwards so anything inside has a positive distance to all of them
+////////////////////////////////////////////////////////////////////////////////
+struct Frustum {
+
+	enum class Plane {
+		LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE
+	};
+
+	enum class Result {
+		OUTSIDE, INTERSECTING, INSIDE
+	};
+
+	// matrices from Matrix4::Perspective and Matrix4::Ortho clip depth to -1..1, pass zero_to_one_depth for ones that clip to 0..1
+	static Frustum		FromMatrix			( const Matrix4& view_perspective, bool zero_to_one_depth = false );
+
+	inline double		Distance			( Plane plane, Vec3 pos ) const { const Vec4& p = p_Planes[(int)plane]; return p.x * pos.x + p.y * pos.y + p.z * pos.z + p.w; }
+	bool				ContainsPoint		( Vec3 pos ) const;
+	bool				IntersectsSphere	( Vec3 centre, double radius ) const;
+	bool				IntersectsAABB		( Vec3 min_pos, Vec3 max_pos ) const;
+	// INSIDE means everything within the box is visible, so a hierarchy can skip testing what is in it
+	Result				ClassifyAABB		( Vec3 min_pos, Vec3 max_pos ) const;
+
+	std::array<Vec4, 6>	p_Planes;			// normal in xyz, normalised, with the distance from the origin in w
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// bounds in structure of arrays form, so four at a time can be loaded straight into SIMD registers
+struct SphereBoundsSoA {
+	inline void			Add					( Vec3 centre, double radius ) { p_X.push_back((float)centre.x); p_Y.push_back((float)centre.y); p_Z.push_back((float)centre.z); p_Radius.push_back((float)radius); }
+	inline void			Clear				( void ) { p_X.clear(); p_Y.clear(); p_Z.clear(); p_Radius.clear(); }
+	inline int			Size				( void ) const { return (int)p_X.size(); }
+
+	std::vector<float>	p_X;
+	std::vector<float>	p_Y;
+	std::vector<float>	p_Z;
+	std::vector<float>	p_Radius;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct AABBBoundsSoA {
+	inline void			Add					( Vec3 min_pos, Vec3 max_pos ) { p_MinX.push_back((float)min_pos.x); p_MinY.push_back((float)min_pos.y); p_MinZ.push_back((float)min_pos.z); p_MaxX.push_back((float)max_pos.x); p_MaxY.push_back((float)max_pos.y); p_MaxZ.push_back((float)max_pos.z); }
+	inline void			Clear				( void ) { p_MinX.clear(); p_MinY.clear(); p_MinZ.clear(); p_MaxX.clear(); p_MaxY.clear(); p_MaxZ.clear(); }
+	inline int			Size				( void ) const { return (int)p_MinX.size(); }
+
+	std::vector<float>	p_MinX;
+	std::vector<float>	p_MinY;
+	std::vector<float>	p_MinZ;
+	std::vector<float>	p_MaxX;
+	std::vector<float>	p_MaxY;
+	std::vector<float>	p_MaxZ;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// fills visible with the indices of every sphere or box that is at least partly in the frustum, in ascending order
+// the tests are conservative - something just outside a corner where two planes meet can still count as visible
+// the result never depends on thread_count, more threads only help with hundreds of thousands of bounds
+void FrustumCullSpheres	( const Frustum& frustum, const SphereBoundsSoA& spheres, std::vector<int>& visible, int thread_count = 1 );
+void FrustumCullAABBs	( const Frustum& frustum, const AABBBoundsSoA& boxes, std::vector<int>& visible, int thread_count = 1 );
+
+////////////////////////////////////////////////////////////////////////////////
+struct CullGridStats {
+	int		p_CellsOutside = 0;
+	int		p_CellsIntersecting = 0;
+	int		p_CellsInside = 0;
+	int		p_SpheresTested = 0;		// only the ones in cells that straddle a plane get tested one by one
+	int		p_Visible = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// spheres bucketed into a uniform grid, so whole cells can be thrown away or accepted with one box test
+// Build sorts a copy of the bounds into cell order, so it needs calling again whenever they move - build once for static scenery
+// cells outside the frustum cost nothing, cells fully inside are copied across without any per sphere tests
+////////////////////////////////////////////////////////////////////////////////
+class CullGrid {
+public:
+
+							CullGrid			( double cell_size, int max_cells_per_axis = 64 );
+
+	void					Build				( const SphereBoundsSoA& spheres );
+	// the same spheres FrustumCullSpheres finds, ordered by cell instead of by index
+	CullGridStats			Cull				( const Frustum& frustum, std::vector<int>& visible, int thread_count = 1 ) const;
+
+	inline int				GetNumCells			( void ) const { return (int)m_Cells.size(); }
+	inline int				GetNumSpheres		( void ) const { return m_Sorted.Size(); }
+
+private:
+
+	struct Cell {
+		int		p_Start;
+		int		p_Count;
+		Vec3	p_Min;					// bounds of the spheres in the cell, not of the cell itself
+		Vec3	p_Max;
+	};
+
+	double					m_CellSize;
+	int						m_MaxCellsPerAxis;
+	std::vector<Cell>		m_Cells;			// only the ones with something in them
+	SphereBoundsSoA			m_Sorted;
+	std::vector<int>		m_SortedIndices;	// original index of each sorted sphere
+};
+
+} // namespace Neshny
@@ -3,77 +3,75 @@
 
 namespace Neshny {
 
-#if defined(NESHNY_WEBGPU)
-
 ////////////////////////////////////////////////////////////////////////////////
-BaseSimpleRender::BaseSimpleRender(void) {
+Vec3 BaseSimpleRender::PointJitter(Vec3 pos, int line_index) {
+	// splitmix64 over the position bits, so the jitter stays put as other points come and go
+	uint64_t state = HashMemory((unsigned char*)&pos, sizeof(Vec3)) + uint64_t(line_index) * 0x9E3779B97F4A7C15ull;
+	auto next = [&state]() {
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		z = z ^ (z >> 31);
+		return double(z >> 11) * (1.0 / double(1ull << 53)) - 0.5;
+	};
+	double x = next();
+	double y = next();
+	double z = next();
+	return Vec3(x, y, z);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-BaseSimpleRender::~BaseSimpleRender(void) {
-	delete m_Uniforms;
-	delete m_CircleBuffer;
+BaseSimpleRender::GeometryBatcher::DirtyRange BaseSimpleRender::GeometryBatcher::Diff(const std::vector<RenderVertex>& previous, const std::vector<RenderVertex>& current) {
+
+	const int shared = (int)std::min(previous.size(), current.size());
+	int first = 0;
+	while ((first < shared) && (memcmp(&previous[first], &current[first], sizeof(RenderVertex)) == 0)) {
+		first++;
+	}
+	if (previous.size() != current.size()) {
+		// anything after a resize is uploaded up to the new end
+		return DirtyRange{ first, (int)current.size() - first };
+	}
+	if (first == shared) {
+		return DirtyRange{ 0, 0 };
+	}
+	int last = shared - 1;
+	while ((last > first) && (memcmp(&previous[last], &current[last], sizeof(RenderVertex)) == 0)) {
+		last--;
+	}
+	return DirtyRange{ first, last - first + 1 };
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void BaseSimpleRender::IRender(WebGPURTT& rtt, const Matrix4& view_perspective, int width, int height, Vec3 offset, double scale, double point_size) {
+void BaseSimpleRender::GeometryBatcher::Build(const std::vector<SimpleLine>& lines, const std::vector<SimplePoint>& points, const std::vector<SimpleTriangle>& triangles, const std::vector<SimpleCircle>& circles, const std::vector<SimpleSquare>& squares, Vec3 offset, double scale, double point_size) {
 
-	struct RenderPoint {
-		fVec4	p_Pos;
-		fVec4	p_Col;
-	};
-	std::vector<RenderPoint> simple_lines;
-	std::vector<RenderPoint> simple_circles;
-	std::vector<RenderPoint> simple_triangles;
-
-	for (WebGPUBuffer* prev_buffer : m_PreviousFrameBuffers) {
-		delete prev_buffer;
-	}
-	m_PreviousFrameBuffers.clear();
-	int msaa_samples = rtt.GetMSAASamples();
-	if (m_MSAASamples != msaa_samples) {
-		m_MSAASamples = msaa_samples;
-		m_LinePipeline = nullptr;
+	auto& simple_lines = m_Scratch[BATCH_LINES];
+	auto& simple_triangles = m_Scratch[BATCH_TRIANGLES];
+	auto& simple_circles = m_Scratch[BATCH_CIRCLES];
+	for (auto& scratch : m_Scratch) {
+		scratch.clear();
 	}
 
-	auto gpu_vp = view_perspective.ToGPU();
-
-	simple_lines.reserve(m_Lines.size() * 2);
-	simple_circles.reserve(m_Circles.size());
-	Vec2 offset2d(offset.x, offset.y);
-	for (const auto& line : m_Lines) {
+	simple_lines.reserve(lines.size() * 2 + points.size() * 4);
+	simple_circles.reserve(circles.size());
+	for (const auto& line : lines) {
 		simple_lines.push_back({ fVec4(((line.p_A - offset) * scale).ToFloat3(), 1.0), line.p_Col.ToFloat4() });
 		simple_lines.push_back({ fVec4(((line.p_B - offset) * scale).ToFloat3(), 1.0), line.p_Col.ToFloat4() });
 	}
-	for (const auto& circle : m_Circles) {
+	for (const auto& circle : circles) {
 		simple_circles.push_back({ fVec4((circle.p_Pos.x - offset.x) * scale, (circle.p_Pos.y - offset.y) * scale, circle.p_Radius * scale, circle.p_Radius * scale), circle.p_Col.ToFloat4() });
 	}
-	for (auto it = m_Points.begin(); it != m_Points.end(); it++) {
-
+	for (const auto& point : points) {
 		// TODO: use on_top
-		//if (it->p_OnTop) {
-		//} else {
-		//}
-		Vec3 dpos = (it->p_Pos - offset) * scale;
-
+		fVec4 col = point.p_Col.ToFloat4();
+		fVec4 center = fVec4(((point.p_Pos - offset) * scale).ToFloat3(), 1.0);
 		for (int i = 0; i < 2; i++) {
-			Vec3 off = (it->p_Pos - offset + Vec3(Random() - 0.5, Random() - 0.5, Random() - 0.5) * point_size) * scale;
-			simple_lines.push_back({ fVec4(it->p_Pos.ToFloat3(), 1.0), it->p_Col.ToFloat4() });
-			simple_lines.push_back({ fVec4(off.ToFloat3(), 1.0), it->p_Col.ToFloat4() });
-		}
-		if (it->p_Str.size() <= 0) {
-			continue;
-		}
-		fVec3 result = gpu_vp * fVec3(dpos.x, dpos.y, dpos.z);
-		if (result.z > 1) {
-			continue;
+			Vec3 off = (point.p_Pos - offset + PointJitter(point.p_Pos, i) * point_size) * scale;
+			simple_lines.push_back({ center, col });
+			simple_lines.push_back({ fVec4(off.ToFloat3(), 1.0), col });
 		}
-		int x = (int)floor((result.x + 1.0) * 0.5 * width);
-		int y = (int)floor((1.0 - result.y) * 0.5 * height);
-		ImGui::SetCursorPos(ImVec2(x, y));
-		ImGui::Text(it->p_Str.c_str());
 	}
-	for (const auto& square: m_Squares) {
+	for (const auto& square: squares) {
 		fVec4 col = square.p_Col.ToFloat4();
 		fVec4 pos_a = fVec4(((square.p_MinPos - offset) * scale).ToFloat3(), 1.0);
 		fVec4 pos_c = fVec4(((square.p_MaxPos - offset) * scale).ToFloat3(), 1.0);
@@ -95,20 +93,91 @@ void BaseSimpleRender::IRender(WebGPURTT& rtt, const Matrix4& view_perspective,
 			simple_lines.push_back({ pos_d, col }); simple_lines.push_back({ pos_a, col });
 		}
 	}
-	for (const auto& triangle: m_Triangles) {
+	for (const auto& triangle: triangles) {
 		auto col = triangle.p_Col.ToFloat4();
 		simple_triangles.push_back({ fVec4(((triangle.p_A - offset) * scale).ToFloat3(), 1.0), col });
 		simple_triangles.push_back({ fVec4(((triangle.p_B - offset) * scale).ToFloat3(), 1.0), col });
 		simple_triangles.push_back({ fVec4(((triangle.p_C - offset) * scale).ToFloat3(), 1.0), col });
 	}
 
-	m_LineBuffer.Init({ WGPUVertexFormat_Float32x4, WGPUVertexFormat_Float32x4 }, WGPUPrimitiveTopology_LineList, (unsigned char*)simple_lines.data(), (int)simple_lines.size() * sizeof(RenderPoint));
-	m_TriangleBuffer.Init({ WGPUVertexFormat_Float32x4, WGPUVertexFormat_Float32x4 }, WGPUPrimitiveTopology_TriangleList, (unsigned char*)simple_triangles.data(), (int)simple_triangles.size() * sizeof(RenderPoint));
+	for (int batch = 0; batch < BATCH_COUNT; batch++) {
+		m_Dirty[batch] = Diff(m_Vertices[batch], m_Scratch[batch]);
+		std::swap(m_Vertices[batch], m_Scratch[batch]);
+	}
+}
+
+#if defined(NESHNY_WEBGPU)
+
+////////////////////////////////////////////////////////////////////////////////
+BaseSimpleRender::BaseSimpleRender(void) {
+}
+
+////////////////////////////////////////////////////////////////////////////////
+BaseSimpleRender::~BaseSimpleRender(void) {
+	delete m_Uniforms;
+	delete m_CircleBuffer;
+	for (WebGPUBuffer* buffer : m_TextureUniforms) {
+		delete buffer;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void BaseSimpleRender::IRender(WebGPURTT& rtt, const Matrix4& view_perspective, int width, int height, Vec3 offset, double scale, double point_size) {
+
+	int msaa_samples = rtt.GetMSAASamples();
+	if (m_MSAASamples != msaa_samples) {
+		m_MSAASamples = msaa_samples;
+		m_LinePipeline = nullptr;
+	}
+
+	auto gpu_vp = view_perspective.ToGPU();
+
+	// the retained primitives are only re-batched when they or the transform change, and then only changed ranges are uploaded
+	bool rebuild = m_Dirty || !(m_BuiltOffset == offset) || (m_BuiltScale != scale) || (m_BuiltPointSize != point_size);
+	if (rebuild) {
+		m_Batcher.Build(m_Lines, m_Points, m_Triangles, m_Circles, m_Squares, offset, scale, point_size);
+		m_Dirty = false;
+		m_BuiltOffset = offset;
+		m_BuiltScale = scale;
+		m_BuiltPointSize = point_size;
+	}
+
+	for (auto it = m_Points.begin(); it != m_Points.end(); it++) {
+		if (it->p_Str.size() <= 0) {
+			continue;
+		}
+		Vec3 dpos = (it->p_Pos - offset) * scale;
+		fVec3 result = gpu_vp * fVec3(dpos.x, dpos.y, dpos.z);
+		if (result.z > 1) {
+			continue;
+		}
+		int x = (int)floor((result.x + 1.0) * 0.5 * width);
+		int y = (int)floor((1.0 - result.y) * 0.5 * height);
+		ImGui::SetCursorPos(ImVec2(x, y));
+		ImGui::Text(it->p_Str.c_str());
+	}
 
 	if (!m_Uniforms) {
 		// TODO: this throws an error for one frame due to buffers being empty at first
 		m_Uniforms = new WebGPUBuffer(WGPUBufferUsage_Uniform, nullptr, sizeof(fMatrix4));
 		m_CircleBuffer = new WebGPUBuffer(WGPUBufferUsage_Storage);
+		m_LineBuffer.Init({ WGPUVertexFormat_Float32x4, WGPUVertexFormat_Float32x4 }, WGPUPrimitiveTopology_LineList, nullptr, 0);
+		m_TriangleBuffer.Init({ WGPUVertexFormat_Float32x4, WGPUVertexFormat_Float32x4 }, WGPUPrimitiveTopology_TriangleList, nullptr, 0);
+	}
+	if (rebuild) {
+		auto upload = [this](BatchType batch, auto&& write) {
+			auto range = m_Batcher.GetDirtyRange(batch);
+			const auto& verts = m_Batcher.GetVertices(batch);
+			write(range.p_Count > 0 ? (unsigned char*)&verts[range.p_Start] : nullptr, range.p_Start * (int)sizeof(RenderVertex), range.p_Count * (int)sizeof(RenderVertex), (int)verts.size());
+		};
+		upload(BATCH_LINES, [this](unsigned char* data, int offset_bytes, int size_bytes, int total) { m_LineBuffer.UpdateVertices(data, offset_bytes, size_bytes, total); });
+		upload(BATCH_TRIANGLES, [this](unsigned char* data, int offset_bytes, int size_bytes, int total) { m_TriangleBuffer.UpdateVertices(data, offset_bytes, size_bytes, total); });
+		upload(BATCH_CIRCLES, [this](unsigned char* data, int offset_bytes, int size_bytes, int total) {
+			m_CircleBuffer->EnsureSizeBytes(total * (int)sizeof(RenderVertex), false);
+			if (size_bytes > 0) {
+				m_CircleBuffer->Write(data, offset_bytes, size_bytes);
+			}
+		});
 	}
 	if (!m_LinePipeline) {
 		m_LinePipeline = std::make_unique<WebGPUPipeline>();
@@ -133,32 +202,39 @@ void BaseSimpleRender::IRender(WebGPURTT& rtt, const Matrix4& view_perspective,
 			.AddSampler(*Core::GetSampler(WGPUAddressMode_Repeat, WGPUFilterMode_Nearest))
 			.FinalizeRender("SimpleTexture", *Core::GetBuffer("Square"), {}, msaa_samples);
 	}
-	m_CircleBuffer->EnsureSizeBytes((int)simple_circles.size() * sizeof(RenderPoint));
-	m_CircleBuffer->SetValues(simple_circles);
 
 	wgpuQueueWriteBuffer(Core::Singleton().GetWebGPUQueue(), m_Uniforms->Get(), 0, &gpu_vp, sizeof(fMatrix4));
 
 	rtt.Render(m_LinePipeline.get());
 	rtt.Render(m_TrianglePipeline.get());
-	rtt.Render(m_CirclePipeline.get(), (int)m_Circles.size());
+	rtt.Render(m_CirclePipeline.get(), (int)m_Batcher.GetVertices(BATCH_CIRCLES).size());
 
 	for (auto& text: m_Texts) {
 		ImGui::SetCursorPos(ImVec2(text.p_Pos.x, text.p_Pos.y));
 		ImGuiTextColoredUnformatted(text.p_Text, ImVec4(text.p_Col.x, text.p_Col.y, text.p_Col.z, text.p_Col.w));
 	}
 
-	// TODO: sort by texture name and render in batches
+	// grouped by texture so the bound texture only changes once per distinct texture
+	std::vector<std::pair<const WebGPUTexture*, const SimpleTexture*>> textured;
+	textured.reserve(m_Textures.size());
 	for (const auto& tex : m_Textures) {
 		const WebGPUTexture* texture = nullptr;
 		if (std::holds_alternative<std::string>(tex.p_Texture)) {
 			auto texture_res = Core::GetResource<Texture2D>(std::get<std::string>(tex.p_Texture));
 			if (!texture_res.IsValid()) {
-				return;
+				continue;
 			}
 			texture = &(texture_res->Get());
 		} else {
 			texture = std::get<WebGPUTexture*>(tex.p_Texture);
 		}
+		textured.push_back({ texture, &tex });
+	}
+	std::stable_sort(textured.begin(), textured.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	const WebGPUTexture* bound_texture = nullptr;
+	for (int i = 0; i < (int)textured.size(); i++) {
+		const auto& tex = *textured[i].second;
 		Matrix4 modded = Matrix4::Identity();
 
 		Vec3 center = (tex.p_MaxPos + tex.p_MinPos) * 0.5;
@@ -170,12 +246,16 @@ void BaseSimpleRender::IRender(WebGPURTT& rtt, const Matrix4& view_perspective,
 		modded = view_perspective * modded;
 		auto new_gpu = modded.ToGPU();
 
-		WebGPUBuffer* uniform_mat = new WebGPUBuffer(WGPUBufferUsage_Uniform, nullptr, sizeof(fMatrix4));
+		if (i >= (int)m_TextureUniforms.size()) {
+			m_TextureUniforms.push_back(new WebGPUBuffer(WGPUBufferUsage_Uniform, nullptr, sizeof(fMatrix4)));
+		}
+		WebGPUBuffer* uniform_mat = m_TextureUniforms[i];
 		wgpuQueueWriteBuffer(Core::Singleton().GetWebGPUQueue(), uniform_mat->Get(), 0, &new_gpu, sizeof(fMatrix4));
 
-		m_PreviousFrameBuffers.push_back(uniform_mat);
-
-		m_TexturePipeline->ReplaceTexture(0, texture->GetTextureView());
+		if (textured[i].first != bound_texture) {
+			bound_texture = textured[i].first;
+			m_TexturePipeline->ReplaceTexture(0, bound_texture->GetTextureView());
+		}
 		m_TexturePipeline->ReplaceBuffer(0, *uniform_mat);
 		rtt.Render(m_TexturePipeline.get());
 	}
@@ -232,7 +312,7 @@ void BaseSimpleRender::IRender(const Matrix4 & view_perspective, int width, int
 		glUniform4f(debug_prog->GetUniform("uColor"), it->p_Col.x, it->p_Col.y, it->p_Col.z, it->p_Col.w);
 		glUniform3f(debug_prog->GetUniform("uPosA"), dpos.x, dpos.y, dpos.z);
 		for (int i = 0; i < 2; i++) {
-			Vec3 off = (it->p_Pos - offset + Vec3(Random() - 0.5, Random() - 0.5, Random() - 0.5) * point_size) * scale;
+			Vec3 off = (it->p_Pos - offset + PointJitter(it->p_Pos, i) * point_size) * scale;
 			glUniform3f(debug_prog->GetUniform("uPosB"), off.x, off.y, off.z);
 			line_buffer->Draw();
 		}
@@ -363,6 +443,9 @@ void InfoViewer::IRenderImGui(InterfaceInfoViewer& data) {
 		timings.clear();
 	}
 
+	auto queue_stats = Core::Singleton().GetMainThreadQueue().GetLastFrameStats();
+	ImGui::Text("Main thread tasks: %i submitted, %i executed, %i still pending, %.3f ms, max wait %.3f ms", queue_stats.p_Submitted, queue_stats.p_Executed, queue_stats.p_Remaining, queue_stats.p_Milliseconds, queue_stats.p_MaxLatencyMilliseconds);
+
 	ImGui::Text("End-to-end frame loop histogram");
 
 	if (ImGui::BeginTable("##SegmentTable", (int)m_LoopHistogram.size() + 2, ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV)) {
@@ -395,6 +478,19 @@ void InfoViewer::IRenderImGui(InterfaceInfoViewer& data) {
 		ImGui::EndTable();
 	}
 
+	auto frame_stats = FrameStats::Singleton().GetSnapshot();
+	auto show_summary = [](const FrameStatsSummary& summary) {
+		ImGui::Text("%s: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms, %lld over budget", summary.p_Name.c_str(), summary.p_P50Ms, summary.p_P95Ms, summary.p_P99Ms, summary.p_MaxMs, (long long)summary.p_Spikes);
+	};
+	show_summary(frame_stats.p_Frame);
+	for (const auto& summary : frame_stats.p_Subsystems) {
+		show_summary(summary);
+	}
+#ifdef NESHNY_WEBGPU
+	const auto& staging = WebGPUBuffer::GetStagingPool().GetStats();
+	ImGui::Text("Staging: %lld reads in %lld maps, %d buffers (%d free, %d in flight), %.2f MB, %lld created, %lld reused", (long long)staging.p_Reads, (long long)staging.p_Maps, staging.p_LiveBlocks, staging.p_FreeBlocks, staging.p_InFlightBlocks, (double)staging.p_LiveBytes / (1024.0 * 1024.0), (long long)staging.p_BlocksCreated, (long long)staging.p_BlocksReused);
+#endif
+
 	int64_t total_nanos = 0;
 	for (auto iter = timings.begin(); iter != timings.end(); iter++) {
 		total_nanos += iter->p_Nanos;
@@ -516,7 +612,7 @@ void BufferViewer::ICheckpoint(std::string_view stage, GPUEntity& buffer) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::shared_ptr<SSBO> BufferViewer::IGetStoredFrameAt(std::string_view name, int tick, int& count) {
+std::shared_ptr<SSBO> BufferViewer::IGetStoredFrameAt(std::string_view name, int tick, int& count, int soa_stride) {
 
 	auto existing = m_Frames.find(std::string(name));
 	if (existing == m_Frames.end()) {
@@ -528,6 +624,13 @@ std::shared_ptr<SSBO> BufferViewer::IGetStoredFrameAt(std::string_view name, int
 #if defined(NESHNY_GL)
 			return std::make_shared<SSBO>(existing->second.p_StructSize * frame.p_Count + (int)sizeof(int) * ENTITY_OFFSET_INTS, frame.p_Data.get()); // TODO: cache this if it's not performant
 #elif defined(NESHNY_WEBGPU)
+			if (soa_stride > 0) {
+				int floats_per = existing->second.p_StructSize / (int)sizeof(int);
+				std::vector<int> soa(ENTITY_OFFSET_INTS + floats_per * soa_stride, 0);
+				memcpy(soa.data(), frame.p_Data.get(), sizeof(int) * ENTITY_OFFSET_INTS);
+				TransposeEntityToSoA((int*)frame.p_Data.get() + ENTITY_OFFSET_INTS, soa.data() + ENTITY_OFFSET_INTS, std::min(frame.p_Count, soa_stride), floats_per, soa_stride);
+				return std::make_shared<SSBO>(WGPUBufferUsage_Storage, (unsigned char*)soa.data(), (int)soa.size() * sizeof(int));
+			}
 			return std::make_shared<SSBO>(WGPUBufferUsage_Storage, frame.p_Data.get(), existing->second.p_StructSize * frame.p_Count + (int)sizeof(int) * ENTITY_OFFSET_INTS); // TODO: cache this if it's not performant
 #endif
 		}
@@ -1169,6 +1272,93 @@ void ResourceViewer::RenderImGui(InterfaceResourceViewer& data) {
 	ImGui::End();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void MemoryViewer::IRenderImGui(InterfaceMemoryViewer& data) {
+
+	if (!data.p_Visible) {
+		return;
+	}
+	ImGui::Begin("Memory Viewer", &data.p_Visible, ImGuiWindowFlags_NoCollapse);
+
+	if (!AllocationTracker::IsCompiledIn()) {
+		ImGui::Text("Allocations are only tracked when built with NESHNY_TRACK_ALLOCATIONS");
+		ImGui::End();
+		return;
+	}
+
+	const double to_mb = 1.0 / (1024.0 * 1024.0);
+	auto snapshot = AllocationTracker::GetSnapshot();
+	ImGui::Text("Live: %.2f MB in %lld allocations", (double)snapshot.p_LiveBytes * to_mb, (long long)snapshot.p_LiveAllocations);
+	if (ImGui::Button("Take Baseline")) {
+		m_Baseline = snapshot;
+		data.p_ShowDiff = true;
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Change Since Baseline", &data.p_ShowDiff);
+	ImGui::SameLine();
+	if (ImGui::Button("Reset Peaks")) {
+		AllocationTracker::ResetPeaks();
+	}
+	const MemorySnapshot shown = data.p_ShowDiff ? AllocationTracker::Diff(m_Baseline, snapshot) : snapshot;
+
+	ImGuiTableFlags table_flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV;
+	if (ImGui::BeginTable("##MemoryTable", 7, table_flags, ImVec2(0, 300))) {
+		ImGui::TableSetupScrollFreeze(1, 1);
+
+		ImGui::TableSetupColumn("Tag", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Live MB", ImGuiTableColumnFlags_WidthFixed, 80);
+		ImGui::TableSetupColumn("Peak MB", ImGuiTableColumnFlags_WidthFixed, 80);
+		ImGui::TableSetupColumn("Live Count", ImGuiTableColumnFlags_WidthFixed, 90);
+		ImGui::TableSetupColumn("Allocations", ImGuiTableColumnFlags_WidthFixed, 90);
+		ImGui::TableSetupColumn("Allocated MB", ImGuiTableColumnFlags_WidthFixed, 90);
+		ImGui::TableSetupColumn("Samples", ImGuiTableColumnFlags_WidthFixed, 70);
+		ImGui::TableHeadersRow();
+
+		for (int tag = 0; tag < (int)shown.p_Tags.size(); tag++) {
+			const auto& stats = shown.p_Tags[tag];
+			if ((stats.p_Allocations == 0) && (stats.p_LiveBytes == 0)) {
+				continue;
+			}
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%s", stats.p_Name.c_str());
+			ImGui::TableSetColumnIndex(1);
+			ImGuiTextColoredUnformatted(std::format("{:.3f}", (double)stats.p_LiveBytes * to_mb), (data.p_ShowDiff && (stats.p_LiveBytes > 0)) ? ImVec4(1.0f, 0.6f, 0.3f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.3f", (double)stats.p_PeakBytes * to_mb);
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%lld", (long long)stats.p_LiveAllocations);
+			ImGui::TableSetColumnIndex(4);
+			ImGui::Text("%lld", (long long)stats.p_Allocations);
+			ImGui::TableSetColumnIndex(5);
+			ImGui::Text("%.3f", (double)stats.p_AllocatedBytes * to_mb);
+			ImGui::TableSetColumnIndex(6);
+			if (ImGui::Button(std::format("Show##{}", tag).c_str())) {
+				m_SampleTag = tag;
+				m_Samples = AllocationTracker::GetLiveSamples(tag);
+				m_SelectedStack.clear();
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	if ((m_SampleTag >= 0) && (m_SampleTag < (int)snapshot.p_Tags.size())) {
+		ImGui::Text("%i sampled allocations still live in %s, oldest first", (int)m_Samples.size(), snapshot.p_Tags[m_SampleTag].p_Name.c_str());
+		ImGui::BeginChild("Samples", ImVec2(0, 150), true);
+		for (const auto& sample : m_Samples) {
+			if (ImGui::Selectable(std::format("#{} - {} bytes##{}", sample.p_Sequence, sample.p_Size, sample.p_Sequence).c_str())) {
+				m_SelectedStack = AllocationTracker::DescribeFrames(sample.p_Frames);
+			}
+		}
+		ImGui::EndChild();
+		for (const auto& frame : m_SelectedStack) {
+			ImGui::TextUnformatted(frame.c_str());
+		}
+	}
+
+	ImGui::End();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 Token Scrapbook2D::ActivateRTT(void) {
 	auto& self = Singleton();
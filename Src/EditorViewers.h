@@ -14,20 +14,18 @@ class BaseSimpleRender {
 
 public:
 
-    inline void									AddLine             ( Vec3 a, Vec3 b, Vec4 color = Vec4(1.0, 1.0, 1.0, 1.0), bool on_top = false ) { m_Lines.push_back(SimpleLine{a, b, color, on_top}); }
-    inline void									AddPoint            ( Vec3 pos, Vec4 color = Vec4(1.0, 1.0, 1.0, 1.0), bool on_top = false ) { m_Points.push_back(SimplePoint{pos, std::string(""), color, on_top}); }
-    inline void									AddPoint            ( Vec3 pos, std::string_view text, Vec4 color, bool on_top = true ) { m_Points.push_back(SimplePoint{pos, std::string(text), color, on_top}); }
-    inline void									AddTriangle         ( Vec3 a, Vec3 b, Vec3 c, Vec4 color ) { m_Triangles.push_back(SimpleTriangle{a, b, c, color}); }
-    inline void									AddCircle			( Vec3 a, double radius, Vec4 color, bool filled = false ) { m_Circles.push_back(SimpleCircle{a, radius, color, filled}); }
-    inline void									AddSquare			( Vec3 min_pos, Vec3 max_pos, Vec4 color, bool filled = false ) { m_Squares.push_back(SimpleSquare{min_pos, max_pos, color, filled}); }
+    inline void									AddLine             ( Vec3 a, Vec3 b, Vec4 color = Vec4(1.0, 1.0, 1.0, 1.0), bool on_top = false ) { m_Lines.push_back(SimpleLine{a, b, color, on_top}); m_Dirty = true; }
+    inline void									AddPoint            ( Vec3 pos, Vec4 color = Vec4(1.0, 1.0, 1.0, 1.0), bool on_top = false ) { m_Points.push_back(SimplePoint{pos, std::string(""), color, on_top}); m_Dirty = true; }
+    inline void									AddPoint            ( Vec3 pos, std::string_view text, Vec4 color, bool on_top = true ) { m_Points.push_back(SimplePoint{pos, std::string(text), color, on_top}); m_Dirty = true; }
+    inline void									AddTriangle         ( Vec3 a, Vec3 b, Vec3 c, Vec4 color ) { m_Triangles.push_back(SimpleTriangle{a, b, c, color}); m_Dirty = true; }
+    inline void									AddCircle			( Vec3 a, double radius, Vec4 color, bool filled = false ) { m_Circles.push_back(SimpleCircle{a, radius, color, filled}); m_Dirty = true; }
+    inline void									AddSquare			( Vec3 min_pos, Vec3 max_pos, Vec4 color, bool filled = false ) { m_Squares.push_back(SimpleSquare{min_pos, max_pos, color, filled}); m_Dirty = true; }
     inline void									AddTexture			( Vec3 min_pos, Vec3 max_pos, std::string_view filename ) { m_Textures.push_back(SimpleTexture{min_pos, max_pos, std::string(filename) }); }
 #if defined(NESHNY_WEBGPU)
     inline void									AddTexture			( Vec3 min_pos, Vec3 max_pos, WebGPUTexture* texture ) { m_Textures.push_back(SimpleTexture{min_pos, max_pos, texture }); }
 #endif
 	void										AddText				( std::string_view text, Vec2 pos, Vec4 color ) { m_Texts.push_back(SimpleText{ std::string(text), pos, color }); }
 
-protected:
-
 	struct SimplePoint {
 		Vec3 p_Pos;
 		std::string p_Str;
@@ -74,12 +72,54 @@ protected:
 #endif
 	};
 
+	struct RenderVertex {
+		fVec4	p_Pos;
+		fVec4	p_Col;
+	};
+
+	enum BatchType {
+		BATCH_LINES,
+		BATCH_TRIANGLES,
+		BATCH_CIRCLES, // one vertex per instance, xy position and zw radius
+		BATCH_COUNT
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// CPU stage of the render, builds one vertex list per batch type and diffs it against the previous build
+	// so that only the range that actually changed has to be uploaded
+	class GeometryBatcher {
+	public:
+
+		struct DirtyRange {
+			int		p_Start = 0;
+			int		p_Count = 0; // in vertices, zero if nothing changed
+		};
+
+		void									Build				( const std::vector<SimpleLine>& lines, const std::vector<SimplePoint>& points, const std::vector<SimpleTriangle>& triangles, const std::vector<SimpleCircle>& circles, const std::vector<SimpleSquare>& squares, Vec3 offset, double scale, double point_size );
+		inline const std::vector<RenderVertex>&	GetVertices			( BatchType batch ) const { return m_Vertices[batch]; }
+		inline DirtyRange						GetDirtyRange		( BatchType batch ) const { return m_Dirty[batch]; }
+		inline bool								IsDirty				( void ) const { for (const auto& range : m_Dirty) { if (range.p_Count > 0) return true; } return false; }
+
+		static DirtyRange						Diff				( const std::vector<RenderVertex>& previous, const std::vector<RenderVertex>& current );
+
+	private:
+
+		std::array<std::vector<RenderVertex>, BATCH_COUNT>	m_Vertices;
+		std::array<std::vector<RenderVertex>, BATCH_COUNT>	m_Scratch;
+		std::array<DirtyRange, BATCH_COUNT>					m_Dirty;
+	};
+
+	// deterministic per point so a static scene produces identical vertices every frame, each component is in [-0.5, 0.5)
+	static Vec3									PointJitter			( Vec3 pos, int line_index );
+
+protected:
+
 #if defined(NESHNY_WEBGPU)
 	void										IRender				( WebGPURTT& rtt, const Matrix4& view_perspective, int width, int height, Vec3 offset, double scale, double point_size = 1.0 );
 #elif defined(NESHNY_GL)
 	void										IRender				( const Matrix4& view_perspective, int width, int height, Vec3 offset, double scale, double point_size = 1.0 );
 #endif
-	inline void									IClear		        ( void ) { m_Lines.clear(); m_Points.clear(); m_Triangles.clear(); m_Circles.clear(); m_Squares.clear(); m_Textures.clear(); m_Texts.clear(); }
+	inline void									IClear		        ( void ) { m_Lines.clear(); m_Points.clear(); m_Triangles.clear(); m_Circles.clear(); m_Squares.clear(); m_Textures.clear(); m_Texts.clear(); m_Dirty = true; }
 
 												BaseSimpleRender	( void );
 												~BaseSimpleRender	( void );
@@ -91,6 +131,13 @@ protected:
 	std::vector<SimpleSquare>					m_Squares;
 	std::vector<SimpleTexture>					m_Textures;
 	std::vector<SimpleText>						m_Texts;
+
+	// set whenever the retained primitives change, along with the transform they were last built with
+	bool										m_Dirty = true;
+	Vec3										m_BuiltOffset;
+	double										m_BuiltScale = 0.0;
+	double										m_BuiltPointSize = 0.0;
+	GeometryBatcher								m_Batcher;
 	
 #if defined(NESHNY_WEBGPU)
 	WebGPUBuffer*								m_Uniforms = nullptr;
@@ -104,7 +151,7 @@ protected:
 	std::unique_ptr<WebGPUPipeline>				m_CirclePipeline;
 	std::unique_ptr<WebGPUPipeline>				m_TexturePipeline;
 
-	std::vector<WebGPUBuffer*>					m_PreviousFrameBuffers;
+	std::vector<WebGPUBuffer*>					m_TextureUniforms; // reused across frames, one per texture drawn
 	int											m_MSAASamples = 0;
 
 #endif
@@ -236,7 +283,8 @@ public:
 
 	void								RenderImGui			( InterfaceBufferViewer& data );
 
-	static inline std::shared_ptr<SSBO> GetStoredFrameAt	( std::string_view name, int tick, int& count ) { return Singleton().IGetStoredFrameAt(name, tick, count); }
+	// soa_stride is non-zero when the frame is for an SOA entity, frames are stored as AOS so will be transposed back
+	static inline std::shared_ptr<SSBO> GetStoredFrameAt	( std::string_view name, int tick, int& count, int soa_stride = 0 ) { return Singleton().IGetStoredFrameAt(name, tick, count, soa_stride); }
 
 	static inline void					Highlight			( std::string_view name, int id ) { Singleton().IHighlight(name, id); }
 	static inline void					ClearHighlight		( void ) { Singleton().IHighlight(std::string(), -1); }
@@ -265,7 +313,7 @@ protected:
 
 	void					ICheckpoint			( std::string_view name, std::string_view stage, SSBO& buffer, int count, const StructInfo* info, MemberSpec::Type type );
 	void					ICheckpoint			( std::string_view stage, GPUEntity& entity );
-	std::shared_ptr<SSBO>	IGetStoredFrameAt	( std::string_view name, int tick, int& count );
+	std::shared_ptr<SSBO>	IGetStoredFrameAt	( std::string_view name, int tick, int& count, int soa_stride );
 
 	void					IStoreCheckpoint	( std::string name, CheckpointData data, const StructInfo* info, MemberSpec::Type type );
 	void					IHighlight			( std::string_view name, int id ) { m_HighlightName = name; m_HighlightID = id; }
@@ -306,6 +354,27 @@ public:
 	static void						RenderImGui			( InterfaceResourceViewer& data );
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////
+class MemoryViewer {
+public:
+
+	inline static MemoryViewer&		Singleton			( void ) { static MemoryViewer instance; return instance; }
+
+	inline static void				RenderImGui			( InterfaceMemoryViewer& data ) { Singleton().IRenderImGui(data); }
+
+protected:
+									MemoryViewer		( void ) {}
+
+	void							IRenderImGui		( InterfaceMemoryViewer& data );
+
+	MemorySnapshot					m_Baseline;			// what the diff is against, taken with the button
+	std::vector<MemorySample>		m_Samples;
+	std::vector<std::string>		m_SelectedStack;
+	int								m_SampleTag = -1;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,673 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "EntitySnapshot.h"
+
+namespace Neshny {
+
+namespace DeltaCoding {
+
+////////////////////////////////////////////////////////////////////////////////
+inline void PutVarint(std::vector<unsigned char>& out, uint64_t val) {
+	while (val >= 0x80) {
+		out.push_back((unsigned char)(val | 0x80));
+		val >>= 7;
+	}
+	out.push_back((unsigned char)val);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline int VarintSize(uint64_t val) {
+	int size = 1;
+	while (val >= 0x80) {
+		val >>= 7;
+		size++;
+	}
+	return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline bool GetVarint(std::span<const unsigned char> in, size_t& pos, uint64_t& val) {
+	val = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= in.size()) {
+			return false;
+		}
+		unsigned char byte = in[pos++];
+		val |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void PutInt(std::vector<unsigned char>& out, int val) {
+	for (int i = 0; i < 4; i++) {
+		out.push_back((unsigned char)((uint32_t)val >> (i * 8)));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline bool GetInt(std::span<const unsigned char> in, size_t& pos, int& val) {
+	if (pos + 4 > in.size()) {
+		return false;
+	}
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; i++) {
+		bits |= (uint32_t)in[pos++] << (i * 8);
+	}
+	val = (int)bits;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t ZigZag(int64_t val) {
+	return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline int64_t UnZigZag(uint64_t val) {
+	return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+// quantised values are clamped to this, so the difference of two always fits in an int64
+constexpr int64_t QUANTISE_LIMIT = 4000000000000000000;
+
+////////////////////////////////////////////////////////////////////////////////
+// both sides quantise the same float bits the same way, anything that is not a number counts as zero
+inline int64_t Quantise(int bits, float step) {
+	double val = (double)std::bit_cast<float>(bits) / step;
+	if (!std::isfinite(val)) {
+		return 0;
+	}
+	return std::llround(std::clamp(val, (double)-QUANTISE_LIMIT, (double)QUANTISE_LIMIT));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// false when the change would take the value past what Quantise can give, which only a damaged delta asks for
+inline bool AddQuantised(int64_t quantised, int64_t change, int64_t& result) {
+	if ((change > 0) ? (quantised > QUANTISE_LIMIT - change) : (quantised < -QUANTISE_LIMIT - change)) {
+		return false;
+	}
+	result = quantised + change;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline int Dequantise(int64_t quantised, float step) {
+	return std::bit_cast<int>((float)((double)quantised * step));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ids go up strictly, so each is written as the gap from the one before
+inline void PutIds(std::vector<unsigned char>& out, const std::vector<int>& ids) {
+	PutVarint(out, ids.size());
+	int64_t prev = -1;
+	for (int id : ids) {
+		PutVarint(out, (uint64_t)(id - prev - 1));
+		prev = id;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline bool GetIds(std::span<const unsigned char> in, size_t& pos, std::vector<int>& ids) {
+	uint64_t count;
+	if (!GetVarint(in, pos, count) || (count > in.size() - pos)) {
+		return false;
+	}
+	ids.resize(count);
+	int64_t prev = -1;
+	for (auto& id : ids) {
+		uint64_t gap;
+		if (!GetVarint(in, pos, gap) || (gap > INT_MAX)) {
+			return false;
+		}
+		prev += (int64_t)gap + 1;
+		if (prev > INT_MAX) {
+			return false;
+		}
+		id = (int)prev;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline int ThreadsFor(int thread_count, int64_t work) {
+#ifdef __EMSCRIPTEN__
+	return 1;
+#else
+	return (int)std::clamp<int64_t>(std::min<int64_t>(thread_count, work / ENTITY_DELTA_MIN_PER_THREAD), 1, 64);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// the live items in order of id, so the hash does not depend on where the items sit in the buffer
+inline uint64_t SnapshotHash(std::span<const int> snapshot, const std::vector<uint64_t>& sorted, int ints_per_item) {
+	StreamingHasher hasher;
+	for (uint64_t key : sorted) {
+		hasher.Update(snapshot.data() + (size_t)(key & 0xFFFFFFFF) * ints_per_item, ints_per_item * sizeof(int));
+	}
+	return hasher.Digest64();
+}
+
+} // namespace DeltaCoding
+
+////////////////////////////////////////////////////////////////////////////////
+EntityDeltaCodec::EntityDeltaCodec(const StructInfo& info, std::string_view id_name) {
+	for (const auto& member : info.p_Members) {
+		const int ints = (int)(member.p_Size / sizeof(int)) * (int)member.p_ArrayCount.value_or(1);
+		const bool is_float = (member.p_Type == MemberSpec::T_FLOAT) || (member.p_Type == MemberSpec::T_VEC2) || (member.p_Type == MemberSpec::T_VEC3) || (member.p_Type == MemberSpec::T_VEC4) || (member.p_Type == MemberSpec::T_MAT3) || (member.p_Type == MemberSpec::T_MAT4);
+		if ((member.p_Name == id_name) && (member.p_Type == MemberSpec::T_INT)) {
+			m_IdOffset = m_IntsPerItem;
+		}
+		if (is_float) {
+			m_FloatMembers.push_back({ member.p_Name, { m_IntsPerItem, ints } });
+		}
+		for (int i = 0; i < ints; i++) {
+			m_Fields.push_back(Field{ is_float, 0.0f });
+		}
+		m_IntsPerItem += ints;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool EntityDeltaCodec::SetQuantisation(std::string_view member_name, float step) {
+	for (const auto& member : m_FloatMembers) {
+		if (member.first == member_name) {
+			for (int i = 0; i < member.second.second; i++) {
+				m_Fields[member.second.first + i].p_Step = std::max(step, 0.0f);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// (id << 32) | index for every live item, sorted so both sides walk entities in the same order whatever the layout
+void EntityDeltaCodec::SortById(std::span<const int> snapshot, std::vector<uint64_t>& out, int thread_count) const {
+	const int count = (int)(snapshot.size() / m_IntsPerItem);
+	std::vector<uint32_t> ids;
+	std::vector<uint32_t> indices;
+	ids.reserve(count);
+	indices.reserve(count);
+	bool sorted = true;
+	for (int i = 0; i < count; i++) {
+		int id = snapshot[(size_t)i * m_IntsPerItem + m_IdOffset];
+		if (id >= 0) {
+			sorted = sorted && (ids.empty() || (ids.back() < (uint32_t)id));
+			ids.push_back((uint32_t)id);
+			indices.push_back((uint32_t)i);
+		}
+	}
+	// a buffer that only ever appends is in order of id already
+	if (!sorted) {
+		RadixSort(ids, indices, thread_count);
+	}
+	out.resize(ids.size());
+	for (size_t i = 0; i < ids.size(); i++) {
+		out[i] = ((uint64_t)ids[i] << 32) | indices[i];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// one pass over a range of the common list, every field of an item is compared while it is in cache
+// returns how many entities changed at all
+int EntityDeltaCodec::FindChanges(int begin, int end, std::span<const int> baseline, std::span<const int> current, const std::vector<Common>& common, std::vector<FieldChanges>& out) const {
+	out.resize(m_IntsPerItem);
+	int changed_entities = 0;
+	for (int k = begin; k < end; k++) {
+		const int* old_item = baseline.data() + (size_t)common[k].p_Baseline * m_IntsPerItem;
+		const int* new_item = current.data() + (size_t)common[k].p_Current * m_IntsPerItem;
+		if (memcmp(old_item, new_item, m_IntsPerItem * sizeof(int)) == 0) {
+			continue;
+		}
+		bool any = false;
+		for (int field = 0; field < m_IntsPerItem; field++) {
+			const int old_val = old_item[field];
+			const int new_val = new_item[field];
+			if (old_val == new_val) {
+				continue;
+			}
+			const Field& spec = m_Fields[field];
+			uint64_t payload;
+			if (spec.p_Step > 0.0f) {
+				int64_t old_q = DeltaCoding::Quantise(old_val, spec.p_Step);
+				int64_t new_q = DeltaCoding::Quantise(new_val, spec.p_Step);
+				if (old_q == new_q) {
+					continue;
+				}
+				payload = DeltaCoding::ZigZag(new_q - old_q);
+			} else {
+				payload = spec.p_Float ? (uint32_t)new_val : DeltaCoding::ZigZag((int32_t)((uint32_t)new_val - (uint32_t)old_val));
+			}
+			out[field].p_Changed.push_back(k);
+			out[field].p_Payloads.push_back(payload);
+			any = true;
+		}
+		changed_entities += any ? 1 : 0;
+	}
+	return changed_entities;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// which entities changed this int, either as gaps between their positions in the common list or a bit for every one, whichever is smaller
+// then the new values, as a difference for ints and quantised floats and as they are for exact floats
+void EntityDeltaCodec::EncodeField(int field, const std::vector<std::vector<FieldChanges>>& ranges, int common_count, std::vector<unsigned char>& out) const {
+
+	const Field& spec = m_Fields[field];
+	uint64_t count = 0;
+	uint64_t gap_bytes = 0;
+	int prev = -1;
+	for (const auto& range : ranges) {
+		for (int k : range[field].p_Changed) {
+			gap_bytes += DeltaCoding::VarintSize(k - prev - 1);
+			prev = k;
+		}
+		count += range[field].p_Changed.size();
+	}
+
+	DeltaCoding::PutVarint(out, count);
+	if (count == 0) {
+		return;
+	}
+	const uint64_t bit_bytes = ((uint64_t)common_count + 7) / 8;
+	if (gap_bytes <= bit_bytes) {
+		out.push_back(0);
+		prev = -1;
+		for (const auto& range : ranges) {
+			for (int k : range[field].p_Changed) {
+				DeltaCoding::PutVarint(out, k - prev - 1);
+				prev = k;
+			}
+		}
+	} else {
+		out.push_back(1);
+		size_t start = out.size();
+		out.resize(start + bit_bytes, 0);
+		for (const auto& range : ranges) {
+			for (int k : range[field].p_Changed) {
+				out[start + k / 8] |= (unsigned char)(1 << (k % 8));
+			}
+		}
+	}
+	for (const auto& range : ranges) {
+		for (uint64_t payload : range[field].p_Payloads) {
+			if (spec.p_Float && (spec.p_Step <= 0.0f)) {
+				DeltaCoding::PutInt(out, (int)(uint32_t)payload);
+			} else {
+				DeltaCoding::PutVarint(out, payload);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<unsigned char> EntityDeltaCodec::Encode(std::span<const int> baseline, std::span<const int> current, int thread_count, EntityDeltaStats* stats) const {
+
+	EntityDeltaStats local_stats;
+	stats = stats ? stats : &local_stats;
+	*stats = EntityDeltaStats{};
+	if (!IsValid()) {
+		return {};
+	}
+
+	std::vector<uint64_t> baseline_sorted;
+	std::vector<uint64_t> current_sorted;
+	SortById(baseline, baseline_sorted, thread_count);
+	SortById(current, current_sorted, thread_count);
+
+	// one merge of the two id lists splits them into deleted, created and common
+	std::vector<int> deleted;
+	std::vector<int> created;
+	std::vector<int> created_index;
+	std::vector<Common> common;
+	common.reserve(std::min(baseline_sorted.size(), current_sorted.size()));
+	size_t old_pos = 0;
+	size_t new_pos = 0;
+	while ((old_pos < baseline_sorted.size()) || (new_pos < current_sorted.size())) {
+		int old_id = old_pos < baseline_sorted.size() ? (int)(baseline_sorted[old_pos] >> 32) : INT_MAX;
+		int new_id = new_pos < current_sorted.size() ? (int)(current_sorted[new_pos] >> 32) : INT_MAX;
+		if ((new_pos >= current_sorted.size()) || ((old_pos < baseline_sorted.size()) && (old_id < new_id))) {
+			deleted.push_back(old_id);
+			old_pos++;
+		} else if ((old_pos >= baseline_sorted.size()) || (new_id < old_id)) {
+			created.push_back(new_id);
+			created_index.push_back((int)(current_sorted[new_pos] & 0xFFFFFFFF));
+			new_pos++;
+		} else {
+			common.push_back(Common{ (int)(baseline_sorted[old_pos] & 0xFFFFFFFF), (int)(current_sorted[new_pos] & 0xFFFFFFFF) });
+			old_pos++;
+			new_pos++;
+		}
+	}
+
+	std::vector<unsigned char> out;
+	DeltaCoding::PutVarint(out, ENTITY_DELTA_VERSION);
+	DeltaCoding::PutVarint(out, m_IntsPerItem);
+	uint64_t hash = DeltaCoding::SnapshotHash(baseline, baseline_sorted, m_IntsPerItem);
+	for (int i = 0; i < 8; i++) {
+		out.push_back((unsigned char)(hash >> (i * 8)));
+	}
+	DeltaCoding::PutVarint(out, baseline_sorted.size());
+	DeltaCoding::PutVarint(out, current_sorted.size());
+	DeltaCoding::PutIds(out, deleted);
+	DeltaCoding::PutIds(out, created);
+	// created entities are quantised too, so everything the receiver holds sits on the steps and any later change of half a step is sent
+	for (int index : created_index) {
+		for (int i = 0; i < m_IntsPerItem; i++) {
+			int val = current[(size_t)index * m_IntsPerItem + i];
+			DeltaCoding::PutInt(out, m_Fields[i].p_Step > 0.0f ? DeltaCoding::Dequantise(DeltaCoding::Quantise(val, m_Fields[i].p_Step), m_Fields[i].p_Step) : val);
+		}
+	}
+
+	// threads compare their own range of entities, then encode their own share of the fields from every range in order
+	const int num_fields = m_IntsPerItem;
+	const int num_threads = DeltaCoding::ThreadsFor(thread_count, (int64_t)common.size());
+	std::vector<std::vector<FieldChanges>> ranges(num_threads);
+	std::vector<int> range_changed(num_threads, 0);
+	std::vector<std::vector<unsigned char>> field_data(num_fields);
+	std::barrier sync(num_threads);
+	ParallelFor(num_threads, [&](int t) {
+		try {
+			range_changed[t] = FindChanges((int)((int64_t)common.size() * t / num_threads), (int)((int64_t)common.size() * (t + 1) / num_threads), baseline, current, common, ranges[t]);
+		} catch (...) {
+			// the other threads are waiting on this one, ParallelFor hands the exception on once they are done
+			sync.arrive_and_wait();
+			throw;
+		}
+		sync.arrive_and_wait();
+		for (int field = t; field < num_fields; field += num_threads) {
+			if (field != m_IdOffset) {
+				EncodeField(field, ranges, (int)common.size(), field_data[field]);
+			}
+		}
+	});
+	for (int field = 0; field < num_fields; field++) {
+		DeltaCoding::PutVarint(out, field_data[field].size());
+		out.insert(out.end(), field_data[field].begin(), field_data[field].end());
+	}
+
+	stats->p_Entities = (int)current_sorted.size();
+	stats->p_Created = (int)created.size();
+	stats->p_Deleted = (int)deleted.size();
+	for (int t = 0; t < num_threads; t++) {
+		stats->p_Changed += range_changed[t];
+		for (const auto& changes : ranges[t]) {
+			stats->p_ChangedValues += (int64_t)changes.p_Changed.size();
+		}
+	}
+	stats->p_Threads = num_threads;
+	stats->p_Bytes = out.size();
+	return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// common holds where each entity in the common list now sits in the snapshot
+bool EntityDeltaCodec::ApplyField(int field, std::span<const unsigned char> data, std::vector<int>& snapshot, const std::vector<int>& common) const {
+
+	const Field& spec = m_Fields[field];
+	size_t pos = 0;
+	uint64_t count;
+	if (data.empty()) {
+		return field == m_IdOffset;
+	}
+	if (!DeltaCoding::GetVarint(data, pos, count) || (count > common.size())) {
+		return false;
+	}
+	if (count == 0) {
+		return pos == data.size();
+	}
+	if (pos >= data.size()) {
+		return false;
+	}
+	std::vector<int> changed;
+	changed.reserve(count);
+	unsigned char mode = data[pos++];
+	if (mode == 0) {
+		int64_t prev = -1;
+		for (uint64_t i = 0; i < count; i++) {
+			uint64_t gap;
+			if (!DeltaCoding::GetVarint(data, pos, gap) || (gap >= common.size())) {
+				return false;
+			}
+			prev += (int64_t)gap + 1;
+			if (prev >= (int64_t)common.size()) {
+				return false;
+			}
+			changed.push_back((int)prev);
+		}
+	} else if (mode == 1) {
+		const size_t bit_bytes = (common.size() + 7) / 8;
+		if (pos + bit_bytes > data.size()) {
+			return false;
+		}
+		for (int k = 0; k < (int)common.size(); k++) {
+			if (data[pos + k / 8] & (1 << (k % 8))) {
+				changed.push_back(k);
+			}
+		}
+		pos += bit_bytes;
+		if (changed.size() != count) {
+			return false;
+		}
+	} else {
+		return false;
+	}
+
+	for (int k : changed) {
+		int& val = snapshot[(size_t)common[k] * m_IntsPerItem + field];
+		if (spec.p_Float && (spec.p_Step <= 0.0f)) {
+			if (!DeltaCoding::GetInt(data, pos, val)) {
+				return false;
+			}
+			continue;
+		}
+		uint64_t payload;
+		if (!DeltaCoding::GetVarint(data, pos, payload)) {
+			return false;
+		}
+		if (spec.p_Step > 0.0f) {
+			int64_t quantised;
+			if (!DeltaCoding::AddQuantised(DeltaCoding::Quantise(val, spec.p_Step), DeltaCoding::UnZigZag(payload), quantised)) {
+				return false;
+			}
+			val = DeltaCoding::Dequantise(quantised, spec.p_Step);
+		} else {
+			val = (int)((uint32_t)val + (uint32_t)DeltaCoding::UnZigZag(payload));
+		}
+	}
+	return pos == data.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool EntityDeltaCodec::Apply(std::vector<int>& snapshot, std::span<const unsigned char> delta, std::string& err, int thread_count) const {
+
+	if (!IsValid()) {
+		err = "Codec has no id member";
+		return false;
+	}
+	size_t pos = 0;
+	uint64_t version, ints_per_item, baseline_count, current_count;
+	if (!DeltaCoding::GetVarint(delta, pos, version) || (version != ENTITY_DELTA_VERSION)) {
+		err = "Unknown delta version";
+		return false;
+	}
+	if (!DeltaCoding::GetVarint(delta, pos, ints_per_item) || (ints_per_item != (uint64_t)m_IntsPerItem)) {
+		err = "Delta is for a different struct";
+		return false;
+	}
+	if (pos + 8 > delta.size()) {
+		err = "Delta is truncated";
+		return false;
+	}
+	uint64_t hash = 0;
+	for (int i = 0; i < 8; i++) {
+		hash |= (uint64_t)delta[pos++] << (i * 8);
+	}
+	if (!DeltaCoding::GetVarint(delta, pos, baseline_count) || !DeltaCoding::GetVarint(delta, pos, current_count) || (current_count > INT_MAX)) {
+		err = "Delta is truncated";
+		return false;
+	}
+
+	// a keyframe starts from nothing whatever the snapshot holds
+	std::span<const int> source = baseline_count == 0 ? std::span<const int>() : std::span<const int>(snapshot);
+	std::vector<uint64_t> sorted;
+	SortById(source, sorted, thread_count);
+	if ((sorted.size() != baseline_count) || (DeltaCoding::SnapshotHash(source, sorted, m_IntsPerItem) != hash)) {
+		err = "Delta was not made from this snapshot";
+		return false;
+	}
+
+	std::vector<int> deleted;
+	std::vector<int> created;
+	if (!DeltaCoding::GetIds(delta, pos, deleted) || !DeltaCoding::GetIds(delta, pos, created)) {
+		err = "Delta is truncated";
+		return false;
+	}
+	if ((sorted.size() < deleted.size()) || (sorted.size() - deleted.size() + created.size() != current_count)) {
+		err = "Delta entity counts do not add up";
+		return false;
+	}
+
+	// survivors keep their order, so each item's new index is how many survivors came before it
+	const int source_count = (int)(source.size() / m_IntsPerItem);
+	std::vector<char> survives(source_count, 0);
+	std::vector<int> common;
+	common.reserve(sorted.size() - deleted.size());
+	size_t deleted_pos = 0;
+	for (uint64_t key : sorted) {
+		int id = (int)(key >> 32);
+		if ((deleted_pos < deleted.size()) && (deleted[deleted_pos] == id)) {
+			deleted_pos++;
+			continue;
+		}
+		if ((deleted_pos < deleted.size()) && (deleted[deleted_pos] < id)) {
+			break;
+		}
+		survives[key & 0xFFFFFFFF] = 1;
+		common.push_back((int)(key & 0xFFFFFFFF));
+	}
+	if (deleted_pos != deleted.size()) {
+		err = "Delta deletes an entity that is not there";
+		return false;
+	}
+	std::vector<int> new_index(source_count, -1);
+	std::vector<int> result;
+	result.reserve(current_count * m_IntsPerItem);
+	for (int i = 0; i < source_count; i++) {
+		if (survives[i]) {
+			new_index[i] = (int)(result.size() / m_IntsPerItem);
+			result.insert(result.end(), source.begin() + (size_t)i * m_IntsPerItem, source.begin() + (size_t)(i + 1) * m_IntsPerItem);
+		}
+	}
+	for (int& index : common) {
+		index = new_index[index];
+	}
+
+	// created ids must be new, both lists are in order of id so one merge checks that
+	size_t common_pos = 0;
+	for (int id : created) {
+		while ((common_pos < common.size()) && (result[(size_t)common[common_pos] * m_IntsPerItem + m_IdOffset] < id)) {
+			common_pos++;
+		}
+		if ((common_pos < common.size()) && (result[(size_t)common[common_pos] * m_IntsPerItem + m_IdOffset] == id)) {
+			err = "Delta creates an entity that is already there";
+			return false;
+		}
+	}
+	for (int id : created) {
+		size_t start = result.size();
+		result.resize(start + m_IntsPerItem);
+		for (int i = 0; i < m_IntsPerItem; i++) {
+			if (!DeltaCoding::GetInt(delta, pos, result[start + i])) {
+				err = "Delta is truncated";
+				return false;
+			}
+		}
+		if (result[start + m_IdOffset] != id) {
+			err = "Created entity does not have the id it was listed under";
+			return false;
+		}
+	}
+
+	std::vector<std::span<const unsigned char>> field_data(m_IntsPerItem);
+	for (auto& data : field_data) {
+		uint64_t size;
+		if (!DeltaCoding::GetVarint(delta, pos, size) || (size > delta.size() - pos)) {
+			err = "Delta is truncated";
+			return false;
+		}
+		data = delta.subspan(pos, size);
+		pos += size;
+	}
+	if (pos != delta.size()) {
+		err = "Delta has bytes left over";
+		return false;
+	}
+
+	// each field only writes its own int of each item, so they can all go at once
+	const int num_threads = std::min(DeltaCoding::ThreadsFor(thread_count, (int64_t)common.size()), m_IntsPerItem);
+	std::vector<char> thread_ok(num_threads, 1);
+	ParallelFor(num_threads, [&](int t) {
+		for (int field = t; field < m_IntsPerItem; field += num_threads) {
+			if (!ApplyField(field, field_data[field], result, common)) {
+				thread_ok[t] = 0;
+				return;
+			}
+		}
+	});
+	if (std::find(thread_ok.begin(), thread_ok.end(), 0) != thread_ok.end()) {
+		err = "Delta has a corrupt field";
+		return false;
+	}
+
+	snapshot.swap(result);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoopbackTransport::Send(std::vector<unsigned char> packet) {
+	std::lock_guard<std::mutex> lock(m_Lock);
+	m_PacketsSent++;
+	m_BytesSent += packet.size();
+	m_Packets.push_back(std::move(packet));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoopbackTransport::Receive(std::vector<unsigned char>& packet) {
+	std::lock_guard<std::mutex> lock(m_Lock);
+	if (m_Packets.empty()) {
+		return false;
+	}
+	packet = std::move(m_Packets.front());
+	m_Packets.pop_front();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+EntityDeltaStats EntityReplicationSender::Send(std::span<const int> current, int thread_count) {
+	EntityDeltaStats stats;
+	std::vector<unsigned char> packet = m_Codec.Encode(m_Baseline, current, thread_count, &stats);
+	// applying it here too is what keeps the baseline identical to the receiver's, quantisation included
+	std::string err;
+	m_Codec.Apply(m_Baseline, packet, err, thread_count);
+	m_Transport.Send(std::move(packet));
+	return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool EntityReplicationReceiver::Receive(std::string& err, int thread_count) {
+	std::vector<unsigned char> packet;
+	while (m_Transport.Receive(packet)) {
+		if (!m_Codec.Apply(m_Snapshot, packet, err, thread_count)) {
+			return false;
+		}
+		m_Applied++;
+	}
+	return true;
+}
+
+} // namespace Neshny
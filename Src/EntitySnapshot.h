@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+constexpr int ENTITY_DELTA_VERSION = 1;
+// below this many entities per thread a delta is not split up
+constexpr int ENTITY_DELTA_MIN_PER_THREAD = 8192;
+
+////////////////////////////////////////////////////////////////////////////////
+struct EntityDeltaStats {
+	int			p_Entities = 0;			// in the current snapshot
+	int			p_Created = 0;
+	int			p_Deleted = 0;
+	int			p_Changed = 0;			// entities with at least one member changed
+	int64_t		p_ChangedValues = 0;	// ints sent for changed entities, a vec3 that moved is up to three
+	int			p_Threads = 1;
+	uint64_t	p_Bytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// turns one snapshot of an entity type into another, for sending state over a network or recording a replay
+// a snapshot is every item's ints one after the other, as GPUEntity::ExtractAll gives them, items with a negative id are holes and skipped
+// entities are matched by id, not by index, so items moved around by MOVING_COMPACT or a defrag are not sent again
+// a delta holds the ids deleted, the ids created with all of their data, and for each int of the struct which entities changed it and to what
+// floats can be quantised to a step, which makes small changes a byte or two rather than four and drops ones below half a step
+// deltas are only valid against the exact baseline they were made from, a hash of it is checked when one is applied
+// a delta from an empty baseline is a keyframe, applying it replaces whatever was there
+////////////////////////////////////////////////////////////////////////////////
+class EntityDeltaCodec {
+public:
+									EntityDeltaCodec		( const StructInfo& info, std::string_view id_name );
+
+	// false when there is no float member of that name
+	bool							SetQuantisation			( std::string_view member_name, float step );
+
+	// baseline must be what the receiver has, which with quantisation is not the last snapshot sent but the result of applying the last delta to it
+	std::vector<unsigned char>		Encode					( std::span<const int> baseline, std::span<const int> current, int thread_count = 1, EntityDeltaStats* stats = nullptr ) const;
+	// surviving entities keep their order, created ones go on the end in order of id, the snapshot is untouched if this fails
+	bool							Apply					( std::vector<int>& snapshot, std::span<const unsigned char> delta, std::string& err, int thread_count = 1 ) const;
+
+	inline int						GetIntsPerItem			( void ) const { return m_IntsPerItem; }
+	inline int						GetIdOffset				( void ) const { return m_IdOffset; }
+	inline bool						IsValid					( void ) const { return m_IdOffset >= 0; }
+
+	template<typename T>
+	static std::vector<int>			ToSnapshot				( const std::vector<T>& items ) {
+		static_assert(sizeof(T) % sizeof(int) == 0, "Entity items are a whole number of ints");
+		// fVec3 and the rest write their own copies so are not trivially copyable, but anything owning memory has a destructor and is caught
+		static_assert(std::is_trivially_destructible_v<T>, "Entity items are copied as plain bytes");
+		std::vector<int> snapshot(items.size() * sizeof(T) / sizeof(int));
+		memcpy(snapshot.data(), (const void*)items.data(), items.size() * sizeof(T));
+		return snapshot;
+	}
+	template<typename T>
+	static std::vector<T>			FromSnapshot			( std::span<const int> snapshot ) {
+		static_assert(std::is_trivially_destructible_v<T>, "Entity items are copied as plain bytes");
+		std::vector<T> items(snapshot.size() * sizeof(int) / sizeof(T));
+		memcpy((void*)items.data(), snapshot.data(), items.size() * sizeof(T));
+		return items;
+	}
+
+private:
+
+	struct Field {
+		bool			p_Float = false;
+		float			p_Step = 0.0f;			// zero when the float is sent exactly
+	};
+
+	// one entity in both snapshots, in order of id
+	struct Common {
+		int				p_Baseline;
+		int				p_Current;
+	};
+
+	// one field over one range of the common list
+	struct FieldChanges {
+		std::vector<int>		p_Changed;				// positions in the common list
+		std::vector<uint64_t>	p_Payloads;
+	};
+
+	void							SortById				( std::span<const int> snapshot, std::vector<uint64_t>& out, int thread_count ) const;
+	int								FindChanges				( int begin, int end, std::span<const int> baseline, std::span<const int> current, const std::vector<Common>& common, std::vector<FieldChanges>& out ) const;
+	void							EncodeField				( int field, const std::vector<std::vector<FieldChanges>>& ranges, int common_count, std::vector<unsigned char>& out ) const;
+	bool							ApplyField				( int field, std::span<const unsigned char> data, std::vector<int>& snapshot, const std::vector<int>& common ) const;
+
+	int								m_IntsPerItem = 0;
+	int								m_IdOffset = -1;
+	std::vector<Field>				m_Fields;				// one per int in an item
+	std::vector<std::pair<std::string, std::pair<int, int>>>	m_FloatMembers;		// name to first int and how many
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// whatever carries deltas from a sender to a receiver, packets must arrive whole and in order
+////////////////////////////////////////////////////////////////////////////////
+class SnapshotTransport {
+public:
+	virtual				~SnapshotTransport		( void ) {}
+
+	virtual void		Send					( std::vector<unsigned char> packet ) = 0;
+	// false when nothing is waiting
+	virtual bool		Receive					( std::vector<unsigned char>& packet ) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// an in process queue, for testing replication without a network and for recording replays
+////////////////////////////////////////////////////////////////////////////////
+class LoopbackTransport : public SnapshotTransport {
+public:
+
+	virtual void		Send					( std::vector<unsigned char> packet );
+	virtual bool		Receive					( std::vector<unsigned char>& packet );
+
+	inline uint64_t		GetPacketsSent			( void ) const { return m_PacketsSent; }
+	inline uint64_t		GetBytesSent			( void ) const { return m_BytesSent; }
+
+private:
+
+	std::mutex								m_Lock;
+	std::deque<std::vector<unsigned char>>	m_Packets;
+	uint64_t								m_PacketsSent = 0;
+	uint64_t								m_BytesSent = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// keeps its own copy of what the receiver has, so each delta is made against exactly that
+////////////////////////////////////////////////////////////////////////////////
+class EntityReplicationSender {
+public:
+						EntityReplicationSender		( const EntityDeltaCodec& codec, SnapshotTransport& transport ) : m_Codec(codec), m_Transport(transport) {}
+
+	EntityDeltaStats	Send						( std::span<const int> current, int thread_count = 1 );
+	// the next send is a keyframe, for when the receiver has lost track
+	inline void			Reset						( void ) { m_Baseline.clear(); }
+
+	inline const std::vector<int>&	GetBaseline		( void ) const { return m_Baseline; }
+
+private:
+
+	const EntityDeltaCodec&		m_Codec;
+	SnapshotTransport&			m_Transport;
+	std::vector<int>			m_Baseline;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+class EntityReplicationReceiver {
+public:
+						EntityReplicationReceiver	( const EntityDeltaCodec& codec, SnapshotTransport& transport ) : m_Codec(codec), m_Transport(transport) {}
+
+	// applies every packet waiting, stops at the first that does not apply and returns false
+	bool				Receive						( std::string& err, int thread_count = 1 );
+
+	inline const std::vector<int>&	GetSnapshot		( void ) const { return m_Snapshot; }
+	inline uint64_t		GetApplied					( void ) const { return m_Applied; }
+
+private:
+
+	const EntityDeltaCodec&		m_Codec;
+	SnapshotTransport&			m_Transport;
+	std::vector<int>			m_Snapshot;
+	uint64_t					m_Applied = 0;
+};
+
+} // namespace Neshny
@@ -0,0 +1,487 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#if (defined(__linux__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+	#define NESHNY_MMAP
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+#ifdef NESHNY_IO_URING
+	#include <linux/io_uring.h>
+	#include <sys/syscall.h>
+	// linux/fs.h comes in with io_uring and defines BLOCK_SIZE, which would break any later use of the name in the jumbo build
+	#undef BLOCK_SIZE
+#endif
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this == &other) {
+		return *this;
+	}
+	Close();
+	m_Data = other.m_Data;
+	m_Size = other.m_Size;
+	m_Valid = other.m_Valid;
+	m_Mapped = other.m_Mapped;
+	m_Fallback = std::move(other.m_Fallback);
+	if (!m_Mapped) {
+		m_Data = m_Fallback.data();
+	}
+	other.m_Data = nullptr;
+	other.m_Size = 0;
+	other.m_Valid = false;
+	other.m_Mapped = false;
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MappedFile::Open(std::string_view path) {
+
+	Close();
+#ifdef NESHNY_MMAP
+	int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode)) {
+		close(fd);
+		return false;
+	}
+	m_Size = (size_t)info.st_size;
+	if (m_Size > 0) {
+		// private and writable so that loaders that scribble on their input only ever touch their own copy-on-write pages
+		void* ptr = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (ptr != MAP_FAILED) {
+			m_Data = (unsigned char*)ptr;
+			m_Mapped = true;
+			m_Valid = true;
+		}
+	}
+	close(fd);
+	if (m_Valid) {
+		return true;
+	}
+#endif
+	std::string err;
+	if (!ReadWholeFile(path, m_Fallback, err)) {
+		m_Size = 0;
+		return false;
+	}
+	m_Fallback.push_back(0); // never hand out a null pointer for an empty file
+	m_Data = m_Fallback.data();
+	m_Size = m_Fallback.size() - 1;
+	m_Valid = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MappedFile::Close(void) {
+#ifdef NESHNY_MMAP
+	if (m_Mapped) {
+		munmap(m_Data, m_Size);
+	}
+#endif
+	m_Fallback = {};
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Valid = false;
+	m_Mapped = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ReadWholeFile(std::string_view path, std::vector<unsigned char>& data, std::string& err) {
+	// sized up front and read directly into the destination, rather than through a stringstream
+	FILE* file = fopen(std::string(path).c_str(), "rb");
+	if (!file) {
+		err = std::format("Could not open {} for reading", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size < 0) {
+		fclose(file);
+		err = std::format("Could not size {}", path);
+		return false;
+	}
+	data.resize(size);
+	size_t read = size > 0 ? fread(data.data(), 1, size, file) : 0;
+	fclose(file);
+	if (read != (size_t)size) {
+		err = std::format("Short read on {}", path);
+		return false;
+	}
+	return true;
+}
+
+#ifdef NESHNY_IO_URING
+////////////////////////////////////////////////////////////////////////////////
+// minimal io_uring wrapper over the raw syscalls, only what batched reads need
+////////////////////////////////////////////////////////////////////////////////
+class IOUring {
+public:
+					IOUring			( void ) {}
+					~IOUring		( void );
+
+	bool			Init			( unsigned entries );
+	bool			PushRead		( int fd, unsigned char* dest, unsigned size, uint64_t offset, uint64_t user_data );
+	int				Submit			( int wait_for );
+	int				Wait			( int wait_for );
+	bool			PopCompletion	( uint64_t& user_data, int& result );
+
+	inline int		GetUnsubmitted	( void ) const { return (int)m_Pending; }
+
+private:
+
+	int				m_Fd = -1;
+	void*			m_SQRing = nullptr;
+	size_t			m_SQRingSize = 0;
+	void*			m_CQRing = nullptr;
+	size_t			m_CQRingSize = 0;
+	io_uring_sqe*	m_SQEs = nullptr;
+	size_t			m_SQEsSize = 0;
+
+	unsigned*		m_SQHead = nullptr;
+	unsigned*		m_SQTail = nullptr;
+	unsigned*		m_SQMask = nullptr;
+	unsigned*		m_SQArray = nullptr;
+	unsigned		m_SQEntries = 0;
+	unsigned		m_Pending = 0;
+
+	unsigned*		m_CQHead = nullptr;
+	unsigned*		m_CQTail = nullptr;
+	unsigned*		m_CQMask = nullptr;
+	io_uring_cqe*	m_CQEs = nullptr;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+IOUring::~IOUring(void) {
+	if (m_SQEs) {
+		munmap(m_SQEs, m_SQEsSize);
+	}
+	if (m_CQRing && (m_CQRing != m_SQRing)) {
+		munmap(m_CQRing, m_CQRingSize);
+	}
+	if (m_SQRing) {
+		munmap(m_SQRing, m_SQRingSize);
+	}
+	if (m_Fd >= 0) {
+		close(m_Fd);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool IOUring::Init(unsigned entries) {
+
+	io_uring_params params = {};
+	m_Fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (m_Fd < 0) {
+		return false; // disabled by seccomp, sysctl or an old kernel
+	}
+	m_SQRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_CQRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (single_mmap) {
+		m_SQRingSize = m_CQRingSize = std::max(m_SQRingSize, m_CQRingSize);
+	}
+	void* sq_ptr = mmap(nullptr, m_SQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+	if (sq_ptr == MAP_FAILED) {
+		return false;
+	}
+	m_SQRing = sq_ptr;
+	if (single_mmap) {
+		m_CQRing = m_SQRing;
+	} else {
+		void* cq_ptr = mmap(nullptr, m_CQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+		if (cq_ptr == MAP_FAILED) {
+			return false;
+		}
+		m_CQRing = cq_ptr;
+	}
+	m_SQEsSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes_ptr = mmap(nullptr, m_SQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES);
+	if (sqes_ptr == MAP_FAILED) {
+		return false;
+	}
+	m_SQEs = (io_uring_sqe*)sqes_ptr;
+
+	unsigned char* sq = (unsigned char*)m_SQRing;
+	m_SQHead = (unsigned*)(sq + params.sq_off.head);
+	m_SQTail = (unsigned*)(sq + params.sq_off.tail);
+	m_SQMask = (unsigned*)(sq + params.sq_off.ring_mask);
+	m_SQArray = (unsigned*)(sq + params.sq_off.array);
+	m_SQEntries = params.sq_entries;
+
+	unsigned char* cq = (unsigned char*)m_CQRing;
+	m_CQHead = (unsigned*)(cq + params.cq_off.head);
+	m_CQTail = (unsigned*)(cq + params.cq_off.tail);
+	m_CQMask = (unsigned*)(cq + params.cq_off.ring_mask);
+	m_CQEs = (io_uring_cqe*)(cq + params.cq_off.cqes);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool IOUring::PushRead(int fd, unsigned char* dest, unsigned size, uint64_t offset, uint64_t user_data) {
+
+	unsigned tail = *m_SQTail;
+	unsigned head = std::atomic_ref<unsigned>(*m_SQHead).load(std::memory_order_acquire);
+	if (tail - head >= m_SQEntries) {
+		return false;
+	}
+	unsigned index = tail & *m_SQMask;
+	io_uring_sqe& sqe = m_SQEs[index];
+	sqe = {};
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = fd;
+	sqe.addr = (uint64_t)dest;
+	sqe.len = size;
+	sqe.off = offset;
+	sqe.user_data = user_data;
+	m_SQArray[index] = index;
+	std::atomic_ref<unsigned>(*m_SQTail).store(tail + 1, std::memory_order_release);
+	m_Pending++;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int IOUring::Submit(int wait_for) {
+	int submitted = (int)syscall(__NR_io_uring_enter, m_Fd, m_Pending, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+	if (submitted > 0) {
+		m_Pending -= submitted;
+	}
+	return submitted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int IOUring::Wait(int wait_for) {
+	return (int)syscall(__NR_io_uring_enter, m_Fd, 0, wait_for, IORING_ENTER_GETEVENTS, nullptr, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool IOUring::PopCompletion(uint64_t& user_data, int& result) {
+	unsigned head = *m_CQHead;
+	if (head == std::atomic_ref<unsigned>(*m_CQTail).load(std::memory_order_acquire)) {
+		return false;
+	}
+	const io_uring_cqe& cqe = m_CQEs[head & *m_CQMask];
+	user_data = cqe.user_data;
+	result = cqe.res;
+	std::atomic_ref<unsigned>(*m_CQHead).store(head + 1, std::memory_order_release);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ReadFilesIOUring(std::vector<FileReadResult>& results, int queue_depth) {
+
+	IOUring ring;
+	if (!ring.Init((unsigned)std::max(1, queue_depth))) {
+		return false;
+	}
+
+	struct InFlight {
+		int			p_Fd = -1;
+		size_t		p_Done = 0;
+		bool		p_Queued = false;
+	};
+	std::vector<InFlight> state(results.size());
+	// reads larger than this are split, the kernel caps a single read at just under 2GB anyway
+	const size_t max_chunk = size_t(1) << 30;
+
+	auto queue_read = [&](int index) {
+		auto& file = state[index];
+		auto& result = results[index];
+		size_t remaining = result.p_Data.size() - file.p_Done;
+		file.p_Queued = ring.PushRead(file.p_Fd, result.p_Data.data() + file.p_Done, (unsigned)std::min(remaining, max_chunk), file.p_Done, (uint64_t)index);
+		return file.p_Queued;
+	};
+	auto finish = [&](int index, bool success, std::string err = {}) {
+		if (state[index].p_Fd >= 0) {
+			close(state[index].p_Fd);
+			state[index].p_Fd = -1;
+		}
+		results[index].p_Success = success;
+		results[index].p_Error = std::move(err);
+		if (!success) {
+			results[index].p_Data = {};
+		}
+	};
+
+	int next = 0;
+	int in_flight = 0;
+	const int total = (int)results.size();
+	uint64_t user_data = 0;
+	int res = 0;
+	while ((next < total) || (in_flight > 0)) {
+
+		// files are opened and sized just before their read is queued, so only queue_depth descriptors are ever open
+		while ((next < total) && (in_flight < queue_depth)) {
+			auto& result = results[next];
+			int fd = open(result.p_Path.c_str(), O_RDONLY | O_CLOEXEC);
+			struct stat info;
+			if (fd < 0) {
+				finish(next++, false, std::format("Could not open {} for reading", result.p_Path));
+				continue;
+			}
+			state[next].p_Fd = fd;
+			if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode)) {
+				finish(next++, false, std::format("Could not size {}", result.p_Path));
+				continue;
+			}
+			result.p_Data.resize((size_t)info.st_size);
+			if (info.st_size == 0) {
+				finish(next++, true);
+				continue;
+			}
+			if (!queue_read(next)) {
+				close(fd);
+				state[next].p_Fd = -1;
+				break;
+			}
+			next++;
+			in_flight++;
+		}
+		if (in_flight <= 0) {
+			continue;
+		}
+
+		if (ring.Submit(1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			// the ring is broken, but reads it already took can still land in their buffers
+			// so each buffer stays with its result until its completion turns up, the unsubmitted ones never started
+			int outstanding = -ring.GetUnsubmitted();
+			for (int i = 0; i < total; i++) {
+				outstanding += state[i].p_Queued ? 1 : 0;
+			}
+			while (outstanding > 0) {
+				// completions are written to the shared ring without a syscall, and it has room for twice the queue depth so none are held back
+				// so when the kernel cannot be waited on the ring is polled instead
+				if ((ring.Wait(1) < 0) && (errno != EINTR)) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				while (ring.PopCompletion(user_data, res)) {
+					state[(int)user_data].p_Queued = false;
+					outstanding--;
+				}
+			}
+			for (int i = 0; i < total; i++) {
+				state[i].p_Queued = false;
+			}
+			// whatever is left gets read the slow way
+			for (int i = 0; i < total; i++) {
+				if (state[i].p_Fd >= 0) {
+					close(state[i].p_Fd);
+					state[i].p_Fd = -1;
+				}
+				if (!results[i].p_Success) {
+					results[i].p_Success = ReadWholeFile(results[i].p_Path, results[i].p_Data, results[i].p_Error);
+				}
+			}
+			return true;
+		}
+
+		while (ring.PopCompletion(user_data, res)) {
+			int index = (int)user_data;
+			state[index].p_Queued = false;
+			if (res < 0) {
+				if (res == -EINTR || res == -EAGAIN) {
+					queue_read(index);
+					continue;
+				}
+				in_flight--;
+				finish(index, false, std::format("Read failed on {} ({})", results[index].p_Path, -res));
+				continue;
+			}
+			state[index].p_Done += res;
+			if ((res == 0) || (state[index].p_Done >= results[index].p_Data.size())) {
+				// a zero read means the file shrank underneath us
+				results[index].p_Data.resize(state[index].p_Done);
+				in_flight--;
+				finish(index, true);
+			} else {
+				queue_read(index); // short read, carry on from where it stopped
+			}
+		}
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool IOUringSupported(void) {
+	static const bool supported = []() {
+		IOUring ring;
+		return ring.Init(1);
+	}();
+	return supported;
+}
+#else
+////////////////////////////////////////////////////////////////////////////////
+bool IOUringSupported(void) {
+	return false;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+void ReadFilesThreaded(std::vector<FileReadResult>& results, int max_threads) {
+#ifdef __EMSCRIPTEN__
+	int num_threads = 1;
+#else
+	int num_threads = max_threads > 0 ? max_threads : std::max(1, (int)std::thread::hardware_concurrency());
+#endif
+	num_threads = std::max(1, std::min(num_threads, (int)results.size()));
+
+	std::atomic_int next = 0;
+	auto worker = [&results, &next]() {
+		int index;
+		while ((index = next++) < (int)results.size()) {
+			auto& result = results[index];
+			result.p_Success = ReadWholeFile(result.p_Path, result.p_Data, result.p_Error);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int t = 1; t < num_threads; t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<FileReadResult> ReadFilesBatched(const std::vector<std::string>& paths, FileBatchOptions options, FileReadBackend* used_backend) {
+
+	std::vector<FileReadResult> results(paths.size());
+	for (int i = 0; i < (int)paths.size(); i++) {
+		results[i].p_Path = paths[i];
+	}
+
+	FileReadBackend backend = options.p_Backend;
+	if ((backend == FileReadBackend::AUTO) || (backend == FileReadBackend::IO_URING)) {
+		backend = IOUringSupported() ? FileReadBackend::IO_URING : FileReadBackend::THREAD_POOL;
+	}
+#ifdef NESHNY_IO_URING
+	if ((backend == FileReadBackend::IO_URING) && !ReadFilesIOUring(results, options.p_QueueDepth)) {
+		backend = FileReadBackend::THREAD_POOL;
+	}
+#endif
+	if (backend == FileReadBackend::THREAD_POOL) {
+		ReadFilesThreaded(results, options.p_Threads);
+	} else if (backend == FileReadBackend::SYNC) {
+		for (auto& result : results) {
+			result.p_Success = ReadWholeFile(result.p_Path, result.p_Data, result.p_Error);
+		}
+	}
+	if (used_backend) {
+		*used_backend = backend;
+	}
+	return results;
+}
+
+} // namespace Neshny
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__) && __has_include(<linux/io_uring.h>)
+	#define NESHNY_IO_URING
+#endif
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// read-only view of a whole file, memory mapped where possible so the data is never copied into a string
+// the mapping is private, so writes through GetMutableData are allowed but never reach the file
+////////////////////////////////////////////////////////////////////////////////
+class MappedFile {
+public:
+										MappedFile			( void ) {}
+										MappedFile			( std::string_view path ) { Open(path); }
+										~MappedFile			( void ) { Close(); }
+
+										MappedFile			( const MappedFile& ) = delete;
+	MappedFile&							operator=			( const MappedFile& ) = delete;
+										MappedFile			( MappedFile&& other ) noexcept { *this = std::move(other); }
+	MappedFile&							operator=			( MappedFile&& other ) noexcept;
+
+	bool								Open				( std::string_view path );
+	void								Close				( void );
+
+	inline bool							IsValid				( void ) const { return m_Valid; }
+	inline bool							IsMapped			( void ) const { return m_Mapped; }
+	inline size_t						GetSize				( void ) const { return m_Size; }
+	inline std::span<const unsigned char>	GetData			( void ) const { return std::span<const unsigned char>(m_Data, m_Size); }
+	inline unsigned char*				GetMutableData		( void ) { return m_Data; }
+	inline std::string_view				GetString			( void ) const { return std::string_view((const char*)m_Data, m_Size); }
+
+private:
+
+	unsigned char*						m_Data = nullptr;
+	size_t								m_Size = 0;
+	bool								m_Valid = false;
+	bool								m_Mapped = false;
+	std::vector<unsigned char>			m_Fallback; // owned copy for empty files and platforms without mmap
+};
+
+////////////////////////////////////////////////////////////////////////////////
+enum class FileReadBackend {
+	AUTO,			// io_uring where the kernel allows it, otherwise threads
+	IO_URING,
+	THREAD_POOL,
+	SYNC
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct FileReadResult {
+	std::string							p_Path;
+	std::vector<unsigned char>			p_Data;
+	bool								p_Success = false;
+	std::string							p_Error;
+
+	inline std::span<const unsigned char>	GetData			( void ) const { return p_Data; }
+	inline std::string_view				GetString			( void ) const { return std::string_view((const char*)p_Data.data(), p_Data.size()); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct FileBatchOptions {
+	FileReadBackend						p_Backend = FileReadBackend::AUTO;
+	int									p_QueueDepth = 64;	// reads in flight at once for io_uring
+	int									p_Threads = -1;		// for the thread fallback, -1 is one per hardware thread
+};
+
+// reads many whole files at once and blocks until all of them are done, results are in the same order as paths
+// a file that fails does not stop the others, check p_Success on each result
+std::vector<FileReadResult> ReadFilesBatched(const std::vector<std::string>& paths, FileBatchOptions options = {}, FileReadBackend* used_backend = nullptr);
+bool ReadWholeFile(std::string_view path, std::vector<unsigned char>& data, std::string& err);
+bool IOUringSupported(void);
+
+} // namespace Neshny
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "FixedStepScheduler.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+FixedStepScheduler::FixedStepScheduler(FixedStepParams params) :
+	m_Params(params)
+{
+	m_Params.p_TicksPerSecond = std::max(1, m_Params.p_TicksPerSecond);
+	m_Params.p_MaxCatchUpTicks = std::max(1, m_Params.p_MaxCatchUpTicks);
+	m_Params.p_ThreadCount = std::max(1, m_Params.p_ThreadCount);
+	// slot 0 is always the calling thread
+	for (int slot = 1; slot < m_Params.p_ThreadCount; slot++) {
+		m_Threads.emplace_back(&FixedStepScheduler::WorkerLoop, this, slot);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+FixedStepScheduler::~FixedStepScheduler(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Stop = true;
+	}
+	m_WakeCondition.notify_all();
+	for (auto& thread : m_Threads) {
+		thread.join();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FixedStepScheduler::Reset(void) {
+	m_Accumulator = 0;
+	m_Tick = 0;
+	m_DroppedTicks = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int FixedStepScheduler::Advance(TimerNanos real_time) {
+	if (m_Params.p_Unthrottled) {
+		RunTicks(m_Params.p_MaxCatchUpTicks);
+		return m_Params.p_MaxCatchUpTicks;
+	}
+
+	// whole seconds are split off first so the multiply cannot overflow however long the hitch was
+	int64_t nanos = std::max((int64_t)real_time.count(), (int64_t)0);
+	int64_t whole_seconds = nanos / ACCUMULATOR_PER_TICK;
+	m_Accumulator += (nanos - whole_seconds * ACCUMULATOR_PER_TICK) * m_Params.p_TicksPerSecond;
+
+	int64_t due = whole_seconds * m_Params.p_TicksPerSecond + m_Accumulator / ACCUMULATOR_PER_TICK;
+	m_Accumulator %= ACCUMULATOR_PER_TICK;
+	int count = (int)std::min(due, (int64_t)m_Params.p_MaxCatchUpTicks);
+	m_DroppedTicks += due - count;
+
+	RunTicks(count);
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FixedStepScheduler::StepWorlds(int slot, int64_t first_tick, int count) {
+	const double step_seconds = GetStepSeconds();
+	const int num_slots = (int)m_Threads.size() + 1;
+	for (int i = slot; i < (int)m_Worlds.size(); i += num_slots) {
+		for (int t = 0; t < count; t++) {
+			m_Worlds[i]->Step(step_seconds, first_tick + t);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FixedStepScheduler::RunTicks(int count) {
+	if (count <= 0) {
+		return;
+	}
+	if (m_Threads.empty() || (m_Worlds.size() <= 1)) {
+		// no point waking the workers, and stepping every world per tick keeps the order simple for single threaded users
+		const double step_seconds = GetStepSeconds();
+		for (int t = 0; t < count; t++) {
+			for (auto world : m_Worlds) {
+				world->Step(step_seconds, m_Tick + t);
+			}
+		}
+		m_Tick += count;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_JobFirstTick = m_Tick;
+		m_JobTicks = count;
+		m_Outstanding = (int)m_Threads.size();
+		m_WorkerException = nullptr;
+		m_Generation++;
+	}
+	m_WakeCondition.notify_all();
+
+	std::exception_ptr exception;
+	try {
+		StepWorlds(0, m_Tick, count);
+	} catch (...) {
+		exception = std::current_exception();
+	}
+
+	std::unique_lock<std::mutex> lock(m_Lock);
+	m_DoneCondition.wait(lock, [this]() { return m_Outstanding == 0; });
+	m_Tick += count;
+	if (!exception) {
+		exception = m_WorkerException;
+	}
+	lock.unlock();
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FixedStepScheduler::WorkerLoop(int slot) {
+	uint64_t seen_generation = 0;
+	while (true) {
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_WakeCondition.wait(lock, [this, seen_generation]() { return m_Stop || (m_Generation != seen_generation); });
+		if (m_Stop) {
+			return;
+		}
+		seen_generation = m_Generation;
+		int64_t first_tick = m_JobFirstTick;
+		int count = m_JobTicks;
+		lock.unlock();
+
+		std::exception_ptr exception;
+		try {
+			StepWorlds(slot, first_tick, count);
+		} catch (...) {
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+		if (exception && !m_WorkerException) {
+			m_WorkerException = exception;
+		}
+		if (--m_Outstanding == 0) {
+			m_DoneCondition.notify_one();
+		}
+	}
+}
+
+} // namespace Neshny
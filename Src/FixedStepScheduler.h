@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////
+class ISimulation {
+public:
+	virtual							~ISimulation() {}
+
+	// always called with the same step_seconds, and with ticks in order without gaps
+	virtual void					Step		( double step_seconds, int64_t tick ) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct FixedStepParams {
+	int		p_TicksPerSecond = 60;
+	int		p_MaxCatchUpTicks = 4;		// most ticks run by one Advance, past that the backlog is dropped and the simulation runs slower than real time
+	bool	p_Unthrottled = false;		// ignore real time and run p_MaxCatchUpTicks every Advance, for headless servers running ahead of real time
+	int		p_ThreadCount = 1;			// worlds are spread across this many threads, 1 steps everything on the calling thread
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// decouples simulation from rendering - call Advance once per rendered frame with the real time that passed
+// and it runs however many whole fixed ticks are due, then render using GetAlpha to blend between the last two simulation states
+// time is accumulated in integer nanoseconds scaled by the tick rate, so the ticks run only ever depend on the sequence of frame times given
+// with more than one thread each world is stepped through all of a frame's ticks on its own thread, so worlds must not share mutable state
+////////////////////////////////////////////////////////////////////////////////
+class FixedStepScheduler {
+public:
+
+									FixedStepScheduler	( FixedStepParams params = {} );
+									~FixedStepScheduler	( void );
+
+									FixedStepScheduler	( const FixedStepScheduler& ) = delete;
+	FixedStepScheduler&				operator=			( const FixedStepScheduler& ) = delete;
+
+	// not thread safe, only call between Advances
+	void							AddWorld			( ISimulation* world ) { m_Worlds.push_back(world); }
+	void							RemoveWorld			( ISimulation* world ) { std::erase(m_Worlds, world); }
+
+	// returns the number of ticks run
+	int								Advance				( TimerNanos real_time );
+	// runs ticks straight away no matter the time, leaving the accumulated time alone
+	void							RunTicks			( int count );
+	void							Reset				( void );
+
+	// how far real time is between the last tick and the next one, from 0 up to but not including 1
+	inline double					GetAlpha			( void ) const { return (double)m_Accumulator / (double)ACCUMULATOR_PER_TICK; }
+	inline double					GetStepSeconds		( void ) const { return 1.0 / m_Params.p_TicksPerSecond; }
+	inline int64_t					GetTick				( void ) const { return m_Tick; }
+	inline int64_t					GetDroppedTicks		( void ) const { return m_DroppedTicks; }
+	inline const FixedStepParams&	GetParams			( void ) const { return m_Params; }
+
+private:
+
+	// the accumulator is in nanoseconds times ticks per second, so one tick is always exactly a second's worth of nanoseconds
+	static constexpr int64_t		ACCUMULATOR_PER_TICK = 1000000000;
+
+	void							StepWorlds			( int slot, int64_t first_tick, int count );
+	void							WorkerLoop			( int slot );
+
+	FixedStepParams					m_Params;
+	std::vector<ISimulation*>		m_Worlds;
+	int64_t							m_Accumulator = 0;
+	int64_t							m_Tick = 0;
+	int64_t							m_DroppedTicks = 0;
+
+	std::vector<std::thread>		m_Threads;
+	std::mutex						m_Lock;
+	std::condition_variable			m_WakeCondition;
+	std::condition_variable			m_DoneCondition;
+	uint64_t						m_Generation = 0;
+	int64_t							m_JobFirstTick = 0;
+	int								m_JobTicks = 0;
+	int								m_Outstanding = 0;
+	bool							m_Stop = false;
+	std::exception_ptr				m_WorkerException;
+};
+
+} // namespace Neshny
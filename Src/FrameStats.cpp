@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "FrameStats.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+int LatencyHistogram::BucketIndex(int64_t value) {
+	if (value < SUB_BUCKET_COUNT) {
+		return (int)std::max(value, (int64_t)0);
+	}
+	// the top SUB_BUCKET_BITS + 1 bits pick the bucket, the exponent says how many low bits were thrown away
+	int exponent = (int)std::bit_width((uint64_t)value) - SUB_BUCKET_BITS - 1;
+	return exponent * SUB_BUCKET_COUNT + (int)(value >> exponent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int64_t LatencyHistogram::BucketLowest(int index) {
+	if (index < SUB_BUCKET_COUNT * 2) {
+		return index;
+	}
+	int exponent = index / SUB_BUCKET_COUNT - 1;
+	int64_t mantissa = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+	return mantissa << exponent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LatencyHistogram::Record(int64_t value, int64_t count) {
+	if (count <= 0) {
+		return;
+	}
+	value = std::max(value, (int64_t)0);
+	if (value > MAX_VALUE) {
+		value = MAX_VALUE;
+		m_ClampedCount += count;
+	}
+	m_Counts[BucketIndex(value)] += count;
+	m_Min = m_Count ? std::min(m_Min, value) : value;
+	m_Max = std::max(m_Max, value);
+	m_Count += count;
+	m_Sum += value * count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+	if (!other.m_Count) {
+		return;
+	}
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		m_Counts[i] += other.m_Counts[i];
+	}
+	m_Min = m_Count ? std::min(m_Min, other.m_Min) : other.m_Min;
+	m_Max = std::max(m_Max, other.m_Max);
+	m_Count += other.m_Count;
+	m_Sum += other.m_Sum;
+	m_ClampedCount += other.m_ClampedCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LatencyHistogram::Reset(void) {
+	std::fill(m_Counts.begin(), m_Counts.end(), 0);
+	m_Count = 0;
+	m_Sum = 0;
+	m_Min = 0;
+	m_Max = 0;
+	m_ClampedCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+	if (!m_Count) {
+		return 0;
+	}
+	percentile = std::clamp(percentile, 0.0, 100.0);
+	int64_t target = std::max((int64_t)1, (int64_t)std::ceil(percentile * 0.01 * (double)m_Count));
+	int64_t so_far = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		so_far += m_Counts[i];
+		if (so_far >= target) {
+			return std::clamp(BucketHighest(i), m_Min, m_Max);
+		}
+	}
+	return m_Max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::Scope::Finish(void) {
+	if (m_Finished) {
+		return;
+	}
+	m_Finished = true;
+	m_Stats.AddSubsystemTime(m_Label, std::chrono::steady_clock::now() - m_Timer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+FrameStats::Tracked& FrameStats::FindSubsystem(const char* label) {
+	for (auto& subsystem : m_Subsystems) {
+		if (subsystem.p_Name == label) {
+			return subsystem;
+		}
+	}
+	m_Subsystems.emplace_back();
+	m_Subsystems.back().p_Name = label;
+	return m_Subsystems.back();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::AddSubsystemTime(const char* label, TimerNanos time) {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	Tracked& subsystem = FindSubsystem(label);
+	subsystem.p_CurrentFrame += time;
+	subsystem.p_UsedThisFrame = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::SetBudget(const char* label, TimerNanos budget) {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	FindSubsystem(label).p_Budget = budget;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::RecordTracked(Tracked& tracked, TimerNanos time, const char* label) {
+	tracked.p_Total.Record(time);
+	tracked.p_Interval.Record(time);
+	if ((tracked.p_Budget > TimerNanos::zero()) && (time > tracked.p_Budget)) {
+		tracked.p_TotalSpikes++;
+		tracked.p_IntervalSpikes++;
+		if (m_RecentSpikes.size() >= MAX_RECENT_SPIKES) {
+			m_RecentSpikes.pop_front();
+		}
+		m_RecentSpikes.push_back({ m_FrameIndex, label, time, tracked.p_Budget });
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::EndFrame(TimerNanos frame_time) {
+	{
+		std::lock_guard<std::mutex> lock(m_SubsystemLock);
+		RecordTracked(m_Frame, frame_time, nullptr);
+		for (auto& subsystem : m_Subsystems) {
+			// subsystems that did not run this frame are left out rather than counted as taking no time
+			if (subsystem.p_UsedThisFrame) {
+				RecordTracked(subsystem, subsystem.p_CurrentFrame, subsystem.p_Name.c_str());
+			}
+			subsystem.p_CurrentFrame = TimerNanos::zero();
+			subsystem.p_UsedThisFrame = false;
+		}
+	}
+	m_FrameIndex++;
+	m_TotalTime += frame_time;
+	m_IntervalTime += frame_time;
+	if ((m_Interval > TimerNanos::zero()) && (m_IntervalTime >= m_Interval)) {
+		FinishInterval();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::FinishInterval(void) {
+	m_LastIntervalSnapshot = GetSnapshot(true);
+	if (m_ExportFile.is_open()) {
+		if (m_ExportFormat == FrameStatsFormat::CSV) {
+			m_ExportFile << ToCSV(m_LastIntervalSnapshot);
+		} else {
+			Json::ParseError err;
+			m_ExportFile << Json::ToJson(m_LastIntervalSnapshot, err) << "\n";
+		}
+		m_ExportFile.flush(); // so dashboards tailing the file see each interval as it happens
+	}
+
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	m_IntervalTime = TimerNanos::zero();
+	m_Frame.p_Interval.Reset();
+	m_Frame.p_IntervalSpikes = 0;
+	for (auto& subsystem : m_Subsystems) {
+		subsystem.p_Interval.Reset();
+		subsystem.p_IntervalSpikes = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::Reset(void) {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	auto reset = [](Tracked& tracked) {
+		tracked.p_Total.Reset();
+		tracked.p_Interval.Reset();
+		tracked.p_TotalSpikes = 0;
+		tracked.p_IntervalSpikes = 0;
+		tracked.p_CurrentFrame = TimerNanos::zero();
+		tracked.p_UsedThisFrame = false;
+	};
+	reset(m_Frame);
+	for (auto& subsystem : m_Subsystems) {
+		reset(subsystem);
+	}
+	m_RecentSpikes.clear();
+	m_FrameIndex = 0;
+	m_TotalTime = TimerNanos::zero();
+	m_IntervalTime = TimerNanos::zero();
+	m_LastIntervalSnapshot = {};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+FrameStatsSummary FrameStats::Summarise(const Tracked& tracked, bool interval_only) const {
+	const LatencyHistogram& histogram = interval_only ? tracked.p_Interval : tracked.p_Total;
+	const double to_ms = NANO_CONVERT * 1000.0;
+	return {
+		tracked.p_Name
+		,histogram.GetCount()
+		,histogram.GetMean() * to_ms
+		,(double)histogram.ValueAtPercentile(50.0) * to_ms
+		,(double)histogram.ValueAtPercentile(95.0) * to_ms
+		,(double)histogram.ValueAtPercentile(99.0) * to_ms
+		,(double)histogram.GetMax() * to_ms
+		,(double)tracked.p_Budget.count() * to_ms
+		,interval_only ? tracked.p_IntervalSpikes : tracked.p_TotalSpikes
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+FrameStatsSnapshot FrameStats::GetSnapshot(bool interval_only) const {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	FrameStatsSnapshot snapshot;
+	snapshot.p_FrameIndex = m_FrameIndex;
+	snapshot.p_Seconds = std::chrono::duration_cast<TimerSeconds>(m_TotalTime).count();
+	snapshot.p_IntervalSeconds = std::chrono::duration_cast<TimerSeconds>(interval_only ? m_IntervalTime : m_TotalTime).count();
+	snapshot.p_Frame = Summarise(m_Frame, interval_only);
+	snapshot.p_Frame.p_Name = "Frame";
+	for (const auto& subsystem : m_Subsystems) {
+		snapshot.p_Subsystems.push_back(Summarise(subsystem, interval_only));
+	}
+	return snapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::deque<FrameStats::Spike> FrameStats::GetRecentSpikes(void) const {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	return m_RecentSpikes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const LatencyHistogram* FrameStats::GetSubsystemHistogram(const char* label) const {
+	std::lock_guard<std::mutex> lock(m_SubsystemLock);
+	for (const auto& subsystem : m_Subsystems) {
+		if (subsystem.p_Name == label) {
+			return &subsystem.p_Total;
+		}
+	}
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool FrameStats::StartExport(std::string_view filename, FrameStatsFormat format, bool append) {
+	StopExport();
+	bool write_header = (format == FrameStatsFormat::CSV) && ((!append) || (!std::filesystem::exists(filename)) || (std::filesystem::file_size(filename) == 0));
+	m_ExportFile.open(std::string(filename), std::ios::out | (append ? std::ios::app : std::ios::trunc));
+	if (!m_ExportFile.is_open()) {
+		return false;
+	}
+	m_ExportFormat = format;
+	if (write_header) {
+		m_ExportFile << ToCSVHeader();
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameStats::StopExport(void) {
+	if (m_ExportFile.is_open()) {
+		m_ExportFile.close();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string FrameStats::ToCSVHeader(void) {
+	return "Frame,Seconds,IntervalSeconds,Name,Count,MeanMs,P50Ms,P95Ms,P99Ms,MaxMs,BudgetMs,Spikes\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string FrameStats::ToCSV(const FrameStatsSnapshot& snapshot) {
+	// one row per frame or subsystem summary, all sharing the snapshot columns, which is what most dashboards want to import
+	std::string result;
+	auto add_row = [&snapshot, &result](const FrameStatsSummary& summary) {
+		std::string name = summary.p_Name;
+		if (name.find_first_of(",\"\n") != std::string::npos) {
+			name = "\"" + ReplaceAll(name, "\"", "\"\"") + "\"";
+		}
+		result += std::format("{},{:.6f},{:.6f},{},{},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{}\n"
+			,snapshot.p_FrameIndex, snapshot.p_Seconds, snapshot.p_IntervalSeconds, name, summary.p_Count
+			,summary.p_MeanMs, summary.p_P50Ms, summary.p_P95Ms, summary.p_P99Ms, summary.p_MaxMs, summary.p_BudgetMs, summary.p_Spikes
+		);
+	};
+	add_row(snapshot.p_Frame);
+	for (const auto& subsystem : snapshot.p_Subsystems) {
+		add_row(subsystem);
+	}
+	return result;
+}
+
+} // namespace Neshny
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// HDR style log-linear histogram of nanosecond durations
+// every power of two range is split into SUB_BUCKET_COUNT linear buckets, so any value is kept to within 1/128 (~0.8%)
+// memory is fixed at construction and recording is a couple of bit operations, no matter how many values go in
+////////////////////////////////////////////////////////////////////////////////
+class LatencyHistogram {
+public:
+
+	static constexpr int		SUB_BUCKET_BITS = 7;
+	static constexpr int		SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static constexpr int		MAX_EXPONENT = 36;
+	static constexpr int		BUCKET_COUNT = (MAX_EXPONENT + 2) * SUB_BUCKET_COUNT;
+	static constexpr int64_t	MAX_VALUE = (int64_t(SUB_BUCKET_COUNT * 2) << MAX_EXPONENT) - 1; // a bit over 4.8 hours, anything longer is clamped
+
+								LatencyHistogram	( void ) : m_Counts(BUCKET_COUNT, 0) {}
+
+	void						Record				( int64_t value, int64_t count = 1 );
+	inline void					Record				( TimerNanos nanos ) { Record(nanos.count()); }
+	void						Merge				( const LatencyHistogram& other );
+	void						Reset				( void );
+
+	// returns the largest value that could be in the same bucket as the value at the percentile, so it never under reports
+	int64_t						ValueAtPercentile	( double percentile ) const;
+	inline int64_t				GetCount			( void ) const { return m_Count; }
+	inline int64_t				GetMin				( void ) const { return m_Count ? m_Min : 0; }
+	inline int64_t				GetMax				( void ) const { return m_Max; }
+	inline double				GetMean				( void ) const { return m_Count ? (double)m_Sum / (double)m_Count : 0.0; }
+	inline int64_t				GetClampedCount		( void ) const { return m_ClampedCount; }
+
+	static int					BucketIndex			( int64_t value );
+	static int64_t				BucketLowest		( int index );
+	static int64_t				BucketHighest		( int index ) { return BucketLowest(index + 1) - 1; }
+
+private:
+
+	std::vector<int64_t>		m_Counts;
+	int64_t						m_Count = 0;
+	int64_t						m_Sum = 0;
+	int64_t						m_Min = 0;
+	int64_t						m_Max = 0;
+	int64_t						m_ClampedCount = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct FrameStatsSummary {
+	std::string		p_Name;
+	int64_t			p_Count = 0;
+	double			p_MeanMs = 0.0;
+	double			p_P50Ms = 0.0;
+	double			p_P95Ms = 0.0;
+	double			p_P99Ms = 0.0;
+	double			p_MaxMs = 0.0;
+	double			p_BudgetMs = 0.0; // zero when there is no budget
+	int64_t			p_Spikes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct FrameStatsSnapshot {
+	int64_t							p_FrameIndex = 0;
+	double							p_Seconds = 0.0; // total frame time since the stats were last reset
+	double							p_IntervalSeconds = 0.0; // frame time covered by this snapshot
+	FrameStatsSummary				p_Frame;
+	std::vector<FrameStatsSummary>	p_Subsystems;
+};
+
+enum class FrameStatsFormat {
+	CSV
+	,JSON // one snapshot object per line
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// rolling frame time statistics, does not need a window or a graphics device so it works just as well headless
+// whole frame and per subsystem times each go into two histograms - one for everything since Reset and one for the current interval
+// when an interval's worth of frame time has passed it is turned into a snapshot, optionally appended to an export file, and started again
+////////////////////////////////////////////////////////////////////////////////
+class FrameStats {
+public:
+
+	static constexpr int		MAX_RECENT_SPIKES = 64;
+
+	struct Spike {
+		int64_t			p_FrameIndex;
+		const char*		p_Label; // nullptr for the whole frame
+		TimerNanos		p_Time;
+		TimerNanos		p_Budget;
+	};
+
+	// adds the time from construction to destruction or Finish to a subsystem for the current frame, same as DebugTiming
+	class Scope {
+	public:
+						Scope				( const char* label, FrameStats& stats = Singleton() ) : m_Stats(stats), m_Label(label), m_Timer(std::chrono::steady_clock::now()) {}
+						~Scope				( void ) { Finish(); }
+		void			Finish				( void );
+	private:
+		FrameStats&		m_Stats;
+		const char*		m_Label;
+		TimerPoint		m_Timer;
+		bool			m_Finished = false;
+	};
+
+	inline static FrameStats&			Singleton				( void ) { static FrameStats instance; return instance; }
+
+										FrameStats				( void ) = default;
+										~FrameStats				( void ) { StopExport(); }
+
+	// safe to call from any thread, times for the same label within a frame are summed
+	void								AddSubsystemTime		( const char* label, TimerNanos time );
+	void								EndFrame				( TimerNanos frame_time );
+	void								Reset					( void );
+
+	// a zero budget turns spike detection off
+	inline void							SetFrameBudget			( TimerNanos budget ) { m_Frame.p_Budget = budget; }
+	void								SetBudget				( const char* label, TimerNanos budget );
+	inline void							SetInterval				( TimerNanos interval ) { m_Interval = interval; }
+
+	bool								StartExport				( std::string_view filename, FrameStatsFormat format, bool append = false );
+	void								StopExport				( void );
+	inline bool							IsExporting				( void ) const { return m_ExportFile.is_open(); }
+
+	FrameStatsSnapshot					GetSnapshot				( bool interval_only = false ) const;
+	// the most recent completed interval, empty until the first interval has passed
+	inline const FrameStatsSnapshot&	GetLastIntervalSnapshot	( void ) const { return m_LastIntervalSnapshot; }
+	inline const LatencyHistogram&		GetFrameHistogram		( void ) const { return m_Frame.p_Total; }
+	const LatencyHistogram*				GetSubsystemHistogram	( const char* label ) const;
+	// a copy, as spikes are recorded under the lock while subsystem times can arrive from any thread
+	std::deque<Spike>					GetRecentSpikes			( void ) const;
+	inline int64_t						GetFrameIndex			( void ) const { return m_FrameIndex; }
+
+	static std::string					ToCSVHeader				( void );
+	static std::string					ToCSV					( const FrameStatsSnapshot& snapshot );
+
+private:
+
+	struct Tracked {
+		std::string			p_Name;
+		TimerNanos			p_Budget = TimerNanos::zero();
+		TimerNanos			p_CurrentFrame = TimerNanos::zero();
+		bool				p_UsedThisFrame = false;
+		LatencyHistogram	p_Total;
+		LatencyHistogram	p_Interval;
+		int64_t				p_TotalSpikes = 0;
+		int64_t				p_IntervalSpikes = 0;
+	};
+
+	Tracked&							FindSubsystem			( const char* label );
+	void								RecordTracked			( Tracked& tracked, TimerNanos time, const char* label );
+	FrameStatsSummary					Summarise				( const Tracked& tracked, bool interval_only ) const;
+	void								FinishInterval			( void );
+
+	mutable std::mutex					m_SubsystemLock;
+	std::list<Tracked>					m_Subsystems; // list so references stay put as new subsystems are found
+	Tracked								m_Frame;
+	std::deque<Spike>					m_RecentSpikes;
+
+	int64_t								m_FrameIndex = 0;
+	TimerNanos							m_TotalTime = TimerNanos::zero();
+	TimerNanos							m_IntervalTime = TimerNanos::zero();
+	TimerNanos							m_Interval = std::chrono::seconds(5);
+	FrameStatsSnapshot					m_LastIntervalSnapshot;
+
+	std::ofstream						m_ExportFile;
+	FrameStatsFormat					m_ExportFormat = FrameStatsFormat::CSV;
+};
+
+} // namespace Neshny
+
+namespace meta {
+	template<> inline auto registerMembers<Neshny::FrameStatsSummary>() {
+		return members(
+			member("Name", &Neshny::FrameStatsSummary::p_Name)
+			,member("Count", &Neshny::FrameStatsSummary::p_Count)
+			,member("MeanMs", &Neshny::FrameStatsSummary::p_MeanMs)
+			,member("P50Ms", &Neshny::FrameStatsSummary::p_P50Ms)
+			,member("P95Ms", &Neshny::FrameStatsSummary::p_P95Ms)
+			,member("P99Ms", &Neshny::FrameStatsSummary::p_P99Ms)
+			,member("MaxMs", &Neshny::FrameStatsSummary::p_MaxMs)
+			,member("BudgetMs", &Neshny::FrameStatsSummary::p_BudgetMs)
+			,member("Spikes", &Neshny::FrameStatsSummary::p_Spikes)
+		);
+	}
+	template<> inline auto registerMembers<Neshny::FrameStatsSnapshot>() {
+		return members(
+			member("Frame", &Neshny::FrameStatsSnapshot::p_FrameIndex)
+			,member("Seconds", &Neshny::FrameStatsSnapshot::p_Seconds)
+			,member("IntervalSeconds", &Neshny::FrameStatsSnapshot::p_IntervalSeconds)
+			,member("Total", &Neshny::FrameStatsSnapshot::p_Frame)
+			,member("Subsystems", &Neshny::FrameStatsSnapshot::p_Subsystems)
+		);
+	}
+}
@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "GridCacheCPU.h"
+
+namespace Neshny {
+
+namespace GridCacheMath {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// i32(f32) in WGSL rounds toward zero and saturates, NaN has no defined result so it is taken as zero
+	inline int ToInt(float val) {
+		if (std::isnan(val)) {
+			return 0;
+		}
+		if (val <= (float)std::numeric_limits<int>::min()) {
+			return std::numeric_limits<int>::min();
+		}
+		if (val >= (float)std::numeric_limits<int>::max()) {
+			return std::numeric_limits<int>::max();
+		}
+		return (int)val;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// GetGridPos2D and GetGridPos3D in CacheUtils.wgsl for one axis
+	inline int PointCell(float pos, float grid_min, float inv_range, int grid_size) {
+		float frac = (pos - grid_min) * inv_range;
+		return std::clamp(ToInt(std::floor((float)grid_size * frac)), 0, grid_size - 1);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// the ends of the loops in ItemRadiusMain for one axis
+	inline void RadiusCells(float pos, float radius, float grid_min, float inv_range, int grid_size, int& min_cell, int& max_cell) {
+		float scale = (float)grid_size * inv_range;
+		min_cell = std::clamp(ToInt(std::floor(scale * ((pos - radius) - grid_min))), 0, grid_size - 1);
+		max_cell = std::clamp(ToInt(std::ceil(scale * ((pos + radius) - grid_min))), 0, grid_size - 1);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+GridCacheBuilder::GridCacheBuilder(const StructInfo& info, std::string_view pos_name, std::optional<std::string_view> radius_name, std::string_view id_name) {
+	for (const auto& member : info.p_Members) {
+		const int ints = (int)(member.p_Size / sizeof(int)) * (int)member.p_ArrayCount.value_or(1);
+		if ((member.p_Name == id_name) && (member.p_Type == MemberSpec::T_INT)) {
+			m_IdOffset = m_IntsPerItem;
+		}
+		if ((member.p_Name == pos_name) && ((member.p_Type == MemberSpec::T_VEC2) || (member.p_Type == MemberSpec::T_VEC3))) {
+			m_PosOffset = m_IntsPerItem;
+			m_PosDimensions = member.p_Type == MemberSpec::T_VEC2 ? 2 : 3;
+		}
+		if (radius_name.has_value() && (member.p_Name == *radius_name) && (member.p_Type == MemberSpec::T_FLOAT)) {
+			m_RadiusOffset = m_IntsPerItem;
+		}
+		m_IntsPerItem += ints;
+	}
+	m_HasRadius = radius_name.has_value();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCacheBuilder::Generate2D(std::span<const int> snapshot, iVec2 grid_size, Vec2 grid_min, Vec2 grid_max, GridCacheLayout& out, std::string& err, int thread_count) const {
+	if (m_PosDimensions != 2) {
+		err = "2D grid caches need a vec2 position";
+		return false;
+	}
+	return Generate(snapshot, false, iVec3(grid_size.x, grid_size.y, 1), fVec3((float)grid_min.x, (float)grid_min.y, 0.0f), fVec3((float)grid_max.x, (float)grid_max.y, 0.0f), out, err, thread_count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCacheBuilder::Generate3D(std::span<const int> snapshot, iVec3 grid_size, Vec3 grid_min, Vec3 grid_max, GridCacheLayout& out, std::string& err, int thread_count) const {
+	if (m_PosDimensions != 3) {
+		err = "3D grid caches need a vec3 position";
+		return false;
+	}
+	return Generate(snapshot, true, grid_size, fVec3((float)grid_min.x, (float)grid_min.y, (float)grid_min.z), fVec3((float)grid_max.x, (float)grid_max.y, (float)grid_max.z), out, err, thread_count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename F>
+void GridCacheBuilder::ForEachCell(const int* item, bool is_3d, iVec3 grid_size, fVec3 grid_min, fVec3 grid_max, const F& fn) const {
+
+	const int dims = is_3d ? 3 : 2;
+	float pos[3] = { 0.0f, 0.0f, 0.0f };
+	float mins[3] = { grid_min.x, grid_min.y, grid_min.z };
+	float inv_range[3] = { 1.0f / (grid_max.x - grid_min.x), 1.0f / (grid_max.y - grid_min.y), 1.0f / (grid_max.z - grid_min.z) };
+	int sizes[3] = { grid_size.x, grid_size.y, grid_size.z };
+	memcpy(pos, item + m_PosOffset, dims * sizeof(float));
+
+	int lo[3] = { 0, 0, 0 };
+	int hi[3] = { 0, 0, 0 };
+	if (m_HasRadius) {
+		float radius;
+		memcpy(&radius, item + m_RadiusOffset, sizeof(float));
+		for (int d = 0; d < dims; d++) {
+			GridCacheMath::RadiusCells(pos[d], radius, mins[d], inv_range[d], sizes[d], lo[d], hi[d]);
+		}
+	} else {
+		for (int d = 0; d < dims; d++) {
+			lo[d] = hi[d] = GridCacheMath::PointCell(pos[d], mins[d], inv_range[d], sizes[d]);
+		}
+	}
+
+	for (int z = lo[2]; z <= hi[2]; z++) {
+		for (int y = lo[1]; y <= hi[1]; y++) {
+			int row = (y + z * sizes[1]) * sizes[0];
+			for (int x = lo[0]; x <= hi[0]; x++) {
+				fn(row + x);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// counts per thread over contiguous runs of items, then one pass over the cells turns them into each thread's place in each cell
+// so every thread fills its own slots and items come out in index order without sorting
+bool GridCacheBuilder::Generate(std::span<const int> snapshot, bool is_3d, iVec3 grid_size, fVec3 grid_min, fVec3 grid_max, GridCacheLayout& out, std::string& err, int thread_count) const {
+
+	if ((m_IdOffset < 0) || (m_PosOffset < 0)) {
+		err = "Entity has no int id or no position";
+		return false;
+	}
+	if (m_HasRadius && (m_RadiusOffset < 0)) {
+		err = "Radius is not a float member of the entity";
+		return false;
+	}
+	if ((grid_size.x <= 0) || (grid_size.y <= 0) || (grid_size.z <= 0)) {
+		err = "Grid size must be positive";
+		return false;
+	}
+
+	const int count = (int)(snapshot.size() / m_IntsPerItem);
+	const int num_cells = grid_size.x * grid_size.y * grid_size.z;
+#ifdef __EMSCRIPTEN__
+	const int threads = 1;
+#else
+	const int threads = std::clamp(std::min(thread_count, count / GRID_CACHE_MIN_PER_THREAD), 1, 64);
+#endif
+
+	std::vector<std::vector<int>> cursors(threads, std::vector<int>(num_cells, 0));
+	auto for_each_item = [&](int t, auto&& fn) {
+		const int start = (int)(((int64_t)count * t) / threads);
+		const int end = (int)(((int64_t)count * (t + 1)) / threads);
+		for (int i = start; i < end; i++) {
+			const int* item = snapshot.data() + (size_t)i * m_IntsPerItem;
+			if (item[m_IdOffset] < 0) {
+				continue;
+			}
+			ForEachCell(item, is_3d, grid_size, grid_min, grid_max, [&fn, i](int cell) { fn(i, cell); });
+		}
+	};
+
+	ParallelFor(threads, [&](int t) {
+		std::vector<int>& counts = cursors[t];
+		for_each_item(t, [&counts](int, int cell) { counts[cell]++; });
+	});
+
+	out.p_GridSize = grid_size;
+	out.p_Indices.assign((size_t)num_cells * 3, 0);
+	int total = 0;
+	for (int cell = 0; cell < num_cells; cell++) {
+		const int start = total;
+		for (int t = 0; t < threads; t++) {
+			int num = cursors[t][cell];
+			cursors[t][cell] = total;
+			total += num;
+		}
+		const int cell_count = total - start;
+		if (cell_count > 0) {
+			out.p_Indices[cell * 3] = cell_count;
+			out.p_Indices[cell * 3 + 1] = start;
+			out.p_Indices[cell * 3 + 2] = cell_count;
+		}
+	}
+	out.p_TotalSize = total;
+	out.p_Items.resize(total);
+
+	ParallelFor(threads, [&](int t) {
+		std::vector<int>& fill = cursors[t];
+		int* items = out.p_Items.data();
+		for_each_item(t, [&fill, items](int index, int cell) { items[fill[cell]++] = index; });
+	});
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCacheBuilder::Canonicalise(iVec3 grid_size, std::span<const int> indices, std::span<const int> items, GridCacheLayout& out, std::string& err) {
+
+	const int num_cells = grid_size.x * grid_size.y * grid_size.z;
+	if ((int64_t)indices.size() < (int64_t)num_cells * 3) {
+		err = std::format("Index buffer holds {} ints but the grid needs {}", indices.size(), (int64_t)num_cells * 3);
+		return false;
+	}
+
+	out.p_GridSize = grid_size;
+	out.p_Indices.assign((size_t)num_cells * 3, 0);
+	out.p_Items.clear();
+	for (int cell = 0; cell < num_cells; cell++) {
+		const int cell_count = indices[cell * 3];
+		const int offset = indices[cell * 3 + 1];
+		const int filled = indices[cell * 3 + 2];
+		if (cell_count == 0) {
+			if ((offset != 0) || (filled != 0)) {
+				err = std::format("Empty cell {} has offset {} and {} filled", cell, offset, filled);
+				return false;
+			}
+			continue;
+		}
+		if ((cell_count < 0) || (filled != cell_count) || (offset < 0) || ((int64_t)offset + cell_count > (int64_t)items.size())) {
+			err = std::format("Cell {} has {} items at offset {} with {} filled, which does not fit {} items", cell, cell_count, offset, filled, items.size());
+			return false;
+		}
+		const int start = (int)out.p_Items.size();
+		out.p_Items.insert(out.p_Items.end(), items.begin() + offset, items.begin() + offset + cell_count);
+		std::sort(out.p_Items.begin() + start, out.p_Items.end());
+		out.p_Indices[cell * 3] = cell_count;
+		out.p_Indices[cell * 3 + 1] = start;
+		out.p_Indices[cell * 3 + 2] = cell_count;
+	}
+	out.p_TotalSize = (int)out.p_Items.size();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCacheBuilder::Validate(const GridCacheLayout& expected, std::span<const int> indices, std::span<const int> items, std::string& err) {
+
+	GridCacheLayout found;
+	if (!Canonicalise(expected.p_GridSize, indices, items, found, err)) {
+		return false;
+	}
+	const int num_cells = expected.GetCellCount();
+	for (int cell = 0; cell < num_cells; cell++) {
+		auto expected_items = expected.GetCell(cell);
+		auto found_items = found.GetCell(cell);
+		if (!std::equal(expected_items.begin(), expected_items.end(), found_items.begin(), found_items.end())) {
+			const int x = cell % expected.p_GridSize.x;
+			const int y = (cell / expected.p_GridSize.x) % expected.p_GridSize.y;
+			const int z = cell / (expected.p_GridSize.x * expected.p_GridSize.y);
+			err = std::format("Cell ({}, {}, {}) holds {} items where {} were expected", x, y, z, found_items.size(), expected_items.size());
+			if (found_items.size() == expected_items.size()) {
+				auto mismatch = std::mismatch(expected_items.begin(), expected_items.end(), found_items.begin());
+				err = std::format("Cell ({}, {}, {}) holds item {} where {} was expected", x, y, z, *mismatch.second, *mismatch.first);
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace Neshny
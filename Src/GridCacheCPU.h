@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// below this many entities per thread a cache is not split up
+constexpr int GRID_CACHE_MIN_PER_THREAD = 16384;
+
+////////////////////////////////////////////////////////////////////////////////
+// the two buffers GridCache builds on the GPU, as the shaders in GridCache2D.wgsl and GridCache3D.wgsl leave them
+// p_Indices has three ints per cell - how many items it holds, where they start in p_Items, and how many were filled in
+// cells are numbered x first, then y, then z, and empty ones are all zero
+////////////////////////////////////////////////////////////////////////////////
+struct GridCacheLayout {
+
+	inline int					GetCellIndex		( iVec3 cell ) const { return cell.x + (cell.y + cell.z * p_GridSize.y) * p_GridSize.x; }
+	inline int					GetCellCount		( void ) const { return p_GridSize.x * p_GridSize.y * p_GridSize.z; }
+	inline std::span<const int>	GetCell				( int cell_index ) const { return std::span<const int>(p_Items).subspan(p_Indices[cell_index * 3 + 1], p_Indices[cell_index * 3]); }
+
+	iVec3				p_GridSize;
+	std::vector<int>	p_Indices;
+	std::vector<int>	p_Items;			// entity indices, only the first p_TotalSize are in use
+	int					p_TotalSize = 0;	// what the INDEX pass reports, one per item per cell it touches
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// builds what GridCache::Generate2DCache and Generate3DCache do from a snapshot of the entity, on the CPU
+// the GPU allocates each cell's run and fills it with atomics, so which cell comes first and the order within a cell change from run to run
+// this gives the one canonical layout - runs in order of cell and items in each in order of index - and Canonicalise puts a GPU layout into it
+// every cell position is worked out with the same float operations as the shaders, so the two agree exactly unless a driver fuses a multiply and add
+// a snapshot is every item's ints one after the other, as in EntityDeltaCodec, items with a negative id are not in the entity and skipped
+////////////////////////////////////////////////////////////////////////////////
+class GridCacheBuilder {
+public:
+								GridCacheBuilder	( const StructInfo& info, std::string_view pos_name, std::optional<std::string_view> radius_name, std::string_view id_name );
+
+	// false when the position is not a vec2 for 2D or a vec3 for 3D, or the radius is not a float
+	bool						Generate2D			( std::span<const int> snapshot, iVec2 grid_size, Vec2 grid_min, Vec2 grid_max, GridCacheLayout& out, std::string& err, int thread_count = 1 ) const;
+	bool						Generate3D			( std::span<const int> snapshot, iVec3 grid_size, Vec3 grid_min, Vec3 grid_max, GridCacheLayout& out, std::string& err, int thread_count = 1 ) const;
+
+	// indices and items as read back from the GPU buffers, items can be longer than the total in use
+	static bool					Canonicalise		( iVec3 grid_size, std::span<const int> indices, std::span<const int> items, GridCacheLayout& out, std::string& err );
+	// true if the GPU buffers hold the same cache as expected once put in canonical order, err names the first cell that differs otherwise
+	static bool					Validate			( const GridCacheLayout& expected, std::span<const int> indices, std::span<const int> items, std::string& err );
+
+	inline int					GetIntsPerItem		( void ) const { return m_IntsPerItem; }
+
+private:
+
+	bool						Generate			( std::span<const int> snapshot, bool is_3d, iVec3 grid_size, fVec3 grid_min, fVec3 grid_max, GridCacheLayout& out, std::string& err, int thread_count ) const;
+	// calls fn(cell_index) for each cell the item touches
+	template<typename F>
+	void						ForEachCell			( const int* item, bool is_3d, iVec3 grid_size, fVec3 grid_min, fVec3 grid_max, const F& fn ) const;
+
+	int							m_IntsPerItem = 0;
+	int							m_IdOffset = -1;
+	int							m_PosOffset = -1;
+	int							m_PosDimensions = 0;
+	int							m_RadiusOffset = -1;
+	bool						m_HasRadius = false;
+};
+
+} // namespace Neshny
@@ -0,0 +1,579 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Hashing.h"
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__SIZEOF_INT128__)
+	#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define NESHNY_HASH_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar port of XXH3 from xxHash 0.8 by Yann Collet (BSD 2-Clause, https://github.com/Cyan4973/xxHash)
+// the output is bit for bit the same as XXH3_64bits_withSeed and XXH3_128bits_withSeed
+////////////////////////////////////////////////////////////////////////////////
+namespace XXH3 {
+
+constexpr uint32_t PRIME32_1 = 0x9E3779B1U;
+constexpr uint32_t PRIME32_2 = 0x85EBCA77U;
+constexpr uint32_t PRIME32_3 = 0xC2B2AE3DU;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+constexpr size_t SECRET_SIZE_MIN = 136;
+constexpr size_t SECRET_CONSUME_RATE = 8;
+constexpr size_t MIDSIZE_MAX = 240;
+constexpr size_t MIDSIZE_STARTOFFSET = 3;
+constexpr size_t MIDSIZE_LASTOFFSET = 17;
+constexpr size_t SECRET_LASTACC_START = 7;
+constexpr size_t SECRET_MERGEACCS_START = 11;
+constexpr size_t STRIPES_PER_BLOCK = (HASH_SECRET_SIZE - HASH_STRIPE_SIZE) / SECRET_CONSUME_RATE;
+constexpr size_t HASH_BLOCK_SIZE = HASH_STRIPE_SIZE * STRIPES_PER_BLOCK;
+
+alignas(64) constexpr unsigned char DEFAULT_SECRET[HASH_SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t Swap64(uint64_t val) {
+	return ((val << 56) & 0xFF00000000000000ULL) | ((val << 40) & 0x00FF000000000000ULL) | ((val << 24) & 0x0000FF0000000000ULL) | ((val << 8) & 0x000000FF00000000ULL) |
+		((val >> 8) & 0x00000000FF000000ULL) | ((val >> 24) & 0x0000000000FF0000ULL) | ((val >> 40) & 0x000000000000FF00ULL) | ((val >> 56) & 0x00000000000000FFULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint32_t Swap32(uint32_t val) {
+	return (val << 24) | ((val << 8) & 0x00FF0000U) | ((val >> 8) & 0x0000FF00U) | (val >> 24);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint32_t ReadLE32(const unsigned char* ptr) {
+	uint32_t val;
+	memcpy(&val, ptr, sizeof(val));
+	if constexpr (std::endian::native == std::endian::big) {
+		val = Swap32(val);
+	}
+	return val;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t ReadLE64(const unsigned char* ptr) {
+	uint64_t val;
+	memcpy(&val, ptr, sizeof(val));
+	if constexpr (std::endian::native == std::endian::big) {
+		val = Swap64(val);
+	}
+	return val;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void WriteLE64(unsigned char* ptr, uint64_t val) {
+	if constexpr (std::endian::native == std::endian::big) {
+		val = Swap64(val);
+	}
+	memcpy(ptr, &val, sizeof(val));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline Hash128 Mult64To128(uint64_t lhs, uint64_t rhs) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t product = (__uint128_t)lhs * rhs;
+	return { (uint64_t)product, (uint64_t)(product >> 64) };
+#elif defined(_MSC_VER) && defined(_M_X64)
+	uint64_t high;
+	uint64_t low = _umul128(lhs, rhs, &high);
+	return { low, high };
+#else
+	uint64_t lo_lo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+	uint64_t hi_lo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+	uint64_t lo_hi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+	uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+	return { lower, upper };
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t Mul128Fold64(uint64_t lhs, uint64_t rhs) {
+	Hash128 product = Mult64To128(lhs, rhs);
+	return product.p_Low ^ product.p_High;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t XorShift64(uint64_t val, int shift) {
+	return val ^ (val >> shift);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t XXH64Avalanche(uint64_t hash) {
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t Avalanche(uint64_t hash) {
+	hash = XorShift64(hash, 37);
+	hash *= PRIME_MX1;
+	return XorShift64(hash, 32);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t RRMXMX(uint64_t hash, uint64_t len) {
+	hash ^= std::rotl(hash, 49) ^ std::rotl(hash, 24);
+	hash *= PRIME_MX2;
+	hash ^= (hash >> 35) + len;
+	hash *= PRIME_MX2;
+	return XorShift64(hash, 28);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t Mix16B(const unsigned char* input, const unsigned char* secret, uint64_t seed) {
+	uint64_t input_lo = ReadLE64(input);
+	uint64_t input_hi = ReadLE64(input + 8);
+	return Mul128Fold64(input_lo ^ (ReadLE64(secret) + seed), input_hi ^ (ReadLE64(secret + 8) - seed));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline Hash128 Mix32B(Hash128 acc, const unsigned char* input_1, const unsigned char* input_2, const unsigned char* secret, uint64_t seed) {
+	acc.p_Low += Mix16B(input_1, secret, seed);
+	acc.p_Low ^= ReadLE64(input_2) + ReadLE64(input_2 + 8);
+	acc.p_High += Mix16B(input_2, secret + 16, seed);
+	acc.p_High ^= ReadLE64(input_1) + ReadLE64(input_1 + 8);
+	return acc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Len0To16_64(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	if (len > 8) {
+		uint64_t bitflip_1 = (ReadLE64(secret + 24) ^ ReadLE64(secret + 32)) + seed;
+		uint64_t bitflip_2 = (ReadLE64(secret + 40) ^ ReadLE64(secret + 48)) - seed;
+		uint64_t input_lo = ReadLE64(input) ^ bitflip_1;
+		uint64_t input_hi = ReadLE64(input + len - 8) ^ bitflip_2;
+		uint64_t acc = len + Swap64(input_lo) + input_hi + Mul128Fold64(input_lo, input_hi);
+		return Avalanche(acc);
+	}
+	if (len >= 4) {
+		seed ^= (uint64_t)Swap32((uint32_t)seed) << 32;
+		uint32_t input_1 = ReadLE32(input);
+		uint32_t input_2 = ReadLE32(input + len - 4);
+		uint64_t bitflip = (ReadLE64(secret + 8) ^ ReadLE64(secret + 16)) - seed;
+		uint64_t input_64 = input_2 + ((uint64_t)input_1 << 32);
+		return RRMXMX(input_64 ^ bitflip, len);
+	}
+	if (len > 0) {
+		uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | ((uint32_t)input[len - 1]) | ((uint32_t)len << 8);
+		uint64_t bitflip = (ReadLE32(secret) ^ ReadLE32(secret + 4)) + seed;
+		return XXH64Avalanche((uint64_t)combined ^ bitflip);
+	}
+	return XXH64Avalanche(seed ^ (ReadLE64(secret + 56) ^ ReadLE64(secret + 64)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Len17To128_64(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	uint64_t acc = len * PRIME64_1;
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc += Mix16B(input + 48, secret + 96, seed);
+				acc += Mix16B(input + len - 64, secret + 112, seed);
+			}
+			acc += Mix16B(input + 32, secret + 64, seed);
+			acc += Mix16B(input + len - 48, secret + 80, seed);
+		}
+		acc += Mix16B(input + 16, secret + 32, seed);
+		acc += Mix16B(input + len - 32, secret + 48, seed);
+	}
+	acc += Mix16B(input, secret, seed);
+	acc += Mix16B(input + len - 16, secret + 16, seed);
+	return Avalanche(acc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Len129To240_64(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	uint64_t acc = len * PRIME64_1;
+	const int num_rounds = (int)len / 16;
+	for (int i = 0; i < 8; i++) {
+		acc += Mix16B(input + 16 * i, secret + 16 * i, seed);
+	}
+	uint64_t acc_end = Mix16B(input + len - 16, secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET, seed);
+	acc = Avalanche(acc);
+	for (int i = 8; i < num_rounds; i++) {
+		acc_end += Mix16B(input + 16 * i, secret + 16 * (i - 8) + MIDSIZE_STARTOFFSET, seed);
+	}
+	return Avalanche(acc + acc_end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Hash128 Len0To16_128(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	if (len > 8) {
+		uint64_t bitflip_lo = (ReadLE64(secret + 32) ^ ReadLE64(secret + 40)) - seed;
+		uint64_t bitflip_hi = (ReadLE64(secret + 48) ^ ReadLE64(secret + 56)) + seed;
+		uint64_t input_lo = ReadLE64(input);
+		uint64_t input_hi = ReadLE64(input + len - 8);
+		Hash128 m128 = Mult64To128(input_lo ^ input_hi ^ bitflip_lo, PRIME64_1);
+		m128.p_Low += (uint64_t)(len - 1) << 54;
+		input_hi ^= bitflip_hi;
+		m128.p_High += input_hi + (uint64_t)(uint32_t)input_hi * (PRIME32_2 - 1);
+		m128.p_Low ^= Swap64(m128.p_High);
+		Hash128 h128 = Mult64To128(m128.p_Low, PRIME64_2);
+		h128.p_High += m128.p_High * PRIME64_2;
+		return { Avalanche(h128.p_Low), Avalanche(h128.p_High) };
+	}
+	if (len >= 4) {
+		seed ^= (uint64_t)Swap32((uint32_t)seed) << 32;
+		uint32_t input_lo = ReadLE32(input);
+		uint32_t input_hi = ReadLE32(input + len - 4);
+		uint64_t input_64 = input_lo + ((uint64_t)input_hi << 32);
+		uint64_t bitflip = (ReadLE64(secret + 16) ^ ReadLE64(secret + 24)) + seed;
+		Hash128 m128 = Mult64To128(input_64 ^ bitflip, PRIME64_1 + (len << 2));
+		m128.p_High += (m128.p_Low << 1);
+		m128.p_Low ^= (m128.p_High >> 3);
+		m128.p_Low = XorShift64(m128.p_Low, 35);
+		m128.p_Low *= PRIME_MX2;
+		m128.p_Low = XorShift64(m128.p_Low, 28);
+		m128.p_High = Avalanche(m128.p_High);
+		return m128;
+	}
+	if (len > 0) {
+		uint32_t combined_lo = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | ((uint32_t)input[len - 1]) | ((uint32_t)len << 8);
+		uint32_t combined_hi = std::rotl(Swap32(combined_lo), 13);
+		uint64_t bitflip_lo = (ReadLE32(secret) ^ ReadLE32(secret + 4)) + seed;
+		uint64_t bitflip_hi = (ReadLE32(secret + 8) ^ ReadLE32(secret + 12)) - seed;
+		return { XXH64Avalanche((uint64_t)combined_lo ^ bitflip_lo), XXH64Avalanche((uint64_t)combined_hi ^ bitflip_hi) };
+	}
+	uint64_t bitflip_lo = ReadLE64(secret + 64) ^ ReadLE64(secret + 72);
+	uint64_t bitflip_hi = ReadLE64(secret + 80) ^ ReadLE64(secret + 88);
+	return { XXH64Avalanche(seed ^ bitflip_lo), XXH64Avalanche(seed ^ bitflip_hi) };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline Hash128 FinishMidSize128(Hash128 acc, size_t len, uint64_t seed) {
+	uint64_t low = acc.p_Low + acc.p_High;
+	uint64_t high = (acc.p_Low * PRIME64_1) + (acc.p_High * PRIME64_4) + ((len - seed) * PRIME64_2);
+	return { Avalanche(low), (uint64_t)0 - Avalanche(high) };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Hash128 Len17To128_128(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	Hash128 acc = { len * PRIME64_1, 0 };
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc = Mix32B(acc, input + 48, input + len - 64, secret + 96, seed);
+			}
+			acc = Mix32B(acc, input + 32, input + len - 48, secret + 64, seed);
+		}
+		acc = Mix32B(acc, input + 16, input + len - 32, secret + 32, seed);
+	}
+	acc = Mix32B(acc, input, input + len - 16, secret, seed);
+	return FinishMidSize128(acc, len, seed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Hash128 Len129To240_128(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed) {
+	Hash128 acc = { len * PRIME64_1, 0 };
+	for (size_t i = 32; i < 160; i += 32) {
+		acc = Mix32B(acc, input + i - 32, input + i - 16, secret + i - 32, seed);
+	}
+	acc = { Avalanche(acc.p_Low), Avalanche(acc.p_High) };
+	for (size_t i = 160; i <= len; i += 32) {
+		acc = Mix32B(acc, input + i - 32, input + i - 16, secret + MIDSIZE_STARTOFFSET + i - 160, seed);
+	}
+	acc = Mix32B(acc, input + len - 16, input + len - 32, secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, (uint64_t)0 - seed);
+	return FinishMidSize128(acc, len, seed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void InitAcc(uint64_t* acc) {
+	acc[0] = PRIME32_3;
+	acc[1] = PRIME64_1;
+	acc[2] = PRIME64_2;
+	acc[3] = PRIME64_3;
+	acc[4] = PRIME64_4;
+	acc[5] = PRIME32_2;
+	acc[6] = PRIME64_5;
+	acc[7] = PRIME32_1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void InitSecret(unsigned char* secret, uint64_t seed) {
+	for (int i = 0; i < HASH_SECRET_SIZE / 16; i++) {
+		WriteLE64(secret + 16 * i, ReadLE64(DEFAULT_SECRET + 16 * i) + seed);
+		WriteLE64(secret + 16 * i + 8, ReadLE64(DEFAULT_SECRET + 16 * i + 8) - seed);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// the hot loop for long inputs - eight independent 64 bit lanes, done two at a time with SSE2 where it is available
+// both versions give identical results, SSE2 is roughly 50% faster
+inline void Accumulate512(uint64_t* acc, const unsigned char* input, const unsigned char* secret) {
+	for (int lane = 0; lane < 8; lane++) {
+		uint64_t data_val = ReadLE64(input + lane * 8);
+		uint64_t data_key = data_val ^ ReadLE64(secret + lane * 8);
+		acc[lane ^ 1] += data_val;
+		acc[lane] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void Accumulate(uint64_t* acc, const unsigned char* input, const unsigned char* secret, size_t num_stripes) {
+#ifdef NESHNY_HASH_SSE2
+	__m128i vacc[4];
+	for (int i = 0; i < 4; i++) {
+		vacc[i] = _mm_loadu_si128((const __m128i*)acc + i);
+	}
+	for (size_t n = 0; n < num_stripes; n++) {
+		const __m128i* vinput = (const __m128i*)(input + n * HASH_STRIPE_SIZE);
+		const __m128i* vsecret = (const __m128i*)(secret + n * SECRET_CONSUME_RATE);
+		for (int i = 0; i < 4; i++) {
+			__m128i data_vec = _mm_loadu_si128(vinput + i);
+			__m128i data_key = _mm_xor_si128(data_vec, _mm_loadu_si128(vsecret + i));
+			__m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));
+			__m128i sum = _mm_add_epi64(vacc[i], _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2)));
+			vacc[i] = _mm_add_epi64(product, sum);
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		_mm_storeu_si128((__m128i*)acc + i, vacc[i]);
+	}
+#else
+	for (size_t n = 0; n < num_stripes; n++) {
+		Accumulate512(acc, input + n * HASH_STRIPE_SIZE, secret + n * SECRET_CONSUME_RATE);
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void ScrambleAcc(uint64_t* acc, const unsigned char* secret) {
+#ifdef NESHNY_HASH_SSE2
+	const __m128i prime = _mm_set1_epi32((int)PRIME32_1);
+	for (int i = 0; i < 4; i++) {
+		__m128i acc_vec = _mm_loadu_si128((const __m128i*)acc + i);
+		__m128i data_vec = _mm_xor_si128(acc_vec, _mm_srli_epi64(acc_vec, 47));
+		__m128i data_key = _mm_xor_si128(data_vec, _mm_loadu_si128((const __m128i*)secret + i));
+		__m128i product_lo = _mm_mul_epu32(data_key, prime);
+		__m128i product_hi = _mm_mul_epu32(_mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		_mm_storeu_si128((__m128i*)acc + i, _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32)));
+	}
+#else
+	for (int lane = 0; lane < 8; lane++) {
+		uint64_t val = XorShift64(acc[lane], 47);
+		val ^= ReadLE64(secret + lane * 8);
+		acc[lane] = val * PRIME32_1;
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline uint64_t MergeAccs(const uint64_t* acc, const unsigned char* secret, uint64_t start) {
+	uint64_t result = start;
+	for (int i = 0; i < 4; i++) {
+		result += Mul128Fold64(acc[2 * i] ^ ReadLE64(secret + 16 * i), acc[2 * i + 1] ^ ReadLE64(secret + 16 * i + 8));
+	}
+	return Avalanche(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline Hash128 MergeAccs128(const uint64_t* acc, const unsigned char* secret, uint64_t len) {
+	return {
+		MergeAccs(acc, secret + SECRET_MERGEACCS_START, len * PRIME64_1),
+		MergeAccs(acc, secret + HASH_SECRET_SIZE - 64 - SECRET_MERGEACCS_START, ~(len * PRIME64_2))
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void HashLong(uint64_t* acc, const unsigned char* input, size_t len, const unsigned char* secret) {
+	InitAcc(acc);
+	const size_t num_blocks = (len - 1) / HASH_BLOCK_SIZE;
+	for (size_t n = 0; n < num_blocks; n++) {
+		Accumulate(acc, input + n * HASH_BLOCK_SIZE, secret, STRIPES_PER_BLOCK);
+		ScrambleAcc(acc, secret + HASH_SECRET_SIZE - HASH_STRIPE_SIZE);
+	}
+	const size_t num_stripes = ((len - 1) - (HASH_BLOCK_SIZE * num_blocks)) / HASH_STRIPE_SIZE;
+	Accumulate(acc, input + num_blocks * HASH_BLOCK_SIZE, secret, num_stripes);
+	Accumulate512(acc, input + len - HASH_STRIPE_SIZE, secret + HASH_SECRET_SIZE - HASH_STRIPE_SIZE - SECRET_LASTACC_START);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// long inputs use a secret derived from the seed, shorter ones mix the seed in directly
+inline const unsigned char* LongSecret(uint64_t seed, unsigned char* custom_secret) {
+	if (seed == 0) {
+		return DEFAULT_SECRET;
+	}
+	InitSecret(custom_secret, seed);
+	return custom_secret;
+}
+
+} // namespace XXH3
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t HashBytes64(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* input = (const unsigned char*)data;
+	if (size <= 16) {
+		return XXH3::Len0To16_64(input, size, XXH3::DEFAULT_SECRET, seed);
+	} else if (size <= 128) {
+		return XXH3::Len17To128_64(input, size, XXH3::DEFAULT_SECRET, seed);
+	} else if (size <= XXH3::MIDSIZE_MAX) {
+		return XXH3::Len129To240_64(input, size, XXH3::DEFAULT_SECRET, seed);
+	}
+	alignas(64) unsigned char custom_secret[HASH_SECRET_SIZE];
+	const unsigned char* secret = XXH3::LongSecret(seed, custom_secret);
+	alignas(64) uint64_t acc[8];
+	XXH3::HashLong(acc, input, size, secret);
+	return XXH3::MergeAccs(acc, secret + XXH3::SECRET_MERGEACCS_START, (uint64_t)size * XXH3::PRIME64_1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Hash128 HashBytes128(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* input = (const unsigned char*)data;
+	if (size <= 16) {
+		return XXH3::Len0To16_128(input, size, XXH3::DEFAULT_SECRET, seed);
+	} else if (size <= 128) {
+		return XXH3::Len17To128_128(input, size, XXH3::DEFAULT_SECRET, seed);
+	} else if (size <= XXH3::MIDSIZE_MAX) {
+		return XXH3::Len129To240_128(input, size, XXH3::DEFAULT_SECRET, seed);
+	}
+	alignas(64) unsigned char custom_secret[HASH_SECRET_SIZE];
+	const unsigned char* secret = XXH3::LongSecret(seed, custom_secret);
+	alignas(64) uint64_t acc[8];
+	XXH3::HashLong(acc, input, size, secret);
+	return XXH3::MergeAccs128(acc, secret, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StreamingHasher::Reset(uint64_t seed) {
+	XXH3::InitAcc(m_Acc);
+	if (seed == 0) {
+		memcpy(m_Secret, XXH3::DEFAULT_SECRET, HASH_SECRET_SIZE);
+	} else if (seed != m_Seed) {
+		XXH3::InitSecret(m_Secret, seed);
+	}
+	m_Seed = seed;
+	m_BufferedSize = 0;
+	m_StripesSoFar = 0;
+	m_TotalSize = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StreamingHasher::ConsumeStripes(const unsigned char* input, size_t num_stripes, uint64_t* acc, size_t& stripes_so_far) const {
+	const unsigned char* secret = m_Secret + stripes_so_far * XXH3::SECRET_CONSUME_RATE;
+	if (num_stripes >= XXH3::STRIPES_PER_BLOCK - stripes_so_far) {
+		size_t stripes_this_iter = XXH3::STRIPES_PER_BLOCK - stripes_so_far;
+		do {
+			XXH3::Accumulate(acc, input, secret, stripes_this_iter);
+			XXH3::ScrambleAcc(acc, m_Secret + HASH_SECRET_SIZE - HASH_STRIPE_SIZE);
+			input += stripes_this_iter * HASH_STRIPE_SIZE;
+			num_stripes -= stripes_this_iter;
+			stripes_this_iter = XXH3::STRIPES_PER_BLOCK;
+			secret = m_Secret;
+		} while (num_stripes >= XXH3::STRIPES_PER_BLOCK);
+		stripes_so_far = 0;
+	}
+	if (num_stripes > 0) {
+		XXH3::Accumulate(acc, input, secret, num_stripes);
+		stripes_so_far += num_stripes;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StreamingHasher::Update(const void* data, size_t size) {
+	if (size == 0) {
+		return;
+	}
+	const unsigned char* input = (const unsigned char*)data;
+	const unsigned char* end = input + size;
+	m_TotalSize += size;
+
+	// small updates just land in the buffer, which is what makes hashing a struct one member at a time cheap
+	if (size <= HASH_BUFFER_SIZE - m_BufferedSize) {
+		memcpy(m_Buffer + m_BufferedSize, input, size);
+		m_BufferedSize += size;
+		return;
+	}
+
+	// the buffer is only ever consumed once more data arrives, so the final stripe is always available to the digest
+	constexpr size_t buffer_stripes = HASH_BUFFER_SIZE / HASH_STRIPE_SIZE;
+	if (m_BufferedSize) {
+		size_t load_size = HASH_BUFFER_SIZE - m_BufferedSize;
+		memcpy(m_Buffer + m_BufferedSize, input, load_size);
+		input += load_size;
+		ConsumeStripes(m_Buffer, buffer_stripes, m_Acc, m_StripesSoFar);
+		m_BufferedSize = 0;
+	}
+	if (end - input > HASH_BUFFER_SIZE) {
+		size_t num_stripes = (size_t)(end - 1 - input) / HASH_STRIPE_SIZE;
+		ConsumeStripes(input, num_stripes, m_Acc, m_StripesSoFar);
+		input += num_stripes * HASH_STRIPE_SIZE;
+		memcpy(m_Buffer + HASH_BUFFER_SIZE - HASH_STRIPE_SIZE, input - HASH_STRIPE_SIZE, HASH_STRIPE_SIZE);
+	}
+	memcpy(m_Buffer, input, (size_t)(end - input));
+	m_BufferedSize = (size_t)(end - input);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StreamingHasher::DigestLong(uint64_t* acc) const {
+	memcpy(acc, m_Acc, sizeof(m_Acc));
+	alignas(64) unsigned char last_stripe[HASH_STRIPE_SIZE];
+	const unsigned char* last_stripe_ptr;
+	if (m_BufferedSize >= HASH_STRIPE_SIZE) {
+		size_t num_stripes = (m_BufferedSize - 1) / HASH_STRIPE_SIZE;
+		size_t stripes_so_far = m_StripesSoFar;
+		ConsumeStripes(m_Buffer, num_stripes, acc, stripes_so_far);
+		last_stripe_ptr = m_Buffer + m_BufferedSize - HASH_STRIPE_SIZE;
+	} else {
+		// the end of the previous buffer still holds the bytes just before these ones
+		size_t catchup_size = HASH_STRIPE_SIZE - m_BufferedSize;
+		memcpy(last_stripe, m_Buffer + HASH_BUFFER_SIZE - catchup_size, catchup_size);
+		memcpy(last_stripe + catchup_size, m_Buffer, m_BufferedSize);
+		last_stripe_ptr = last_stripe;
+	}
+	XXH3::Accumulate512(acc, last_stripe_ptr, m_Secret + HASH_SECRET_SIZE - HASH_STRIPE_SIZE - XXH3::SECRET_LASTACC_START);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t StreamingHasher::Digest64(void) const {
+	if (m_TotalSize > XXH3::MIDSIZE_MAX) {
+		alignas(64) uint64_t acc[8];
+		DigestLong(acc);
+		return XXH3::MergeAccs(acc, m_Secret + XXH3::SECRET_MERGEACCS_START, m_TotalSize * XXH3::PRIME64_1);
+	}
+	return HashBytes64(m_Buffer, (size_t)m_TotalSize, m_Seed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Hash128 StreamingHasher::Digest128(void) const {
+	if (m_TotalSize > XXH3::MIDSIZE_MAX) {
+		alignas(64) uint64_t acc[8];
+		DigestLong(acc);
+		return XXH3::MergeAccs128(acc, m_Secret, m_TotalSize);
+	}
+	return HashBytes128(m_Buffer, (size_t)m_TotalSize, m_Seed);
+}
+
+} // namespace Neshny
@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+constexpr int HASH_SECRET_SIZE = 192;
+constexpr int HASH_STRIPE_SIZE = 64;
+constexpr int HASH_BUFFER_SIZE = 256;
+
+////////////////////////////////////////////////////////////////////////////////
+struct Hash128 {
+	uint64_t	p_Low = 0;
+	uint64_t	p_High = 0;
+
+	inline bool operator==(const Hash128& other) const { return (p_Low == other.p_Low) && (p_High == other.p_High); }
+	inline bool operator!=(const Hash128& other) const { return !(*this == other); }
+};
+
+// XXH3 compatible, so results match any other xxHash implementation and are safe to store on disk or send over the network
+uint64_t HashBytes64(const void* data, size_t size, uint64_t seed = 0);
+Hash128 HashBytes128(const void* data, size_t size, uint64_t seed = 0);
+inline uint64_t HashString64(std::string_view str, uint64_t seed = 0) { return HashBytes64(str.data(), str.size(), seed); }
+inline Hash128 HashString128(std::string_view str, uint64_t seed = 0) { return HashBytes128(str.data(), str.size(), seed); }
+
+////////////////////////////////////////////////////////////////////////////////
+// gives exactly the same result as hashing all the data at once with the same seed, no matter how it is split up
+////////////////////////////////////////////////////////////////////////////////
+class StreamingHasher {
+public:
+								StreamingHasher		( uint64_t seed = 0 ) { Reset(seed); }
+
+	void						Reset				( uint64_t seed = 0 );
+	void						Update				( const void* data, size_t size );
+	inline void					Update				( std::string_view str ) { Update(str.data(), str.size()); }
+	uint64_t					Digest64			( void ) const;
+	Hash128						Digest128			( void ) const;
+
+	inline uint64_t				GetTotalSize		( void ) const { return m_TotalSize; }
+
+	// little endian bytes of a number or enum, so the hash does not depend on the platform
+	template <class T>
+	inline void					UpdateValue			( T value ) {
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "UpdateValue only takes numbers and enums");
+		if constexpr (std::is_enum_v<T>) {
+			UpdateValue(static_cast<std::underlying_type_t<T>>(value));
+		} else if constexpr (std::is_same_v<T, bool>) {
+			unsigned char byte = value ? 1 : 0;
+			Update(&byte, 1);
+		} else {
+			unsigned char bytes[sizeof(T)];
+			memcpy(bytes, &value, sizeof(T));
+			if constexpr (std::endian::native == std::endian::big) {
+				std::reverse(bytes, bytes + sizeof(T));
+			}
+			Update(bytes, sizeof(T));
+		}
+	}
+
+private:
+
+	void						ConsumeStripes		( const unsigned char* input, size_t num_stripes, uint64_t* acc, size_t& stripes_so_far ) const;
+	void						DigestLong			( uint64_t* acc ) const;
+
+	uint64_t					m_Acc[8];
+	unsigned char				m_Secret[HASH_SECRET_SIZE];
+	unsigned char				m_Buffer[HASH_BUFFER_SIZE];
+	size_t						m_BufferedSize = 0;
+	size_t						m_StripesSoFar = 0;
+	uint64_t					m_TotalSize = 0;
+	uint64_t					m_Seed = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Hashing of Metastuff registered structs
+// members are fed one at a time in a canonical form instead of serialising the whole struct first:
+// integers are widened to 64 bits, floats to doubles with -0 and NaN normalised, containers are prefixed by their size
+// so changing a member from int to int64_t or float to double keeps the same hash, but reordering or renaming members does not
+////////////////////////////////////////////////////////////////////////////////
+namespace Hashing {
+
+template <typename T, typename = std::enable_if_t <meta::isRegistered<T>()>>
+void HashInto(StreamingHasher& hasher, const T& obj);
+
+template <typename T, typename = std::enable_if_t <!meta::isRegistered<T>()>, typename = void>
+void HashInto(StreamingHasher& hasher, const T& obj);
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const T& val) {
+	if constexpr (std::is_same_v<T, bool>) {
+		hasher.UpdateValue(val);
+	} else if constexpr (std::is_floating_point_v<T>) {
+		double dval = (double)val;
+		if (dval == 0.0) {
+			dval = 0.0; // -0 and 0 compare equal so must hash equal
+		} else if (std::isnan(dval)) {
+			dval = std::numeric_limits<double>::quiet_NaN();
+		}
+		hasher.UpdateValue(std::bit_cast<uint64_t>(dval));
+	} else if constexpr (std::is_enum_v<T>) {
+		HashByType(hasher, static_cast<std::underlying_type_t<T>>(val));
+	} else if constexpr (std::is_signed_v<T>) {
+		hasher.UpdateValue((int64_t)val);
+	} else if constexpr (std::is_unsigned_v<T>) {
+		hasher.UpdateValue((uint64_t)val);
+	} else {
+		static_assert(!sizeof(T), "Type cannot be hashed, register it with Metastuff or add a HashByType overload");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void HashByType(StreamingHasher& hasher, const std::string& val) {
+	hasher.UpdateValue((uint64_t)val.size());
+	hasher.Update(val);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const BaseVec2<T>& val) {
+	HashInto(hasher, val.x);
+	HashInto(hasher, val.y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const BaseVec3<T>& val) {
+	HashInto(hasher, val.x);
+	HashInto(hasher, val.y);
+	HashInto(hasher, val.z);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const BaseVec4<T>& val) {
+	HashInto(hasher, val.x);
+	HashInto(hasher, val.y);
+	HashInto(hasher, val.z);
+	HashInto(hasher, val.w);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const std::optional<T>& val) {
+	HashInto(hasher, val.has_value());
+	if (val) {
+		HashInto(hasher, *val);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const std::vector<T>& val) {
+	hasher.UpdateValue((uint64_t)val.size());
+	for (const auto& elem : val) {
+		HashInto(hasher, (const T&)elem); // the cast makes std::vector<bool> elements plain bools
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline void HashByType(StreamingHasher& hasher, const std::list<T>& val) {
+	hasher.UpdateValue((uint64_t)val.size());
+	for (const auto& elem : val) {
+		HashInto(hasher, elem);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename K, typename T>
+inline void HashByType(StreamingHasher& hasher, const std::map<K, T>& val) {
+	hasher.UpdateValue((uint64_t)val.size());
+	for (const auto& [key, value] : val) {
+		HashInto(hasher, key);
+		HashInto(hasher, value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename K, typename T>
+inline void HashByType(StreamingHasher& hasher, const std::unordered_map<K, T>& val) {
+	// iteration order differs between platforms and insertion histories, so each entry is hashed alone and combined with a sum
+	Hash128 combined;
+	for (const auto& [key, value] : val) {
+		StreamingHasher entry_hasher;
+		HashInto(entry_hasher, key);
+		HashInto(entry_hasher, value);
+		Hash128 entry = entry_hasher.Digest128();
+		combined.p_Low += entry.p_Low;
+		combined.p_High += entry.p_High;
+	}
+	hasher.UpdateValue((uint64_t)val.size());
+	hasher.UpdateValue(combined.p_Low);
+	hasher.UpdateValue(combined.p_High);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class HasherFunc {
+public:
+	HasherFunc(const T& obj, StreamingHasher& hasher) : m_ClassObj{obj}, m_Hasher{hasher} {}
+
+	template<typename Member>
+	void operator()(Member& member) {
+		if (member.canGetConstRef()) {
+			HashInto(m_Hasher, member.get(m_ClassObj));
+		} else if (member.hasGetter()) {
+			HashInto(m_Hasher, member.getCopy(m_ClassObj));
+		}
+	}
+
+private:
+	const T&			m_ClassObj;
+	StreamingHasher&	m_Hasher;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T, typename>
+inline void HashInto(StreamingHasher& hasher, const T& obj) {
+	HasherFunc<T> hasher_func(obj, hasher);
+	meta::doForAllMembers<T>(hasher_func);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T, typename, typename>
+inline void HashInto(StreamingHasher& hasher, const T& obj) {
+	HashByType(hasher, obj);
+}
+
+} // namespace Hashing
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline uint64_t HashStruct64(const T& obj, uint64_t seed = 0) {
+	StreamingHasher hasher(seed);
+	Hashing::HashInto(hasher, obj);
+	return hasher.Digest64();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+inline Hash128 HashStruct128(const T& obj, uint64_t seed = 0) {
+	StreamingHasher hasher(seed);
+	Hashing::HashInto(hasher, obj);
+	return hasher.Digest128();
+}
+
+} // namespace Neshny
@@ -11,7 +11,16 @@
 #include "LinearAlgebra.cpp"
 #include "Preprocessor.cpp"
 #include "NeshnyUtils.cpp"
+#include "FileIO.cpp"
+#include "Hashing.cpp"
+#include "Culling.cpp"
+#include "RayQueries.cpp"
+#include "Broadphase.cpp"
+#include "LooseTree.cpp"
+#include "GridCacheCPU.cpp"
+#include "EntitySnapshot.cpp"
 #include "NeshnyDebugUtils.cpp"
+#include "StagingPool.cpp"
 #ifdef NESHNY_WEBGPU
     #include "WebGPU/WGPUUtils.cpp"
     #include "WebGPU/EntityWebGPU.cpp"
@@ -22,7 +31,13 @@
     #include "OpenGL/PipelineGL.cpp"
 #endif
 #include "Core.cpp"
+#include "FrameStats.cpp"
+#include "AllocationTracker.cpp"
+#include "FixedStepScheduler.cpp"
+#include "JobGraph.cpp"
 #include "Resources.cpp"
+#include "TextureAtlas.cpp"
+#include "Audio.cpp"
 #include "EditorViewers.cpp"
 #include "Geometry.cpp"
 #ifndef NESHNY_SKIP_TESTS
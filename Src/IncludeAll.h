@@ -2,27 +2,37 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <list>
 #include <set>
+#include <map>
+#include <unordered_map>
 #include <deque>
 #include <stack>
 #include <math.h>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <assert.h>
 #include <stdio.h>
 #include <string>
 #include <optional>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
 #include <variant>
 #include <chrono>
 #include <format>
 #include <stdint.h>
 #include <span>
+#include <bit>
+#include <barrier>
 #include <sstream>
 #include <string_view>
+#include <charconv>
 #include <functional>
 #include <source_location>
 
@@ -31,9 +41,13 @@
 #endif
 
 #include "NeshnyUtils.h"
+#include "CodeBuilder.h"
+#include "Sorting.h"
+#include "FileIO.h"
 #include "LinearAlgebra.h"
 #include "NeshnyDebugUtils.h"
 #include "Preprocessor.h"
+#include "StagingPool.h"
 #ifdef NESHNY_WEBGPU
     #include "WebGPU/WGPUUtils.h"
 #elif defined(NESHNY_GL)
@@ -41,8 +55,22 @@
 #endif
 #include "NeshnyStructs.h"
 #include "Serialization.h"
+#include "Hashing.h"
+#include "Culling.h"
+#include "RayQueries.h"
+#include "Broadphase.h"
+#include "LooseTree.h"
+#include "GridCacheCPU.h"
+#include "EntitySnapshot.h"
+#include "ComponentStore.h"
 #include "Core.h"
+#include "FrameStats.h"
+#include "AllocationTracker.h"
+#include "FixedStepScheduler.h"
+#include "JobGraph.h"
 #include "Resources.h"
+#include "TextureAtlas.h"
+#include "Audio.h"
 #ifdef NESHNY_WEBGPU
     #include "WebGPU/EntityWebGPU.h"
 #elif defined(NESHNY_GL)
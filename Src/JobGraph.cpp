@@ -0,0 +1,332 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "JobGraph.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+JobGraph::JobGraph(int thread_count) {
+#ifndef __EMSCRIPTEN__
+	// the calling thread is always one of them
+	for (int i = 1; i < std::clamp(thread_count, 1, 64); i++) {
+		m_Threads.emplace_back(&JobGraph::WorkerLoop, this);
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+JobGraph::~JobGraph(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Stop = true;
+	}
+	m_WakeCondition.notify_all();
+	for (auto& thread : m_Threads) {
+		thread.join();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int JobGraph::GetResource(const std::string& name) {
+	auto found = m_Resources.find(name);
+	if (found != m_Resources.end()) {
+		return found->second;
+	}
+	int index = (int)m_Resources.size();
+	m_Resources.insert({ name, index });
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int JobGraph::AddJob(std::string_view name, std::function<void()> job, const JobAccess& access) {
+	return AddParallelFor(name, 1, 1, [job = std::move(job)](int, int) { job(); }, access);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int JobGraph::AddParallelFor(std::string_view name, int count, int chunk_size, std::function<void(int start, int end)> job, const JobAccess& access) {
+	Job added;
+	added.p_Name = name;
+	added.p_Work = std::move(job);
+	added.p_Count = std::max(0, count);
+	added.p_ChunkSize = std::max(1, chunk_size);
+	for (const auto& read : access.p_Reads) {
+		added.p_Reads.push_back(GetResource(read));
+	}
+	for (const auto& write : access.p_Writes) {
+		added.p_Writes.push_back(GetResource(write));
+	}
+	m_Jobs.push_back(std::move(added));
+	m_Compiled = false;
+	return (int)m_Jobs.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::AddDependency(int before, int after) {
+	if ((before < 0) || (before >= (int)m_Jobs.size()) || (after < 0) || (after >= (int)m_Jobs.size())) {
+		return;
+	}
+	m_Jobs[after].p_After.push_back(before);
+	m_Compiled = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::SetCount(int handle, int count) {
+	if ((handle >= 0) && (handle < (int)m_Jobs.size())) {
+		m_Jobs[handle].p_Count = std::max(0, count);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::Clear(void) {
+	m_Jobs.clear();
+	m_Resources.clear();
+	m_SuccessorStart.clear();
+	m_Successors.clear();
+	m_InitialWaiting.clear();
+	m_Compiled = false;
+	m_Error.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool JobGraph::Compile(std::string& err) {
+
+	const int num_jobs = (int)m_Jobs.size();
+	std::vector<std::vector<int>> before(num_jobs);
+
+	// walking in the order jobs were added, each resource remembers its last writer and who has read it since
+	std::vector<int> last_writer(m_Resources.size(), -1);
+	std::vector<std::vector<int>> readers(m_Resources.size());
+	for (int job = 0; job < num_jobs; job++) {
+		auto& deps = before[job];
+		deps = m_Jobs[job].p_After;
+		for (int resource : m_Jobs[job].p_Reads) {
+			if (last_writer[resource] >= 0) {
+				deps.push_back(last_writer[resource]);
+			}
+		}
+		for (int resource : m_Jobs[job].p_Writes) {
+			if (last_writer[resource] >= 0) {
+				deps.push_back(last_writer[resource]);
+			}
+			deps.insert(deps.end(), readers[resource].begin(), readers[resource].end());
+		}
+		for (int resource : m_Jobs[job].p_Reads) {
+			readers[resource].push_back(job);
+		}
+		for (int resource : m_Jobs[job].p_Writes) {
+			last_writer[resource] = job;
+			readers[resource].clear();
+		}
+		std::sort(deps.begin(), deps.end());
+		deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+	}
+
+	m_SuccessorStart.assign(num_jobs + 1, 0);
+	m_InitialWaiting.assign(num_jobs, 0);
+	for (int job = 0; job < num_jobs; job++) {
+		m_InitialWaiting[job] = (int)before[job].size();
+		for (int dep : before[job]) {
+			m_SuccessorStart[dep + 1]++;
+		}
+	}
+	for (int job = 0; job < num_jobs; job++) {
+		m_SuccessorStart[job + 1] += m_SuccessorStart[job];
+	}
+	m_Successors.resize(m_SuccessorStart[num_jobs]);
+	std::vector<int> cursor(m_SuccessorStart.begin(), m_SuccessorStart.end() - 1);
+	for (int job = 0; job < num_jobs; job++) {
+		for (int dep : before[job]) {
+			m_Successors[cursor[dep]++] = job;
+		}
+	}
+
+	// Kahn's algorithm, anything never freed up is in or behind a cycle
+	std::vector<int> waiting = m_InitialWaiting;
+	std::vector<int> open;
+	for (int job = 0; job < num_jobs; job++) {
+		if (waiting[job] == 0) {
+			open.push_back(job);
+		}
+	}
+	int visited = 0;
+	while (!open.empty()) {
+		int job = open.back();
+		open.pop_back();
+		visited++;
+		for (int i = m_SuccessorStart[job]; i < m_SuccessorStart[job + 1]; i++) {
+			if (--waiting[m_Successors[i]] == 0) {
+				open.push_back(m_Successors[i]);
+			}
+		}
+	}
+	if (visited < num_jobs) {
+		std::string names;
+		for (int job = 0; job < num_jobs; job++) {
+			if (waiting[job] > 0) {
+				names += (names.empty() ? "" : ", ") + m_Jobs[job].p_Name;
+			}
+		}
+		err = std::format("Job graph has a cycle through {}", names);
+		m_Error = err;
+		m_Compiled = false;
+		return false;
+	}
+
+	m_Ready.clear();
+	m_Ready.reserve(num_jobs);
+	m_Error.clear();
+	m_Compiled = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<int> JobGraph::GetDependencies(int handle) const {
+	std::vector<int> result;
+	if (!m_Compiled) {
+		return result;
+	}
+	for (int job = 0; job < (int)m_Jobs.size(); job++) {
+		for (int i = m_SuccessorStart[job]; i < m_SuccessorStart[job + 1]; i++) {
+			if (m_Successors[i] == handle) {
+				result.push_back(job);
+			}
+		}
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::MakeReady(int job) {
+	Job& ready = m_Jobs[job];
+	ready.p_NextChunk = 0;
+	ready.p_ChunksLeft = (ready.p_Count + ready.p_ChunkSize - 1) / ready.p_ChunkSize;
+	if (ready.p_ChunksLeft > 0) {
+		m_Ready.push_back(job);
+		return;
+	}
+	// an empty parallel for finishes straight away
+	m_JobsLeft--;
+	for (int i = m_SuccessorStart[job]; i < m_SuccessorStart[job + 1]; i++) {
+		if (--m_Jobs[m_Successors[i]].p_Waiting == 0) {
+			MakeReady(m_Successors[i]);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool JobGraph::Run(void) {
+
+	if (!m_Compiled) {
+		std::string err;
+		if (!Compile(err)) {
+			return false;
+		}
+	}
+	if (m_Jobs.empty()) {
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		// m_Ready has room for every job so pushing never reallocates
+		m_Ready.clear();
+		m_ReadyHead = 0;
+		m_JobsLeft = (int)m_Jobs.size();
+		m_JobException = nullptr;
+		for (int job = 0; job < (int)m_Jobs.size(); job++) {
+			m_Jobs[job].p_Waiting = m_InitialWaiting[job];
+		}
+		for (int job = 0; job < (int)m_Jobs.size(); job++) {
+			if (m_InitialWaiting[job] == 0) {
+				MakeReady(job);
+			}
+		}
+		m_Generation++;
+	}
+	m_WakeCondition.notify_all();
+
+	DoWork();
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		exception = m_JobException;
+		m_JobException = nullptr;
+	}
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::DoWork(void) {
+
+	std::unique_lock<std::mutex> lock(m_Lock);
+	while (true) {
+		m_WorkCondition.wait(lock, [this]() { return (m_JobsLeft == 0) || (m_ReadyHead < (int)m_Ready.size()); });
+		if (m_JobsLeft == 0) {
+			return;
+		}
+
+		const int job = m_Ready[m_ReadyHead];
+		Job& current = m_Jobs[job];
+		const int chunk = current.p_NextChunk++;
+		const int num_chunks = (current.p_Count + current.p_ChunkSize - 1) / current.p_ChunkSize;
+		if (current.p_NextChunk >= num_chunks) {
+			m_ReadyHead++;
+		}
+		if (m_ReadyHead < (int)m_Ready.size()) {
+			// each thread that takes a chunk wakes the next while there is more, so a big parallel for spreads without waking everyone at once
+			m_WorkCondition.notify_one();
+		}
+		const int start = chunk * current.p_ChunkSize;
+		const int end = std::min(start + current.p_ChunkSize, current.p_Count);
+		lock.unlock();
+
+		std::exception_ptr exception;
+		try {
+			current.p_Work(start, end);
+		} catch (...) {
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+		if (exception && !m_JobException) {
+			m_JobException = exception;
+		}
+		if (--current.p_ChunksLeft > 0) {
+			continue;
+		}
+		// a job that threw still counts as finished so the rest of the graph drains and Run can return
+		const int ready_before = (int)m_Ready.size();
+		m_JobsLeft--;
+		for (int i = m_SuccessorStart[job]; i < m_SuccessorStart[job + 1]; i++) {
+			if (--m_Jobs[m_Successors[i]].p_Waiting == 0) {
+				MakeReady(m_Successors[i]);
+			}
+		}
+		if (m_JobsLeft == 0) {
+			m_WorkCondition.notify_all();
+		} else if ((int)m_Ready.size() > ready_before) {
+			m_WorkCondition.notify_one();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void JobGraph::WorkerLoop(void) {
+	uint64_t seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Lock);
+			m_WakeCondition.wait(lock, [this, &seen_generation]() { return m_Stop || (m_Generation != seen_generation); });
+			if (m_Stop) {
+				return;
+			}
+			seen_generation = m_Generation;
+		}
+		DoWork();
+	}
+}
+
+} // namespace Neshny
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// what a job touches, by any name - a component, an entity type, a buffer
+struct JobAccess {
+	std::vector<std::string>	p_Reads;
+	std::vector<std::string>	p_Writes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// runs a frame's systems as a graph instead of one after another, on a pool of threads that sleep between runs
+// dependencies come from the order jobs are added and what they touch - a job runs after every earlier job that writes something it reads,
+// and one that writes runs after every earlier job that reads or writes the same thing, so jobs only ever wait on what came before them
+// AddDependency adds edges on top of that, which is the only way to make a cycle, and Run refuses to start a graph that has one
+// the graph is built once and run every frame, nothing is allocated by Run unless jobs were added since the last one
+// a parallel for is one job split into chunks that any thread can take, and jobs after it wait for every chunk
+////////////////////////////////////////////////////////////////////////////////
+class JobGraph {
+public:
+
+								JobGraph			( int thread_count = 1 );
+								~JobGraph			( void );
+
+								JobGraph			( const JobGraph& ) = delete;
+	JobGraph&					operator=			( const JobGraph& ) = delete;
+
+	// not thread safe, only call between Runs, each returns a handle for AddDependency and SetCount
+	int							AddJob				( std::string_view name, std::function<void()> job, const JobAccess& access = {} );
+	// job(start, end) is called for each chunk of up to chunk_size items out of count
+	int							AddParallelFor		( std::string_view name, int count, int chunk_size, std::function<void(int start, int end)> job, const JobAccess& access = {} );
+	// after waits for before even when they share nothing
+	void						AddDependency		( int before, int after );
+	// changes how many items a parallel for covers, without rebuilding the graph
+	void						SetCount			( int handle, int count );
+	void						Clear				( void );
+
+	// false if the graph has a cycle, err names the jobs in it
+	bool						Compile				( std::string& err );
+	// runs every job once and returns when they are all done, rethrowing the first exception a job threw
+	// compiles first if the graph has changed, and false without running anything if that fails
+	bool						Run					( void );
+
+	inline int					GetJobCount			( void ) const { return (int)m_Jobs.size(); }
+	inline int					GetThreadCount		( void ) const { return (int)m_Threads.size() + 1; }
+	inline const std::string&	GetError			( void ) const { return m_Error; }
+	// the jobs each one waits on directly once compiled, for debug views
+	std::vector<int>			GetDependencies		( int handle ) const;
+
+private:
+
+	struct Job {
+		std::string						p_Name;
+		std::function<void(int, int)>	p_Work;
+		int								p_Count = 1;
+		int								p_ChunkSize = 1;
+		std::vector<int>				p_Reads;			// resource indices
+		std::vector<int>				p_Writes;
+		std::vector<int>				p_After;			// from AddDependency
+
+		// per run, only touched with the lock held
+		int								p_Waiting = 0;		// jobs before this not yet finished
+		int								p_NextChunk = 0;
+		int								p_ChunksLeft = 0;
+	};
+
+	int							GetResource			( const std::string& name );
+	// takes and runs chunks until every job is finished, on workers and the calling thread alike
+	void						DoWork				( void );
+	// with the lock held
+	void						MakeReady			( int job );
+	void						WorkerLoop			( void );
+
+	std::vector<Job>			m_Jobs;
+	std::unordered_map<std::string, int>	m_Resources;
+	bool						m_Compiled = false;
+	std::string					m_Error;
+
+	// compiled, successors of job i are m_Successors[m_SuccessorStart[i]] up to m_SuccessorStart[i + 1]
+	std::vector<int>			m_SuccessorStart;
+	std::vector<int>			m_Successors;
+	std::vector<int>			m_InitialWaiting;
+
+	std::vector<std::thread>	m_Threads;
+	std::mutex					m_Lock;
+	std::condition_variable		m_WakeCondition;	// a new run has started
+	std::condition_variable		m_WorkCondition;	// a job became ready or the run finished
+	uint64_t					m_Generation = 0;
+	std::vector<int>			m_Ready;			// jobs with chunks left to take, each added once per run so it never grows
+	int							m_ReadyHead = 0;
+	int							m_JobsLeft = 0;
+	bool						m_Stop = false;
+	std::exception_ptr			m_JobException;
+};
+
+} // namespace Neshny
@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "LooseTree.h"
+
+namespace Neshny {
+
+namespace LooseTreeShapes {
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D, typename B>
+	inline bool Overlaps(const B& a, const B& b) {
+		for (int axis = 0; axis < D; axis++) {
+			if ((a.p_Min[axis] > b.p_Max[axis]) || (b.p_Min[axis] > a.p_Max[axis])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D, typename B>
+	inline bool Contains(const B& outer, const B& inner) {
+		for (int axis = 0; axis < D; axis++) {
+			if ((inner.p_Min[axis] < outer.p_Min[axis]) || (inner.p_Max[axis] > outer.p_Max[axis])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// squared distance from the centre to the nearest and to the furthest point of the box
+	template<int D, typename B>
+	inline void SphereDistances(const B& box, const std::array<double, D>& centre, double& nearest, double& furthest) {
+		nearest = 0.0;
+		furthest = 0.0;
+		for (int axis = 0; axis < D; axis++) {
+			double below = box.p_Min[axis] - centre[axis];
+			double above = centre[axis] - box.p_Max[axis];
+			double outside = std::max(std::max(below, above), 0.0);
+			double far_side = std::max(std::abs(below), std::abs(above));
+			nearest += outside * outside;
+			furthest += far_side * far_side;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D, typename B>
+	inline bool SegmentHits(const B& box, const std::array<double, D>& origin, const std::array<double, D>& dir) {
+		double enter = 0.0;
+		double leave = 1.0;
+		for (int axis = 0; axis < D; axis++) {
+			if (std::abs(dir[axis]) < 1e-12) {
+				if ((origin[axis] < box.p_Min[axis]) || (origin[axis] > box.p_Max[axis])) {
+					return false;
+				}
+				continue;
+			}
+			double inv = 1.0 / dir[axis];
+			double near_t = (box.p_Min[axis] - origin[axis]) * inv;
+			double far_t = (box.p_Max[axis] - origin[axis]) * inv;
+			if (near_t > far_t) {
+				std::swap(near_t, far_t);
+			}
+			enter = std::max(enter, near_t);
+			leave = std::min(leave, far_t);
+			if (enter > leave) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D>
+	inline Vec3 ToVec3(const std::array<double, D>& pos) {
+		return Vec3(pos[0], pos[1], D == 3 ? pos[D - 1] : 0.0);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+typename LooseTree<D>::Box LooseTree<D>::ToBox(VecType min_pos, VecType max_pos) {
+	if constexpr (D == 2) {
+		return Box{ { min_pos.x, min_pos.y }, { max_pos.x, max_pos.y } };
+	} else {
+		return Box{ { min_pos.x, min_pos.y, min_pos.z }, { max_pos.x, max_pos.y, max_pos.z } };
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+LooseTree<D>::LooseTree(VecType world_min, VecType world_max, int max_depth) :
+	m_MaxDepth(std::clamp(max_depth, 0, LOOSE_TREE_MAX_DEPTH))
+{
+	Box bounds = ToBox(world_min, world_max);
+	double size = 0.0;
+	for (int axis = 0; axis < D; axis++) {
+		size = std::max(size, bounds.p_Max[axis] - bounds.p_Min[axis]);
+	}
+	size = std::max(size, 1e-6);
+	for (int axis = 0; axis < D; axis++) {
+		m_World.p_Min[axis] = bounds.p_Min[axis];
+		m_World.p_Max[axis] = bounds.p_Min[axis] + size;
+	}
+	for (int depth = 0; depth <= LOOSE_TREE_MAX_DEPTH; depth++) {
+		m_CellSizes[depth] = size / (double)(1 << depth);
+	}
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+int LooseTree<D>::FindCell(const Box& box, std::array<int, D>& cell) const {
+
+	std::array<double, D> centre;
+	double extent = 0.0;
+	for (int axis = 0; axis < D; axis++) {
+		centre[axis] = (box.p_Min[axis] + box.p_Max[axis]) * 0.5;
+		extent = std::max(extent, (box.p_Max[axis] - box.p_Min[axis]) * 0.5);
+	}
+
+	// the deepest cells no smaller than the object fit it within their loose bounds, wherever its centre is in them
+	int depth = 0;
+	while ((depth < m_MaxDepth) && (extent * 2.0 <= m_CellSizes[depth + 1])) {
+		depth++;
+	}
+	for (; depth > 0; depth--) {
+		const double size = m_CellSizes[depth];
+		const int max_cell = (1 << depth) - 1;
+		bool fits = true;
+		for (int axis = 0; axis < D; axis++) {
+			// centres past the edge of the world go in the edge cell, where they often still fit as the loose bounds reach half a cell out
+			cell[axis] = (int)std::clamp(std::floor((centre[axis] - m_World.p_Min[axis]) / size), 0.0, (double)max_cell);
+			// checked rather than assumed, so rounding at a cell edge can never leave part of an object outside its node
+			double loose_min = m_World.p_Min[axis] + (cell[axis] - 0.5) * size;
+			fits = fits && (box.p_Min[axis] >= loose_min) && (box.p_Max[axis] <= loose_min + size * 2.0);
+		}
+		if (fits) {
+			return depth;
+		}
+	}
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+int LooseTree<D>::NewNode(int parent, int depth, const std::array<int, D>& cell) {
+
+	int index;
+	if (m_FreeNodes.empty()) {
+		index = (int)m_Nodes.size();
+		m_Nodes.emplace_back();
+	} else {
+		index = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+	}
+	Node& node = m_Nodes[index];
+	const double size = m_CellSizes[depth];
+	for (int axis = 0; axis < D; axis++) {
+		node.p_Loose.p_Min[axis] = m_World.p_Min[axis] + (cell[axis] - 0.5) * size;
+		node.p_Loose.p_Max[axis] = node.p_Loose.p_Min[axis] + size * 2.0;
+	}
+	node.p_Children.fill(-1);
+	node.p_Cell = cell;
+	node.p_Parent = parent;
+	node.p_Depth = depth;
+	node.p_First = -1;
+	node.p_SubtreeCount = 0;
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+int LooseTree<D>::GetNode(int depth, const std::array<int, D>& cell) {
+
+	int node = 0;
+	for (int level = 1; level <= depth; level++) {
+		std::array<int, D> level_cell;
+		int child = 0;
+		for (int axis = 0; axis < D; axis++) {
+			level_cell[axis] = cell[axis] >> (depth - level);
+			child |= (level_cell[axis] & 1) << axis;
+		}
+		int next = m_Nodes[node].p_Children[child];
+		if (next < 0) {
+			next = NewNode(node, level, level_cell);
+			m_Nodes[node].p_Children[child] = next;
+		}
+		node = next;
+	}
+	return node;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::Link(int handle, int node) {
+
+	Object& obj = m_Objects[handle];
+	obj.p_Node = node;
+	obj.p_Prev = -1;
+	obj.p_Next = m_Nodes[node].p_First;
+	if (obj.p_Next >= 0) {
+		m_Objects[obj.p_Next].p_Prev = handle;
+	}
+	m_Nodes[node].p_First = handle;
+	for (int up = node; up >= 0; up = m_Nodes[up].p_Parent) {
+		m_Nodes[up].p_SubtreeCount++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::Unlink(int handle) {
+
+	Object& obj = m_Objects[handle];
+	if (obj.p_Prev >= 0) {
+		m_Objects[obj.p_Prev].p_Next = obj.p_Next;
+	} else {
+		m_Nodes[obj.p_Node].p_First = obj.p_Next;
+	}
+	if (obj.p_Next >= 0) {
+		m_Objects[obj.p_Next].p_Prev = obj.p_Prev;
+	}
+
+	// anything left empty below the root goes back to the pool, its children already have
+	for (int up = obj.p_Node; up >= 0;) {
+		Node& node = m_Nodes[up];
+		int parent = node.p_Parent;
+		if ((--node.p_SubtreeCount == 0) && (parent >= 0)) {
+			auto& siblings = m_Nodes[parent].p_Children;
+			*std::find(siblings.begin(), siblings.end(), up) = -1;
+			node.p_Depth = -1;
+			m_FreeNodes.push_back(up);
+		}
+		up = parent;
+	}
+	obj.p_Node = -1;
+	obj.p_Next = -1;
+	obj.p_Prev = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+int LooseTree<D>::Add(VecType min_pos, VecType max_pos) {
+
+	int handle;
+	if (m_FreeHandles.empty()) {
+		handle = (int)m_Objects.size();
+		m_Objects.emplace_back();
+	} else {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	Object& obj = m_Objects[handle];
+	obj.p_Box = ToBox(min_pos, max_pos);
+	std::array<int, D> cell;
+	int depth = FindCell(obj.p_Box, cell);
+	Link(handle, GetNode(depth, cell));
+	m_Count++;
+	return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+bool LooseTree<D>::Move(int handle, VecType min_pos, VecType max_pos) {
+
+	if (!IsValid(handle)) {
+		return false;
+	}
+	Object& obj = m_Objects[handle];
+	obj.p_Box = ToBox(min_pos, max_pos);
+	std::array<int, D> cell;
+	int depth = FindCell(obj.p_Box, cell);
+	const Node& current = m_Nodes[obj.p_Node];
+	if ((depth == current.p_Depth) && ((depth == 0) || (cell == current.p_Cell))) {
+		return false;
+	}
+	// unlinked first, so the old path is freed before the new one is made and can share its nodes
+	Unlink(handle);
+	Link(handle, GetNode(depth, cell));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::Remove(int handle) {
+	if (!IsValid(handle)) {
+		return;
+	}
+	Unlink(handle);
+	m_FreeHandles.push_back(handle);
+	m_Count--;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::Clear(void) {
+	m_Nodes.clear();
+	m_FreeNodes.clear();
+	m_Objects.clear();
+	m_FreeHandles.clear();
+	m_Count = 0;
+	std::array<int, D> root_cell;
+	root_cell.fill(0);
+	NewNode(-1, 0, root_cell);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+LooseTreeStats LooseTree<D>::GetStats(void) const {
+	LooseTreeStats stats;
+	stats.p_Objects = m_Count;
+	stats.p_Nodes = (int)(m_Nodes.size() - m_FreeNodes.size());
+	for (const auto& node : m_Nodes) {
+		stats.p_Depth = std::max(stats.p_Depth, node.p_Depth);
+	}
+	return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+template<typename N, typename O>
+void LooseTree<D>::Search(const N& node_test, const O& object_test, std::vector<int>& found) const {
+
+	found.clear();
+	// depth first, so at most one set of children per level is waiting
+	std::array<std::pair<int, bool>, (LOOSE_TREE_MAX_DEPTH + 1) * NUM_CHILDREN> stack;
+	int stack_size = 0;
+	stack[stack_size++] = { 0, false };
+	while (stack_size > 0) {
+		auto [index, take_all] = stack[--stack_size];
+		const Node& node = m_Nodes[index];
+		// the root is never culled, objects outside the world are in it and not within its bounds
+		if ((index != 0) && !take_all) {
+			Visit visit = node_test(node.p_Loose);
+			if (visit == Visit::SKIP) {
+				continue;
+			}
+			take_all = visit == Visit::TAKE_ALL;
+		}
+		for (int handle = node.p_First; handle >= 0; handle = m_Objects[handle].p_Next) {
+			if (take_all || object_test(m_Objects[handle].p_Box)) {
+				found.push_back(handle);
+			}
+		}
+		for (int child : node.p_Children) {
+			if (child >= 0) {
+				stack[stack_size++] = { child, take_all };
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::QueryAABB(VecType min_pos, VecType max_pos, std::vector<int>& found) const {
+	Box query = ToBox(min_pos, max_pos);
+	Search([&query](const Box& loose) {
+		if (!LooseTreeShapes::Overlaps<D>(loose, query)) {
+			return Visit::SKIP;
+		}
+		return LooseTreeShapes::Contains<D>(query, loose) ? Visit::TAKE_ALL : Visit::SEARCH;
+	}, [&query](const Box& box) {
+		return LooseTreeShapes::Overlaps<D>(box, query);
+	}, found);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::QuerySphere(VecType centre, double radius, std::vector<int>& found) const {
+	const std::array<double, D> pos = ToBox(centre, centre).p_Min;
+	const double rad_sqr = radius * radius;
+	Search([&pos, rad_sqr](const Box& loose) {
+		double nearest, furthest;
+		LooseTreeShapes::SphereDistances<D>(loose, pos, nearest, furthest);
+		if (nearest > rad_sqr) {
+			return Visit::SKIP;
+		}
+		return furthest <= rad_sqr ? Visit::TAKE_ALL : Visit::SEARCH;
+	}, [&pos, rad_sqr](const Box& box) {
+		double nearest, furthest;
+		LooseTreeShapes::SphereDistances<D>(box, pos, nearest, furthest);
+		return nearest <= rad_sqr;
+	}, found);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::QueryFrustum(const Frustum& frustum, std::vector<int>& found) const {
+	Search([&frustum](const Box& loose) {
+		switch (frustum.ClassifyAABB(LooseTreeShapes::ToVec3<D>(loose.p_Min), LooseTreeShapes::ToVec3<D>(loose.p_Max))) {
+			case Frustum::Result::OUTSIDE: return Visit::SKIP;
+			case Frustum::Result::INSIDE: return Visit::TAKE_ALL;
+			default: return Visit::SEARCH;
+		}
+	}, [&frustum](const Box& box) {
+		return frustum.IntersectsAABB(LooseTreeShapes::ToVec3<D>(box.p_Min), LooseTreeShapes::ToVec3<D>(box.p_Max));
+	}, found);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+void LooseTree<D>::QueryRay(VecType ray_origin, VecType ray_end, std::vector<int>& found) const {
+	const std::array<double, D> origin = ToBox(ray_origin, ray_origin).p_Min;
+	const std::array<double, D> end = ToBox(ray_end, ray_end).p_Min;
+	std::array<double, D> dir;
+	for (int axis = 0; axis < D; axis++) {
+		dir[axis] = end[axis] - origin[axis];
+	}
+	Search([&origin, &dir](const Box& loose) {
+		return LooseTreeShapes::SegmentHits<D>(loose, origin, dir) ? Visit::SEARCH : Visit::SKIP;
+	}, [&origin, &dir](const Box& box) {
+		return LooseTreeShapes::SegmentHits<D>(box, origin, dir);
+	}, found);
+}
+
+template class LooseTree<2>;
+template class LooseTree<3>;
+
+} // namespace Neshny
@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// deep enough for objects a sixty five thousandth the size of the world, and keeps the query stack a fixed size
+constexpr int LOOSE_TREE_MAX_DEPTH = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+struct LooseTreeStats {
+	int		p_Objects = 0;
+	int		p_Nodes = 0;
+	int		p_Depth = 0;			// deepest node in use
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// loose quadtree or octree of axis aligned boxes, for dynamic objects whose sizes differ by orders of magnitude
+// every node's bounds are stretched to twice its cell, so an object goes straight to one node picked by its size and centre
+// with nothing to split or push down, a big object is only ever in one node and small ones sit deep enough that queries skip most of them
+// nodes come from a pool and go back to it when their subtree empties, objects are an intrusive list per node, so nothing allocates once warmed up
+// objects too far outside the world bounds to fit an edge node are kept in the root, which is always searched
+////////////////////////////////////////////////////////////////////////////////
+template<int D>
+class LooseTree {
+	static_assert((D == 2) || (D == 3), "Loose trees are only quadtrees and octrees");
+
+public:
+
+	using VecType = std::conditional_t<D == 2, Vec2, Vec3>;
+
+								LooseTree			( VecType world_min, VecType world_max, int max_depth = 10 );
+
+	int							Add					( VecType min_pos, VecType max_pos );
+	// only relinks the object when it needs a different node, true if it did
+	bool						Move				( int handle, VecType min_pos, VecType max_pos );
+	void						Remove				( int handle );
+	void						Clear				( void );
+
+	inline int					Size				( void ) const { return m_Count; }
+	inline bool					IsValid				( int handle ) const { return (handle >= 0) && (handle < (int)m_Objects.size()) && (m_Objects[handle].p_Node >= 0); }
+	LooseTreeStats				GetStats			( void ) const;
+
+	// each query clears found and fills it with the handles of every object whose box touches the shape, in no particular order
+	void						QueryAABB			( VecType min_pos, VecType max_pos, std::vector<int>& found ) const;
+	void						QuerySphere			( VecType centre, double radius, std::vector<int>& found ) const;
+	// a quadtree is tested as lying flat at z = 0
+	void						QueryFrustum		( const Frustum& frustum, std::vector<int>& found ) const;
+	// objects whose box the segment from ray_origin to ray_end passes through
+	void						QueryRay			( VecType ray_origin, VecType ray_end, std::vector<int>& found ) const;
+
+private:
+
+	static constexpr int NUM_CHILDREN = 1 << D;
+
+	enum class Visit {
+		SKIP, SEARCH, TAKE_ALL
+	};
+
+	struct Box {
+		std::array<double, D>	p_Min;
+		std::array<double, D>	p_Max;
+	};
+
+	struct Node {
+		Box						p_Loose;
+		std::array<int, NUM_CHILDREN>	p_Children;
+		int						p_Parent = -1;
+		std::array<int, D>		p_Cell;					// in cells of this depth's size from the world minimum
+		int						p_Depth = 0;			// -1 while in the pool
+		int						p_First = -1;			// object list
+		int						p_SubtreeCount = 0;		// objects here and below, a node is freed when this reaches zero
+	};
+
+	struct Object {
+		Box						p_Box;
+		int						p_Node = -1;
+		int						p_Next = -1;
+		int						p_Prev = -1;
+	};
+
+	static Box					ToBox				( VecType min_pos, VecType max_pos );
+	// the depth and cell a box belongs in, depth 0 for the root
+	int							FindCell			( const Box& box, std::array<int, D>& cell ) const;
+	// walks down to the cell, making nodes on the way where there are none
+	int							GetNode				( int depth, const std::array<int, D>& cell );
+	int							NewNode				( int parent, int depth, const std::array<int, D>& cell );
+	void						Link				( int handle, int node );
+	void						Unlink				( int handle );
+	// node_test culls by each node's loose box, TAKE_ALL means every object below is inside and none need object_test
+	template<typename N, typename O>
+	void						Search				( const N& node_test, const O& object_test, std::vector<int>& found ) const;
+
+	Box							m_World;			// the root's cell, a square or cube
+	int							m_MaxDepth;
+	std::array<double, LOOSE_TREE_MAX_DEPTH + 1>	m_CellSizes;		// at each depth
+	int							m_Count = 0;
+
+	std::vector<Node>			m_Nodes;			// the root is always the first
+	std::vector<int>			m_FreeNodes;
+	std::vector<Object>			m_Objects;			// indexed by handle
+	std::vector<int>			m_FreeHandles;
+};
+
+using LooseQuadtree = LooseTree<2>;
+using LooseOctree = LooseTree<3>;
+
+} // namespace Neshny
@@ -5,6 +5,342 @@
 
 namespace Neshny {
 
+///////////////////////////////////////////////////////////////////////////////
+AlgorithmStepper::Recording::Recording(size_t capacity_bytes, int sample_every, std::function<bool(int)> predicate) :
+	m_Buffer		( std::max(capacity_bytes, MIN_CAPACITY) )
+	,m_SampleEvery	( std::max(1, sample_every) )
+	,m_Predicate	( predicate )
+{
+	UpdateSampling();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t AlgorithmStepper::Recording::PayloadSize(RecordType type) {
+	switch (type) {
+		case RecordType::MAIN_POINT_2D:
+		case RecordType::SCRAP_POINT_2D:
+			return sizeof(uint32_t) * 3;
+		case RecordType::SCRAP_POINT_3D:
+			return sizeof(uint32_t) * 4;
+		case RecordType::MAIN_LINE_2D:
+		case RecordType::SCRAP_LINE_2D:
+			return sizeof(uint32_t) * 5;
+		case RecordType::SCRAP_LINE_3D:
+			return sizeof(uint32_t) * 7;
+		case RecordType::STEP_END:
+			return sizeof(uint32_t) * 3;
+		default:
+			return 0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::Recording::ValidateRecords(std::span<const unsigned char> records) {
+	size_t offset = 0;
+	RecordType last_type = RecordType::STEP_END;
+	while (offset < records.size()) {
+		RecordHeader header;
+		if (records.size() - offset < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, records.data() + offset, sizeof(header));
+		if ((uint8_t)header.p_Type > (uint8_t)RecordType::INFO) {
+			return false;
+		}
+		const size_t record_size = sizeof(header) + PayloadSize(header.p_Type) + header.p_TextLength;
+		if (record_size > records.size() - offset) {
+			return false;
+		}
+		offset += record_size;
+		last_type = header.p_Type;
+	}
+	return last_type == RecordType::STEP_END;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::UpdateSampling(void) {
+	m_Sampling = ((m_StepIndex % m_SampleEvery) == 0) && ((!m_Predicate) || m_Predicate(m_StepIndex));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::Write(const void* data, size_t size) {
+	if (size == 0) {
+		return;
+	}
+	size_t first = std::min(size, m_Buffer.size() - m_Head);
+	memcpy(m_Buffer.data() + m_Head, data, first);
+	memcpy(m_Buffer.data(), (const unsigned char*)data + first, size - first);
+	m_Head = (m_Head + size) % m_Buffer.size();
+	m_Used += size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::Read(size_t offset, void* data, size_t size) const {
+	if (size == 0) {
+		return;
+	}
+	offset %= m_Buffer.size();
+	size_t first = std::min(size, m_Buffer.size() - offset);
+	memcpy(data, m_Buffer.data() + offset, first);
+	memcpy((unsigned char*)data + first, m_Buffer.data(), size - first);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::Recording::Reserve(size_t size) {
+	// only whole finished steps are ever dropped, the step being recorded is never cut from the front
+	while (m_Buffer.size() - m_Used < size) {
+		if (m_Used == m_CurrentStepBytes) {
+			return false;
+		}
+		RecordHeader header;
+		do {
+			Read(m_Tail, &header, sizeof(header));
+			size_t record_size = sizeof(header) + PayloadSize(header.p_Type) + header.p_TextLength;
+			m_Tail = (m_Tail + record_size) % m_Buffer.size();
+			m_Used -= record_size;
+		} while (header.p_Type != RecordType::STEP_END);
+		m_KeptSteps--;
+		m_DroppedSteps++;
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::AddRecord(RecordHeader header, const uint32_t* values, std::string_view text) {
+	if ((!m_Sampling) || m_CurrentTruncated) {
+		return;
+	}
+	header.p_TextLength = (uint16_t)std::min(text.size(), (size_t)std::numeric_limits<uint16_t>::max());
+	const size_t payload_size = PayloadSize(header.p_Type);
+	const size_t record_size = sizeof(header) + payload_size + header.p_TextLength;
+	// room for the step end record and a short header is always kept back so a step that outgrows the buffer can still be closed
+	constexpr size_t header_headroom = 64;
+	const size_t step_end_size = sizeof(RecordHeader) + PayloadSize(RecordType::STEP_END) + header_headroom;
+	if (!Reserve(record_size + step_end_size)) {
+		m_CurrentTruncated = true;
+		return;
+	}
+	Write(&header, sizeof(header));
+	Write(values, payload_size);
+	Write(text.data(), header.p_TextLength);
+	m_CurrentStepBytes += record_size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline uint32_t PackStepperColor(Vec4 color) {
+	auto channel = [](double val) { return (uint32_t)std::lround(std::clamp(val, 0.0, 1.0) * 255.0); };
+	return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (channel(color.w) << 24);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Vec4 UnpackStepperColor(uint32_t packed) {
+	return Vec4(packed & 0xFF, (packed >> 8) & 0xFF, (packed >> 16) & 0xFF, packed >> 24) / 255.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::AddPoint(RecordType type, fVec3 pos, Vec4 color, PointType point_type, std::string_view text) {
+	uint32_t values[4] = { std::bit_cast<uint32_t>(pos.x), std::bit_cast<uint32_t>(pos.y), std::bit_cast<uint32_t>(pos.z), PackStepperColor(color) };
+	if (type != RecordType::SCRAP_POINT_3D) {
+		values[2] = values[3];
+	}
+	AddRecord({ type, (uint8_t)point_type, 0 }, values, text);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::AddLine(RecordType type, fVec3 start, fVec3 end, Vec4 color) {
+	if (type == RecordType::SCRAP_LINE_3D) {
+		uint32_t values[7] = {
+			std::bit_cast<uint32_t>(start.x), std::bit_cast<uint32_t>(start.y), std::bit_cast<uint32_t>(start.z),
+			std::bit_cast<uint32_t>(end.x), std::bit_cast<uint32_t>(end.y), std::bit_cast<uint32_t>(end.z), PackStepperColor(color)
+		};
+		AddRecord({ type, 0, 0 }, values, {});
+	} else {
+		uint32_t values[5] = { std::bit_cast<uint32_t>(start.x), std::bit_cast<uint32_t>(start.y), std::bit_cast<uint32_t>(end.x), std::bit_cast<uint32_t>(end.y), PackStepperColor(color) };
+		AddRecord({ type, 0, 0 }, values, {});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::AddInfo(std::string_view info) {
+	AddRecord({ RecordType::INFO, 0, 0 }, nullptr, info);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::Recording::EndStep(std::string_view header, std::optional<Vec2> highlight) {
+	if (m_Sampling) {
+		uint8_t flags = (highlight.has_value() ? FLAG_HIGHLIGHT : 0) | (m_CurrentTruncated ? FLAG_TRUNCATED : 0);
+		uint32_t values[3] = { (uint32_t)m_StepIndex, std::bit_cast<uint32_t>(highlight ? (float)highlight->x : 0.0f), std::bit_cast<uint32_t>(highlight ? (float)highlight->y : 0.0f) };
+		RecordHeader record = { RecordType::STEP_END, flags, 0 };
+		record.p_TextLength = (uint16_t)std::min(header.size(), (size_t)std::numeric_limits<uint16_t>::max());
+		size_t record_size = sizeof(record) + PayloadSize(RecordType::STEP_END) + record.p_TextLength;
+		if (!Reserve(record_size)) {
+			// the header text is the only thing that can still not fit, drop it rather than the step
+			record.p_TextLength = 0;
+			record_size = sizeof(record) + PayloadSize(RecordType::STEP_END);
+			Reserve(record_size);
+		}
+		Write(&record, sizeof(record));
+		Write(values, sizeof(values));
+		Write(header.data(), record.p_TextLength);
+		m_KeptSteps++;
+	}
+	m_CurrentStepBytes = 0;
+	m_CurrentTruncated = false;
+	m_StepIndex++;
+	UpdateSampling();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<AlgorithmStepper::Step> AlgorithmStepper::Recording::Decode(void) const {
+	std::vector<Step> steps;
+	steps.push_back({});
+	size_t offset = m_Tail;
+	size_t remaining = m_Used;
+	std::string text;
+	while (remaining >= sizeof(RecordHeader)) {
+		RecordHeader header;
+		uint32_t values[7];
+		Read(offset, &header, sizeof(header));
+		const size_t payload_size = PayloadSize(header.p_Type);
+		const size_t record_size = sizeof(header) + payload_size + header.p_TextLength;
+		if (((uint8_t)header.p_Type > (uint8_t)RecordType::INFO) || (record_size > remaining)) {
+			break; // only a damaged buffer gets here, so keep what was read before it
+		}
+		Read(offset + sizeof(header), values, payload_size);
+		text.resize(header.p_TextLength);
+		Read(offset + sizeof(header) + payload_size, text.data(), header.p_TextLength);
+		offset += record_size;
+		remaining -= record_size;
+
+		auto val = [&values](int index) { return (double)std::bit_cast<float>(values[index]); };
+		Step& step = steps.back();
+		switch (header.p_Type) {
+			case RecordType::MAIN_POINT_2D:
+				step.p_Main2DPoints.push_back({ Vec2(val(0), val(1)), UnpackStepperColor(values[2]), (PointType)header.p_Flags, text });
+				break;
+			case RecordType::SCRAP_POINT_2D:
+				step.p_Scrap2DPoints.push_back({ Vec2(val(0), val(1)), UnpackStepperColor(values[2]), (PointType)header.p_Flags, text });
+				break;
+			case RecordType::SCRAP_POINT_3D:
+				step.p_Scrap3DPoints.push_back({ Vec3(val(0), val(1), val(2)), UnpackStepperColor(values[3]), text });
+				break;
+			case RecordType::MAIN_LINE_2D:
+				step.p_Main2DLines.push_back({ Vec2(val(0), val(1)), Vec2(val(2), val(3)), UnpackStepperColor(values[4]) });
+				break;
+			case RecordType::SCRAP_LINE_2D:
+				step.p_Scrap2DLines.push_back({ Vec2(val(0), val(1)), Vec2(val(2), val(3)), UnpackStepperColor(values[4]) });
+				break;
+			case RecordType::SCRAP_LINE_3D:
+				step.p_Scrap3DLines.push_back({ Vec3(val(0), val(1), val(2)), Vec3(val(3), val(4), val(5)), UnpackStepperColor(values[6]) });
+				break;
+			case RecordType::INFO:
+				step.p_Info.push_back(text);
+				break;
+			case RecordType::STEP_END:
+				step.p_Header = text;
+				step.p_SourceIndex = (int)values[0];
+				if (header.p_Flags & FLAG_HIGHLIGHT) {
+					step.p_MainHighlight = Vec2(val(1), val(2));
+				}
+				if (header.p_Flags & FLAG_TRUNCATED) {
+					step.p_Info.push_back("Step was larger than the recording buffer and has been cut short");
+				}
+				steps.push_back({});
+				break;
+		}
+	}
+	return steps;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// file layout is a small header followed by the live part of the ring buffer from oldest to newest
+struct StepperFileHeader {
+	uint32_t	p_Magic;
+	uint32_t	p_Version;
+	uint64_t	p_Used;
+	int32_t		p_StepIndex;
+	int32_t		p_KeptSteps;
+	int32_t		p_DroppedSteps;
+	int32_t		p_SampleEvery;
+};
+constexpr uint32_t STEPPER_FILE_MAGIC = 0x5054534E; // "NSTP"
+constexpr uint32_t STEPPER_FILE_VERSION = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::Recording::Save(std::string_view filename) const {
+	std::ofstream file;
+	file.open(std::string(filename), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+	// only finished steps are saved, so a loaded file always ends on a step end
+	const size_t used = m_Used - m_CurrentStepBytes;
+	StepperFileHeader header = { STEPPER_FILE_MAGIC, STEPPER_FILE_VERSION, used, m_StepIndex, m_KeptSteps, m_DroppedSteps, m_SampleEvery };
+	file.write((const char*)&header, sizeof(header));
+	size_t first = std::min(used, m_Buffer.size() - m_Tail);
+	file.write((const char*)m_Buffer.data() + m_Tail, first);
+	file.write((const char*)m_Buffer.data(), used - first);
+	return file.good();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::Recording::Load(std::string_view filename) {
+	MappedFile file(filename);
+	if ((!file.IsValid()) || (file.GetSize() < sizeof(StepperFileHeader))) {
+		return false;
+	}
+	StepperFileHeader header;
+	memcpy(&header, file.GetData().data(), sizeof(header));
+	if ((header.p_Magic != STEPPER_FILE_MAGIC) || (header.p_Version != STEPPER_FILE_VERSION) || (file.GetSize() - sizeof(header) < header.p_Used)) {
+		return false;
+	}
+	if (!ValidateRecords(file.GetData().subspan(sizeof(header), header.p_Used))) {
+		return false;
+	}
+	m_Buffer.assign(std::max((size_t)header.p_Used, m_Buffer.size()), 0);
+	m_Head = m_Tail = m_Used = 0;
+	Write(file.GetData().data() + sizeof(header), header.p_Used);
+	m_StepIndex = header.p_StepIndex;
+	m_KeptSteps = header.p_KeptSteps;
+	m_DroppedSteps = header.p_DroppedSteps;
+	m_SampleEvery = std::max(1, header.p_SampleEvery);
+	m_CurrentStepBytes = 0;
+	m_CurrentTruncated = false;
+	UpdateSampling();
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::StartRecording(size_t capacity_bytes, int sample_every, std::function<bool(int)> predicate) {
+	p_Recording = std::make_unique<Recording>(capacity_bytes, sample_every, predicate);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AlgorithmStepper::StopRecording(void) {
+	if (!p_Recording) {
+		return;
+	}
+	p_Steps = p_Recording->Decode();
+	p_DisplayedStep = std::max(0, (int)p_Steps.size() - 2);
+	p_Recording.reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::SaveRecording(std::string_view filename) const {
+	return p_Recording && p_Recording->Save(filename);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AlgorithmStepper::LoadRecording(std::string_view filename) {
+	auto recording = std::make_unique<Recording>(Recording::MIN_CAPACITY);
+	if (!recording->Load(filename)) {
+		return false;
+	}
+	p_Recording = std::move(recording);
+	StopRecording();
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 void AlgorithmStepper::RenderDialog(bool* close) {
 	ImGui::Begin("Stepper", close, ImGuiWindowFlags_NoCollapse);
@@ -15,6 +351,9 @@ void AlgorithmStepper::RenderDialog(bool* close) {
 
 	if (p_DisplayedStep < p_Steps.size()) {
 		const auto& step = p_Steps[p_DisplayedStep];
+		if (step.p_SourceIndex >= 0) {
+			ImGui::Text("Recorded step %d", step.p_SourceIndex);
+		}
 		if (!step.p_Header.empty()) {
 			ImGui::Text(step.p_Header.data());
 			ImGui::NewLine();
@@ -1,6 +1,14 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// wraps calls on an AlgorithmStepper so the arguments are only evaluated for sampled steps
+// and the whole call disappears when NESHNY_NO_STEPPER is defined, eg NESHNY_STEP(stepper, Add2DPointToMain(pos, col));
+#ifdef NESHNY_NO_STEPPER
+	#define NESHNY_STEP(stepper, call)
+#else
+	#define NESHNY_STEP(stepper, call) do { if ((stepper).IsSampling()) { (stepper).call; } } while (false)
+#endif
+
 namespace Neshny {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,6 +47,7 @@ struct AlgorithmStepper {
 
 	struct Step {
 		std::string p_Header;
+		int p_SourceIndex = -1; // index of the step in the original run when recorded with sampling
 		std::optional<Vec2> p_MainHighlight;
 		std::vector<Point2D> p_Main2DPoints;
 		std::vector<Point2D> p_Scrap2DPoints;
@@ -49,6 +58,74 @@ struct AlgorithmStepper {
 		std::vector<std::string> p_Info;
 	};
 
+	////////////////////////////////////////////////////////////////////////////////
+	// fixed size ring buffer of packed records, each a header then 32 bit words (float positions, RGBA8 colour) then any text
+	// when full the oldest whole steps are dropped, so memory never grows no matter how long the capture runs
+	class Recording {
+	public:
+		enum class RecordType : uint8_t {
+			STEP_END
+			,MAIN_POINT_2D
+			,SCRAP_POINT_2D
+			,SCRAP_POINT_3D
+			,MAIN_LINE_2D
+			,SCRAP_LINE_2D
+			,SCRAP_LINE_3D
+			,INFO
+		};
+		struct RecordHeader {
+			RecordType	p_Type;
+			uint8_t		p_Flags;		// point type for points, highlight and truncation bits for step ends
+			uint16_t	p_TextLength;
+		};
+
+		static constexpr size_t MIN_CAPACITY = 1024;
+		static constexpr uint8_t FLAG_HIGHLIGHT = 1;
+		static constexpr uint8_t FLAG_TRUNCATED = 2;
+
+								Recording			( size_t capacity_bytes, int sample_every = 1, std::function<bool(int)> predicate = {} );
+
+		inline bool				IsSampling			( void ) const { return m_Sampling; }
+		inline size_t			GetCapacity			( void ) const { return m_Buffer.size(); }
+		inline size_t			GetUsedBytes		( void ) const { return m_Used; }
+		inline int				GetStepIndex		( void ) const { return m_StepIndex; }
+		inline int				GetKeptSteps		( void ) const { return m_KeptSteps; }
+		inline int				GetDroppedSteps		( void ) const { return m_DroppedSteps; }
+
+		void					AddPoint			( RecordType type, fVec3 pos, Vec4 color, PointType point_type, std::string_view text );
+		void					AddLine				( RecordType type, fVec3 start, fVec3 end, Vec4 color );
+		void					AddInfo				( std::string_view info );
+		void					EndStep				( std::string_view header, std::optional<Vec2> highlight );
+
+		std::vector<Step>		Decode				( void ) const;
+		bool					Save				( std::string_view filename ) const;
+		bool					Load				( std::string_view filename );
+
+	private:
+
+		static size_t			PayloadSize			( RecordType type );
+		// true if the bytes are whole records of known types, ending with a step end, as Save writes them
+		static bool				ValidateRecords		( std::span<const unsigned char> records );
+		bool					Reserve				( size_t size );
+		void					Write				( const void* data, size_t size );
+		void					Read				( size_t offset, void* data, size_t size ) const;
+		void					AddRecord			( RecordHeader header, const uint32_t* values, std::string_view text );
+		void					UpdateSampling		( void );
+
+		std::vector<unsigned char>	m_Buffer;
+		size_t					m_Head = 0;
+		size_t					m_Tail = 0;
+		size_t					m_Used = 0;
+		size_t					m_CurrentStepBytes = 0;
+		bool					m_CurrentTruncated = false;
+		bool					m_Sampling = true;
+		int						m_SampleEvery = 1;
+		std::function<bool(int)>	m_Predicate;
+		int						m_StepIndex = 0;
+		int						m_KeptSteps = 0;
+		int						m_DroppedSteps = 0;
+	};
+
 	AlgorithmStepper(float point_size = 6.0) :
 		p_PointSize	( point_size )
 	{
@@ -66,35 +143,69 @@ struct AlgorithmStepper {
 			|| (!p_Steps[0].p_Scrap3DLines.empty());
 	}
 
-	void EndStep(std::string header = std::string(), std::optional<Vec2> highlight_point = std::nullopt) {
+	void EndStep(std::string_view header = std::string_view(), std::optional<Vec2> highlight_point = std::nullopt) {
+		if (p_Recording) {
+			return p_Recording->EndStep(header, highlight_point);
+		}
 		p_Steps.back().p_Header = header;
 		p_Steps.back().p_MainHighlight = highlight_point;
 		p_Steps.push_back({});
 		p_DisplayedStep = (int)p_Steps.size() - 2;
 	}
 
-	void Add2DPointToMain(Vec2 pos, Vec4 color, PointType type = PointType::P_CIRCLE, std::string text = "") {
-		p_Steps.back().p_Main2DPoints.push_back({ pos, color, type, text });
+	void Add2DPointToMain(Vec2 pos, Vec4 color, PointType type = PointType::P_CIRCLE, std::string_view text = "") {
+		if (p_Recording) {
+			return p_Recording->AddPoint(Recording::RecordType::MAIN_POINT_2D, fVec3(pos.x, pos.y, 0), color, type, text);
+		}
+		p_Steps.back().p_Main2DPoints.push_back({ pos, color, type, std::string(text) });
 	}
-	void Add2DPointToScrap(Vec2 pos, Vec4 color, PointType type = PointType::P_CIRCLE, std::string text = "") {
-		p_Steps.back().p_Scrap2DPoints.push_back({ pos, color, type, text });
+	void Add2DPointToScrap(Vec2 pos, Vec4 color, PointType type = PointType::P_CIRCLE, std::string_view text = "") {
+		if (p_Recording) {
+			return p_Recording->AddPoint(Recording::RecordType::SCRAP_POINT_2D, fVec3(pos.x, pos.y, 0), color, type, text);
+		}
+		p_Steps.back().p_Scrap2DPoints.push_back({ pos, color, type, std::string(text) });
 	}
-	void Add3DPointToScrap(Vec3 pos, Vec4 color, std::string text = "") {
-		p_Steps.back().p_Scrap3DPoints.push_back({ pos, color, text });
+	void Add3DPointToScrap(Vec3 pos, Vec4 color, std::string_view text = "") {
+		if (p_Recording) {
+			return p_Recording->AddPoint(Recording::RecordType::SCRAP_POINT_3D, pos.ToFloat3(), color, PointType::P_NONE, text);
+		}
+		p_Steps.back().p_Scrap3DPoints.push_back({ pos, color, std::string(text) });
 	}
 	void Add2DLineToMain(Vec2 start, Vec2 end, Vec4 color) {
+		if (p_Recording) {
+			return p_Recording->AddLine(Recording::RecordType::MAIN_LINE_2D, fVec3(start.x, start.y, 0), fVec3(end.x, end.y, 0), color);
+		}
 		p_Steps.back().p_Main2DLines.push_back({ start, end, color });
 	}
 	void Add2DLineToScrap(Vec2 start, Vec2 end, Vec4 color) {
+		if (p_Recording) {
+			return p_Recording->AddLine(Recording::RecordType::SCRAP_LINE_2D, fVec3(start.x, start.y, 0), fVec3(end.x, end.y, 0), color);
+		}
 		p_Steps.back().p_Scrap2DLines.push_back({ start, end, color });
 	}
 	void Add3DLineToScrap(Vec3 start, Vec3 end, Vec4 color) {
+		if (p_Recording) {
+			return p_Recording->AddLine(Recording::RecordType::SCRAP_LINE_3D, start.ToFloat3(), end.ToFloat3(), color);
+		}
 		p_Steps.back().p_Scrap3DLines.push_back({ start, end, color });
 	}
-	void AddInfo(std::string info) {
-		p_Steps.back().p_Info.push_back(info);
+	void AddInfo(std::string_view info) {
+		if (p_Recording) {
+			return p_Recording->AddInfo(info);
+		}
+		p_Steps.back().p_Info.push_back(std::string(info));
 	}
 
+	// false while recording a step that is not being sampled, see NESHNY_STEP
+	inline bool IsSampling(void) const { return (!p_Recording) || p_Recording->IsSampling(); }
+
+	// switches to recording into a bounded ring buffer, keeping every sample_every-th step for which predicate (given the step index) is true
+	void StartRecording(size_t capacity_bytes, int sample_every = 1, std::function<bool(int)> predicate = {});
+	// decodes whatever the ring buffer kept into p_Steps for viewing and goes back to normal mode
+	void StopRecording(void);
+	bool SaveRecording(std::string_view filename) const;
+	bool LoadRecording(std::string_view filename);
+
 	void AdjustCurrentStep(int delta);
 
 	void RenderDialog(bool* close);
@@ -102,6 +213,7 @@ struct AlgorithmStepper {
 	void RenderScrapbooks(void) const;
 
 	std::vector<Step> p_Steps;
+	std::unique_ptr<Recording> p_Recording;
 
 	int	p_DisplayedStep = 0;
 	float p_PointSize;
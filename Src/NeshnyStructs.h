@@ -244,4 +244,139 @@ struct StructInfo {
 	std::string				p_GPUReadOnlyInsertion;
 };
 
+// moves live entities from the end of a STABLE_WITH_GAPS buffer into the lowest holes so the max index can shrink
+// this is the CPU reference, the backends upload p_Moves and run the same copies in a shader
+struct EntityDefragPlan {
+
+	struct Move {
+		int		p_From;
+		int		p_To;
+	};
+
+	// ids[i] < 0 marks a hole, max_moves < 0 is unlimited otherwise only that many entities get moved this call
+	static EntityDefragPlan Create(const std::vector<int>& ids, int max_moves = -1) {
+		EntityDefragPlan plan;
+		const int max_index = (int)ids.size();
+		std::vector<bool> alive(max_index);
+		plan.p_Remap.resize(max_index);
+		for (int i = 0; i < max_index; i++) {
+			alive[i] = ids[i] >= 0;
+			plan.p_Remap[i] = alive[i] ? i : -1;
+			plan.p_LiveCount += alive[i] ? 1 : 0;
+		}
+
+		int low = 0;
+		int high = max_index - 1;
+		while (true) {
+			while ((high >= 0) && !alive[high]) {
+				high--;
+			}
+			while ((low < high) && alive[low]) {
+				low++;
+			}
+			if ((low >= high) || ((max_moves >= 0) && ((int)plan.p_Moves.size() >= max_moves))) {
+				break;
+			}
+			plan.p_Moves.push_back({ high, low });
+			plan.p_Remap[high] = low;
+			alive[low] = true;
+			alive[high] = false;
+		}
+		while ((high >= 0) && !alive[high]) {
+			high--;
+		}
+		plan.p_NewMaxIndex = high + 1;
+		plan.p_Complete = plan.p_NewMaxIndex == plan.p_LiveCount;
+
+		// descending, since creation pops from the end of the free list this fills the lowest holes first
+		for (int i = plan.p_NewMaxIndex - 1; i >= 0; i--) {
+			if (!alive[i]) {
+				plan.p_FreeList.push_back(i);
+			}
+		}
+		return plan;
+	}
+
+	// data starts after the ENTITY_OFFSET_INTS header, stride of zero means AOS otherwise each column is stride ints apart
+	void Apply(int* data, int floats_per, int id_offset_ints, int stride = 0) const {
+		const int item_step = stride > 0 ? 1 : floats_per;
+		const int member_step = stride > 0 ? stride : 1;
+		for (const auto& move : p_Moves) {
+			for (int f = 0; f < floats_per; f++) {
+				data[move.p_To * item_step + f * member_step] = data[move.p_From * item_step + f * member_step];
+			}
+			data[move.p_From * item_step + id_offset_ints * member_step] = -1;
+		}
+	}
+
+	std::vector<Move>	p_Moves;
+	std::vector<int>	p_Remap; // old index to new index, -1 for holes
+	std::vector<int>	p_FreeList;
+	int					p_LiveCount = 0;
+	int					p_NewMaxIndex = 0;
+	bool				p_Complete = true;
+};
+
+// order preserving compaction of MOVING_COMPACT deaths, each survivor moves to the number of survivors before it
+// the shaders get that as an exclusive prefix sum in blocks of SCAN_BLOCK_SIZE, scanning the block totals the same way a level up until one block is left
+// this is the CPU reference, an exclusive sum has one answer however it is split so a running count gives exactly the same indices
+struct EntityCompaction {
+
+	static constexpr int SCAN_BLOCK_SIZE = 512;
+
+	// where each level of the scan sits in one scratch buffer, level 0 has one int per entity and each level after one per block of the level below
+	// the last level is a single int that ends up holding the live count
+	struct Level {
+		int		p_Offset;
+		int		p_Count;
+	};
+
+	static std::vector<Level> GetLevels(int count) {
+		std::vector<Level> levels;
+		int offset = 0;
+		do {
+			levels.push_back({ offset, count });
+			offset += count;
+			count = (count + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE;
+		} while (levels.back().p_Count > SCAN_BLOCK_SIZE);
+		levels.push_back({ offset, 1 });
+		return levels;
+	}
+
+	// a scan pass per level but the last, an add pass per level below the top one, then the scatter and a copy back
+	static int GetPassCount(int count) {
+		const int levels = (int)GetLevels(count).size();
+		return (levels - 1) + (levels - 2) + 2;
+	}
+
+	// ids[i] < 0 marks a death
+	static EntityCompaction Create(const std::vector<int>& ids) {
+		EntityCompaction result;
+		result.p_Remap.resize(ids.size());
+		for (int i = 0; i < (int)ids.size(); i++) {
+			result.p_Remap[i] = ids[i] >= 0 ? result.p_LiveCount++ : -1;
+		}
+		return result;
+	}
+
+	// in place, survivors only ever move down and keep their order so nothing is overwritten before it is read
+	// slots from the live count up are left as they were, as the shaders only copy back the live range
+	void Apply(int* data, int floats_per, int stride = 0) const {
+		const int item_step = stride > 0 ? 1 : floats_per;
+		const int member_step = stride > 0 ? stride : 1;
+		for (int i = 0; i < (int)p_Remap.size(); i++) {
+			const int to = p_Remap[i];
+			if ((to < 0) || (to == i)) {
+				continue;
+			}
+			for (int f = 0; f < floats_per; f++) {
+				data[to * item_step + f * member_step] = data[i * item_step + f * member_step];
+			}
+		}
+	}
+
+	std::vector<int>	p_Remap; // old index to new index, -1 for deaths
+	int					p_LiveCount = 0;
+};
+
 } // namespace Neshny
\ No newline at end of file
@@ -20,6 +20,24 @@ unsigned int RandomGenerator::Next(void) {
     return (xor_shifted >> rot) | (xor_shifted << (((rot ^ 0xFFFFFFFF) + 1) & 31));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+unsigned int RandomGenerator::NextBounded(unsigned int bound) {
+    // Lemire's multiply and reject, avoids both modulo bias and a division in the common case
+    if (bound <= 1) {
+        return 0;
+    }
+    uint64_t mult = uint64_t(Next()) * bound;
+    uint32_t low = uint32_t(mult);
+    if (low < bound) {
+        uint32_t threshold = uint32_t(-bound) % bound;
+        while (low < threshold) {
+            mult = uint64_t(Next()) * bound;
+            low = uint32_t(mult);
+        }
+    }
+    return uint32_t(mult >> 32);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void RandomSeed(uint64_t seed) {
     g_GlobalRandom.Seed(seed);
@@ -52,7 +70,7 @@ int RoundUpPowerTwo(int value) {
 
 ////////////////////////////////////////////////////////////////////////////////
 size_t HashMemory(unsigned char* mem, int size) {
-    return std::hash<std::string_view>()(std::string_view((char*)mem, size));
+    return (size_t)HashBytes64(mem, size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -80,32 +98,26 @@ std::string ReplaceAll(std::string_view str, std::string_view before, std::strin
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string JoinStrings(const std::vector<std::string>& list, std::string_view insert_between) {
-    std::string result;
-    int last_index = (int)list.size() - 1;
-    for (int i = 0; i <= last_index; i++) {
-        if (i == last_index) {
-            result += list[i];
-        } else {
-            result += std::format("{}{}", list[i], insert_between);
-        }
+template<typename Container>
+std::string JoinStringList(const Container& list, std::string_view insert_between) {
+    // sized up front so joining never reallocates
+    std::size_t total = list.empty() ? 0 : insert_between.size() * (list.size() - 1);
+    for (const auto& str : list) {
+        total += str.size();
     }
-    return result;
+    CodeBuilder builder(total);
+    builder.Join(list, insert_between);
+    return builder.Take();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string JoinStrings(const std::vector<std::string>& list, std::string_view insert_between) {
+    return JoinStringList(list, insert_between);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::string JoinStrings(const std::list<std::string>& list, std::string_view insert_between) {
-    std::string result;
-    bool first = true;
-    for (const auto& str: list) {
-        if (first) {
-            result += str;
-            first = false;
-        } else {
-            result += std::format("{}{}", insert_between, str);
-        }
-    }
-    return result;
+    return JoinStringList(list, insert_between);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,6 +139,102 @@ std::string SrcStr(const std::source_location location) {
     return std::format("{}:{}", location.file_name(), location.line());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+ParallelPool::~ParallelPool(void) {
+	for (auto& worker : m_Workers) {
+		{
+			std::unique_lock<std::mutex> lock(worker->p_Lock);
+			worker->p_Stop = true;
+		}
+		worker->p_Wake.notify_one();
+		worker->p_Thread.join();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ParallelPool::WorkerLoop(Worker* worker) {
+	std::unique_lock<std::mutex> lock(worker->p_Lock);
+	while (true) {
+		worker->p_Wake.wait(lock, [worker]() { return worker->p_Stop || worker->p_Task; });
+		if (!worker->p_Task) {
+			return;
+		}
+		std::function<void()> task = std::move(worker->p_Task);
+		worker->p_Task = nullptr;
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ParallelPool::Run(int job_count, const std::function<void(int)>& job) {
+	if (job_count <= 1) {
+		if (job_count == 1) {
+			job(0);
+		}
+		return;
+	}
+
+	std::vector<Worker*> workers;
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		while ((int)workers.size() < job_count - 1) {
+			if (m_Idle.empty()) {
+				m_Workers.push_back(std::make_unique<Worker>());
+				Worker* worker = m_Workers.back().get();
+				worker->p_Thread = std::thread(&ParallelPool::WorkerLoop, this, worker);
+				workers.push_back(worker);
+			} else {
+				workers.push_back(m_Idle.back());
+				m_Idle.pop_back();
+			}
+		}
+	}
+
+	std::mutex done_lock;
+	std::condition_variable done_wake;
+	int remaining = job_count - 1;
+	std::exception_ptr error;
+	auto run_job = [&job, &done_lock, &error](int t) {
+		try {
+			job(t);
+		} catch (...) {
+			std::unique_lock<std::mutex> lock(done_lock);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	};
+	for (int t = 1; t < job_count; t++) {
+		Worker* worker = workers[t - 1];
+		{
+			std::unique_lock<std::mutex> lock(worker->p_Lock);
+			worker->p_Task = [&run_job, &done_lock, &done_wake, &remaining, t]() {
+				run_job(t);
+				std::unique_lock<std::mutex> lock(done_lock);
+				if (--remaining == 0) {
+					done_wake.notify_one();
+				}
+			};
+		}
+		worker->p_Wake.notify_one();
+	}
+	run_job(0);
+	{
+		std::unique_lock<std::mutex> lock(done_lock);
+		done_wake.wait(lock, [&remaining]() { return remaining == 0; });
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_Idle.insert(m_Idle.end(), workers.begin(), workers.end());
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void ImGuiTextColoredUnformatted(std::string str, ImVec4 text_col) {
     ImGui::PushStyleColor(ImGuiCol_Text, text_col);
@@ -44,6 +44,7 @@ public:
 	void			Seed			( uint64_t seed ) { m_State = seed;}
 	void			AutoSeed		( void );
 	unsigned int	Next			( void );
+	unsigned int	NextBounded		( unsigned int bound );
 private:
 	uint64_t	m_State;
 };
@@ -83,23 +84,27 @@ void RemoveUnordered(std::vector<T>& vect, typename std::vector<T>::iterator ite
 }
 ////////////////////////////////////////////////////////////////////////////////
 template <class T>
-void Shuffle(std::vector<T>& vect) {
-	int s = (int)vect.size();
-	std::vector<std::pair<int, int>> indices;
-	indices.reserve(s);
-	for (int i = 0; i < s; i++) {
-		indices.push_back({ i, RandomInt(0, 10000000) });
-	}
-	std::sort(indices.begin(), indices.end(), [&indices](const std::pair<int, int>& a, const std::pair<int, int>& b) -> bool {
-		return a.second < b.second;
-	});
-
-	std::vector<T> output;
-	output.reserve(s);
-	for (const auto& ind : indices) {
-		output.push_back(vect[ind.first]);
+void Shuffle(std::vector<T>& vect, RandomGenerator& generator) {
+	// Fisher-Yates, in place and unbiased as long as NextBounded is
+	for (int i = (int)vect.size() - 1; i > 0; i--) {
+		int j = (int)generator.NextBounded((unsigned int)i + 1);
+		if (j != i) {
+			using std::swap; // picks up the proxy swap for std::vector<bool>
+			swap(vect[i], vect[j]);
+		}
 	}
-	vect = std::move(output);
+}
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+void Shuffle(std::vector<T>& vect) {
+	Shuffle(vect, g_GlobalRandom);
+}
+////////////////////////////////////////////////////////////////////////////////
+// deterministic mode - the same seed and size always produce the same permutation, regardless of the global generator
+template <class T>
+void Shuffle(std::vector<T>& vect, uint64_t seed) {
+	RandomGenerator generator(seed);
+	Shuffle(vect, generator);
 }
 ////////////////////////////////////////////////////////////////////////////////
 template <class T>
@@ -127,4 +132,43 @@ private:
 	bool					p_Valid;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// threads kept for the life of the program so fork-join loops do not start new ones on every call
+// each job gets a worker of its own for the whole call, so jobs are free to wait on one another with std::barrier
+// workers are only made when every existing one is busy, so the pool grows to the most jobs ever run at once
+////////////////////////////////////////////////////////////////////////////////
+class ParallelPool {
+public:
+
+	static ParallelPool&	Get				( void ) { static ParallelPool pool; return pool; }
+
+							~ParallelPool	( void );
+
+	// job(t) runs for t from 0 to job_count - 1, the first on the calling thread, and returns once all are done
+	// the first exception a job throws is rethrown here after the rest have finished
+	void					Run				( int job_count, const std::function<void(int)>& job );
+
+private:
+
+	struct Worker {
+		std::thread				p_Thread;
+		std::mutex				p_Lock;
+		std::condition_variable	p_Wake;
+		std::function<void()>	p_Task;
+		bool					p_Stop = false;
+	};
+
+							ParallelPool	( void ) {}
+	void					WorkerLoop		( Worker* worker );
+
+	std::mutex								m_Lock;
+	std::vector<std::unique_ptr<Worker>>	m_Workers;
+	std::vector<Worker*>					m_Idle;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+inline void ParallelFor(int job_count, const std::function<void(int)>& job) {
+	ParallelPool::Get().Run(job_count, job);
+}
+
 } // namespace Neshny
\ No newline at end of file
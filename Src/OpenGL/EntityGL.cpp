@@ -52,6 +52,14 @@ void GPUEntity::Destroy(void) {
 		delete m_CopyBuffer;
 		m_CopyBuffer = nullptr;
 	}
+	if (m_ScanSSBO) {
+		delete m_ScanSSBO;
+		m_ScanSSBO = nullptr;
+	}
+	if (m_CompactSSBO) {
+		delete m_CompactSSBO;
+		m_CompactSSBO = nullptr;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -125,6 +133,11 @@ void GPUEntity::DeleteInstance(int index) {
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::ProcessMoveDeaths(int death_count) {
 
+	if (m_CompactMode == CompactMode::PREFIX_SUM) {
+		ProcessOrderedDeaths(death_count);
+		return;
+	}
+
 	// todo: for each death, take index d from alive and copy it
 	m_ControlSSBO->EnsureSizeBytes(sizeof(int));
 
@@ -146,6 +159,59 @@ void GPUEntity::ProcessMoveDeaths(int death_count) {
 	m_Info.p_Count -= death_count;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void GPUEntity::ProcessOrderedDeaths(int death_count) {
+
+	// EntityCompaction is the CPU reference for all of this and gives the same buffer
+	const int count = m_Info.p_MaxIndex;
+	const int live_count = count - death_count;
+	const auto levels = EntityCompaction::GetLevels(count);
+	if (!m_ScanSSBO) {
+		m_ScanSSBO = new SSBO();
+	}
+	if (!m_CompactSSBO) {
+		m_CompactSSBO = new SSBO();
+	}
+	m_ScanSSBO->EnsureSizeBytes((levels.back().p_Offset + 1) * sizeof(int), false);
+	m_CompactSSBO->EnsureSizeBytes(std::max(1, live_count * m_NumDataFloats) * sizeof(int), false);
+
+	std::string defines = std::format("#define FLOATS_PER {}\n#define ENTITY_OFFSET_INTS {}\n#define SCAN_BLOCK_SIZE {}", m_NumDataFloats, ENTITY_OFFSET_INTS, EntityCompaction::SCAN_BLOCK_SIZE);
+	m_ScanSSBO->Bind(0);
+	m_SSBO->Bind(1);
+	m_CompactSSBO->Bind(2);
+
+	// up the levels, each scanned in blocks whose totals make the level above, until the top fits in one block
+	for (int level = 0; level < (int)levels.size() - 1; level++) {
+		GLShader* scan_prog = Core::GetComputeShader("EntityCompact", defines + (level == 0 ? "\n#define COMPACT_SCAN\n#define COMPACT_FLAGS" : "\n#define COMPACT_SCAN"));
+		scan_prog->UseProgram();
+		glUniform1i(scan_prog->GetUniform("uLevelOffset"), levels[level].p_Offset);
+		glUniform1i(scan_prog->GetUniform("uNextLevelOffset"), levels[level + 1].p_Offset);
+		Core::DispatchMultiple(scan_prog, levels[level].p_Count, EntityCompaction::SCAN_BLOCK_SIZE);
+	}
+
+	// then back down, adding each block's offset onto the sums inside it
+	GLShader* add_prog = Core::GetComputeShader("EntityCompact", defines + "\n#define COMPACT_ADD");
+	add_prog->UseProgram();
+	for (int level = (int)levels.size() - 3; level >= 0; level--) {
+		glUniform1i(add_prog->GetUniform("uLevelOffset"), levels[level].p_Offset);
+		glUniform1i(add_prog->GetUniform("uNextLevelOffset"), levels[level + 1].p_Offset);
+		Core::DispatchMultiple(add_prog, levels[level].p_Count, EntityCompaction::SCAN_BLOCK_SIZE);
+	}
+
+	// survivors can't move down in place without racing each other, so they are gathered into the scratch buffer and copied back
+	GLShader* scatter_prog = Core::GetComputeShader("EntityCompact", defines);
+	scatter_prog->UseProgram();
+	Core::DispatchMultiple(scatter_prog, count, EntityCompaction::SCAN_BLOCK_SIZE);
+	if (live_count > 0) {
+		// the scatter's storage writes have to land before the copy reads them, later shaders see the copy without a barrier
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glCopyNamedBufferSubData(m_CompactSSBO->Get(), m_SSBO->Get(), 0, ENTITY_OFFSET_INTS * sizeof(int), live_count * m_NumDataFloats * sizeof(int));
+	}
+
+	m_Info.p_MaxIndex = live_count;
+	m_Info.p_Count -= death_count;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::ProcessMoveCreates(int new_count, int new_next_id) {
 	// todo: for each creation, copy data out if it's asked for
@@ -171,6 +237,49 @@ void GPUEntity::ProcessStableCreates(int new_max_index, int new_next_id, int new
 	m_Info.p_NextId = new_next_id;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+EntityDefragPlan GPUEntity::Defragment(int max_moves) {
+
+	if ((m_DeleteMode != DeleteMode::STABLE_WITH_GAPS) || (m_Info.p_MaxIndex <= 0)) {
+		return EntityDefragPlan{};
+	}
+	int id_offset_ints = 0;
+	for (const auto& member : m_Specs.p_Members) {
+		if (member.p_Name == m_IDName) {
+			break;
+		}
+		id_offset_ints += member.p_Size / sizeof(int);
+	}
+
+	std::vector<int> data(m_Info.p_MaxIndex * m_NumDataFloats);
+	MakeCopyIn((unsigned char*)data.data(), ENTITY_OFFSET_INTS * sizeof(int), (int)data.size() * sizeof(int));
+	std::vector<int> ids(m_Info.p_MaxIndex);
+	for (int i = 0; i < m_Info.p_MaxIndex; i++) {
+		ids[i] = data[i * m_NumDataFloats + id_offset_ints];
+	}
+	EntityDefragPlan plan = EntityDefragPlan::Create(ids, max_moves);
+
+	if (!plan.p_Moves.empty()) {
+		std::string defines = std::format("#define FLOATS_PER {}\n#define ID_OFFSET {}\n#define ENTITY_OFFSET_INTS {}", m_NumDataFloats, id_offset_ints, ENTITY_OFFSET_INTS);
+		GLShader* defrag_prog = Core::GetComputeShader("EntityDefrag", defines);
+		defrag_prog->UseProgram();
+
+		GLSSBO moves((int)(plan.p_Moves.size() * sizeof(EntityDefragPlan::Move)), (unsigned char*)plan.p_Moves.data());
+		moves.Bind(0);
+		m_SSBO->Bind(1);
+		Core::DispatchMultiple(defrag_prog, (int)plan.p_Moves.size(), 512);
+	}
+
+	m_FreeList->EnsureSizeBytes(std::max(1, (int)plan.p_FreeList.size()) * sizeof(int), false);
+	if (!plan.p_FreeList.empty()) {
+		m_FreeList->Write((unsigned char*)plan.p_FreeList.data(), 0, (int)plan.p_FreeList.size() * sizeof(int));
+	}
+	m_Info.p_Count = plan.p_LiveCount;
+	m_Info.p_MaxIndex = plan.p_NewMaxIndex;
+	m_Info.p_FreeCount = (int)plan.p_FreeList.size();
+	return plan;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::SwapInputOutputSSBOs(void) {
 	if (!m_DoubleBuffering) {
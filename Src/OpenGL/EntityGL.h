@@ -64,7 +64,7 @@ private:
 };
 
 template<typename T>
-void SerializeStructInfo(StructInfo& info, std::string get_base_str, std::string_view entity_name) {
+void GenerateStructInfo(StructInfo& info, std::string get_base_str, std::string_view entity_name) {
 	Serialiser<T> serializeFunc(info.p_Members);
 	meta::doForAllMembers<T>(serializeFunc);
 
@@ -150,6 +150,18 @@ void SerializeStructInfo(StructInfo& info, std::string get_base_str, std::string
 	info.p_GPUInsertion = JoinStrings(lines, "\n");
 }
 
+template<typename T>
+void SerializeStructInfo(StructInfo& info, std::string get_base_str, std::string_view entity_name) {
+	// the code only depends on T and these arguments, so every entity using the same struct shares one copy
+	static GeneratedCodeCache<StructInfo> cache;
+	std::string key = std::string(entity_name) + '|' + get_base_str;
+	info = cache.Get(key, [&]() {
+		StructInfo generated;
+		GenerateStructInfo<T>(generated, get_base_str, entity_name);
+		return generated;
+	});
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -162,6 +174,14 @@ public:
 		,STABLE_WITH_GAPS
 	};
 
+	// how MOVING_COMPACT fills the holes deaths leave
+	// FILL_FROM_END moves entities off the end into the holes, cheap but the order survivors end up in changes from run to run
+	// PREFIX_SUM keeps survivors in the order they were in, the same every run, for a few more passes over the buffer
+	enum class CompactMode {
+		FILL_FROM_END
+		,PREFIX_SUM
+	};
+
 	// TODO: figure out better way of passing in T, perhaps template entire class
 
 	template <typename T> GPUEntity(std::string_view name, DeleteMode delete_mode, int T::* id_ptr, std::string_view id_name, bool double_buffer = true) :
@@ -252,11 +272,18 @@ public:
 	inline bool					IsDoubleBuffering		( void ) const { return m_DoubleBuffering; };
 
 	inline DeleteMode			GetDeleteMode			( void ) const { return m_DeleteMode; }
+	inline CompactMode			GetCompactMode			( void ) const { return m_CompactMode; }
+	inline void					SetCompactMode			( CompactMode mode ) { m_CompactMode = mode; }
 	void						ProcessMoveDeaths		( int death_count );
 	void						ProcessMoveCreates		( int new_count, int new_next_id );
 	void						ProcessStableDeaths		( int death_count );
 	void						ProcessStableCreates	( int new_max_id, int new_next_id, int new_free_count );
 
+	// STABLE_WITH_GAPS only, max_moves < 0 compacts fully, otherwise call it every frame as a budgeted background step
+	// the returned plan's remap is old index to new index, for patching caches that store indices
+	EntityDefragPlan			Defragment				( int max_moves = -1 );
+	inline double				GetFragmentation		( void ) const { return m_Info.p_MaxIndex > 0 ? 1.0 - double(m_Info.p_Count) / m_Info.p_MaxIndex : 0.0; }
+
 	void						SwapInputOutputSSBOs	( void );
 
 protected:
@@ -264,8 +291,10 @@ protected:
 	void						AddInstancesInternal	( unsigned char* data, int item_count, int item_size );
 	void						MakeCopyIn				( unsigned char* ptr, int offset, int size );
 	void						Destroy					( void );
+	void						ProcessOrderedDeaths	( int death_count );
 
 	DeleteMode					m_DeleteMode;
+	CompactMode					m_CompactMode = CompactMode::FILL_FROM_END;
 	std::string					m_Name;
 	StructInfo					m_Specs;
 	std::string					m_GPUInsertion;
@@ -282,6 +311,8 @@ protected:
 	SSBO*						m_ControlSSBO = nullptr;
 	SSBO*						m_FreeList = nullptr;
 	SSBO*						m_CopyBuffer = nullptr;
+	SSBO*						m_ScanSSBO = nullptr;
+	SSBO*						m_CompactSSBO = nullptr;
 
 	EntityInfo					m_Info;
 };
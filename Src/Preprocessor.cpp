@@ -425,4 +425,55 @@ std::string Preprocess(std::string input, const std::function<std::string(std::s
     return output;
 }
 
-}
\ No newline at end of file
+////////////////////////////////////////////////////////////////////////////////
+void ShaderDependencyGraph::SetDependencies(int shader_id, const std::vector<std::string>& files) {
+
+    RemoveShader(shader_id);
+    auto& shader_files = m_ShaderToFiles[shader_id];
+    for (const auto& file : files) {
+        shader_files.insert(file);
+        m_FileToShaders[file].insert(shader_id);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ShaderDependencyGraph::RemoveShader(int shader_id) {
+
+    auto found = m_ShaderToFiles.find(shader_id);
+    if (found == m_ShaderToFiles.end()) {
+        return;
+    }
+    for (const auto& file : found->second) {
+        auto shaders = m_FileToShaders.find(file);
+        shaders->second.erase(shader_id);
+        if (shaders->second.empty()) {
+            m_FileToShaders.erase(shaders);
+        }
+    }
+    m_ShaderToFiles.erase(found);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<int> ShaderDependencyGraph::GetAffectedShaders(const std::vector<std::string>& changed_files) const {
+
+    std::set<int> affected;
+    for (const auto& file : changed_files) {
+        auto found = m_FileToShaders.find(file);
+        if (found != m_FileToShaders.end()) {
+            affected.insert(found->second.begin(), found->second.end());
+        }
+    }
+    return std::vector<int>(affected.begin(), affected.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> ShaderDependencyGraph::GetDependencies(int shader_id) const {
+
+    auto found = m_ShaderToFiles.find(shader_id);
+    if (found == m_ShaderToFiles.end()) {
+        return {};
+    }
+    return std::vector<std::string>(found->second.begin(), found->second.end());
+}
+
+} // namespace Neshny
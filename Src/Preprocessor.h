@@ -7,4 +7,26 @@ namespace Neshny {
 
     std::string      Preprocess  ( std::string_view input, const std::function<std::string(std::string_view, std::string&)>& loader, std::string& err_msg );
 
+////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////
+// maps source files to the shader instances that pulled them in, directly or through any level of #include
+class ShaderDependencyGraph {
+public:
+
+    void                        SetDependencies     ( int shader_id, const std::vector<std::string>& files );
+    void                        RemoveShader        ( int shader_id );
+    void                        Clear               ( void ) { m_FileToShaders.clear(); m_ShaderToFiles.clear(); }
+
+    std::vector<int>            GetAffectedShaders  ( const std::vector<std::string>& changed_files ) const;
+    std::vector<std::string>    GetDependencies     ( int shader_id ) const;
+    inline bool                 IsWatched           ( std::string_view file ) const { return m_FileToShaders.find(std::string(file)) != m_FileToShaders.end(); }
+    inline int                  GetNumShaders       ( void ) const { return (int)m_ShaderToFiles.size(); }
+
+private:
+
+    std::map<std::string, std::set<int>>    m_FileToShaders;
+    std::map<int, std::set<std::string>>    m_ShaderToFiles;
+};
+
 }
\ No newline at end of file
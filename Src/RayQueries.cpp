@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RayQueries.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+	#define NESHNY_RAY_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace Neshny {
+
+namespace ShaderGeometry {
+
+////////////////////////////////////////////////////////////////////////////////
+float SDFSphere(fVec3 pos, fVec3 sphere, float radius) {
+	return (pos - sphere).Length() - radius;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float SDFCapsule(fVec3 pos, fVec3 cyl_start, fVec3 cyl_end, float radius) {
+	fVec3 pa = pos - cyl_start;
+	fVec3 ba = cyl_end - cyl_start;
+	float h = (pa | ba) / (ba | ba);
+	h = std::clamp(h, 0.0f, 1.0f);
+	float dist = (pa - ba * h).Length() - radius;
+	return dist;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float SDFCylinder(fVec3 pos, fVec3 cyl_start, fVec3 cyl_end, float radius) {
+	fVec3 ba = cyl_end - cyl_start;
+	fVec3 pa = pos - cyl_start;
+	float baba = ba | ba;
+	float paba = pa | ba;
+	float x = (pa * baba - ba * paba).Length() - radius * baba;
+	float y = fabsf(paba - baba * 0.5f) - baba * 0.5f;
+	float x2 = x * x;
+	float y2 = y * y * baba;
+	float d = (std::max(x, y) < 0.0f) ? -std::min(x2, y2) : (((x > 0.0f) ? x2 : 0.0f) + ((y > 0.0f) ? y2 : 0.0f));
+	float sign = (d > 0.0f) ? 1.0f : ((d < 0.0f) ? -1.0f : 0.0f);
+	float dist = sign * sqrtf(fabsf(d)) / baba;
+	return dist;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RayPlane(fVec3 plane_point, fVec3 plane_normal, fVec3 ray_origin, fVec3 ray_end, fVec3& hit_pos, float& hit_frac) {
+
+	fVec3 ray_delta = ray_end - ray_origin;
+	fVec3 ray_dir = ray_delta / ray_delta.Length();
+	float denom = plane_normal | ray_dir;
+	if (fabsf(denom) < ALMOST_ZERO_F) {
+		return false;
+	}
+	float t = ((plane_point - ray_origin) | plane_normal) / denom;
+	hit_pos = ray_dir * t + ray_origin;
+	hit_frac = t;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RaySphere(fVec3 sphere_pos, float sphere_rad, fVec3 ray_origin, fVec3 ray_end, fVec3& hit_pos, fVec3& normal, float& hit_frac) {
+
+	fVec3 d = ray_end - ray_origin;
+	fVec3 f = ray_origin - sphere_pos;
+
+	float sqr_size = sphere_rad * sphere_rad;
+	float a = d | d;
+	float b = 2.0f * (f | d);
+	float c = (f | f) - sqr_size;
+
+	float det = b * b - 4.0f * a * c;
+	if (det < 0.0f) {
+		return false;
+	}
+
+	det = sqrtf(det);
+	float t = (-b - det) / (2.0f * a); // assume smallest frac - doesn't handle exit point
+	hit_frac = t;
+	hit_pos = d * t + ray_origin;
+
+	normal = (hit_pos - sphere_pos).NormalizeCopy();
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RayCylinder(fVec3 cyl_start, fVec3 cyl_end, float cyl_rad, fVec3 side_x, fVec3 side_y, fVec3 ray_origin, fVec3 ray_end, bool is_capsule, fVec3& hit_pos, fVec3& normal, float& hit_frac) {
+
+	fVec3 offset_start = ray_origin - cyl_start;
+	fVec3 offset_end = ray_end - cyl_start;
+
+	fVec2 start(offset_start | side_x, offset_start | side_y);
+	fVec2 end(offset_end | side_x, offset_end | side_y);
+
+	fVec2 delta = end - start;
+	float rad_sqr = cyl_rad * cyl_rad;
+	float a = delta.x * delta.x + delta.y * delta.y;
+	float b = 2.0f * (delta.x * start.x + delta.y * start.y);
+	float c = (start.x * start.x + start.y * start.y) - rad_sqr;
+
+	float det = b * b - 4 * a * c;
+	if (det < 0) {
+		return false;
+	}
+
+	det = sqrtf(det);
+	float t = (-b - det) / (2.0f * a);
+	hit_frac = t;
+
+	fVec3 world_pos = ray_origin + (ray_end - ray_origin) * t;
+	hit_pos = world_pos;
+
+	fVec3 rel_pos = world_pos - cyl_start;
+
+	fVec3 dir = cyl_end - cyl_start;
+	float len = dir.Length();
+	fVec3 cyl_dir = dir / len;
+	float along = cyl_dir | rel_pos;
+
+	if ((along < 0) || (along > len)) {
+		if (!is_capsule) {
+			fVec3 cyl_pos = along > len ? cyl_end : cyl_start;
+			normal = along > len ? cyl_dir : cyl_dir * -1.0f;
+			if (!RayPlane(cyl_pos, cyl_dir, ray_origin, ray_end, hit_pos, hit_frac)) {
+				return false;
+			}
+			// the shader leaves this as a distance
+			hit_frac /= (ray_end - ray_origin).Length();
+			fVec3 cap_delta = hit_pos - cyl_pos;
+			return (cap_delta | cap_delta) < rad_sqr;
+		}
+		if (!RaySphere((along > len) ? cyl_end : cyl_start, cyl_rad, ray_origin, ray_end, hit_pos, normal, hit_frac)) {
+			return false;
+		}
+	} else {
+		fVec2 cyl_pos(rel_pos | side_x, rel_pos | side_y);
+		normal = (side_x * cyl_pos.x + side_y * cyl_pos.y).NormalizeCopy();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CylinderSides(fVec3 cyl_start, fVec3 cyl_end, fVec3& side_x, fVec3& side_y) {
+	fVec3 dir = (cyl_end - cyl_start).NormalizeCopy();
+	// crossed with whichever axis is least like the cylinder, so the result is never tiny
+	fVec3 abs_dir = dir.Abs();
+	fVec3 helper = (abs_dir.x <= abs_dir.y) && (abs_dir.x <= abs_dir.z) ? fVec3(1.0f, 0.0f, 0.0f) : ((abs_dir.y <= abs_dir.z) ? fVec3(0.0f, 1.0f, 0.0f) : fVec3(0.0f, 0.0f, 1.0f));
+	side_x = (dir ^ helper).NormalizeCopy();
+	side_y = dir ^ side_x;
+}
+
+} // namespace ShaderGeometry
+
+////////////////////////////////////////////////////////////////////////////////
+// runs func on contiguous ranges of count items, one per pool thread with the first on the calling thread
+template<typename Func>
+void RunRayRanges(int thread_count, int count, Func&& func) {
+	constexpr int MIN_PER_THREAD = 256;
+	thread_count = std::clamp(std::min(thread_count, count / MIN_PER_THREAD), 1, 64);
+	ParallelFor(thread_count, [&func, thread_count, count](int t) { func((int)((int64_t)count * t / thread_count), (int)((int64_t)count * (t + 1) / thread_count)); });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int RayPrimitiveSet::AddSphere(Vec3 pos, double radius) {
+	fVec3 centre = pos.ToFloat3();
+	return Add({ RayPrimitiveType::SPHERE, centre, centre, (float)radius }, centre, (float)radius);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int RayPrimitiveSet::AddCapsule(Vec3 start, Vec3 end, double radius) {
+	RayPrimitive prim{ RayPrimitiveType::CAPSULE, start.ToFloat3(), end.ToFloat3(), (float)radius };
+	ShaderGeometry::CylinderSides(prim.p_Start, prim.p_End, prim.p_SideX, prim.p_SideY);
+	return Add(prim, ((start + end) * 0.5).ToFloat3(), (float)((end - start).Length() * 0.5 + radius));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int RayPrimitiveSet::AddCylinder(Vec3 start, Vec3 end, double radius) {
+	RayPrimitive prim{ RayPrimitiveType::CYLINDER, start.ToFloat3(), end.ToFloat3(), (float)radius };
+	ShaderGeometry::CylinderSides(prim.p_Start, prim.p_End, prim.p_SideX, prim.p_SideY);
+	double half_len = (end - start).Length() * 0.5;
+	return Add(prim, ((start + end) * 0.5).ToFloat3(), (float)sqrt(half_len * half_len + radius * radius));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int RayPrimitiveSet::Add(RayPrimitive prim, fVec3 bound_centre, float bound_radius) {
+	int index = Size();
+	m_Primitives.push_back(prim);
+
+	// float error in the shader functions grows with how far from the origin things are
+	float reach = bound_radius * 1.001f + 0.001f + 0.00001f * (fabsf(bound_centre.x) + fabsf(bound_centre.y) + fabsf(bound_centre.z) + bound_radius);
+	int padded = (Size() + 3) / 4 * 4;
+	m_BoundX.resize(padded, 0.0f);
+	m_BoundY.resize(padded, 0.0f);
+	m_BoundZ.resize(padded, 0.0f);
+	m_BoundReach.resize(padded, 0.0f);
+	m_BoundX[index] = bound_centre.x;
+	m_BoundY[index] = bound_centre.y;
+	m_BoundZ[index] = bound_centre.z;
+	m_BoundReach[index] = reach;
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RayPrimitiveSet::Clear(void) {
+	m_Primitives.clear();
+	m_BoundX.clear();
+	m_BoundY.clear();
+	m_BoundZ.clear();
+	m_BoundReach.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RayPrimitiveSet::Intersect(int index, fVec3 ray_origin, fVec3 ray_end, RayHit& closest) const {
+	const RayPrimitive& prim = m_Primitives[index];
+	fVec3 hit_pos, normal;
+	float hit_frac;
+	bool hit = false;
+	if (prim.p_Type == RayPrimitiveType::SPHERE) {
+		hit = ShaderGeometry::RaySphere(prim.p_Start, prim.p_Radius, ray_origin, ray_end, hit_pos, normal, hit_frac);
+	} else {
+		hit = ShaderGeometry::RayCylinder(prim.p_Start, prim.p_End, prim.p_Radius, prim.p_SideX, prim.p_SideY, ray_origin, ray_end, prim.p_Type == RayPrimitiveType::CAPSULE, hit_pos, normal, hit_frac);
+	}
+	if ((!hit) || (!(hit_frac >= 0.0f)) || (hit_frac > 1.0f) || (closest.IsHit() && (hit_frac >= closest.p_Frac))) {
+		return false;
+	}
+	closest = { index, hit_frac, hit_pos, normal };
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float RayPrimitiveSet::Distance(int index, fVec3 pos) const {
+	const RayPrimitive& prim = m_Primitives[index];
+	switch (prim.p_Type) {
+		case RayPrimitiveType::SPHERE: return ShaderGeometry::SDFSphere(pos, prim.p_Start, prim.p_Radius);
+		case RayPrimitiveType::CAPSULE: return ShaderGeometry::SDFCapsule(pos, prim.p_Start, prim.p_End, prim.p_Radius);
+		default: return ShaderGeometry::SDFCylinder(pos, prim.p_Start, prim.p_End, prim.p_Radius);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RayHit RayPrimitiveSet::CastRay(fVec3 ray_origin, fVec3 ray_end) const {
+	RayHit closest;
+	if (!((ray_end - ray_origin).LengthSquared() > 0.0f)) {
+		return closest;
+	}
+	for (int i = 0; i < Size(); i++) {
+		Intersect(i, ray_origin, ray_end, closest);
+	}
+	return closest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float RayPrimitiveSet::SignedDistance(fVec3 pos, int* nearest) const {
+	float best = std::numeric_limits<float>::infinity();
+	int best_index = -1;
+	for (int i = 0; i < Size(); i++) {
+		float dist = Distance(i, pos);
+		if (dist < best) {
+			best = dist;
+			best_index = i;
+		}
+	}
+	if (nearest) {
+		*nearest = best_index;
+	}
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RayHit RayPrimitiveSet::CastRaySIMD(fVec3 ray_origin, fVec3 ray_end) const {
+	RayHit closest;
+	fVec3 delta = ray_end - ray_origin;
+	float delta_sqr = delta.LengthSquared();
+	if (!(delta_sqr > 0.0f)) {
+		return closest;
+	}
+	float inv_delta_sqr = 1.0f / delta_sqr;
+	float ray_slack = 0.00001f * (fabsf(ray_origin.x) + fabsf(ray_origin.y) + fabsf(ray_origin.z) + fabsf(ray_end.x) + fabsf(ray_end.y) + fabsf(ray_end.z));
+	const int count = Size();
+
+	// the segment can only hit a primitive if the closest point on it to the bounding sphere's centre is inside that sphere
+	for (int group = 0; group < count; group += 4) {
+		int mask = 0;
+#ifdef NESHNY_RAY_SSE
+		__m128 to_x = _mm_sub_ps(_mm_loadu_ps(m_BoundX.data() + group), _mm_set1_ps(ray_origin.x));
+		__m128 to_y = _mm_sub_ps(_mm_loadu_ps(m_BoundY.data() + group), _mm_set1_ps(ray_origin.y));
+		__m128 to_z = _mm_sub_ps(_mm_loadu_ps(m_BoundZ.data() + group), _mm_set1_ps(ray_origin.z));
+		__m128 along = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(to_x, _mm_set1_ps(delta.x)), _mm_mul_ps(to_y, _mm_set1_ps(delta.y))), _mm_mul_ps(to_z, _mm_set1_ps(delta.z))), _mm_set1_ps(inv_delta_sqr));
+		along = _mm_min_ps(_mm_max_ps(along, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		__m128 off_x = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(delta.x), along), to_x);
+		__m128 off_y = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(delta.y), along), to_y);
+		__m128 off_z = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(delta.z), along), to_z);
+		__m128 dist_sqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(off_x, off_x), _mm_mul_ps(off_y, off_y)), _mm_mul_ps(off_z, off_z));
+		__m128 reach = _mm_add_ps(_mm_loadu_ps(m_BoundReach.data() + group), _mm_set1_ps(ray_slack));
+		mask = _mm_movemask_ps(_mm_cmple_ps(dist_sqr, _mm_mul_ps(reach, reach)));
+#else
+		for (int lane = 0; lane < 4; lane++) {
+			fVec3 to_centre = fVec3(m_BoundX[group + lane], m_BoundY[group + lane], m_BoundZ[group + lane]) - ray_origin;
+			float along = std::clamp((to_centre | delta) * inv_delta_sqr, 0.0f, 1.0f);
+			float reach = m_BoundReach[group + lane] + ray_slack;
+			mask |= ((delta * along - to_centre).LengthSquared() <= reach * reach) ? (1 << lane) : 0;
+		}
+#endif
+		if (group + 4 > count) {
+			mask &= (1 << (count - group)) - 1;
+		}
+		while (mask) {
+			int lane = std::countr_zero((unsigned int)mask);
+			mask &= mask - 1;
+			Intersect(group + lane, ray_origin, ray_end, closest);
+		}
+	}
+	return closest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float RayPrimitiveSet::SignedDistanceSIMD(fVec3 pos, int* nearest) const {
+	float best = std::numeric_limits<float>::infinity();
+	int best_index = -1;
+	float pos_slack = 0.001f + 0.00001f * (fabsf(pos.x) + fabsf(pos.y) + fabsf(pos.z));
+	const int count = Size();
+
+	// nothing in a bounding sphere can be closer than the sphere is, so groups entirely further away than the best so far are skipped
+	for (int group = 0; group < count; group += 4) {
+		float limit = best + pos_slack + 0.00001f * fabsf(best);
+		int mask = 0;
+#ifdef NESHNY_RAY_SSE
+		__m128 off_x = _mm_sub_ps(_mm_loadu_ps(m_BoundX.data() + group), _mm_set1_ps(pos.x));
+		__m128 off_y = _mm_sub_ps(_mm_loadu_ps(m_BoundY.data() + group), _mm_set1_ps(pos.y));
+		__m128 off_z = _mm_sub_ps(_mm_loadu_ps(m_BoundZ.data() + group), _mm_set1_ps(pos.z));
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(off_x, off_x), _mm_mul_ps(off_y, off_y)), _mm_mul_ps(off_z, off_z)));
+		__m128 lower_bound = _mm_sub_ps(dist, _mm_loadu_ps(m_BoundReach.data() + group));
+		mask = _mm_movemask_ps(_mm_cmple_ps(lower_bound, _mm_set1_ps(limit)));
+#else
+		for (int lane = 0; lane < 4; lane++) {
+			float lower_bound = (fVec3(m_BoundX[group + lane], m_BoundY[group + lane], m_BoundZ[group + lane]) - pos).Length() - m_BoundReach[group + lane];
+			mask |= (lower_bound <= limit) ? (1 << lane) : 0;
+		}
+#endif
+		if (group + 4 > count) {
+			mask &= (1 << (count - group)) - 1;
+		}
+		while (mask) {
+			int lane = std::countr_zero((unsigned int)mask);
+			mask &= mask - 1;
+			float dist = Distance(group + lane, pos);
+			if (dist < best) {
+				best = dist;
+				best_index = group + lane;
+			}
+		}
+	}
+	if (nearest) {
+		*nearest = best_index;
+	}
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RayPrimitiveSet::CastRays(const std::vector<Ray>& rays, std::vector<RayHit>& hits, int thread_count) const {
+	hits.resize(rays.size());
+	RunRayRanges(thread_count, (int)rays.size(), [this, &rays, &hits](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			hits[i] = CastRaySIMD(rays[i].p_Origin, rays[i].p_End);
+		}
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RayPrimitiveSet::SignedDistances(const std::vector<fVec3>& points, std::vector<float>& distances, std::vector<int>* nearest, int thread_count) const {
+	distances.resize(points.size());
+	if (nearest) {
+		nearest->resize(points.size());
+	}
+	RunRayRanges(thread_count, (int)points.size(), [this, &points, &distances, nearest](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			distances[i] = SignedDistanceSIMD(points[i], nearest ? &(*nearest)[i] : nullptr);
+		}
+	});
+}
+
+} // namespace Neshny
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// float versions of the functions in Shaders/RayTracing.glsl, line for line, so the CPU gets the same answers a shader does
+// the one deliberate difference - a flat cylinder cap reports hit_frac as a fraction of the ray like everything else, not as a distance
+////////////////////////////////////////////////////////////////////////////////
+namespace ShaderGeometry {
+
+	constexpr float ALMOST_ZERO_F = 0.0001f;	// matches ALMOST_ZERO in Shaders/Utils.glsl
+
+	float	SDFSphere		( fVec3 pos, fVec3 sphere, float radius );
+	float	SDFCapsule		( fVec3 pos, fVec3 cyl_start, fVec3 cyl_end, float radius );
+	float	SDFCylinder		( fVec3 pos, fVec3 cyl_start, fVec3 cyl_end, float radius );
+
+	// hit_frac is the distance along the normalised ray direction
+	bool	RayPlane		( fVec3 plane_point, fVec3 plane_normal, fVec3 ray_origin, fVec3 ray_end, fVec3& hit_pos, float& hit_frac );
+	// hit_frac is the fraction of the way from ray_origin to ray_end, and can be outside 0 to 1 - only the nearer of the two hits is found
+	bool	RaySphere		( fVec3 sphere_pos, float sphere_rad, fVec3 ray_origin, fVec3 ray_end, fVec3& hit_pos, fVec3& normal, float& hit_frac );
+	// side_x and side_y are unit vectors perpendicular to the cylinder and each other, see CylinderSides
+	bool	RayCylinder		( fVec3 cyl_start, fVec3 cyl_end, float cyl_rad, fVec3 side_x, fVec3 side_y, fVec3 ray_origin, fVec3 ray_end, bool is_capsule, fVec3& hit_pos, fVec3& normal, float& hit_frac );
+	void	CylinderSides	( fVec3 cyl_start, fVec3 cyl_end, fVec3& side_x, fVec3& side_y );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+enum class RayPrimitiveType {
+	SPHERE, CAPSULE, CYLINDER
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct RayPrimitive {
+	RayPrimitiveType	p_Type;
+	fVec3				p_Start;		// the centre for spheres
+	fVec3				p_End;
+	float				p_Radius;
+	fVec3				p_SideX;
+	fVec3				p_SideY;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct Ray {
+	fVec3	p_Origin;
+	fVec3	p_End;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct RayHit {
+	inline bool	IsHit			( void ) const { return p_Primitive >= 0; }
+
+	int			p_Primitive = -1;
+	float		p_Frac = 0.0f;		// from 0 at the ray origin to 1 at its end
+	fVec3		p_Pos;
+	fVec3		p_Normal;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// a set of shader primitives that many rays or points can be tested against at once
+// CastRay and SignedDistance check every primitive one by one with the ShaderGeometry functions, they are the reference
+// CastRays and SignedDistances rule out four primitives at a time by their bounding spheres with SIMD, then run the same functions on the rest
+// so the batched results are always exactly the ones the reference gives
+////////////////////////////////////////////////////////////////////////////////
+class RayPrimitiveSet {
+public:
+
+	// each returns the index hits report the primitive by
+	int						AddSphere			( Vec3 pos, double radius );
+	int						AddCapsule			( Vec3 start, Vec3 end, double radius );
+	int						AddCylinder			( Vec3 start, Vec3 end, double radius );
+	void					Clear				( void );
+
+	inline int				Size				( void ) const { return (int)m_Primitives.size(); }
+	inline const RayPrimitive&	Get				( int index ) const { return m_Primitives[index]; }
+
+	// the closest hit between the ray origin and end, ties go to the lowest index
+	// only the near side of each primitive is tested, like the shaders, so a ray starting inside one does not hit it
+	RayHit					CastRay				( fVec3 ray_origin, fVec3 ray_end ) const;
+	// the union of every primitive, with the index of the closest one
+	float					SignedDistance		( fVec3 pos, int* nearest = nullptr ) const;
+
+	void					CastRays			( const std::vector<Ray>& rays, std::vector<RayHit>& hits, int thread_count = 1 ) const;
+	void					SignedDistances		( const std::vector<fVec3>& points, std::vector<float>& distances, std::vector<int>* nearest = nullptr, int thread_count = 1 ) const;
+
+private:
+
+	int						Add					( RayPrimitive prim, fVec3 bound_centre, float bound_radius );
+	bool					Intersect			( int index, fVec3 ray_origin, fVec3 ray_end, RayHit& closest ) const;
+	float					Distance			( int index, fVec3 pos ) const;
+	RayHit					CastRaySIMD			( fVec3 ray_origin, fVec3 ray_end ) const;
+	float					SignedDistanceSIMD	( fVec3 pos, int* nearest ) const;
+
+	std::vector<RayPrimitive>	m_Primitives;
+	// bounding spheres, padded to a multiple of four - the padding is masked off
+	std::vector<float>			m_BoundX;
+	std::vector<float>			m_BoundY;
+	std::vector<float>			m_BoundZ;
+	std::vector<float>			m_BoundReach;		// radius plus some slack, so float error never rules out a real hit
+};
+
+} // namespace Neshny
@@ -208,14 +208,10 @@ bool ObjModelFile::FileInit(std::string_view path, unsigned char* data, int leng
 					}
 				}
 			} else if ((line_tokens[0] == "mtllib") && (tokens >= 2)) {
-				std::ifstream file(std::format("{}{}", directory, line_tokens[1]), std::ios::in | std::ios::binary);
-				if (file.is_open()) {
-					std::ostringstream data_stream;
-					data_stream << file.rdbuf();
-					std::string sub_file_data = data_stream.str();
-
+				MappedFile file(std::format("{}{}", directory, line_tokens[1]));
+				if (file.IsValid()) {
 					std::string new_material;
-					read_file((unsigned char*)sub_file_data.data(), sub_file_data.length(), [&] (const std::vector<std::string_view>& sub_line_tokens) {
+					read_file(file.GetMutableData(), (int)file.GetSize(), [&] (const std::vector<std::string_view>& sub_line_tokens) {
 						if ((sub_line_tokens[0] == "newmtl") && (sub_line_tokens.size() >= 2)) {
 							new_material = std::string(sub_line_tokens[1]);
 						} else if ((sub_line_tokens[0] == "map_Kd") && (sub_line_tokens.size() >= 2)) {
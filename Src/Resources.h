@@ -14,16 +14,13 @@ public:
 	virtual bool		FileInit(std::string_view path, unsigned char* data, int length, std::string& err) = 0;
 
 	bool				Load(std::string_view path, std::string& err) {
-		std::ifstream file(std::string(path), std::ios::in | std::ios::binary);
-		if (!file.is_open()) {
+		// mapped rather than read, FileInit sees the file's pages directly and the mapping is released once it returns
+		MappedFile file(path);
+		if (!file.IsValid()) {
 			err = std::format("Could not open {} for reading", path);
 			return false;
 		}
-		std::ostringstream data_stream;
-		data_stream << file.rdbuf();
-		std::string data = data_stream.str();
-
-		return FileInit(path, (unsigned char*)data.data(), data.size(), err);
+		return FileInit(path, file.GetMutableData(), (int)file.GetSize(), err);
 	};
 };
 
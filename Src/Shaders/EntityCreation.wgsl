@@ -17,6 +17,7 @@ fn main(@builtin(global_invocation_id) global_id: vec3u) {
     }
     let item_size: i32 = b_Data[1];
     let id_offset: i32 = b_Data[2];
+    let stride: i32 = b_Data[3]; // zero unless the entity is stored as SOA
 
     // checks the free list, and allocates there if available, otherwises expands max index and places there
     atomicAdd(&b_Entity[0], 1); //ioCount
@@ -28,6 +29,14 @@ fn main(@builtin(global_invocation_id) global_id: vec3u) {
         creation_index = b_FreeList[prev_free_count - 1];
     } else {
         creation_index = atomicAdd(&b_Entity[3], 1); //ioMaxIndex
+        if ((stride > 0) && (creation_index >= stride)) {
+            // SOA columns are stride apart, so writing here would land in the next column
+            atomicAdd(&b_Entity[3], -1);
+            atomicAdd(&b_Entity[0], -1);
+            b_IndexIdData[comp_index * 2] = -1;
+            b_IndexIdData[comp_index * 2 + 1] = -1;
+            return;
+        }
     }
 
     {
@@ -36,12 +45,17 @@ fn main(@builtin(global_invocation_id) global_id: vec3u) {
         b_IndexIdData[base_ind + 1] = new_id;
     }
 
-    let in_offset: i32 = comp_index * item_size + 3;
-    let out_offset: i32 = ENTITY_OFFSET_INTS + creation_index * item_size;
+    let in_offset: i32 = comp_index * item_size + 4;
+    var out_offset: i32 = ENTITY_OFFSET_INTS + creation_index * item_size;
+    var out_step: i32 = 1;
+    if (stride > 0) {
+        out_offset = ENTITY_OFFSET_INTS + creation_index;
+        out_step = stride;
+    }
 
     // copies all data except for ID, which is allocated here
     for(var i: i32; i < item_size; i++) {
         let input: i32 = select(b_Data[in_offset + i], new_id, i == id_offset);
-        atomicStore(&b_Entity[out_offset + i], input);
+        atomicStore(&b_Entity[out_offset + i * out_step], input);
     }
 }
\ No newline at end of file
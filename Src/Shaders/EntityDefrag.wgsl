@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@group(0) @binding(0) var<storage, read_write> b_Entity: array<i32>;
+@group(0) @binding(1) var<storage, read> b_Moves: array<i32>;
+
+@compute @workgroup_size(256)
+
+////////////////////////////////////////////////////////////////////////////////
+fn main(@builtin(global_invocation_id) global_id: vec3u) {
+
+    let count: i32 = b_Moves[0];
+    let move_index = i32(global_id.x);
+    if (move_index >= count) {
+        return;
+    }
+    let item_size: i32 = b_Moves[1];
+    let id_offset: i32 = b_Moves[2];
+    let stride: i32 = b_Moves[3]; // zero unless the entity is stored as SOA
+
+    // sources are always live and destinations always holes, so no two moves touch the same slot
+    let from_index: i32 = b_Moves[4 + move_index * 2];
+    let to_index: i32 = b_Moves[5 + move_index * 2];
+
+    var item_step: i32 = item_size;
+    var member_step: i32 = 1;
+    if (stride > 0) {
+        item_step = 1;
+        member_step = stride;
+    }
+    let from_offset: i32 = ENTITY_OFFSET_INTS + from_index * item_step;
+    let to_offset: i32 = ENTITY_OFFSET_INTS + to_index * item_step;
+
+    for(var i: i32; i < item_size; i++) {
+        b_Entity[to_offset + i * member_step] = b_Entity[from_offset + i * member_step];
+    }
+    b_Entity[from_offset + id_offset * member_step] = -1;
+}
@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// below this many elements sorting is done on the calling thread only
+constexpr int RADIX_PARALLEL_THRESHOLD = 1 << 16;
+constexpr int RADIX_MIN_PER_THREAD = 1 << 15;
+
+////////////////////////////////////////////////////////////////////////////////
+// maps a key to an unsigned integer with the same ordering, so the sort only ever looks at bytes
+template <class K>
+struct RadixKey {
+	static_assert((sizeof(K) == 4) || (sizeof(K) == 8), "Radix sort only supports 32 and 64 bit keys");
+	static_assert(std::is_integral_v<K> || std::is_floating_point_v<K>, "Radix sort keys must be integers or floats");
+
+	using Bits = std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+	static constexpr Bits SIGN_BIT = Bits(1) << (sizeof(K) * 8 - 1);
+
+	static inline Bits ToBits(K key) {
+		Bits bits = std::bit_cast<Bits>(key);
+		if constexpr (std::is_floating_point_v<K>) {
+			// negative floats are flipped entirely so that more negative sorts lower, positive just gain the sign bit
+			return (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+		} else if constexpr (std::is_signed_v<K>) {
+			return bits ^ SIGN_BIT;
+		} else {
+			return bits;
+		}
+	}
+};
+
+struct RadixNoValue {};
+
+////////////////////////////////////////////////////////////////////////////////
+inline int RadixSortThreadCount(size_t count, int max_threads) {
+#ifdef __EMSCRIPTEN__
+	return 1;
+#else
+	if ((count < RADIX_PARALLEL_THRESHOLD) || (max_threads == 1)) {
+		return 1;
+	}
+	int threads = max_threads > 0 ? max_threads : std::max(1, (int)std::thread::hardware_concurrency());
+	return std::max(1, std::min(threads, (int)(count / RADIX_MIN_PER_THREAD)));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// stable LSD radix sort, one byte per pass, values are permuted along with their keys when given
+// each thread histograms and scatters its own contiguous chunk, so equal keys keep their relative order
+template <class K, class V>
+void RadixSortInternal(K* keys, V* values, size_t count, int max_threads) {
+
+	constexpr bool has_values = !std::is_same_v<V, RadixNoValue>;
+	constexpr int num_passes = sizeof(K);
+	constexpr int num_buckets = 256;
+	using Key = RadixKey<K>;
+
+	if (count <= 1) {
+		return;
+	}
+
+	std::vector<K> key_scratch(count);
+	std::vector<V> value_scratch(has_values ? count : 0);
+
+	K* src_keys = keys;
+	K* dst_keys = key_scratch.data();
+	V* src_values = values;
+	V* dst_values = value_scratch.data();
+
+	const int num_threads = RadixSortThreadCount(count, max_threads);
+	const size_t chunk_size = (count + num_threads - 1) / num_threads;
+	std::vector<std::array<size_t, num_buckets>> histograms(num_threads);
+
+	int shift = 0;
+	bool skip_pass = false;
+	bool after_histogram = true;
+
+	// runs once on a single thread between each phase - turns the histograms into scatter offsets, or swaps the buffers
+	auto between_phases = [&]() noexcept {
+		if (after_histogram) {
+			skip_pass = false;
+			size_t offset = 0;
+			for (int bucket = 0; bucket < num_buckets; bucket++) {
+				size_t bucket_total = 0;
+				for (int t = 0; t < num_threads; t++) {
+					size_t bucket_count = histograms[t][bucket];
+					histograms[t][bucket] = offset + bucket_total;
+					bucket_total += bucket_count;
+				}
+				// every key has the same byte here, so this pass would not move anything
+				skip_pass = skip_pass || (bucket_total == count);
+				offset += bucket_total;
+			}
+		} else {
+			if (!skip_pass) {
+				std::swap(src_keys, dst_keys);
+				if constexpr (has_values) {
+					std::swap(src_values, dst_values);
+				}
+			}
+			shift += 8;
+		}
+		after_histogram = !after_histogram;
+	};
+	std::barrier sync(num_threads, between_phases);
+
+	auto worker = [&](int thread_index) {
+		const size_t start = std::min(count, thread_index * chunk_size);
+		const size_t end = std::min(count, start + chunk_size);
+		auto& histogram = histograms[thread_index];
+		for (int pass = 0; pass < num_passes; pass++) {
+
+			histogram.fill(0);
+			for (size_t i = start; i < end; i++) {
+				histogram[(Key::ToBits(src_keys[i]) >> shift) & 0xFF]++;
+			}
+			sync.arrive_and_wait();
+
+			if (!skip_pass) {
+				for (size_t i = start; i < end; i++) {
+					size_t dest = histogram[(Key::ToBits(src_keys[i]) >> shift) & 0xFF]++;
+					dst_keys[dest] = src_keys[i];
+					if constexpr (has_values) {
+						dst_values[dest] = std::move(src_values[i]);
+					}
+				}
+			}
+			sync.arrive_and_wait();
+		}
+	};
+
+	// every pass waits on the barrier, which ParallelFor allows as each job has a thread of its own
+	ParallelFor(num_threads, worker);
+
+	if (src_keys != keys) {
+		std::copy(src_keys, src_keys + count, keys);
+		if constexpr (has_values) {
+			std::move(src_values, src_values + count, values);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sorts 32 or 64 bit integer or float keys in ascending order, max_threads of -1 uses one thread per hardware thread
+template <class K>
+void RadixSort(std::span<K> keys, int max_threads = -1) {
+	RadixSortInternal<K, RadixNoValue>(keys.data(), nullptr, keys.size(), max_threads);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class K>
+void RadixSort(std::vector<K>& keys, int max_threads = -1) {
+	RadixSort(std::span<K>(keys), max_threads);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sorts by key and applies the same permutation to values, stable for equal keys
+template <class K, class V>
+void RadixSort(std::span<K> keys, std::span<V> values, int max_threads = -1) {
+	if (keys.size() != values.size()) {
+		throw std::invalid_argument("Radix sort needs exactly one value per key");
+	}
+	RadixSortInternal<K, V>(keys.data(), values.data(), keys.size(), max_threads);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class K, class V>
+void RadixSort(std::vector<K>& keys, std::vector<V>& values, int max_threads = -1) {
+	RadixSort(std::span<K>(keys), std::span<V>(values), max_threads);
+}
+
+} // namespace Neshny
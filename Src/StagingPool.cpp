@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "StagingPool.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+StagingPool::StagingPool(StagingDevice device, StagingPoolParams params) :
+	m_Device(std::move(device))
+	,m_Params(params)
+{
+	m_Params.p_MinBlockBytes = RoundUpPowerTwo(std::max(m_Params.p_MinBlockBytes, SHARED_ALIGNMENT));
+	m_Params.p_MaxPooledBytes = std::max(m_Params.p_MaxPooledBytes, m_Params.p_MinBlockBytes);
+	m_Params.p_SharedBlockBytes = std::clamp(m_Params.p_SharedBlockBytes, m_Params.p_MinBlockBytes, m_Params.p_MaxPooledBytes);
+	m_Params.p_MaxSharedReadBytes = std::min(m_Params.p_MaxSharedReadBytes, m_Params.p_SharedBlockBytes);
+	m_Params.p_ReuseAfterFrames = std::max(m_Params.p_ReuseAfterFrames, 0);
+	m_FreeBlocks.resize(GetSizeClass(m_Params.p_MaxPooledBytes) + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+StagingPool::~StagingPool(void) {
+	// blocks still waiting on a mapping are destroyed too, the device has to cancel those callbacks without calling them
+	for (auto& block : m_Blocks) {
+		m_Device.p_Destroy(block->p_Handle);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int StagingPool::GetSizeClass(int size_bytes) const {
+	if (size_bytes > m_Params.p_MaxPooledBytes) {
+		return -1;
+	}
+	int size_class = 0;
+	while (GetSizeClassBytes(size_class) < size_bytes) {
+		size_class++;
+	}
+	return size_class;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+StagingPool::Target StagingPool::Read(int size_bytes, ReadCallback&& callback) {
+	size_bytes = std::max(size_bytes, 0);
+	int aligned_size = (size_bytes + SHARED_ALIGNMENT - 1) / SHARED_ALIGNMENT * SHARED_ALIGNMENT;
+	m_Stats.p_Reads++;
+
+	bool shared = aligned_size <= m_Params.p_MaxSharedReadBytes;
+	if (shared && m_OpenBlock && (m_OpenBlock->p_UsedBytes + aligned_size > m_OpenBlock->p_SizeBytes)) {
+		m_ClosedBlocks.push_back(m_OpenBlock);
+		m_OpenBlock = nullptr;
+	}
+	// every block handed out before this call has been copied into by now, so they can all be mapped
+	MapClosedBlocks();
+
+	if (shared) {
+		if (!m_OpenBlock) {
+			m_OpenBlock = Acquire(m_Params.p_SharedBlockBytes);
+		}
+		int offset = m_OpenBlock->p_UsedBytes;
+		m_OpenBlock->p_UsedBytes += aligned_size;
+		m_OpenBlock->p_Reads.push_back({ offset, size_bytes, std::move(callback) });
+		return { m_OpenBlock->p_Handle, offset };
+	}
+
+	Block* block = Acquire(aligned_size);
+	block->p_UsedBytes = aligned_size;
+	block->p_Reads.push_back({ 0, size_bytes, std::move(callback) });
+	m_ClosedBlocks.push_back(block);
+	return { block->p_Handle, 0 };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::Flush(void) {
+	if (m_OpenBlock) {
+		m_ClosedBlocks.push_back(m_OpenBlock);
+		m_OpenBlock = nullptr;
+	}
+	MapClosedBlocks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::EndFrame(void) {
+	m_Frame++;
+	for (auto& free_list : m_FreeBlocks) {
+		while ((!free_list.empty()) && (m_Frame - free_list.front()->p_ReleasedFrame > m_Params.p_TrimAfterFrames)) {
+			Block* block = free_list.front();
+			free_list.pop_front();
+			m_Stats.p_FreeBlocks--;
+			Destroy(block);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+StagingPool::Block* StagingPool::Acquire(int size_bytes) {
+	int size_class = GetSizeClass(size_bytes);
+	m_Stats.p_InFlightBlocks++;
+	if (size_class >= 0) {
+		// the most recently released block that is past the fence, so rarely used blocks age out and get trimmed
+		auto& free_list = m_FreeBlocks[size_class];
+		for (auto iter = free_list.rbegin(); iter != free_list.rend(); iter++) {
+			if (m_Frame - (*iter)->p_ReleasedFrame >= m_Params.p_ReuseAfterFrames) {
+				Block* block = *iter;
+				free_list.erase(std::next(iter).base());
+				m_Stats.p_FreeBlocks--;
+				m_Stats.p_BlocksReused++;
+				block->p_UsedBytes = 0;
+				return block;
+			}
+		}
+	} else {
+		m_Stats.p_OversizedReads++;
+	}
+
+	int block_size = size_class >= 0 ? GetSizeClassBytes(size_class) : size_bytes;
+	m_Blocks.push_back(std::make_unique<Block>(Block{ m_Device.p_Create(block_size), block_size, size_class }));
+	m_Stats.p_BlocksCreated++;
+	m_Stats.p_LiveBlocks++;
+	m_Stats.p_LiveBytes += block_size;
+	m_Stats.p_PeakLiveBytes = std::max(m_Stats.p_PeakLiveBytes, m_Stats.p_LiveBytes);
+	return m_Blocks.back().get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::Release(Block* block) {
+	m_Stats.p_InFlightBlocks--;
+	if (block->p_SizeClass < 0) {
+		Destroy(block);
+		return;
+	}
+	block->p_ReleasedFrame = m_Frame;
+	m_FreeBlocks[block->p_SizeClass].push_back(block);
+	m_Stats.p_FreeBlocks++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::Destroy(Block* block) {
+	m_Device.p_Destroy(block->p_Handle);
+	m_Stats.p_BlocksDestroyed++;
+	m_Stats.p_LiveBlocks--;
+	m_Stats.p_LiveBytes -= block->p_SizeBytes;
+	std::erase_if(m_Blocks, [block](const auto& owned) { return owned.get() == block; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::Map(Block* block) {
+	m_Stats.p_Maps++;
+	m_Device.p_MapRead(block->p_Handle, block->p_UsedBytes, [this, block](const unsigned char* data) {
+		// moved out first so a callback that reads again can't touch this list
+		std::vector<PendingRead> reads = std::move(block->p_Reads);
+		block->p_Reads.clear();
+		for (auto& read : reads) {
+			read.p_Callback(data ? data + read.p_Offset : nullptr, read.p_Size);
+		}
+		Release(block);
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void StagingPool::MapClosedBlocks(void) {
+	// swapped out first since a device that calls back straight away could get here again through a read callback
+	std::vector<Block*> closed;
+	std::swap(closed, m_ClosedBlocks);
+	for (Block* block : closed) {
+		Map(block);
+	}
+}
+
+} // namespace Neshny
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+// the few things the pool needs from a graphics API, so it can run against a fake one in tests
+struct StagingDevice {
+	// a buffer the GPU can copy into and the CPU can map for reading
+	std::function<void*(int size_bytes)>													p_Create;
+	std::function<void(void* handle)>														p_Destroy;
+	// maps the first size_bytes of the buffer and calls back with the data, or nullptr if mapping failed
+	// the data only has to stay valid until the callback returns, the buffer is unmapped after that
+	std::function<void(void* handle, int size_bytes, std::function<void(const unsigned char* data)>&& callback)>	p_MapRead;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct StagingPoolParams {
+	int		p_MinBlockBytes = 256;			// the smallest size class, each class after that is double the one before
+	int		p_MaxPooledBytes = 64 << 20;	// reads bigger than this get a buffer of their own that is destroyed afterwards
+	int		p_SharedBlockBytes = 4096;		// small reads are packed into blocks this big and mapped together
+	int		p_MaxSharedReadBytes = 1024;
+	int		p_ReuseAfterFrames = 1;			// a block released in frame N is only handed out again from frame N + this
+	int		p_TrimAfterFrames = 300;		// free blocks that go unused this long are destroyed
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct StagingPoolStats {
+	int64_t	p_Reads = 0;
+	int64_t	p_Maps = 0;						// fewer than reads when small reads shared a mapping
+	int64_t	p_BlocksCreated = 0;
+	int64_t	p_BlocksDestroyed = 0;
+	int64_t	p_BlocksReused = 0;
+	int64_t	p_OversizedReads = 0;
+	int		p_LiveBlocks = 0;
+	int		p_FreeBlocks = 0;
+	int		p_InFlightBlocks = 0;			// handed out and not released yet, either still filling or waiting on a mapping
+	int64_t	p_LiveBytes = 0;
+	int64_t	p_PeakLiveBytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// reuses readback staging buffers instead of creating and destroying one per read
+// small reads made between flushes are packed into one shared block and come back from a single mapping
+// blocks come in power of two size classes and are only reused once a few frames have passed since they were released
+// not thread safe - Read, Flush and EndFrame must be called from the thread the device calls back on
+////////////////////////////////////////////////////////////////////////////////
+class StagingPool {
+public:
+
+	using ReadCallback = std::function<void(const unsigned char* data, int size_bytes)>;
+
+	// where the caller has to copy the data being read, straight after calling Read
+	struct Target {
+		void*	p_Handle;
+		int		p_Offset;
+	};
+
+								StagingPool			( StagingDevice device, StagingPoolParams params = {} );
+								~StagingPool		( void );
+
+								StagingPool			( const StagingPool& ) = delete;
+	StagingPool&				operator=			( const StagingPool& ) = delete;
+
+	// the callback gets nullptr for the data if the mapping failed
+	Target						Read				( int size_bytes, ReadCallback&& callback );
+	// maps everything read so far, must be called before waiting on any of those reads
+	void						Flush				( void );
+	// call once a frame, after Flush
+	void						EndFrame			( void );
+
+	inline const StagingPoolStats&	GetStats		( void ) const { return m_Stats; }
+	inline const StagingPoolParams&	GetParams		( void ) const { return m_Params; }
+	inline int64_t				GetFrame			( void ) const { return m_Frame; }
+	// power of two size class a read of this many bytes is served from, -1 when it's too big to pool
+	int							GetSizeClass		( int size_bytes ) const;
+	inline int					GetSizeClassBytes	( int size_class ) const { return m_Params.p_MinBlockBytes << size_class; }
+
+private:
+
+	static constexpr int		SHARED_ALIGNMENT = 8;
+
+	struct PendingRead {
+		int				p_Offset;
+		int				p_Size;
+		ReadCallback	p_Callback;
+	};
+
+	struct Block {
+		void*						p_Handle;
+		int							p_SizeBytes;
+		int							p_SizeClass;
+		int							p_UsedBytes = 0;
+		int64_t						p_ReleasedFrame = 0;
+		std::vector<PendingRead>	p_Reads;
+	};
+
+	Block*						Acquire				( int size_bytes );
+	void						Release				( Block* block );
+	void						Destroy				( Block* block );
+	void						Map					( Block* block );
+	void						MapClosedBlocks		( void );
+
+	StagingDevice						m_Device;
+	StagingPoolParams					m_Params;
+	StagingPoolStats					m_Stats;
+	int64_t								m_Frame = 0;
+
+	std::vector<std::unique_ptr<Block>>	m_Blocks;
+	std::vector<std::deque<Block*>>		m_FreeBlocks;		// one per size class, oldest release first
+	Block*								m_OpenBlock = nullptr;
+	std::vector<Block*>					m_ClosedBlocks;		// copied into but not mapped yet
+};
+
+} // namespace Neshny
@@ -0,0 +1,518 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "TextureAtlas.h"
+
+namespace Neshny {
+
+////////////////////////////////////////////////////////////////////////////////
+void AtlasPacker::Reset(int width, int height, AtlasPackMethod method) {
+	m_Method = method;
+	m_Width = width;
+	m_Height = height;
+	m_UsedArea = 0;
+	m_Skyline.clear();
+	m_FreeRects.clear();
+	if ((width <= 0) || (height <= 0)) {
+		return;
+	}
+	if (method == AtlasPackMethod::SKYLINE) {
+		m_Skyline.push_back(SkylineNode{ 0, 0, width });
+	} else {
+		m_FreeRects.push_back(AtlasRect{ 0, 0, width, height });
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::optional<AtlasRect> AtlasPacker::Insert(int width, int height) {
+	if ((width <= 0) || (height <= 0) || (width > m_Width) || (height > m_Height)) {
+		return std::nullopt;
+	}
+	// skyline looks at the freed space first, so removing and adding sprites of similar sizes does not creep upwards
+	std::optional<AtlasRect> result = InsertFreeList(width, height);
+	if (result) {
+		SplitFreeList(*result);
+	} else if (m_Method == AtlasPackMethod::SKYLINE) {
+		result = InsertSkyline(width, height);
+	}
+	if (result) {
+		m_UsedArea += (int64_t)width * height;
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// a skyline restored this way is only the top of everything occupied, any gaps underneath are lost
+void AtlasPacker::Occupy(const AtlasRect& rect) {
+	if (m_Method == AtlasPackMethod::SKYLINE) {
+		RaiseSkyline(rect);
+	}
+	SplitFreeList(rect);
+	m_UsedArea += (int64_t)rect.p_Width * rect.p_Height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AtlasPacker::Free(const AtlasRect& rect) {
+	m_UsedArea -= (int64_t)rect.p_Width * rect.p_Height;
+	for (const auto& other : m_FreeRects) {
+		if (other.Contains(rect)) {
+			return;
+		}
+	}
+	m_FreeRects.erase(std::remove_if(m_FreeRects.begin(), m_FreeRects.end(), [&rect](const AtlasRect& other) { return rect.Contains(other); }), m_FreeRects.end());
+	m_FreeRects.push_back(rect);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// best short side fit, ties go to the lowest then leftmost so the result never depends on the order of the list
+std::optional<AtlasRect> AtlasPacker::InsertFreeList(int width, int height) const {
+	const AtlasRect* best = nullptr;
+	int best_short = INT_MAX;
+	int best_long = INT_MAX;
+	for (const auto& free_rect : m_FreeRects) {
+		if ((free_rect.p_Width < width) || (free_rect.p_Height < height)) {
+			continue;
+		}
+		int left_x = free_rect.p_Width - width;
+		int left_y = free_rect.p_Height - height;
+		int short_side = std::min(left_x, left_y);
+		int long_side = std::max(left_x, left_y);
+		bool better = (short_side < best_short) || ((short_side == best_short) && (long_side < best_long));
+		if (!better && best && (short_side == best_short) && (long_side == best_long)) {
+			better = (free_rect.p_Y < best->p_Y) || ((free_rect.p_Y == best->p_Y) && (free_rect.p_X < best->p_X));
+		}
+		if (better) {
+			best = &free_rect;
+			best_short = short_side;
+			best_long = long_side;
+		}
+	}
+	if (!best) {
+		return std::nullopt;
+	}
+	return AtlasRect{ best->p_X, best->p_Y, width, height };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// every free rectangle the used one overlaps is cut into the up to four parts around it
+// then only the new parts need checking against the rest for any that are inside another
+void AtlasPacker::SplitFreeList(const AtlasRect& used) {
+	std::vector<AtlasRect> new_rects;
+	int write = 0;
+	for (int i = 0; i < (int)m_FreeRects.size(); i++) {
+		const AtlasRect free_rect = m_FreeRects[i];
+		if (!free_rect.Overlaps(used)) {
+			m_FreeRects[write++] = free_rect;
+			continue;
+		}
+		if (used.p_X > free_rect.p_X) {
+			new_rects.push_back(AtlasRect{ free_rect.p_X, free_rect.p_Y, used.p_X - free_rect.p_X, free_rect.p_Height });
+		}
+		if (used.p_X + used.p_Width < free_rect.p_X + free_rect.p_Width) {
+			new_rects.push_back(AtlasRect{ used.p_X + used.p_Width, free_rect.p_Y, free_rect.p_X + free_rect.p_Width - used.p_X - used.p_Width, free_rect.p_Height });
+		}
+		if (used.p_Y > free_rect.p_Y) {
+			new_rects.push_back(AtlasRect{ free_rect.p_X, free_rect.p_Y, free_rect.p_Width, used.p_Y - free_rect.p_Y });
+		}
+		if (used.p_Y + used.p_Height < free_rect.p_Y + free_rect.p_Height) {
+			new_rects.push_back(AtlasRect{ free_rect.p_X, used.p_Y + used.p_Height, free_rect.p_Width, free_rect.p_Y + free_rect.p_Height - used.p_Y - used.p_Height });
+		}
+	}
+	m_FreeRects.resize(write);
+
+	std::vector<bool> dropped(new_rects.size(), false);
+	for (int i = 0; i < (int)new_rects.size(); i++) {
+		for (int j = 0; (j < (int)new_rects.size()) && !dropped[i]; j++) {
+			// of two the same only the first is kept
+			if ((i != j) && !dropped[j] && new_rects[j].Contains(new_rects[i]) && ((j < i) || !(new_rects[j] == new_rects[i]))) {
+				dropped[i] = true;
+			}
+		}
+		for (int j = 0; (j < (int)m_FreeRects.size()) && !dropped[i]; j++) {
+			if (m_FreeRects[j].Contains(new_rects[i])) {
+				dropped[i] = true;
+			}
+		}
+	}
+	if (new_rects.empty()) {
+		return;
+	}
+	m_FreeRects.erase(std::remove_if(m_FreeRects.begin(), m_FreeRects.end(), [&](const AtlasRect& free_rect) {
+		for (int i = 0; i < (int)new_rects.size(); i++) {
+			if (!dropped[i] && new_rects[i].Contains(free_rect)) {
+				return true;
+			}
+		}
+		return false;
+	}), m_FreeRects.end());
+	for (int i = 0; i < (int)new_rects.size(); i++) {
+		if (!dropped[i]) {
+			m_FreeRects.push_back(new_rects[i]);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// how high a rectangle has to sit to clear every node it spans, starting at the given node
+bool AtlasPacker::SkylineFits(int index, int width, int height, int& y) const {
+	if (m_Skyline[index].p_X + width > m_Width) {
+		return false;
+	}
+	y = m_Skyline[index].p_Y;
+	int remaining = width;
+	for (int i = index; remaining > 0; i++) {
+		y = std::max(y, m_Skyline[i].p_Y);
+		if (y + height > m_Height) {
+			return false;
+		}
+		remaining -= m_Skyline[i].p_Width;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// bottom left, the placement whose top ends up lowest wins, then the one on the narrowest node
+std::optional<AtlasRect> AtlasPacker::InsertSkyline(int width, int height) {
+	int best_index = -1;
+	int best_top = INT_MAX;
+	int best_width = INT_MAX;
+	int best_y = 0;
+	for (int i = 0; i < (int)m_Skyline.size(); i++) {
+		int y;
+		if (SkylineFits(i, width, height, y)) {
+			int top = y + height;
+			if ((top < best_top) || ((top == best_top) && (m_Skyline[i].p_Width < best_width))) {
+				best_index = i;
+				best_top = top;
+				best_width = m_Skyline[i].p_Width;
+				best_y = y;
+			}
+		}
+	}
+	if (best_index < 0) {
+		return std::nullopt;
+	}
+	AtlasRect rect{ m_Skyline[best_index].p_X, best_y, width, height };
+	RaiseSkyline(rect);
+	return rect;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// everything under the rectangle's span rises to at least its top, then neighbours at the same height are joined
+void AtlasPacker::RaiseSkyline(const AtlasRect& rect) {
+	const int start = rect.p_X;
+	const int end = rect.p_X + rect.p_Width;
+	const int top = rect.p_Y + rect.p_Height;
+	std::vector<SkylineNode> raised;
+	raised.reserve(m_Skyline.size() + 2);
+	auto append = [&raised](int x, int y, int width) {
+		if (width <= 0) {
+			return;
+		}
+		if (!raised.empty() && (raised.back().p_Y == y)) {
+			raised.back().p_Width += width;
+		} else {
+			raised.push_back(SkylineNode{ x, y, width });
+		}
+	};
+	for (const auto& node : m_Skyline) {
+		const int node_end = node.p_X + node.p_Width;
+		if ((node_end <= start) || (node.p_X >= end)) {
+			append(node.p_X, node.p_Y, node.p_Width);
+			continue;
+		}
+		append(node.p_X, node.p_Y, start - node.p_X);
+		const int inside_start = std::max(node.p_X, start);
+		const int inside_end = std::min(node_end, end);
+		append(inside_start, std::max(node.p_Y, top), inside_end - inside_start);
+		append(end, node.p_Y, node_end - end);
+	}
+	m_Skyline.swap(raised);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::Clear(void) {
+	m_Pages.clear();
+	m_PagePixels.clear();
+	m_Sprites.clear();
+	m_Names.clear();
+	m_NameLookup.clear();
+	m_FreeHandles.clear();
+	m_Count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::AddPage(void) {
+	m_Pages.emplace_back(m_Params.p_PageWidth, m_Params.p_PageHeight, m_Params.p_Method);
+	m_PagePixels.emplace_back();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int TextureAtlas::NewHandle(void) {
+	if (!m_FreeHandles.empty()) {
+		int handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		return handle;
+	}
+	m_Sprites.emplace_back();
+	m_Names.emplace_back();
+	return (int)m_Sprites.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::SetSprite(int handle, int page, const AtlasRect& padded) {
+	const int pad = m_Params.p_Padding;
+	AtlasSprite& sprite = m_Sprites[handle];
+	sprite.p_Page = page;
+	sprite.p_Rect = AtlasRect{ padded.p_X + pad, padded.p_Y + pad, padded.p_Width - pad * 2, padded.p_Height - pad * 2 };
+	const float inv_width = 1.0f / m_Params.p_PageWidth;
+	const float inv_height = 1.0f / m_Params.p_PageHeight;
+	sprite.p_UV = fVec4(sprite.p_Rect.p_X * inv_width, sprite.p_Rect.p_Y * inv_height, (sprite.p_Rect.p_X + sprite.p_Rect.p_Width) * inv_width, (sprite.p_Rect.p_Y + sprite.p_Rect.p_Height) * inv_height);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int TextureAtlas::Add(std::string_view name, int width, int height) {
+	if ((width <= 0) || (height <= 0) || m_NameLookup.contains(std::string(name))) {
+		return -1;
+	}
+	const int padded_width = width + m_Params.p_Padding * 2;
+	const int padded_height = height + m_Params.p_Padding * 2;
+	std::optional<AtlasRect> rect;
+	int page = 0;
+	for (; (page < (int)m_Pages.size()) && !rect; page++) {
+		rect = m_Pages[page].Insert(padded_width, padded_height);
+	}
+	if (!rect && ((int)m_Pages.size() < m_Params.p_MaxPages)) {
+		AddPage();
+		rect = m_Pages.back().Insert(padded_width, padded_height);
+		page = (int)m_Pages.size();
+	}
+	if (!rect) {
+		return -1;
+	}
+	int handle = NewHandle();
+	SetSprite(handle, page - 1, *rect);
+	m_Names[handle] = std::string(name);
+	m_NameLookup[m_Names[handle]] = handle;
+	m_Count++;
+	return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TextureAtlas::Remove(int handle) {
+	if (!IsValid(handle)) {
+		return false;
+	}
+	AtlasSprite& sprite = m_Sprites[handle];
+	const int pad = m_Params.p_Padding;
+	AtlasRect padded{ sprite.p_Rect.p_X - pad, sprite.p_Rect.p_Y - pad, sprite.p_Rect.p_Width + pad * 2, sprite.p_Rect.p_Height + pad * 2 };
+	m_Pages[sprite.p_Page].Free(padded);
+	// whatever goes here next expects clear padding around it
+	auto& pixels = m_PagePixels[sprite.p_Page];
+	if (!pixels.empty()) {
+		for (int y = padded.p_Y; y < padded.p_Y + padded.p_Height; y++) {
+			memset(pixels.data() + ((size_t)y * m_Params.p_PageWidth + padded.p_X) * ATLAS_BYTES_PER_PIXEL, 0, (size_t)padded.p_Width * ATLAS_BYTES_PER_PIXEL);
+		}
+	}
+	sprite = AtlasSprite{};
+	m_NameLookup.erase(m_Names[handle]);
+	m_Names[handle].clear();
+	m_FreeHandles.push_back(handle);
+	m_Count--;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int TextureAtlas::Find(std::string_view name) const {
+	auto found = m_NameLookup.find(std::string(name));
+	return found == m_NameLookup.end() ? -1 : found->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TextureAtlas::Build(const std::vector<AtlasInput>& inputs, std::string& err) {
+
+	Clear();
+	const int count = (int)inputs.size();
+	m_Sprites.resize(count);
+	m_Names.resize(count);
+	for (int i = 0; i < count; i++) {
+		if ((inputs[i].p_Width <= 0) || (inputs[i].p_Height <= 0)) {
+			err = std::format("Sprite {} has no size", inputs[i].p_Name);
+			Clear();
+			return false;
+		}
+		if (!m_NameLookup.insert({ inputs[i].p_Name, i }).second) {
+			err = std::format("Sprite {} is in the atlas twice", inputs[i].p_Name);
+			Clear();
+			return false;
+		}
+		m_Names[i] = inputs[i].p_Name;
+	}
+
+	// biggest first packs tightest, names break ties so the input order never matters
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&inputs](int a, int b) {
+		const AtlasInput& in_a = inputs[a];
+		const AtlasInput& in_b = inputs[b];
+		int side_a = std::max(in_a.p_Width, in_a.p_Height);
+		int side_b = std::max(in_b.p_Width, in_b.p_Height);
+		if (side_a != side_b) {
+			return side_a > side_b;
+		}
+		if (in_a.p_Height != in_b.p_Height) {
+			return in_a.p_Height > in_b.p_Height;
+		}
+		if (in_a.p_Width != in_b.p_Width) {
+			return in_a.p_Width > in_b.p_Width;
+		}
+		return in_a.p_Name < in_b.p_Name;
+	});
+
+	const int padded_extra = m_Params.p_Padding * 2;
+	for (int index : order) {
+		const int padded_width = inputs[index].p_Width + padded_extra;
+		const int padded_height = inputs[index].p_Height + padded_extra;
+		std::optional<AtlasRect> rect;
+		int page = 0;
+		for (; (page < (int)m_Pages.size()) && !rect; page++) {
+			rect = m_Pages[page].Insert(padded_width, padded_height);
+		}
+		if (!rect && ((int)m_Pages.size() < m_Params.p_MaxPages)) {
+			AddPage();
+			rect = m_Pages.back().Insert(padded_width, padded_height);
+			page = (int)m_Pages.size();
+		}
+		if (!rect) {
+			err = std::format("Sprite {} does not fit in {} pages of {}x{}", inputs[index].p_Name, m_Params.p_MaxPages, m_Params.p_PageWidth, m_Params.p_PageHeight);
+			Clear();
+			return false;
+		}
+		SetSprite(index, page - 1, *rect);
+		m_Count++;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t TextureAtlas::HashInputs(const std::vector<AtlasInput>& inputs) const {
+	StreamingHasher hasher;
+	hasher.UpdateValue(ATLAS_CACHE_VERSION);
+	hasher.UpdateValue(m_Params.p_PageWidth);
+	hasher.UpdateValue(m_Params.p_PageHeight);
+	hasher.UpdateValue(m_Params.p_MaxPages);
+	hasher.UpdateValue(m_Params.p_Padding);
+	hasher.UpdateValue(m_Params.p_Method);
+	hasher.UpdateValue((uint64_t)inputs.size());
+	for (const auto& input : inputs) {
+		hasher.UpdateValue((uint64_t)input.p_Name.size());
+		hasher.Update(input.p_Name);
+		hasher.UpdateValue(input.p_Width);
+		hasher.UpdateValue(input.p_Height);
+	}
+	return hasher.Digest64();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// false if the cache does not describe a valid layout of these inputs, in which case it is packed again
+bool TextureAtlas::ApplyLayout(const std::vector<AtlasInput>& inputs, const AtlasLayoutCache& cache) {
+
+	Clear();
+	const int count = (int)inputs.size();
+	if ((cache.p_Pages.size() != inputs.size()) || (cache.p_X.size() != inputs.size()) || (cache.p_Y.size() != inputs.size())) {
+		return false;
+	}
+	m_Sprites.resize(count);
+	m_Names.resize(count);
+	const int padded_extra = m_Params.p_Padding * 2;
+	for (int i = 0; i < count; i++) {
+		const int page = cache.p_Pages[i];
+		AtlasRect rect{ cache.p_X[i], cache.p_Y[i], inputs[i].p_Width + padded_extra, inputs[i].p_Height + padded_extra };
+		if ((page < 0) || (page >= m_Params.p_MaxPages) || (rect.p_X < 0) || (rect.p_Y < 0) || (rect.p_X + rect.p_Width > m_Params.p_PageWidth) || (rect.p_Y + rect.p_Height > m_Params.p_PageHeight)) {
+			Clear();
+			return false;
+		}
+		while ((int)m_Pages.size() <= page) {
+			AddPage();
+		}
+		m_Pages[page].Occupy(rect);
+		SetSprite(i, page, rect);
+		m_Names[i] = inputs[i].p_Name;
+		m_NameLookup[inputs[i].p_Name] = i;
+		m_Count++;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TextureAtlas::BuildCached(const std::vector<AtlasInput>& inputs, std::string_view cache_path, std::string& err, bool* from_cache) {
+
+	const uint64_t hash = HashInputs(inputs);
+	AtlasLayoutCache cache;
+	bool cached = Core::LoadBinary(cache, cache_path) && (cache.p_Version == ATLAS_CACHE_VERSION) && (cache.p_InputHash == hash) && ApplyLayout(inputs, cache);
+	if (from_cache) {
+		*from_cache = cached;
+	}
+	if (cached) {
+		return true;
+	}
+	if (!Build(inputs, err)) {
+		return false;
+	}
+
+	cache = AtlasLayoutCache{ ATLAS_CACHE_VERSION, hash };
+	for (const auto& sprite : m_Sprites) {
+		cache.p_Pages.push_back(sprite.p_Page);
+		cache.p_X.push_back(sprite.p_Rect.p_X - m_Params.p_Padding);
+		cache.p_Y.push_back(sprite.p_Rect.p_Y - m_Params.p_Padding);
+	}
+	// not being able to write the cache only costs a pack next time
+	Core::SaveBinary(cache, cache_path);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<AtlasUV> TextureAtlas::GetUVTable(void) const {
+	std::vector<AtlasUV> table(m_Sprites.size());
+	for (int i = 0; i < (int)m_Sprites.size(); i++) {
+		table[i].p_UV = m_Sprites[i].p_UV;
+		table[i].p_Page = m_Sprites[i].p_Page;
+	}
+	return table;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::Blit(int handle, const unsigned char* pixels, int pitch) {
+	if (!IsValid(handle)) {
+		return;
+	}
+	const AtlasSprite& sprite = m_Sprites[handle];
+	auto& page = m_PagePixels[sprite.p_Page];
+	if (page.empty()) {
+		page.resize((size_t)m_Params.p_PageWidth * m_Params.p_PageHeight * ATLAS_BYTES_PER_PIXEL, 0);
+	}
+	const size_t page_pitch = (size_t)m_Params.p_PageWidth * ATLAS_BYTES_PER_PIXEL;
+	const AtlasRect& rect = sprite.p_Rect;
+	const size_t row_bytes = (size_t)rect.p_Width * ATLAS_BYTES_PER_PIXEL;
+	auto pixel_at = [&](int x, int y) { return page.data() + (size_t)y * page_pitch + (size_t)x * ATLAS_BYTES_PER_PIXEL; };
+
+	for (int y = 0; y < rect.p_Height; y++) {
+		memcpy(pixel_at(rect.p_X, rect.p_Y + y), pixels + (size_t)y * pitch, row_bytes);
+	}
+	// the edge rows are copied up and down first, then the edge columns out sideways, which fills the corners too
+	const int bleed = std::clamp(m_Params.p_Bleed, 0, m_Params.p_Padding);
+	for (int b = 1; b <= bleed; b++) {
+		memcpy(pixel_at(rect.p_X, rect.p_Y - b), pixel_at(rect.p_X, rect.p_Y), row_bytes);
+		memcpy(pixel_at(rect.p_X, rect.p_Y + rect.p_Height - 1 + b), pixel_at(rect.p_X, rect.p_Y + rect.p_Height - 1), row_bytes);
+	}
+	for (int y = rect.p_Y - bleed; y < rect.p_Y + rect.p_Height + bleed; y++) {
+		for (int b = 1; b <= bleed; b++) {
+			memcpy(pixel_at(rect.p_X - b, y), pixel_at(rect.p_X, y), ATLAS_BYTES_PER_PIXEL);
+			memcpy(pixel_at(rect.p_X + rect.p_Width - 1 + b, y), pixel_at(rect.p_X + rect.p_Width - 1, y), ATLAS_BYTES_PER_PIXEL);
+		}
+	}
+}
+
+} // namespace Neshny
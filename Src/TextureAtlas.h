@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace Neshny {
+
+// bumped whenever packing changes, so layouts cached by an older version are packed again
+constexpr int ATLAS_CACHE_VERSION = 1;
+constexpr int ATLAS_BYTES_PER_PIXEL = 4;
+
+////////////////////////////////////////////////////////////////////////////////
+enum class AtlasPackMethod {
+	SKYLINE,		// fastest, leaves gaps under tall neighbours
+	MAX_RECTS		// packs tighter, a little slower as the free list grows
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct AtlasRect {
+	inline bool		operator==		( const AtlasRect& other ) const { return (p_X == other.p_X) && (p_Y == other.p_Y) && (p_Width == other.p_Width) && (p_Height == other.p_Height); }
+	inline bool		Contains		( const AtlasRect& other ) const { return (other.p_X >= p_X) && (other.p_Y >= p_Y) && (other.p_X + other.p_Width <= p_X + p_Width) && (other.p_Y + other.p_Height <= p_Y + p_Height); }
+	inline bool		Overlaps		( const AtlasRect& other ) const { return (other.p_X < p_X + p_Width) && (p_X < other.p_X + other.p_Width) && (other.p_Y < p_Y + p_Height) && (p_Y < other.p_Y + other.p_Height); }
+
+	int		p_X = 0;
+	int		p_Y = 0;
+	int		p_Width = 0;
+	int		p_Height = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// places rectangles on one page, only integers are involved so the same sequence of calls always gives the same layout
+// freed space is reused by later inserts, skyline keeps it apart from the skyline and max rects puts it back on its free list
+////////////////////////////////////////////////////////////////////////////////
+class AtlasPacker {
+public:
+							AtlasPacker			( int width = 0, int height = 0, AtlasPackMethod method = AtlasPackMethod::MAX_RECTS ) { Reset(width, height, method); }
+
+	void					Reset				( int width, int height, AtlasPackMethod method );
+	std::optional<AtlasRect>	Insert			( int width, int height );
+	// marks a rectangle as taken without searching for it, for restoring a layout
+	void					Occupy				( const AtlasRect& rect );
+	void					Free				( const AtlasRect& rect );
+
+	inline int				GetWidth			( void ) const { return m_Width; }
+	inline int				GetHeight			( void ) const { return m_Height; }
+	inline int64_t			GetUsedArea			( void ) const { return m_UsedArea; }
+	inline double			GetOccupancy		( void ) const { return (m_Width > 0) && (m_Height > 0) ? (double)m_UsedArea / ((double)m_Width * m_Height) : 0.0; }
+
+private:
+
+	struct SkylineNode {
+		int		p_X;
+		int		p_Y;
+		int		p_Width;
+	};
+
+	std::optional<AtlasRect>	InsertSkyline	( int width, int height );
+	bool					SkylineFits			( int index, int width, int height, int& y ) const;
+	void					RaiseSkyline		( const AtlasRect& rect );
+	std::optional<AtlasRect>	InsertFreeList	( int width, int height ) const;
+	void					SplitFreeList		( const AtlasRect& used );
+
+	AtlasPackMethod				m_Method = AtlasPackMethod::MAX_RECTS;
+	int							m_Width = 0;
+	int							m_Height = 0;
+	int64_t						m_UsedArea = 0;
+	std::vector<SkylineNode>	m_Skyline;
+	std::vector<AtlasRect>		m_FreeRects;		// every free rectangle for max rects, only freed ones for skyline
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct AtlasParams {
+	int					p_PageWidth = 2048;
+	int					p_PageHeight = 2048;
+	int					p_MaxPages = 1;
+	int					p_Padding = 1;			// kept clear on every side of a sprite
+	int					p_Bleed = 1;			// how much of the padding gets a copy of the sprite's edge, so filtering never reaches a neighbour
+	AtlasPackMethod		p_Method = AtlasPackMethod::MAX_RECTS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct AtlasInput {
+	std::string		p_Name;
+	int				p_Width;
+	int				p_Height;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct AtlasSprite {
+	int				p_Page = -1;			// -1 when the handle is not in use
+	AtlasRect		p_Rect;					// in pixels, without padding
+	fVec4			p_UV;					// min u, min v, max u, max v
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// an entry per handle, to upload as is so shaders can look up a sprite's place on the texture array
+struct AtlasUV {
+	fVec4			p_UV;
+	int				p_Page;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// the layout saved by BuildCached, only valid for the exact inputs and params it was packed from
+struct AtlasLayoutCache {
+	int						p_Version = 0;
+	uint64_t				p_InputHash = 0;
+	std::vector<int>		p_Pages;
+	std::vector<int>		p_X;
+	std::vector<int>		p_Y;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// packs many small images into a few large pages of the same size, to be uploaded as one texture array
+// instead of a texture per file, so sprites can be drawn without a bind for each
+// Build packs a whole set from scratch, biggest first, and the handle of each sprite is its index in the inputs
+// Add and Remove change a built atlas without moving anything already there
+////////////////////////////////////////////////////////////////////////////////
+class TextureAtlas {
+public:
+								TextureAtlas		( AtlasParams params = {} ) : m_Params(params) {}
+
+	// the order inputs are packed in only depends on their sizes and names, so shuffling them gives the same layout
+	bool						Build				( const std::vector<AtlasInput>& inputs, std::string& err );
+	// reuses the layout saved at cache_path when it was packed from the same inputs and params, otherwise builds and saves it there
+	bool						BuildCached			( const std::vector<AtlasInput>& inputs, std::string_view cache_path, std::string& err, bool* from_cache = nullptr );
+	uint64_t					HashInputs			( const std::vector<AtlasInput>& inputs ) const;
+
+	// -1 when there is no room left on any page
+	int							Add					( std::string_view name, int width, int height );
+	bool						Remove				( int handle );
+	void						Clear				( void );
+
+	inline bool					IsValid				( int handle ) const { return (handle >= 0) && (handle < (int)m_Sprites.size()) && (m_Sprites[handle].p_Page >= 0); }
+	inline const AtlasSprite&	Get					( int handle ) const { return m_Sprites[handle]; }
+	int							Find				( std::string_view name ) const;
+	inline int					GetSpriteCount		( void ) const { return m_Count; }
+	inline int					GetPageCount		( void ) const { return (int)m_Pages.size(); }
+	inline double				GetOccupancy		( int page ) const { return m_Pages[page].GetOccupancy(); }
+	inline const AtlasParams&	GetParams			( void ) const { return m_Params; }
+	std::vector<AtlasUV>		GetUVTable			( void ) const;
+
+	// copies a sprite's pixels, 4 bytes each, into its page and extrudes its edges into the bleed
+	void						Blit				( int handle, const unsigned char* pixels, int pitch );
+	// empty until something is blitted onto the page, rows are p_PageWidth * 4 bytes
+	inline const std::vector<unsigned char>&	GetPagePixels	( int page ) const { return m_PagePixels[page]; }
+
+private:
+
+	void						SetSprite			( int handle, int page, const AtlasRect& padded );
+	int							NewHandle			( void );
+	bool						ApplyLayout			( const std::vector<AtlasInput>& inputs, const AtlasLayoutCache& cache );
+	void						AddPage				( void );
+
+	AtlasParams					m_Params;
+	std::vector<AtlasPacker>	m_Pages;
+	std::vector<std::vector<unsigned char>>	m_PagePixels;
+	std::vector<AtlasSprite>	m_Sprites;			// by handle
+	std::vector<std::string>	m_Names;
+	std::unordered_map<std::string, int>	m_NameLookup;
+	std::vector<int>			m_FreeHandles;
+	int							m_Count = 0;
+};
+
+} // namespace Neshny
+
+namespace meta {
+	template<> inline auto registerMembers<Neshny::AtlasLayoutCache>() {
+		return members(
+			member("Version", &Neshny::AtlasLayoutCache::p_Version)
+			,member("InputHash", &Neshny::AtlasLayoutCache::p_InputHash)
+			,member("Pages", &Neshny::AtlasLayoutCache::p_Pages)
+			,member("X", &Neshny::AtlasLayoutCache::p_X)
+			,member("Y", &Neshny::AtlasLayoutCache::p_Y)
+		);
+	}
+}
@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_AllocationTrackerTags(void) {
+
+		using Tracker = Neshny::AllocationTracker;
+		int tag_a = Tracker::RegisterTag("TrackerTestA");
+		int tag_b = Tracker::RegisterTag("TrackerTestB");
+		Expect("Tags are found again by name", (tag_a > 0) && (tag_b > 0) && (tag_a != tag_b) && (Tracker::RegisterTag("TrackerTestA") == tag_a));
+
+		// everything allocated is made before the scopes, so only the tracked blocks are charged to the tags
+		std::vector<void*> small_blocks;
+		std::vector<void*> big_blocks;
+		small_blocks.reserve(1000);
+		big_blocks.reserve(10);
+		auto before = Tracker::GetSnapshot();
+		{
+			Tracker::Scope scope(tag_a);
+			for (int i = 0; i < 1000; i++) {
+				small_blocks.push_back(Tracker::Allocate(1000, 16));
+			}
+			{
+				Tracker::Scope inner(tag_b);
+				for (int i = 0; i < 10; i++) {
+					big_blocks.push_back(Tracker::Allocate(100000, 16));
+				}
+			}
+			ExpectEqual("Scopes put back the tag they replaced", Tracker::GetCurrentTag(), tag_a);
+		}
+		ExpectEqual("Leaving every scope goes back to untagged", Tracker::GetCurrentTag(), 0);
+
+		auto during = Tracker::Diff(before, Tracker::GetSnapshot());
+		ExpectEqual("Live bytes are charged to the scope's tag", during.p_Tags[tag_a].p_LiveBytes, (int64_t)1000 * 1000);
+		ExpectEqual("Nested scopes charge their own tag", during.p_Tags[tag_b].p_LiveBytes, (int64_t)10 * 100000);
+		Expect("Allocations are counted per tag", (during.p_Tags[tag_a].p_LiveAllocations == 1000) && (during.p_Tags[tag_b].p_Allocations == 10));
+		Expect("Names come with the snapshot", (during.p_Tags[tag_a].p_Name == "TrackerTestA") && (during.p_Tags[0].p_Name == "Untagged"));
+
+		// frees on other threads go to the tag the block was allocated under, and the thread's counts outlive it
+		std::thread freeing([&small_blocks]() {
+			for (int i = 0; i < 500; i++) {
+				Tracker::Free(small_blocks[i]);
+			}
+		});
+		freeing.join();
+		auto after_free = Tracker::Diff(before, Tracker::GetSnapshot());
+		ExpectEqual("Frees on another thread are charged to the allocating tag", after_free.p_Tags[tag_a].p_LiveBytes, (int64_t)500 * 1000);
+		Expect("Peaks are kept after frees", after_free.p_Tags[tag_a].p_PeakBytes >= (int64_t)1000 * 1000 - Tracker::PEAK_FLUSH_BYTES);
+
+		for (int i = 500; i < 1000; i++) {
+			Tracker::Free(small_blocks[i]);
+		}
+		for (void* block : big_blocks) {
+			Tracker::Free(block);
+		}
+		auto after = Tracker::Diff(before, Tracker::GetSnapshot());
+		Expect("Nothing left live once all is freed", (after.p_Tags[tag_a].p_LiveBytes == 0) && (after.p_Tags[tag_b].p_LiveBytes == 0) && (after.p_Tags[tag_a].p_LiveAllocations == 0));
+		Tracker::ResetPeaks();
+		ExpectEqual("Peaks reset to what is live", Tracker::GetSnapshot().p_Tags[tag_b].p_PeakBytes, (int64_t)0);
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 300; t++) {
+			threads.emplace_back([tag_a]() {
+				Tracker::Scope scope(tag_a);
+				void* block = Tracker::Allocate(64, 16);
+				Tracker::Free(Tracker::Allocate(32, 16));
+				Tracker::Free(block);
+			});
+			if (threads.size() >= 8) {
+				for (auto& thread : threads) {
+					thread.join();
+				}
+				threads.clear();
+			}
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		auto churned = Tracker::Diff(before, Tracker::GetSnapshot());
+		Expect("Counts survive more threads coming and going than there are slots", (churned.p_Tags[tag_a].p_Allocations == 1000 + 600) && (churned.p_Tags[tag_a].p_LiveBytes == 0));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_AllocationTrackerSamples(void) {
+
+		using Tracker = Neshny::AllocationTracker;
+		int tag = Tracker::RegisterTag("TrackerTestSampled");
+		std::vector<void*> blocks;
+		blocks.reserve(200);
+
+		Tracker::SetSampleInterval(10000);
+		{
+			Tracker::Scope scope(tag);
+			for (int i = 0; i < 200; i++) {
+				blocks.push_back(Tracker::Allocate(1000, 16));
+			}
+		}
+		auto samples = Tracker::GetLiveSamples(tag);
+		Expect(std::format("About one allocation in every interval is sampled ({})", samples.size()), (samples.size() >= 15) && (samples.size() <= 25));
+		Expect("Samples are of the tag asked for", std::all_of(samples.begin(), samples.end(), [tag](const Neshny::MemorySample& sample) { return (sample.p_Tag == tag) && (sample.p_Size == 1000); }));
+#if defined(__GLIBC__) || defined(__APPLE__)
+		Expect("Samples have a call stack", !samples.empty() && !samples[0].p_Frames.empty() && !Tracker::DescribeFrames(samples[0].p_Frames).empty());
+#endif
+		Expect("Samples are oldest first", std::is_sorted(samples.begin(), samples.end(), [](const Neshny::MemorySample& a, const Neshny::MemorySample& b) { return a.p_Sequence < b.p_Sequence; }));
+
+		for (void* block : blocks) {
+			Tracker::Free(block);
+		}
+		Expect("Freed allocations are no longer live samples", Tracker::GetLiveSamples(tag).empty());
+
+		Tracker::SetSampleInterval(0);
+		const size_t live_before = Tracker::GetLiveSamples().size();
+		void* unsampled = Tracker::Allocate(1000000, 16);
+		ExpectEqual("An interval of zero samples nothing", Tracker::GetLiveSamples().size(), live_before);
+		Tracker::Free(unsampled);
+		Tracker::SetSampleInterval(512 * 1024);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_AllocationTrackerAlignment(void) {
+
+		using Tracker = Neshny::AllocationTracker;
+		bool aligned = true;
+		for (size_t alignment : { 1, 8, 16, 32, 64, 256, 4096 }) {
+			for (size_t size : { 0, 1, 7, 100, 5000 }) {
+				unsigned char* block = (unsigned char*)Tracker::Allocate(size, alignment);
+				aligned = aligned && block && ((uintptr_t)block % std::max(alignment, (size_t)16) == 0);
+				memset(block, 0xAB, size);
+				Tracker::Free(block);
+			}
+		}
+		Expect("Blocks have the alignment asked for and at least 16", aligned);
+		Expect("Impossible sizes give nullptr", Tracker::Allocate(std::numeric_limits<size_t>::max() - 8, 16) == nullptr);
+		Tracker::Free(nullptr);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_AllocationTrackerBenchmark(void) {
+
+		using Tracker = Neshny::AllocationTracker;
+		const int batch = 1000;
+		const int batches = 1000;
+		std::vector<void*> blocks(batch);
+		int tag = Tracker::RegisterTag("TrackerTestBenchmark");
+
+		auto time_ns = [&](auto&& alloc, auto&& release) {
+			double best = std::numeric_limits<double>::max();
+			for (int attempt = 0; attempt < 3; attempt++) {
+				auto start = std::chrono::steady_clock::now();
+				for (int b = 0; b < batches; b++) {
+					for (int i = 0; i < batch; i++) {
+						blocks[i] = alloc(16 + (i & 63) * 4);
+					}
+					for (int i = 0; i < batch; i++) {
+						release(blocks[i]);
+					}
+				}
+				best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (batch * batches));
+			}
+			return best;
+		};
+
+		double malloc_ns = time_ns([](size_t size) { return malloc(size); }, [](void* ptr) { free(ptr); });
+		double tracked_ns = time_ns([](size_t size) { return Tracker::Allocate(size, 16); }, [](void* ptr) { Tracker::Free(ptr); });
+		double scoped_ns = time_ns([tag](size_t size) { Tracker::Scope scope(tag); return Tracker::Allocate(size, 16); }, [](void* ptr) { Tracker::Free(ptr); });
+		Tracker::SetSampleInterval(0);
+		double unsampled_ns = time_ns([](size_t size) { return Tracker::Allocate(size, 16); }, [](void* ptr) { Tracker::Free(ptr); });
+		Tracker::SetSampleInterval(512 * 1024);
+
+		Neshny::Core::Log(std::format("An allocation and free takes {:.1f} ns with malloc, {:.1f} ns tracked, {:.1f} ns with a scope each time and {:.1f} ns without sampling", malloc_ns, tracked_ns, scoped_ns, unsampled_ns));
+		auto stats = Tracker::GetSnapshot();
+		Expect("Nothing the benchmark allocated is left live", (stats.p_Tags[tag].p_LiveBytes == 0) && (stats.p_Tags[tag].p_Allocations == (int64_t)batch * batches * 3));
+	}
+
+}
@@ -0,0 +1,292 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// samples are interleaved floats from -1 to 1, stored at whatever depth is asked for
+	std::string WriteTestWav(std::string_view name, int channels, int frequency, int bits, bool is_float, const std::vector<float>& samples, bool extra_chunk = false) {
+
+		std::string data;
+		auto put = [&data](uint32_t value, int bytes) {
+			for (int i = 0; i < bytes; i++) {
+				data.push_back((char)((value >> (i * 8)) & 0xFF));
+			}
+		};
+		for (float sample : samples) {
+			if (is_float) {
+				put(std::bit_cast<uint32_t>(sample), 4);
+			} else if (bits == 8) {
+				put((uint32_t)(int)std::lround(sample * 127.0f + 128.0f), 1);
+			} else {
+				double scale = (double)((1u << (bits - 1)) - 1);
+				put((uint32_t)(int32_t)std::llround(sample * scale), bits / 8);
+			}
+		}
+
+		std::string file = "RIFF";
+		std::string body = "WAVE";
+		auto put_body = [&body](uint32_t value, int bytes) {
+			for (int i = 0; i < bytes; i++) {
+				body.push_back((char)((value >> (i * 8)) & 0xFF));
+			}
+		};
+		if (extra_chunk) {
+			// odd sized, so the padding byte has to be skipped
+			body += "LIST";
+			put_body(3, 4);
+			body += "abc";
+			body.push_back(0);
+		}
+		body += "fmt ";
+		put_body(16, 4);
+		put_body(is_float ? 3 : 1, 2);
+		put_body(channels, 2);
+		put_body(frequency, 4);
+		put_body(frequency * channels * bits / 8, 4);
+		put_body(channels * bits / 8, 2);
+		put_body(bits, 2);
+		body += "data";
+		put_body((uint32_t)data.size(), 4);
+		body += data;
+		for (int i = 0; i < 4; i++) {
+			file.push_back((char)((body.size() >> (i * 8)) & 0xFF));
+		}
+		file += body;
+
+		std::string path = (std::filesystem::temp_directory_path() / std::string(name)).string();
+		std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(file.data(), file.size());
+		return path;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::vector<float> MakeTestTone(int frames, int channels, int frequency, double pitch) {
+		std::vector<float> samples((size_t)frames * channels);
+		for (int i = 0; i < frames; i++) {
+			for (int c = 0; c < channels; c++) {
+				samples[(size_t)i * channels + c] = (float)(0.8 * sin(2.0 * 3.14159265358979 * pitch * (c + 1) * i / frequency));
+			}
+		}
+		return samples;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_WavStreamDecoder(void) {
+
+		const int frames = 10000;
+		auto tone = MakeTestTone(frames, 2, 22050, 440.0);
+		struct Depth { int bits; bool is_float; double tolerance; };
+		for (auto depth : { Depth{ 8, false, 1.0 / 60.0 }, Depth{ 16, false, 1.0 / 16000.0 }, Depth{ 24, false, 1.0 / 4000000.0 }, Depth{ 32, false, 1.0 / 1000000.0 }, Depth{ 32, true, 0.0 } }) {
+			std::string label = std::format("{} bit {}", depth.bits, depth.is_float ? "float" : "int");
+			std::string path = WriteTestWav("neshny_decoder_test.wav", 2, 22050, depth.bits, depth.is_float, tone, depth.bits == 16);
+
+			Neshny::WavStreamDecoder decoder;
+			std::string err;
+			Expect(std::format("{} opens", label), decoder.Open(path, err));
+			ExpectEqual(std::format("{} channels", label), decoder.GetChannels(), 2);
+			ExpectEqual(std::format("{} frequency", label), decoder.GetFrequency(), 22050);
+			ExpectEqual(std::format("{} frame count", label), (int)decoder.GetFormat().GetFrames(), frames);
+
+			// uneven pieces, so they never line up with anything
+			std::vector<float> decoded;
+			std::vector<float> piece(777 * 2);
+			while (true) {
+				int got = decoder.Decode(piece.data(), 777);
+				decoded.insert(decoded.end(), piece.begin(), piece.begin() + got * 2);
+				if (got < 777) {
+					break;
+				}
+			}
+			Expect(std::format("{} decodes every frame", label), decoded.size() == tone.size());
+			double max_error = 0.0;
+			for (size_t i = 0; i < std::min(decoded.size(), tone.size()); i++) {
+				max_error = std::max(max_error, (double)fabs(decoded[i] - tone[i]));
+			}
+			Expect(std::format("{} matches the tone ({} off)", label, max_error), max_error <= depth.tolerance);
+
+			Expect(std::format("{} rewinds", label), decoder.Rewind());
+			ExpectEqual(std::format("{} decodes again after rewinding", label), decoder.Decode(piece.data(), 777), 777);
+			Expect(std::format("{} starts over", label), std::equal(piece.begin(), piece.end(), decoded.begin()));
+			std::filesystem::remove(path);
+		}
+
+		// cut off part way through the sample data
+		std::string path = WriteTestWav("neshny_decoder_cut.wav", 1, 8000, 16, false, MakeTestTone(1000, 1, 8000, 100.0));
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 501);
+		Neshny::WavStreamDecoder cut;
+		std::string err;
+		Expect("Cut file still opens", cut.Open(path, err));
+		std::vector<float> out(2000);
+		ExpectEqual("Cut file ends early on a whole frame", cut.Decode(out.data(), 2000), 749);
+		ExpectEqual("And then stops", cut.Decode(out.data(), 2000), 0);
+		std::filesystem::remove(path);
+
+		{
+			std::ofstream bad(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			bad << "ID3 this is an mp3";
+		}
+		Neshny::WavStreamDecoder not_wav;
+		Expect("Other formats are refused", !not_wav.Open(path, err));
+		std::filesystem::remove(path);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_AudioRing(void) {
+
+		Neshny::AudioRing ring(4, 1000);
+		Expect("Empty ring reads nothing", ring.Read(nullptr, 0) == 0);
+		unsigned char scratch[100];
+		ExpectEqual("Nothing to read yet", ring.Read(scratch, 100), 0);
+		for (int i = 0; i < 4; i++) {
+			Expect("Free block", ring.BeginWrite() != nullptr);
+			ring.EndWrite(10);
+		}
+		Expect("Full after four", ring.BeginWrite() == nullptr);
+		ExpectEqual("Reads across blocks", ring.Read(scratch, 15), 15);
+		ExpectEqual("Only fully read blocks are freed", ring.GetQueuedBlocks(), 3);
+		Expect("So one can be written", ring.BeginWrite() != nullptr);
+
+		// a producer thread writing blocks of varying fill, read back in odd amounts on this thread
+		Neshny::AudioRing stream_ring(4, 256);
+		const int total = 200000;
+		std::thread producer([&stream_ring]() {
+			int value = 0;
+			int block_index = 0;
+			while (value < total) {
+				unsigned char* block = stream_ring.BeginWrite();
+				if (!block) {
+					std::this_thread::yield();
+					continue;
+				}
+				int bytes = std::min(total - value, 1 + (block_index++ * 37) % 256);
+				for (int i = 0; i < bytes; i++) {
+					block[i] = (unsigned char)(value++ & 0xFF);
+				}
+				stream_ring.EndWrite(bytes);
+			}
+		});
+		int read_total = 0;
+		bool in_order = true;
+		unsigned char out[313];
+		while (read_total < total) {
+			int got = stream_ring.Read(out, 1 + read_total % 313);
+			for (int i = 0; i < got; i++) {
+				in_order = in_order && (out[i] == (unsigned char)((read_total + i) & 0xFF));
+			}
+			read_total += got;
+			if (got == 0) {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		Expect("Everything arrives in order", in_order);
+		ExpectEqual("Nothing more", stream_ring.Read(out, 313), 0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_VoiceAllocator(void) {
+
+		Neshny::VoiceAllocator voices;
+		voices.SetCount(3);
+		bool stolen = true;
+		ExpectEqual("First free voice", voices.Allocate(5, &stolen), 0);
+		Expect("Free voice is not stolen", !stolen);
+		ExpectEqual("Next free voice", voices.Allocate(1), 1);
+		ExpectEqual("Last free voice", voices.Allocate(1), 2);
+		ExpectEqual("All busy", voices.GetActiveCount(), 3);
+
+		ExpectEqual("Lower priority is dropped", voices.Allocate(0, &stolen), -1);
+		ExpectEqual("Equal priority steals the oldest of the lowest", voices.Allocate(1, &stolen), 1);
+		Expect("Which counts as stolen", stolen);
+		ExpectEqual("Then the next oldest", voices.Allocate(1), 2);
+		ExpectEqual("Higher priority takes the lowest", voices.Allocate(3), 1);
+		ExpectEqual("Nothing steals from the top", voices.Allocate(4), 2);
+		ExpectEqual("Except something higher still", voices.Allocate(9), 1);
+
+		voices.Release(0);
+		ExpectEqual("Released voices are used before stealing", voices.Allocate(-10, &stolen), 0);
+		Expect("Without stealing", !stolen);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// plays through SDL's dummy driver, which mixes in real time without any sound hardware
+	void UnitTest_SoundMixerDummyDriver(void) {
+#ifdef SDL_h_
+		int frequency = 0;
+		int channels = 0;
+		Uint16 format = 0;
+		bool opened_here = false;
+		if (!Mix_QuerySpec(&frequency, &format, &channels)) {
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+			Expect("Dummy audio starts", SDL_InitSubSystem(SDL_INIT_AUDIO) == 0);
+			Expect("Mixer opens", Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) == 0);
+			Mix_QuerySpec(&frequency, &format, &channels);
+			opened_here = true;
+		}
+		const int previous_channels = Mix_AllocateChannels(-1);
+		const uint64_t bytes_per_second = (uint64_t)frequency * channels * (SDL_AUDIO_BITSIZE(format) / 8);
+
+		std::string music_path = WriteTestWav("neshny_mixer_music.wav", 2, 22050, 16, false, MakeTestTone(22050, 2, 22050, 220.0));
+		std::string effect_path = WriteTestWav("neshny_mixer_effect.wav", 1, 44100, 16, false, MakeTestTone(4410, 1, 44100, 880.0));
+		std::string err;
+
+		Neshny::StreamingSoundFile music;
+		Expect("Streaming sound loads", music.Init(music_path, {}, err));
+		Expect("Streaming sound only costs its header", music.GetMemoryEstimate() < 4096);
+		Expect("Streaming sound knows its length", fabs(music.GetDuration() - 1.0) < 0.001);
+		Neshny::SoundFile effect;
+		Expect("Effect loads", effect.Init(effect_path, {}, err));
+
+		Neshny::SoundMixer mixer;
+		Expect("Sound mixer starts", mixer.Init(4, err));
+
+		int music_voice = mixer.PlayStream(music, false, 10);
+		Expect("Stream gets a voice", music_voice >= 0);
+		for (int i = 0; i < 5; i++) {
+			Expect("Effect gets a voice", mixer.PlayEffect(effect) >= 0);
+		}
+		auto stats = mixer.GetStats();
+		ExpectEqual("Voices are limited", stats.p_ActiveVoices, 4);
+		ExpectEqual("Two effects were cut off", (int)stats.p_Stolen, 2);
+		Expect("Low priority effect is dropped", mixer.PlayEffect(effect, -1) < 0);
+		ExpectEqual("And counted", (int)mixer.GetStats().p_Dropped, 1);
+
+		// the stream frees its own voice once it has played out
+		auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::seconds(4)) {
+			mixer.Update();
+			if (mixer.GetStats().p_ActiveStreams == 0) {
+				break;
+			}
+			SDL_Delay(10);
+		}
+		stats = mixer.GetStats();
+		ExpectEqual("Stream finishes", stats.p_ActiveStreams, 0);
+		Expect(std::format("All of the stream was played ({} of {} bytes, {} underruns)", stats.p_StreamedBytes, bytes_per_second, stats.p_Underruns), stats.p_StreamedBytes >= bytes_per_second * 99 / 100);
+
+		const uint64_t streamed_before = stats.p_StreamedBytes;
+		int loop_voice = mixer.PlayStream(music, true);
+		Expect("Looping stream gets a voice", loop_voice >= 0);
+		start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1500)) {
+			mixer.Update();
+			SDL_Delay(10);
+		}
+		stats = mixer.GetStats();
+		ExpectEqual("Looping stream keeps going", stats.p_ActiveStreams, 1);
+		Expect("Looping stream played past its end", stats.p_StreamedBytes - streamed_before > bytes_per_second * 6 / 5);
+		mixer.Stop(loop_voice);
+		ExpectEqual("Stopped stream is gone", mixer.GetStats().p_ActiveStreams, 0);
+
+		mixer.Shutdown();
+		Mix_AllocateChannels(previous_channels);
+		if (opened_here) {
+			Mix_CloseAudio();
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		}
+		std::filesystem::remove(music_path);
+		std::filesystem::remove(effect_path);
+#endif
+	}
+
+}
@@ -0,0 +1,251 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	double BroadphaseTestRandom(Neshny::RandomGenerator& generator, double min_val, double max_val) {
+		return min_val + (double)generator.Next() / 4294967296.0 * (max_val - min_val);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct BroadphaseTestBox {
+		Neshny::Vec3	p_Min;
+		Neshny::Vec3	p_Max;
+		Neshny::Vec3	p_Vel;
+		int				p_Index;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// mostly small boxes, with a few that are far bigger
+	std::vector<BroadphaseTestBox> MakeBroadphaseTestBoxes(int count, double spread, bool flat, uint64_t seed) {
+		Neshny::RandomGenerator generator(seed);
+		std::vector<BroadphaseTestBox> boxes(count);
+		for (int i = 0; i < count; i++) {
+			double size = (generator.NextBounded(100) == 0) ? BroadphaseTestRandom(generator, 10.0, 40.0) : BroadphaseTestRandom(generator, 0.2, 2.0);
+			Neshny::Vec3 centre(BroadphaseTestRandom(generator, 0.0, spread), BroadphaseTestRandom(generator, 0.0, spread), flat ? 0.0 : BroadphaseTestRandom(generator, 0.0, spread));
+			Neshny::Vec3 half(size * 0.5, size * 0.5, flat ? 0.0 : size * 0.5);
+			boxes[i].p_Min = centre - half;
+			boxes[i].p_Max = centre + half;
+			boxes[i].p_Vel = Neshny::Vec3(BroadphaseTestRandom(generator, -0.2, 0.2), BroadphaseTestRandom(generator, -0.2, 0.2), flat ? 0.0 : BroadphaseTestRandom(generator, -0.2, 0.2));
+			boxes[i].p_Index = i;
+		}
+		return boxes;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void MoveBroadphaseTestBoxes(std::vector<BroadphaseTestBox>& boxes) {
+		for (auto& box : boxes) {
+			box.p_Min += box.p_Vel;
+			box.p_Max += box.p_Vel;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::vector<Neshny::BroadphasePair> BroadphaseBruteForce(const std::vector<BroadphaseTestBox>& boxes, const std::vector<int>& handles) {
+		std::vector<Neshny::BroadphasePair> pairs;
+		for (int i = 0; i < (int)boxes.size(); i++) {
+			for (int j = i + 1; j < (int)boxes.size(); j++) {
+				const auto& a = boxes[i];
+				const auto& b = boxes[j];
+				if ((a.p_Min.x <= b.p_Max.x) && (b.p_Min.x <= a.p_Max.x) && (a.p_Min.y <= b.p_Max.y) && (b.p_Min.y <= a.p_Max.y) && (a.p_Min.z <= b.p_Max.z) && (b.p_Min.z <= a.p_Max.z)) {
+					pairs.push_back({ std::min(handles[i], handles[j]), std::max(handles[i], handles[j]) });
+				}
+			}
+		}
+		std::sort(pairs.begin(), pairs.end(), [](const Neshny::BroadphasePair& a, const Neshny::BroadphasePair& b) { return (a.p_A < b.p_A) || ((a.p_A == b.p_A) && (a.p_B < b.p_B)); });
+		return pairs;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_SweepAndPruneEvents(void) {
+
+		Neshny::SweepAndPrune2D sap;
+		int a = sap.Add(Neshny::Vec2(0.0, 0.0), Neshny::Vec2(2.0, 2.0));
+		int b = sap.Add(Neshny::Vec2(1.0, 1.0), Neshny::Vec2(3.0, 3.0));
+		int c = sap.Add(Neshny::Vec2(10.0, 0.0), Neshny::Vec2(11.0, 1.0));
+		// overlaps along x with a but not along y
+		int d = sap.Add(Neshny::Vec2(0.5, 5.0), Neshny::Vec2(1.5, 6.0));
+
+		auto stats = sap.Update();
+		ExpectEqual("Four objects", stats.p_Objects, 4);
+		Expect("Only a and b overlap", sap.GetPairs() == std::vector<Neshny::BroadphasePair>{ { a, b } });
+		Expect("Their pair begins", sap.GetBegun() == std::vector<Neshny::BroadphasePair>{ { a, b } });
+		Expect("Nothing ends", sap.GetEnded().empty());
+
+		// touching counts
+		sap.Move(c, Neshny::Vec2(3.0, 0.0), Neshny::Vec2(4.0, 1.0));
+		sap.Update();
+		Expect("b touches c", sap.GetBegun() == std::vector<Neshny::BroadphasePair>{ { b, c } });
+		Expect("a and b persist", sap.GetPersisting() == std::vector<Neshny::BroadphasePair>{ { a, b } });
+
+		sap.Move(a, Neshny::Vec2(-10.0, 0.0), Neshny::Vec2(-8.0, 2.0));
+		sap.Update();
+		Expect("a and b end", sap.GetEnded() == std::vector<Neshny::BroadphasePair>{ { a, b } });
+		Expect("b and c persist", sap.GetPersisting() == std::vector<Neshny::BroadphasePair>{ { b, c } });
+		Expect("Nothing begins", sap.GetBegun().empty());
+
+		// a removed handle is not handed out again before its pairs have ended
+		sap.Remove(b);
+		int e = sap.Add(Neshny::Vec2(3.5, 0.5), Neshny::Vec2(5.0, 5.5));
+		Expect("Removed handle is not reused straight away", e != b);
+		stats = sap.Update();
+		ExpectEqual("Four objects after the swap", stats.p_Objects, 4);
+		Expect("b and c end", sap.GetEnded() == std::vector<Neshny::BroadphasePair>{ { b, c } });
+		Expect("c and e begin", sap.GetBegun() == std::vector<Neshny::BroadphasePair>{ { c, e } });
+		Expect("Removed handle is reused after the update", sap.Add(Neshny::Vec2(100.0, 100.0), Neshny::Vec2(101.0, 101.0)) == b);
+
+		sap.Clear();
+		stats = sap.Update();
+		ExpectEqual("Nothing left", stats.p_Objects, 0);
+		Expect("Clearing ends every pair", sap.GetEnded() == std::vector<Neshny::BroadphasePair>{ { c, e } });
+		Expect("No pairs left", sap.GetPairs().empty());
+		(void)d;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_SweepAndPruneMatchesBruteForce(void) {
+
+		auto boxes = MakeBroadphaseTestBoxes(10000, 150.0, false, 41);
+		Neshny::SweepAndPrune3D single;
+		// sweeping along y instead should not change a thing
+		Neshny::SweepAndPrune3D threaded(1);
+		std::vector<int> handles;
+		for (const auto& box : boxes) {
+			handles.push_back(single.Add(box.p_Min, box.p_Max));
+			threaded.Add(box.p_Min, box.p_Max);
+		}
+
+		std::vector<Neshny::BroadphasePair> previous;
+		bool all_match = true;
+		bool events_match = true;
+		bool threads_match = true;
+		bool any_full_sort_after_first = false;
+		for (int frame = 0; frame < 10; frame++) {
+			auto stats = single.Update(1);
+			threaded.Update(4);
+			any_full_sort_after_first = any_full_sort_after_first || ((frame > 0) && stats.p_FullSort);
+
+			auto expected = BroadphaseBruteForce(boxes, handles);
+			all_match = all_match && (single.GetPairs() == expected);
+			threads_match = threads_match && (threaded.GetPairs() == expected);
+
+			// begun and persisting make up the pairs, ended is whatever was there before and is not now
+			std::vector<Neshny::BroadphasePair> merged = single.GetBegun();
+			merged.insert(merged.end(), single.GetPersisting().begin(), single.GetPersisting().end());
+			std::sort(merged.begin(), merged.end(), [](const Neshny::BroadphasePair& a, const Neshny::BroadphasePair& b) { return (a.p_A < b.p_A) || ((a.p_A == b.p_A) && (a.p_B < b.p_B)); });
+			int still_there = 0;
+			for (const auto& pair : previous) {
+				still_there += std::find(expected.begin(), expected.end(), pair) != expected.end() ? 1 : 0;
+			}
+			events_match = events_match && (merged == expected) && ((int)single.GetPersisting().size() == still_there) && ((int)single.GetEnded().size() == (int)previous.size() - still_there);
+			previous = expected;
+
+			MoveBroadphaseTestBoxes(boxes);
+			for (int i = 0; i < (int)boxes.size(); i++) {
+				single.Move(handles[i], boxes[i].p_Min, boxes[i].p_Max);
+				threaded.Move(handles[i], boxes[i].p_Min, boxes[i].p_Max);
+			}
+		}
+		Expect("Pairs match brute force every frame", all_match);
+		Expect("Threaded pairs match brute force every frame", threads_match);
+		Expect("Begun, persisting and ended agree with the pairs", events_match);
+		Expect("Small moves never need a full sort", !any_full_sort_after_first);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct BroadphaseBenchmarkResult {
+		int		p_SweepPairs;
+		int		p_ThreadedSweepPairs;
+		int		p_GridPairs;
+		double	p_SweepMs;
+		double	p_ThreadedSweepMs;
+		double	p_GridMs;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// average time per frame to find every overlapping pair of a moving mixed size population, along with the pairs each approach found on the last frame
+	BroadphaseBenchmarkResult BenchmarkBroadphase(int count, int frames, bool flat) {
+
+		const double spread = flat ? 400.0 : 150.0;
+		const double max_size = 40.0;
+		auto time_ms = [frames](auto&& run) {
+			auto start = std::chrono::steady_clock::now();
+			run();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+		};
+
+		BroadphaseBenchmarkResult result = {};
+		auto run_sweep = [&](auto& sap, int thread_count, int& pairs, auto&& to_vec) {
+			auto boxes = MakeBroadphaseTestBoxes(count, spread, flat, 42);
+			for (const auto& box : boxes) {
+				sap.Add(to_vec(box.p_Min), to_vec(box.p_Max));
+			}
+			sap.Update(thread_count);
+			for (int frame = 0; frame < frames; frame++) {
+				MoveBroadphaseTestBoxes(boxes);
+				for (const auto& box : boxes) {
+					sap.Move(box.p_Index, to_vec(box.p_Min), to_vec(box.p_Max));
+				}
+				pairs = sap.Update(thread_count).p_Pairs;
+			}
+		};
+		auto run_dimension = [&](int thread_count, int& pairs) {
+			if (flat) {
+				Neshny::SweepAndPrune2D sap;
+				run_sweep(sap, thread_count, pairs, [](Neshny::Vec3 pos) { return Neshny::Vec2(pos.x, pos.y); });
+			} else {
+				Neshny::SweepAndPrune3D sap;
+				run_sweep(sap, thread_count, pairs, [](Neshny::Vec3 pos) { return pos; });
+			}
+		};
+		result.p_SweepMs = time_ms([&]() { run_dimension(1, result.p_SweepPairs); });
+		result.p_ThreadedSweepMs = time_ms([&]() { run_dimension(4, result.p_ThreadedSweepPairs); });
+
+		// the grids are rebuilt every frame, the 2D box grid inserts into every cell a box covers
+		// the 3D grid only stores positions, so has to search as far as the biggest box could reach
+		result.p_GridMs = time_ms([&]() {
+			auto boxes = MakeBroadphaseTestBoxes(count, spread, flat, 42);
+			Neshny::Vec3 margin(max_size, max_size, max_size);
+			Neshny::Grid2DBoxCPUCache<BroadphaseTestBox> grid_2d(Neshny::Vec2(-max_size, -max_size), Neshny::Vec2(spread + max_size, spread + max_size), 4.0, [](const BroadphaseTestBox& box) {
+				return std::pair<Neshny::Vec2, Neshny::Vec2>(Neshny::Vec2(box.p_Min.x, box.p_Min.y), Neshny::Vec2(box.p_Max.x, box.p_Max.y));
+			});
+			Neshny::Grid3DCPUCache<BroadphaseTestBox> grid_3d(margin * -1.0, Neshny::Vec3(spread, spread, spread) + margin, 4.0, [](const BroadphaseTestBox& box) { return (box.p_Min + box.p_Max) * 0.5; });
+			for (int frame = 0; frame < frames; frame++) {
+				MoveBroadphaseTestBoxes(boxes);
+				int pairs = 0;
+				auto check = [&pairs](const BroadphaseTestBox& box, const BroadphaseTestBox* other) {
+					if ((other->p_Index > box.p_Index) && (box.p_Min.x <= other->p_Max.x) && (other->p_Min.x <= box.p_Max.x) && (box.p_Min.y <= other->p_Max.y) && (other->p_Min.y <= box.p_Max.y) && (box.p_Min.z <= other->p_Max.z) && (other->p_Min.z <= box.p_Max.z)) {
+						pairs++;
+					}
+				};
+				if (flat) {
+					grid_2d.Reset();
+					grid_2d.AddItems(boxes);
+					for (const auto& box : boxes) {
+						grid_2d.Iterate(Neshny::Vec2(box.p_Min.x, box.p_Min.y), Neshny::Vec2(box.p_Max.x, box.p_Max.y), [&check, &box](BroadphaseTestBox* other) { check(box, other); });
+					}
+				} else {
+					grid_3d.Reset();
+					grid_3d.AddItems(boxes);
+					for (const auto& box : boxes) {
+						grid_3d.Iterate(box.p_Min - margin * 0.5, box.p_Max + margin * 0.5, [&check, &box](BroadphaseTestBox* other) { check(box, other); return true; });
+					}
+				}
+				result.p_GridPairs = pairs;
+			}
+		});
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_BroadphaseBenchmark(void) {
+		// timings are only reported, what is checked is that every approach finds the same pairs
+		auto flat = BenchmarkBroadphase(20000, 3, true);
+		Neshny::Core::Log(std::format("Broadphase on 20k mixed size 2D boxes: sweep and prune {:.2f} ms a frame, {:.2f} ms on 4 threads, box grid {:.2f} ms, {} pairs", flat.p_SweepMs, flat.p_ThreadedSweepMs, flat.p_GridMs, flat.p_SweepPairs));
+		Expect("Sweep and prune finds the same 2D pairs as the box grid", (flat.p_SweepPairs == flat.p_GridPairs) && (flat.p_ThreadedSweepPairs == flat.p_GridPairs));
+		auto deep = BenchmarkBroadphase(20000, 3, false);
+		Neshny::Core::Log(std::format("Broadphase on 20k mixed size 3D boxes: sweep and prune {:.2f} ms a frame, {:.2f} ms on 4 threads, point grid {:.2f} ms, {} pairs", deep.p_SweepMs, deep.p_ThreadedSweepMs, deep.p_GridMs, deep.p_SweepPairs));
+		Expect("Sweep and prune finds the same 3D pairs as the point grid", (deep.p_SweepPairs == deep.p_GridPairs) && (deep.p_ThreadedSweepPairs == deep.p_GridPairs));
+	}
+
+}
@@ -0,0 +1,470 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+#pragma pack(push)
+#pragma pack (1)
+
+	// the same shape as the EntityInvaders enemies
+	struct CodeGenEnemy {
+		int				p_Id;
+		int				p_Type;
+		int				p_Flags;
+		float			p_Health;
+		Neshny::fVec2	p_Pos;
+		Neshny::fVec2	p_Velocity;
+		float			p_Cooldown;
+	};
+
+	// every member type entities support, including arrays
+	struct CodeGenEverything {
+		int								p_Id;
+		unsigned int					p_Uint;
+		float							p_Float;
+		Neshny::fVec2					p_TwoDim;
+		Neshny::fVec3					p_ThreeDim;
+		Neshny::fVec4					p_FourDim;
+		Neshny::iVec2					p_IntTwoDim;
+		Neshny::iVec3					p_IntThreeDim;
+		Neshny::iVec4					p_IntFourDim;
+		std::array<int, 3>				p_IntArray;
+		std::array<Neshny::fVec2, 2>	p_VecArray;
+	};
+
+#pragma pack(pop)
+}
+
+namespace meta {
+	template<> inline auto registerMembers<Test::CodeGenEnemy>() {
+		return members(
+			member("Id", &Test::CodeGenEnemy::p_Id)
+			,member("Type", &Test::CodeGenEnemy::p_Type)
+			,member("Flags", &Test::CodeGenEnemy::p_Flags)
+			,member("Health", &Test::CodeGenEnemy::p_Health)
+			,member("Pos", &Test::CodeGenEnemy::p_Pos)
+			,member("Velocity", &Test::CodeGenEnemy::p_Velocity)
+			,member("Cooldown", &Test::CodeGenEnemy::p_Cooldown)
+		);
+	}
+	template<> inline auto registerMembers<Test::CodeGenEverything>() {
+		return members(
+			member("Id", &Test::CodeGenEverything::p_Id)
+			,member("Uint", &Test::CodeGenEverything::p_Uint)
+			,member("Float", &Test::CodeGenEverything::p_Float)
+			,member("TwoDim", &Test::CodeGenEverything::p_TwoDim)
+			,member("ThreeDim", &Test::CodeGenEverything::p_ThreeDim)
+			,member("FourDim", &Test::CodeGenEverything::p_FourDim)
+			,member("IntTwoDim", &Test::CodeGenEverything::p_IntTwoDim)
+			,member("IntThreeDim", &Test::CodeGenEverything::p_IntThreeDim)
+			,member("IntFourDim", &Test::CodeGenEverything::p_IntFourDim)
+			,member("IntArray", &Test::CodeGenEverything::p_IntArray)
+			,member("VecArray", &Test::CodeGenEverything::p_VecArray)
+		);
+	}
+}
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_CodeBuilder(void) {
+		Neshny::CodeBuilder builder;
+		builder.Add("x = ", 42, ", y = ", -7, ';');
+		ExpectEqual("Strings, numbers and chars", builder.ToString(), std::string("x = 42, y = -7;"));
+
+		builder.Clear();
+		builder.Add(std::numeric_limits<int64_t>::min(), ' ', std::numeric_limits<uint64_t>::max(), ' ', (std::size_t)3, ' ', true);
+		ExpectEqual("Integer limits", builder.ToString(), std::string("-9223372036854775808 18446744073709551615 3 true"));
+		builder.Clear();
+		builder.Add(0.1f, ' ', 0.5, ' ', 1.0, ' ', 1e20, ' ', 0.1 + 0.2, ' ', -0.0f);
+		ExpectEqual("Floats are shortest round trip like std::format", builder.ToString(), std::string("0.1 0.5 1 1e+20 0.30000000000000004 -0"));
+
+		builder.Clear();
+		builder.Line("fn Main() {");
+		{
+			auto indent = builder.Indented();
+			builder.Line("let a = ", 1, ';');
+			{
+				auto inner = builder.Indented();
+				builder.Line("b");
+			}
+			builder.Line("c");
+		}
+		builder.Line('}');
+		builder.Unindent();
+		ExpectEqual("Indentation", builder.ToString(), std::string("fn Main() {\n\tlet a = 1;\n\t\tb\n\tc\n}\n"));
+		ExpectEqual("Unindent stops at zero", builder.GetIndentLevel(), 0);
+
+		builder.Clear();
+		builder.Join(std::vector<std::string>{ "a", "", "c" }, ", ").Add(" | ").Join(std::list<std::string>{}, ", ").Add(" | ").Join(std::vector<std::string_view>{ "d" }, ", ");
+		ExpectEqual("Join", builder.ToString(), std::string("a, , c |  | d"));
+		Neshny::CodeBuilder::Separator separator("\n");
+		std::string separated;
+		for (auto str : { "x", "y", "z" }) {
+			separated += std::string(separator()) + str;
+		}
+		ExpectEqual("Separator skips the first", separated, std::string("x\ny\nz"));
+
+		// the whole point is that a reused builder stops allocating
+		builder.Clear();
+		for (int i = 0; i < 1000; i++) {
+			builder.Line("\tresult.Member", i, " = ", i * 0.5f, ';');
+		}
+		std::string first = builder.ToString();
+		std::size_t capacity = builder.Capacity();
+		const char* data = builder.View().data();
+		builder.Clear();
+		Expect("Clear keeps the capacity", (builder.Size() == 0) && (builder.Capacity() == capacity));
+		for (int i = 0; i < 1000; i++) {
+			builder.Line("\tresult.Member", i, " = ", i * 0.5f, ';');
+		}
+		Expect("Refilling does not reallocate", (builder.View().data() == data) && (builder.View() == first));
+		std::string taken = builder.Take();
+		Expect("Take hands over the text and leaves it empty", (taken == first) && (builder.Size() == 0));
+		builder.Add("again");
+		ExpectEqual("Usable after a take", builder.ToString(), std::string("again"));
+
+		ExpectEqual("Join nothing", Neshny::JoinStrings(std::vector<std::string>{}, ", "), std::string());
+		ExpectEqual("Join one", Neshny::JoinStrings(std::vector<std::string>{ "one" }, ", "), std::string("one"));
+		ExpectEqual("Join keeps empty items", Neshny::JoinStrings(std::vector<std::string>{ "", "b", "" }, ", "), std::string(", b, "));
+		ExpectEqual("Join a list", Neshny::JoinStrings(std::list<std::string>{ "a", "b" }, "\n"), std::string("a\nb"));
+
+		Neshny::GeneratedCodeCache<std::string> cache;
+		int generated = 0;
+		auto generate = [&generated]() { generated++; return std::string("code"); };
+		std::string first_get = cache.Get("key", generate);
+		std::string second_get = cache.Get("key", generate);
+		Expect("Cache generates once", (first_get == "code") && (second_get == "code") && (generated == 1) && (cache.Size() == 1));
+		cache.Clear();
+		cache.Get("key", generate);
+		ExpectEqual("Cleared cache generates again", generated, 2);
+	}
+
+#if defined(NESHNY_WEBGPU)
+
+	////////////////////////////////////////////////////////////////////////////////
+	// the implementations from before the code builder, kept as the reference the generated code has to match byte for byte
+	std::string LegacyJoinStrings(const std::vector<std::string>& list, std::string_view insert_between) {
+		std::string result;
+		int last_index = (int)list.size() - 1;
+		for (int i = 0; i <= last_index; i++) {
+			if (i == last_index) {
+				result += list[i];
+			} else {
+				result += std::format("{}{}", list[i], insert_between);
+			}
+		}
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<typename T>
+	void LegacySerializeStructInfo(Neshny::StructInfo& info, std::string get_base_str, std::string entity_name, Neshny::EntityLayout layout) {
+		using namespace Neshny;
+		Serialiser<T> serializeFunc(info.p_Members);
+		meta::doForAllMembers<T>(serializeFunc);
+
+		std::vector<std::string> read_only_lines;
+		std::vector<std::string> lines;
+
+		// AOS: (index) * FLOATS_PER + pos, SOA: (index) + pos * STRIDE
+		auto access_str = [&entity_name, layout](int pos, bool with_num) {
+			if (layout == EntityLayout::SOA) {
+				return std::format("(b_{0}[(index) + ({1}{2}) * {0}_STRIDE + ENTITY_OFFSET_INTS])", entity_name, pos, with_num ? " + (num)" : "");
+			}
+			return std::format("(b_{0}[(index) * FLOATS_PER_{0} + {1} + ENTITY_OFFSET_INTS{2}])", entity_name, pos, with_num ? " + (num)" : "");
+		};
+
+		read_only_lines.push_back(std::format("struct {} {{", entity_name));
+		{
+			std::vector<std::string> member_vars;
+			for (auto member : info.p_Members) {
+				auto type_str = MemberSpec::GetGPUType(member.p_Type);
+				member_vars.push_back(std::format("\t{}: {}", member.p_Name, member.p_ArrayCount.has_value() ? std::format("array<{}, {}>", type_str, *member.p_ArrayCount) : type_str));
+			}
+			read_only_lines.push_back(LegacyJoinStrings(member_vars, ",\n"));
+		}
+		read_only_lines.push_back("}");
+
+		read_only_lines.push_back(std::format("fn Get{0}(index: i32) -> {0} {{", entity_name));
+		read_only_lines.push_back(get_base_str);
+		read_only_lines.push_back(std::format("\tvar result: {};", entity_name));
+		int pos_index = 0;
+		std::vector<std::string> functions;
+		for (auto member : info.p_Members) {
+			auto member_name = member.p_Name;
+
+			if (member.p_ArrayCount.has_value()) {
+				std::size_t num = *member.p_ArrayCount;
+				if ((member.p_Type == MemberSpec::Type::T_INT) || (member.p_Type == MemberSpec::Type::T_UINT)) {
+					functions.push_back(std::format("// defined macro Access{}{}(index, array_index)\n", entity_name, member_name));
+					functions.push_back(std::format("#define Access{1}{0}(index,num) {2}\n", member_name, entity_name, access_str(pos_index, true)));
+				}
+				for (std::size_t i = 0; i < num; i++) {
+					std::string get_syntax = MemberSpec::GetGPUGetSyntax(member.p_Type, pos_index, entity_name);
+					pos_index += member.p_Size / sizeof(float);
+					read_only_lines.push_back(std::format("\tresult.{}[{}] = {};", member_name, i, get_syntax));
+				}
+				continue;
+			}
+
+			std::string get_syntax = MemberSpec::GetGPUGetSyntax(member.p_Type, pos_index, entity_name);
+			read_only_lines.push_back(std::format("\tresult.{} = {};", member_name, get_syntax));
+			functions.push_back(std::format("fn Get{2}{1}(index: i32) -> {0} {{\n", MemberSpec::GetGPUType(member.p_Type), member_name, entity_name) + get_base_str + std::format("\n\treturn {};\n}}", get_syntax));
+			if ((member.p_Type == MemberSpec::Type::T_INT) || (member.p_Type == MemberSpec::Type::T_UINT)) {
+				functions.push_back(std::format("// defined macro Access{}{}(index)\n", entity_name, member_name));
+				functions.push_back(std::format("#define Access{1}{0}(index) {2}\n", member_name, entity_name, access_str(pos_index, false)));
+			} else if ((member.p_Type == MemberSpec::Type::T_IVEC2) || (member.p_Type == MemberSpec::Type::T_IVEC3) || (member.p_Type == MemberSpec::Type::T_IVEC4)) {
+				functions.push_back(std::format("// defined macro Access{}{}_X/Y/Z/W(index)\n", entity_name, member_name));
+				functions.push_back(std::format("#define Access{1}{0}_X(index) {2}\n", member_name, entity_name, access_str(pos_index, false)));
+				functions.push_back(std::format("#define Access{1}{0}_Y(index) {2}\n", member_name, entity_name, access_str(pos_index + 1, false)));
+				if (member.p_Type != MemberSpec::Type::T_IVEC2) {
+					functions.push_back(std::format("#define Access{1}{0}_Z(index) {2}\n", member_name, entity_name, access_str(pos_index + 2, false)));
+					if (member.p_Type == MemberSpec::Type::T_IVEC4) {
+						functions.push_back(std::format("#define Access{1}{0}_W(index) {2}\n", member_name, entity_name, access_str(pos_index + 3, false)));
+					}
+				}
+			}
+
+			pos_index += member.p_Size / sizeof(float);
+		}
+		read_only_lines.push_back("\treturn result;\n}");
+		read_only_lines.push_back(LegacyJoinStrings(functions, "\n"));
+
+		lines.push_back(std::format("fn Set{0}(item: {0}, index: i32) {{", entity_name)); // TODO: make this a ref?
+		lines.push_back(get_base_str);
+		pos_index = 0;
+		functions = {};
+		for (auto member : info.p_Members) {
+
+			if (member.p_ArrayCount.has_value()) {
+				std::size_t num = *member.p_ArrayCount;
+				for (std::size_t i = 0; i < num; i++) {
+					auto [mod_str, value_mod_str] = MemberSpec::GetGPUSetSyntax(member.p_Type, pos_index, entity_name, std::format("{}[{}]", member.p_Name, i));
+					lines.push_back(mod_str);
+					pos_index += member.p_Size / sizeof(float);
+				}
+				continue;
+			}
+
+			auto [mod_str, value_mod_str] = MemberSpec::GetGPUSetSyntax(member.p_Type, pos_index, entity_name, member.p_Name);
+			lines.push_back(mod_str);
+			functions.push_back(std::format("fn Set{2}{0}(index: i32, value: {1}) {{\n", member.p_Name, MemberSpec::GetGPUType(member.p_Type), entity_name) + get_base_str + std::format("\n{}\n}}", value_mod_str));
+
+			pos_index += member.p_Size / sizeof(float);
+		}
+
+		lines.push_back("}");
+		lines.push_back(LegacyJoinStrings(functions, "\n"));
+
+		info.p_GPUReadOnlyInsertion = LegacyJoinStrings(read_only_lines, "\n");
+		info.p_GPUInsertion = std::format("{}{}", info.p_GPUReadOnlyInsertion, LegacyJoinStrings(lines, "\n"));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::string LegacyDataVectorStructCode(const Neshny::PipelineCode::DataVector& data_vect, bool read_only) {
+		using namespace Neshny;
+
+		std::vector<std::string> insertion;
+		insertion.push_back(std::format("struct {0} {{", data_vect.p_Name));
+
+		std::vector<std::string> function{ std::format("fn Get{0}(base_index: i32) -> {0} {{ // use io{0}Num for count\n\tvar item: {0};", data_vect.p_Name) };
+		std::vector<std::string> members;
+		if (read_only) {
+			function.push_back(std::format("\tlet index = io{0}Offset + (base_index * {1});", data_vect.p_Name, data_vect.p_NumIntsPerItem));
+		} else {
+			function.push_back(std::format("\tlet index = Get_io{0}Offset + (base_index * {1});", data_vect.p_Name, data_vect.p_NumIntsPerItem));
+		}
+
+		int pos_index = 0;
+		for (const auto& member : data_vect.p_Members) {
+			members.push_back(std::format("\t{}: {}", member.p_Name, MemberSpec::GetGPUType(member.p_Type)));
+
+			std::string name = member.p_Name;
+			if (read_only) {
+
+				if (member.p_Type == MemberSpec::T_INT) {
+					function.push_back(std::format("\titem.{0} = b_Control[index + {1}];", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_FLOAT) {
+					function.push_back(std::format("\titem.{0} = bitcast<f32>(b_Control[index + {1}]);", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC2) {
+					function.push_back(std::format("\titem.{0} = vec2f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC3) {
+					function.push_back(std::format("\titem.{0} = vec3f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]), bitcast<f32>(b_Control[index + {1} + 2]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC4) {
+					function.push_back(std::format("\titem.{0} = vec4f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]), bitcast<f32>(b_Control[index + {1} + 2]), bitcast<f32>(b_Control[index + {1} + 3]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC2) {
+					function.push_back(std::format("\titem.{0} = vec2i(b_Control[index + {1}], b_Control[index + {1} + 1]);", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC3) {
+					function.push_back(std::format("\titem.{0} = vec3i(b_Control[index + {1}], b_Control[index + {1} + 1], b_Control[index + {1} + 2]);", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC4) {
+					function.push_back(std::format("\titem.{0} = vec4i(b_Control[index + {1}], b_Control[index + {1} + 1], b_Control[index + {1} + 2], b_Control[index + {1} + 3]);", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_MAT3) {
+					std::vector<std::string> items;
+					for (int i = 0; i < 9; i++) {
+						items.push_back(std::format("bitcast<f32>(b_Control[index + {} + {}])", pos_index, i));
+					}
+					function.push_back(std::format("\titem.{} = mat3x3f({});", name, LegacyJoinStrings(items, ", ")));
+				} else if (member.p_Type == MemberSpec::T_MAT4) {
+					std::vector<std::string> items;
+					for (int i = 0; i < 16; i++) {
+						items.push_back(std::format("bitcast<f32>(b_Control[index + {} + {}])", pos_index, i));
+					}
+					function.push_back(std::format("\titem.{} = mat4x4f({});", name, LegacyJoinStrings(items, ", ")));
+				}
+			} else {
+				if (member.p_Type == MemberSpec::T_INT) {
+					function.push_back(std::format("\titem.{0} = atomicLoad(&b_Control[index + {1}]);", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_FLOAT) {
+					function.push_back(std::format("\titem.{0} = bitcast<f32>(atomicLoad(&b_Control[index + {1}]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC2) {
+					function.push_back(std::format("\titem.{0} = vec2f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC3) {
+					function.push_back(std::format("\titem.{0} = vec3f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 2])));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_VEC4) {
+					function.push_back(std::format("\titem.{0} = vec4f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 2])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 3])));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC2) {
+					function.push_back(std::format("\titem.{0} = vec2i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC3) {
+					function.push_back(std::format("\titem.{0} = vec3i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]), atomicLoad(&b_Control[index + {1} + 2]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_IVEC4) {
+					function.push_back(std::format("\titem.{0} = vec4i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]), atomicLoad(&b_Control[index + {1} + 2]), atomicLoad(&b_Control[index + {1} + 3]));", name, pos_index));
+				} else if (member.p_Type == MemberSpec::T_MAT3) {
+					std::vector<std::string> items;
+					for (int i = 0; i < 9; i++) {
+						items.push_back(std::format("bitcast<f32>(atomicLoad(&b_Control[index + {} + {}]))", pos_index, i));
+					}
+					function.push_back(std::format("\titem.{} = mat3x3f({});", name, LegacyJoinStrings(items, ", ")));
+				} else if (member.p_Type == MemberSpec::T_MAT4) {
+					std::vector<std::string> items;
+					for (int i = 0; i < 16; i++) {
+						items.push_back(std::format("bitcast<f32>(atomicLoad(&b_Control[index + {} + {}]))", pos_index, i));
+					}
+					function.push_back(std::format("\titem.{} = mat4x4f({});", name, LegacyJoinStrings(items, ", ")));
+				}
+			}
+			pos_index += member.p_Size / sizeof(int);
+		}
+		function.push_back("\treturn item;\n};");
+
+		insertion.push_back(LegacyJoinStrings(members, ",\n"));
+		insertion.push_back("};");
+		insertion.push_back(LegacyJoinStrings(function, "\n"));
+
+		return LegacyJoinStrings(insertion, "\n");
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::vector<Neshny::MemberSpec> CodeGenDataVectorMembers(void) {
+		using Neshny::MemberSpec;
+		return {
+			{ "Int", MemberSpec::T_INT, 4 }
+			,{ "Uint", MemberSpec::T_UINT, 4 }
+			,{ "Float", MemberSpec::T_FLOAT, 4 }
+			,{ "TwoDim", MemberSpec::T_VEC2, 8 }
+			,{ "ThreeDim", MemberSpec::T_VEC3, 12 }
+			,{ "FourDim", MemberSpec::T_VEC4, 16 }
+			,{ "IntTwoDim", MemberSpec::T_IVEC2, 8 }
+			,{ "IntThreeDim", MemberSpec::T_IVEC3, 12 }
+			,{ "IntFourDim", MemberSpec::T_IVEC4, 16 }
+			,{ "Rotation", MemberSpec::T_MAT3, 36 }
+			,{ "Transform", MemberSpec::T_MAT4, 64 }
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::string CodeGenBaseSyntax(std::string_view name, Neshny::EntityLayout layout) {
+		if (layout == Neshny::EntityLayout::SOA) {
+			return "\tlet base = index + ENTITY_OFFSET_INTS;";
+		}
+		return std::format("\tlet base = index * FLOATS_PER_{} + ENTITY_OFFSET_INTS;", name);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<typename T>
+	bool CodeGenMatchesLegacy(std::string_view name, Neshny::EntityLayout layout) {
+		std::string base = CodeGenBaseSyntax(name, layout);
+		Neshny::StructInfo legacy;
+		LegacySerializeStructInfo<T>(legacy, base, std::string(name), layout);
+		Neshny::StructInfo generated;
+		Neshny::GenerateStructInfo<T>(generated, base, std::string(name), layout);
+		Neshny::StructInfo cached;
+		Neshny::SerializeStructInfo<T>(cached, base, std::string(name), layout);
+		Neshny::StructInfo cached_again;
+		Neshny::SerializeStructInfo<T>(cached_again, base, std::string(name), layout);
+
+		bool matches = true;
+		for (const auto* info : { &generated, &cached, &cached_again }) {
+			matches = matches && (info->p_GPUInsertion == legacy.p_GPUInsertion) && (info->p_GPUReadOnlyInsertion == legacy.p_GPUReadOnlyInsertion) && (info->p_Members.size() == legacy.p_Members.size());
+		}
+		return matches;
+	}
+
+	struct CodeGenBenchmarkResult {
+		std::string	p_Name;
+		double		p_LegacyMicros;
+		double		p_BuilderMicros;
+		double		p_CachedMicros;
+		bool		p_Matches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// not a unit test on its own - generates the example structs' code the old way, with the builder and through the cache, best of a few runs
+	template<typename T>
+	CodeGenBenchmarkResult BenchmarkCodeGeneration(std::string_view name, int iterations) {
+		std::string base = CodeGenBaseSyntax(name, Neshny::EntityLayout::AOS);
+		auto micros_per = [&](std::string& last_code, auto&& generate) {
+			double best_seconds = std::numeric_limits<double>::max();
+			for (int run = 0; run < 3; run++) {
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < iterations; i++) {
+					Neshny::StructInfo info;
+					generate(info);
+					// keeping the output also stops the compiler throwing the generation away
+					last_code = std::move(info.p_GPUInsertion);
+				}
+				best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			return best_seconds * 1e6 / iterations;
+		};
+		std::string legacy_code;
+		std::string builder_code;
+		std::string cached_code;
+		CodeGenBenchmarkResult result;
+		result.p_Name = name;
+		result.p_LegacyMicros = micros_per(legacy_code, [&](Neshny::StructInfo& info) { LegacySerializeStructInfo<T>(info, base, std::string(name), Neshny::EntityLayout::AOS); });
+		result.p_BuilderMicros = micros_per(builder_code, [&](Neshny::StructInfo& info) { Neshny::GenerateStructInfo<T>(info, base, std::string(name), Neshny::EntityLayout::AOS); });
+		result.p_CachedMicros = micros_per(cached_code, [&](Neshny::StructInfo& info) { Neshny::SerializeStructInfo<T>(info, base, std::string(name), Neshny::EntityLayout::AOS); });
+		result.p_Matches = (builder_code == legacy_code) && (cached_code == legacy_code);
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_CodeBuilderMatchesFormat(void) {
+		for (auto layout : { Neshny::EntityLayout::AOS, Neshny::EntityLayout::SOA }) {
+			std::string layout_name = layout == Neshny::EntityLayout::AOS ? "AOS" : "SOA";
+			Expect("Enemy struct code is unchanged " + layout_name, CodeGenMatchesLegacy<CodeGenEnemy>("Enemy", layout));
+			Expect("Every member type is unchanged " + layout_name, CodeGenMatchesLegacy<CodeGenEverything>("Everything", layout));
+		}
+
+		Neshny::PipelineCode::DataVector data_vect;
+		data_vect.p_Name = "Spawn";
+		data_vect.p_NumIntsPerItem = 43;
+		data_vect.p_Members = CodeGenDataVectorMembers();
+		for (bool read_only : { true, false }) {
+			ExpectEqual(std::format("Data vector code is unchanged {}", read_only), Neshny::PipelineCode::GetDataVectorStructCode(data_vect, read_only), LegacyDataVectorStructCode(data_vect, read_only));
+		}
+		data_vect.p_Members.clear();
+		ExpectEqual("Empty data vector is unchanged", Neshny::PipelineCode::GetDataVectorStructCode(data_vect, true), LegacyDataVectorStructCode(data_vect, true));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_CodeBuilderBenchmark(void) {
+		for (const auto& result : { BenchmarkCodeGeneration<CodeGenEnemy>("Enemy", 2000), BenchmarkCodeGeneration<CodeGenEverything>("Everything", 500) }) {
+			Neshny::Core::Log(std::format("Generating {} takes {:.2f}us with std::format, {:.2f}us with the builder and {:.2f}us through the cache", result.p_Name, result.p_LegacyMicros, result.p_BuilderMicros, result.p_CachedMicros));
+			Expect(std::format("Benchmarked code for {} matches std::format", result.p_Name), result.p_Matches);
+		}
+	}
+
+#endif
+
+} // namespace Test
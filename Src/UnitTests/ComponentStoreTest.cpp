@@ -0,0 +1,254 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	struct ComponentTestItem {
+		Neshny::fVec2	p_Pos;
+		Neshny::fVec2	p_Vel;
+		int				p_Health = 0;
+		std::string		p_Name;
+	};
+
+	struct ComponentTestSave {
+		std::vector<ComponentTestItem>	p_Items;
+		std::vector<uint64_t>			p_Handles;
+	};
+}
+
+namespace meta {
+	template<> inline auto registerMembers<Test::ComponentTestItem>() {
+		return members(
+			member("Pos", &Test::ComponentTestItem::p_Pos)
+			,member("Vel", &Test::ComponentTestItem::p_Vel)
+			,member("Health", &Test::ComponentTestItem::p_Health)
+			,member("Name", &Test::ComponentTestItem::p_Name)
+		);
+	}
+	template<> inline auto registerMembers<Test::ComponentTestSave>() {
+		return members(
+			member("Items", &Test::ComponentTestSave::p_Items)
+			,member("Handles", &Test::ComponentTestSave::p_Handles)
+		);
+	}
+}
+
+namespace Test {
+
+	using ComponentTestStore = Neshny::ComponentStore<ComponentTestItem>;
+
+	////////////////////////////////////////////////////////////////////////////////
+	bool ComponentTestItemsEqual(const ComponentTestItem& a, const ComponentTestItem& b) {
+		return (a.p_Pos == b.p_Pos) && (a.p_Vel == b.p_Vel) && (a.p_Health == b.p_Health) && (a.p_Name == b.p_Name);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	ComponentTestItem MakeComponentTestItem(int id) {
+		return { Neshny::fVec2((float)id, (float)(id * 2)), Neshny::fVec2(1.0f, -0.5f), id % 100, std::format("item_{}", id) };
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_ComponentStoreHandles(void) {
+
+		ComponentTestStore store;
+		std::vector<std::pair<Neshny::ComponentHandle, int>> live;
+		std::vector<Neshny::ComponentHandle> removed;
+		Neshny::RandomGenerator generator((uint64_t)3);
+
+		// enough churn to fill several chunks and swap items between them
+		for (int i = 0; i < 12000; i++) {
+			if (!live.empty() && (generator.NextBounded(3) == 0)) {
+				int index = (int)generator.NextBounded((uint32_t)live.size());
+				store.Remove(live[index].first);
+				removed.push_back(live[index].first);
+				live[index] = live.back();
+				live.pop_back();
+			} else {
+				live.push_back({ store.Add(MakeComponentTestItem(i)), i });
+			}
+		}
+		ExpectEqual("Count follows adds and removes", store.GetCount(), (int)live.size());
+
+		bool all_match = true;
+		std::vector<bool> seen(store.GetCount(), false);
+		for (const auto& [handle, id] : live) {
+			int index = store.GetIndex(handle);
+			all_match = all_match && store.IsValid(handle) && ComponentTestItemsEqual(store.Get(handle), MakeComponentTestItem(id)) && (store.GetHandle(index) == handle);
+			seen[index] = true;
+		}
+		Expect("Every live handle finds its own item", all_match);
+		Expect("Live items are packed", std::all_of(seen.begin(), seen.end(), [](bool val) { return val; }));
+		Expect("Removed handles are not valid even when their slot is reused", std::none_of(removed.begin(), removed.end(), [&store](Neshny::ComponentHandle handle) { return store.IsValid(handle); }));
+		Expect("Removing twice fails", !store.Remove(removed[0]) && !store.Remove({}));
+
+		auto handle = live[0].first;
+		store.GetComponent<&ComponentTestItem::p_Health>(handle) = 555;
+		ExpectEqual("Components are changed in place", store.Get(handle).p_Health, 555);
+		store.Set(handle, MakeComponentTestItem(7));
+		Expect("Set replaces every component", ComponentTestItemsEqual(store.Get(handle), MakeComponentTestItem(7)));
+
+		store.Clear();
+		Expect("Clear leaves nothing valid", (store.GetCount() == 0) && !store.IsValid(handle));
+		auto after = store.Add(MakeComponentTestItem(1));
+		Expect("Adds after a clear", store.IsValid(after) && (store.GetIndex(after) == 0) && !(after == handle));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_ComponentStoreQuery(void) {
+
+		ComponentTestStore single;
+		ComponentTestStore threaded;
+		for (int i = 0; i < 50000; i++) {
+			single.Add(MakeComponentTestItem(i));
+			threaded.Add(MakeComponentTestItem(i));
+		}
+		for (int i = 0; i < 50000; i += 3) {
+			single.Remove(single.GetHandle(i % single.GetCount()));
+			threaded.Remove(threaded.GetHandle(i % threaded.GetCount()));
+		}
+
+		auto integrate = [](Neshny::fVec2& pos, const Neshny::fVec2& vel) {
+			pos += vel * 0.5f;
+		};
+		single.ForEach<&ComponentTestItem::p_Pos, &ComponentTestItem::p_Vel>(integrate);
+		threaded.ForEach<&ComponentTestItem::p_Pos, &ComponentTestItem::p_Vel>(integrate, 4);
+		auto single_items = single.GetItems();
+		auto threaded_items = threaded.GetItems();
+		bool same = single_items.size() == threaded_items.size();
+		for (int i = 0; same && (i < (int)single_items.size()); i++) {
+			same = ComponentTestItemsEqual(single_items[i], threaded_items[i]);
+		}
+		Expect("Threaded query gives the same result", same);
+
+		auto handle = single.GetHandle(100);
+		auto expected = MakeComponentTestItem(std::stoi(single.Get(handle).p_Name.substr(5)));
+		Expect("Only the named components change", (single.Get(handle).p_Pos == expected.p_Pos + expected.p_Vel * 0.5f) && (single.Get(handle).p_Health == expected.p_Health));
+
+		std::atomic_int visited = 0;
+		std::atomic_int handles_ok = 0;
+		threaded.ForEach<&ComponentTestItem::p_Health>([&threaded, &visited, &handles_ok](Neshny::ComponentHandle handle, int& health) {
+			visited++;
+			handles_ok += (threaded.GetIndex(handle) >= 0) ? 1 : 0;
+		}, 4);
+		Expect("Queries with handles visit every item once", (visited == threaded.GetCount()) && (handles_ok == threaded.GetCount()));
+
+		int chunked = 0;
+		single.ForEachChunk<&ComponentTestItem::p_Health>([&chunked](int first, int count, int* health) {
+			chunked += (first == chunked) ? count : 0;
+		});
+		ExpectEqual("Chunks cover the items in order", chunked, single.GetCount());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_ComponentStoreSerialise(void) {
+
+		ComponentTestStore store;
+		std::vector<Neshny::ComponentHandle> handles;
+		for (int i = 0; i < 3000; i++) {
+			handles.push_back(store.Add(MakeComponentTestItem(i)));
+		}
+		for (int i = 0; i < 3000; i += 4) {
+			store.Remove(handles[i]);
+		}
+
+		ComponentTestSave save;
+		save.p_Items = store.GetItems(&save.p_Handles);
+		for (bool binary : { false, true }) {
+			std::string mode = binary ? "Binary" : "Json";
+			ComponentTestSave loaded;
+			if (binary) {
+				Neshny::Binary::ParseError err;
+				auto data = Neshny::Binary::ToBinary(save, err);
+				Neshny::Binary::FromBinary(data, loaded, err);
+				Expect("Binary round trip", !err);
+			} else {
+				Neshny::Json::ParseError err;
+				auto data = Neshny::Json::ToJson(save, err);
+				Neshny::Json::FromJson(data, loaded, err);
+				Expect("Json round trip", !err);
+			}
+
+			ComponentTestStore restored;
+			Expect(std::format("{} items restore", mode), restored.SetItems(loaded.p_Items, &loaded.p_Handles));
+			bool same = restored.GetCount() == store.GetCount();
+			for (int i = 0; i < 3000; i++) {
+				same = same && (store.IsValid(handles[i]) == restored.IsValid(handles[i]));
+				if (same && store.IsValid(handles[i])) {
+					same = ComponentTestItemsEqual(store.Get(handles[i]), restored.Get(handles[i])) && (store.GetIndex(handles[i]) == restored.GetIndex(handles[i]));
+				}
+			}
+			Expect(std::format("{} handles find the same items after loading", mode), same);
+			auto added = restored.Add(MakeComponentTestItem(9999));
+			Expect(std::format("{} restored store reuses free slots", mode), restored.IsValid(added) && (added.p_Index < 3000));
+		}
+
+		ComponentTestStore fresh;
+		std::vector<uint64_t> duplicate = { save.p_Handles[0], save.p_Handles[0] };
+		Expect("Duplicate handles are refused", !fresh.SetItems({ save.p_Items[0], save.p_Items[1] }, &duplicate));
+		std::vector<uint64_t> far_away = { Neshny::ComponentHandle{ 0xFFFFFFF0, 1 }.ToInt() };
+		std::vector<uint64_t> no_generation = { Neshny::ComponentHandle{ 3, 0 }.ToInt() };
+		Expect("Handles far past the item count are refused", !fresh.SetItems({ save.p_Items[0] }, &far_away));
+		Expect("Handles without a generation are refused", !fresh.SetItems({ save.p_Items[0] }, &no_generation));
+		Expect("Without handles items get new ones", fresh.SetItems(save.p_Items) && (fresh.GetCount() == (int)save.p_Items.size()) && (fresh.GetHandle(5).p_Index == 5));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_ComponentStoreBenchmark(void) {
+
+		const int count = 500000;
+		auto time_ms = [](auto&& fn) {
+			double best = std::numeric_limits<double>::max();
+			for (int attempt = 0; attempt < 3; attempt++) {
+				auto start = std::chrono::steady_clock::now();
+				fn();
+				best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			return best;
+		};
+
+		ComponentTestStore store;
+		std::vector<ComponentTestItem> array_of_structs;
+		std::vector<Neshny::ComponentHandle> handles(count);
+		double add_ms = time_ms([&]() {
+			store.Clear();
+			for (int i = 0; i < count; i++) {
+				handles[i] = store.Add({ Neshny::fVec2((float)i, 0.0f), Neshny::fVec2(1.0f, 1.0f), 100 });
+			}
+		});
+		for (int i = 0; i < count; i++) {
+			array_of_structs.push_back({ Neshny::fVec2((float)i, 0.0f), Neshny::fVec2(1.0f, 1.0f), 100 });
+		}
+
+		auto integrate = [](Neshny::fVec2& pos, const Neshny::fVec2& vel) {
+			pos += vel * 0.016f;
+		};
+		double soa_ms = time_ms([&]() { store.ForEach<&ComponentTestItem::p_Pos, &ComponentTestItem::p_Vel>(integrate); });
+		double threaded_ms = time_ms([&]() { store.ForEach<&ComponentTestItem::p_Pos, &ComponentTestItem::p_Vel>(integrate, 4); });
+		double aos_ms = time_ms([&]() {
+			for (auto& item : array_of_structs) {
+				integrate(item.p_Pos, item.p_Vel);
+			}
+		});
+		// the store has been moved twice as many times, so catch the array up before comparing
+		for (int run = 0; run < 3; run++) {
+			for (auto& item : array_of_structs) {
+				integrate(item.p_Pos, item.p_Vel);
+			}
+		}
+		bool same_positions = true;
+		for (int i = 0; i < count; i++) {
+			same_positions = same_positions && (store.GetComponent<&ComponentTestItem::p_Pos>(handles[i]) == array_of_structs[i].p_Pos);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i += 2) {
+			store.Remove(handles[i]);
+		}
+		double remove_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		Neshny::Core::Log(std::format("Added {}k in {:.1f} ms and removed half in {:.1f} ms", count / 1000, add_ms, remove_ms));
+		Neshny::Core::Log(std::format("Moving {}k items takes {:.2f} ms, {:.2f} ms on 4 threads and {:.2f} ms as an array of structs", count / 1000, soa_ms, threaded_ms, aos_ms));
+		Expect("Moving through the store gives the same positions as the array of structs", same_positions);
+		ExpectEqual("Half are left after removing every second item", store.GetCount(), count / 2);
+	}
+
+}
@@ -0,0 +1,234 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	double CullTestRandom(Neshny::RandomGenerator& generator, double min_val, double max_val) {
+		return min_val + (max_val - min_val) * ((double)generator.Next() / 4294967296.0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	Neshny::SphereBoundsSoA MakeCullTestSpheres(int count, double spread, uint64_t seed) {
+		Neshny::RandomGenerator generator(seed);
+		Neshny::SphereBoundsSoA spheres;
+		for (int i = 0; i < count; i++) {
+			Neshny::Vec3 pos(CullTestRandom(generator, -spread, spread), CullTestRandom(generator, -spread, spread), CullTestRandom(generator, -spread, spread));
+			spheres.Add(pos, CullTestRandom(generator, 0.1, 3.0));
+		}
+		return spheres;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	Neshny::Frustum MakeCullTestFrustum(void) {
+		Neshny::Camera3DFPS cam;
+		cam.p_Pos = Neshny::Vec3(10.0, 5.0, 80.0);
+		cam.p_Direction = Neshny::Quat(25.0, Neshny::Quat::Axis::Y) * Neshny::Quat(-10.0, Neshny::Quat::Axis::X);
+		cam.p_FarPlane = 300.0f;
+		return cam.GetFrustum(1600, 900);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FrustumPlanes(void) {
+		Neshny::Camera3DOrbit orbit;
+		orbit.p_Pos = Neshny::Vec3(0.0, 0.0, 0.0);
+		orbit.p_Zoom = 100.0;
+		auto frustum = orbit.GetFrustum(1000, 1000);
+
+		Expect("Looking at the origin", frustum.ContainsPoint(Neshny::Vec3(0.0, 0.0, 0.0)));
+		Expect("Behind the camera", !frustum.ContainsPoint(Neshny::Vec3(0.0, 0.0, 150.0)));
+		Expect("Past the far plane", !frustum.ContainsPoint(Neshny::Vec3(0.0, 0.0, -1000.0)));
+		Expect("Off to the side", !frustum.ContainsPoint(Neshny::Vec3(500.0, 0.0, 0.0)));
+		Expect("Big sphere off to the side reaches in", frustum.IntersectsSphere(Neshny::Vec3(500.0, 0.0, 0.0), 500.0));
+		Expect("Near plane in front of the camera", (frustum.Distance(Neshny::Frustum::Plane::NEAR_PLANE, Neshny::Vec3(0.0, 0.0, 99.95)) < 0.0) && (frustum.Distance(Neshny::Frustum::Plane::NEAR_PLANE, Neshny::Vec3(0.0, 0.0, 99.85)) > 0.0));
+		Expect("Small box inside", frustum.ClassifyAABB(Neshny::Vec3(-1.0, -1.0, -1.0), Neshny::Vec3(1.0, 1.0, 1.0)) == Neshny::Frustum::Result::INSIDE);
+		Expect("Huge box straddles", frustum.ClassifyAABB(Neshny::Vec3(-1e4, -1e4, -1e4), Neshny::Vec3(1e4, 1e4, 1e4)) == Neshny::Frustum::Result::INTERSECTING);
+		Expect("Box behind is outside", frustum.ClassifyAABB(Neshny::Vec3(-1.0, -1.0, 120.0), Neshny::Vec3(1.0, 1.0, 130.0)) == Neshny::Frustum::Result::OUTSIDE);
+
+		// the planes have to agree with clipping the projected point, for any camera
+		Neshny::Camera3DFPS cam;
+		cam.p_Pos = Neshny::Vec3(10.0, 5.0, 80.0);
+		cam.p_Direction = Neshny::Quat(25.0, Neshny::Quat::Axis::Y) * Neshny::Quat(-10.0, Neshny::Quat::Axis::X);
+		auto view_perspective = cam.GetViewPerspectiveMatrix(1600, 900);
+		auto fps_frustum = cam.GetFrustum(1600, 900);
+		Neshny::RandomGenerator generator((uint64_t)39);
+		int disagreements = 0;
+		int inside = 0;
+		for (int i = 0; i < 100000; i++) {
+			Neshny::Vec3 pos(CullTestRandom(generator, -200.0, 200.0), CullTestRandom(generator, -200.0, 200.0), CullTestRandom(generator, -200.0, 200.0));
+			Neshny::Vec4 clip = view_perspective * Neshny::Vec4(pos, 1.0);
+			double margin = std::min({ clip.w - fabs(clip.x), clip.w - fabs(clip.y), clip.w - fabs(clip.z) });
+			if (fabs(margin) < 1e-6) {
+				continue;
+			}
+			inside += (margin > 0.0) ? 1 : 0;
+			disagreements += ((margin > 0.0) != fps_frustum.ContainsPoint(pos)) ? 1 : 0;
+		}
+		ExpectEqual("Planes match clip space", disagreements, 0);
+		Expect("Some points were inside", inside > 100);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FrustumCullSoA(void) {
+		auto frustum = MakeCullTestFrustum();
+		auto spheres = MakeCullTestSpheres(100003, 300.0, 7);
+
+		std::vector<int> visible;
+		Neshny::FrustumCullSpheres(frustum, spheres, visible);
+		std::vector<int> threaded;
+		bool same_threaded = true;
+		for (int threads : { 2, 4, 7 }) {
+			Neshny::FrustumCullSpheres(frustum, spheres, threaded, threads);
+			same_threaded = same_threaded && (threaded == visible);
+		}
+		Expect("Thread count does not change the result", same_threaded);
+		Expect("Ascending order", std::is_sorted(visible.begin(), visible.end()));
+
+		// the float SIMD test can only disagree with the double one for spheres right on a plane
+		int wrong = 0;
+		int expected_visible = 0;
+		size_t cursor = 0;
+		for (int i = 0; i < spheres.Size(); i++) {
+			Neshny::Vec3 centre(spheres.p_X[i], spheres.p_Y[i], spheres.p_Z[i]);
+			double radius = spheres.p_Radius[i];
+			bool found = (cursor < visible.size()) && (visible[cursor] == i);
+			cursor += found ? 1 : 0;
+			bool expected = frustum.IntersectsSphere(centre, radius);
+			expected_visible += expected ? 1 : 0;
+			bool borderline = frustum.IntersectsSphere(centre, radius + 0.001) != frustum.IntersectsSphere(centre, radius - 0.001);
+			wrong += ((found != expected) && !borderline) ? 1 : 0;
+		}
+		ExpectEqual("Spheres match the scalar test", wrong, 0);
+		Expect("A fair share is visible", (expected_visible > 1000) && (expected_visible < spheres.Size() / 2));
+
+		Neshny::AABBBoundsSoA boxes;
+		for (int i = 0; i < spheres.Size(); i++) {
+			Neshny::Vec3 centre(spheres.p_X[i], spheres.p_Y[i], spheres.p_Z[i]);
+			Neshny::Vec3 half(spheres.p_Radius[i], spheres.p_Radius[i] * 0.5, spheres.p_Radius[i] * 2.0);
+			boxes.Add(centre - half, centre + half);
+		}
+		std::vector<int> visible_boxes;
+		Neshny::FrustumCullAABBs(frustum, boxes, visible_boxes, 3);
+		wrong = 0;
+		cursor = 0;
+		for (int i = 0; i < boxes.Size(); i++) {
+			Neshny::Vec3 min_pos(boxes.p_MinX[i], boxes.p_MinY[i], boxes.p_MinZ[i]);
+			Neshny::Vec3 max_pos(boxes.p_MaxX[i], boxes.p_MaxY[i], boxes.p_MaxZ[i]);
+			bool found = (cursor < visible_boxes.size()) && (visible_boxes[cursor] == i);
+			cursor += found ? 1 : 0;
+			Neshny::Vec3 pad(0.001, 0.001, 0.001);
+			bool borderline = frustum.IntersectsAABB(min_pos - pad, max_pos + pad) != frustum.IntersectsAABB(min_pos + pad, max_pos - pad);
+			wrong += ((found != frustum.IntersectsAABB(min_pos, max_pos)) && !borderline) ? 1 : 0;
+		}
+		ExpectEqual("Boxes match the scalar test", wrong, 0);
+		ExpectEqual("Every box index accounted for", cursor, visible_boxes.size());
+
+		Neshny::SphereBoundsSoA none;
+		Neshny::FrustumCullSpheres(frustum, none, visible, 4);
+		Expect("Nothing in, nothing out", visible.empty());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_CullGrid(void) {
+		auto frustum = MakeCullTestFrustum();
+		auto spheres = MakeCullTestSpheres(200000, 300.0, 11);
+
+		std::vector<int> flat;
+		Neshny::FrustumCullSpheres(frustum, spheres, flat);
+
+		Neshny::CullGrid grid(20.0);
+		grid.Build(spheres);
+		ExpectEqual("Every sphere is in the grid", grid.GetNumSpheres(), spheres.Size());
+
+		std::vector<int> visible;
+		auto stats = grid.Cull(frustum, visible);
+		ExpectEqual("Stats count the visible spheres", stats.p_Visible, (int)visible.size());
+		ExpectEqual("Every cell is classified", stats.p_CellsOutside + stats.p_CellsInside + stats.p_CellsIntersecting, grid.GetNumCells());
+		Expect("Whole cells get skipped and accepted", (stats.p_CellsOutside > 0) && (stats.p_CellsInside > 0) && (stats.p_SpheresTested < spheres.Size() / 4));
+
+		std::vector<int> threaded;
+		bool same_threaded = true;
+		for (int threads : { 3, 5, 8 }) {
+			auto threaded_stats = grid.Cull(frustum, threaded, threads);
+			same_threaded = same_threaded && (threaded == visible) && (threaded_stats.p_SpheresTested == stats.p_SpheresTested);
+		}
+		Expect("Thread count does not change the result", same_threaded);
+
+		std::sort(visible.begin(), visible.end());
+		Expect("Finds the same spheres as the flat cull", visible == flat);
+
+		// everything in one spot, and a cap on the cells, still works
+		Neshny::SphereBoundsSoA clumped;
+		for (int i = 0; i < 1000; i++) {
+			clumped.Add(Neshny::Vec3(0.0, 0.0, 0.0), 1.0);
+		}
+		clumped.Add(Neshny::Vec3(1e6, 0.0, 0.0), 1.0);
+		Neshny::CullGrid capped(0.001, 8);
+		capped.Build(clumped);
+		Expect("Cells capped per axis", capped.GetNumCells() <= 8 * 8 * 8);
+		Neshny::Camera3DOrbit orbit;
+		orbit.p_Zoom = 100.0;
+		capped.Cull(orbit.GetFrustum(100, 100), visible);
+		ExpectEqual("Clump is visible", (int)visible.size(), 1000);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct CullBenchmarkResult {
+		int		p_Count;
+		double	p_ScalarMs;
+		double	p_SIMDMs;
+		double	p_ThreadedMs;
+		double	p_GridMs;
+		bool	p_Matches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// not a unit test on its own - culls the same spheres with the plain double loop, the SIMD kernel, the SIMD kernel on threads and the grid, best of a few runs
+	CullBenchmarkResult BenchmarkCulling(int count, int threads) {
+		auto frustum = MakeCullTestFrustum();
+		auto spheres = MakeCullTestSpheres(count, 300.0, 5);
+		std::vector<Neshny::Vec3> centres;
+		std::vector<double> radii;
+		for (int i = 0; i < count; i++) {
+			centres.push_back(Neshny::Vec3(spheres.p_X[i], spheres.p_Y[i], spheres.p_Z[i]));
+			radii.push_back(spheres.p_Radius[i]);
+		}
+		Neshny::CullGrid grid(20.0);
+		grid.Build(spheres);
+
+		std::vector<int> visible;
+		auto best_ms = [&visible](auto&& cull_func) {
+			double best_seconds = std::numeric_limits<double>::max();
+			for (int run = 0; run < 3; run++) {
+				auto start = std::chrono::high_resolution_clock::now();
+				cull_func();
+				best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			return best_seconds * 1000.0;
+		};
+		double scalar = best_ms([&]() {
+			visible.clear();
+			for (int i = 0; i < count; i++) {
+				if (frustum.IntersectsSphere(centres[i], radii[i])) {
+					visible.push_back(i);
+				}
+			}
+		});
+		std::vector<int> scalar_visible = visible;
+		double simd = best_ms([&]() { Neshny::FrustumCullSpheres(frustum, spheres, visible); });
+		bool matches = visible == scalar_visible;
+		double threaded = best_ms([&]() { Neshny::FrustumCullSpheres(frustum, spheres, visible, threads); });
+		matches = matches && (visible == scalar_visible);
+		double grid_ms = best_ms([&]() { grid.Cull(frustum, visible, threads); });
+		std::sort(visible.begin(), visible.end());
+		matches = matches && (visible == scalar_visible);
+		return { count, scalar, simd, threaded, grid_ms, matches };
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_CullingBenchmark(void) {
+		auto result = BenchmarkCulling(1000000, 4);
+		Neshny::Core::Log(std::format("Culling 1M spheres takes {:.2f} ms with the scalar loop, {:.2f} ms with SIMD, {:.2f} ms on 4 threads and {:.2f} ms with the grid", result.p_ScalarMs, result.p_SIMDMs, result.p_ThreadedMs, result.p_GridMs));
+		Expect("Every way of culling finds the same spheres", result.p_Matches);
+	}
+
+} // namespace Test
@@ -0,0 +1,277 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct SnapshotTestEntity {
+		int					p_Id;
+		Neshny::fVec3		p_Pos;
+		Neshny::fVec3		p_Vel;
+		int					p_State;
+		float				p_Health;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	Neshny::StructInfo SnapshotTestInfo(void) {
+		Neshny::StructInfo info;
+		info.p_Members = {
+			{ "Id", Neshny::MemberSpec::T_INT, sizeof(int) },
+			{ "Pos", Neshny::MemberSpec::T_VEC3, sizeof(float) * 3 },
+			{ "Vel", Neshny::MemberSpec::T_VEC3, sizeof(float) * 3 },
+			{ "State", Neshny::MemberSpec::T_INT, sizeof(int) },
+			{ "Health", Neshny::MemberSpec::T_FLOAT, sizeof(float) }
+		};
+		return info;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	float SnapshotTestRandom(Neshny::RandomGenerator& generator, float min_val, float max_val) {
+		return min_val + (float)((double)generator.Next() / 4294967296.0) * (max_val - min_val);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// a STABLE_WITH_GAPS style buffer, every tenth slot is a hole
+	std::vector<SnapshotTestEntity> MakeSnapshotTestEntities(int count, Neshny::RandomGenerator& generator, int& next_id) {
+		std::vector<SnapshotTestEntity> items(count);
+		for (int i = 0; i < count; i++) {
+			auto& item = items[i];
+			item.p_Id = (i % 10 == 9) ? -1 : next_id++;
+			item.p_Pos = Neshny::fVec3(SnapshotTestRandom(generator, -500.0f, 500.0f), SnapshotTestRandom(generator, -500.0f, 500.0f), SnapshotTestRandom(generator, -500.0f, 500.0f));
+			item.p_Vel = Neshny::fVec3(SnapshotTestRandom(generator, -1.0f, 1.0f), SnapshotTestRandom(generator, -1.0f, 1.0f), SnapshotTestRandom(generator, -1.0f, 1.0f));
+			item.p_State = (int)generator.NextBounded(4);
+			item.p_Health = 100.0f;
+		}
+		return items;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// one simulation step, a fraction of entities move, a few change state, some die and some are born
+	void StepSnapshotTestEntities(std::vector<SnapshotTestEntity>& items, Neshny::RandomGenerator& generator, int& next_id, int moving_percent) {
+		for (auto& item : items) {
+			if (item.p_Id < 0) {
+				continue;
+			}
+			if ((int)generator.NextBounded(100) < moving_percent) {
+				item.p_Pos = item.p_Pos + item.p_Vel;
+			}
+			if (generator.NextBounded(200) == 0) {
+				item.p_State = (item.p_State + 1) % 4;
+				item.p_Health -= 10.0f;
+			}
+			if (generator.NextBounded(500) == 0) {
+				item.p_Id = -1;
+			}
+		}
+		for (auto& item : items) {
+			if ((item.p_Id < 0) && (generator.NextBounded(20) == 0)) {
+				item.p_Id = next_id++;
+				item.p_Pos = Neshny::fVec3(SnapshotTestRandom(generator, -500.0f, 500.0f), 0.0f, 0.0f);
+				item.p_Vel = Neshny::fVec3(0.0f, 1.0f, 0.0f);
+				item.p_State = 0;
+				item.p_Health = 100.0f;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// live entities only, in order of id, so two snapshots laid out differently can be compared
+	std::vector<SnapshotTestEntity> SnapshotTestById(std::span<const int> snapshot) {
+		auto items = Neshny::EntityDeltaCodec::FromSnapshot<SnapshotTestEntity>(snapshot);
+		items.erase(std::remove_if(items.begin(), items.end(), [](const SnapshotTestEntity& item) { return item.p_Id < 0; }), items.end());
+		std::sort(items.begin(), items.end(), [](const SnapshotTestEntity& a, const SnapshotTestEntity& b) { return a.p_Id < b.p_Id; });
+		return items;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	bool SnapshotTestMatches(std::span<const int> a, std::span<const int> b, float tolerance) {
+		auto items_a = SnapshotTestById(a);
+		auto items_b = SnapshotTestById(b);
+		if (items_a.size() != items_b.size()) {
+			return false;
+		}
+		auto close = [tolerance](Neshny::fVec3 u, Neshny::fVec3 v) {
+			return (fabs(u.x - v.x) <= tolerance) && (fabs(u.y - v.y) <= tolerance) && (fabs(u.z - v.z) <= tolerance);
+		};
+		for (int i = 0; i < (int)items_a.size(); i++) {
+			const auto& item_a = items_a[i];
+			const auto& item_b = items_b[i];
+			if ((item_a.p_Id != item_b.p_Id) || (item_a.p_State != item_b.p_State) || (item_a.p_Health != item_b.p_Health) || !close(item_a.p_Pos, item_b.p_Pos) || !close(item_a.p_Vel, item_b.p_Vel)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityDeltaRoundTrip(void) {
+
+		Neshny::EntityDeltaCodec codec(SnapshotTestInfo(), "Id");
+		ExpectEqual("Nine ints an item", codec.GetIntsPerItem(), 9);
+		ExpectEqual("Id is the first", codec.GetIdOffset(), 0);
+		Expect("Only floats quantise", codec.SetQuantisation("Pos", 0.01f) && !codec.SetQuantisation("State", 1.0f) && !codec.SetQuantisation("Missing", 1.0f));
+		codec.SetQuantisation("Pos", 0.0f);
+
+		Neshny::RandomGenerator generator((uint64_t)7);
+		int next_id = 0;
+		auto items = MakeSnapshotTestEntities(20000, generator, next_id);
+		auto baseline = Neshny::EntityDeltaCodec::ToSnapshot(items);
+		StepSnapshotTestEntities(items, generator, next_id, 30);
+		// a compacting buffer moves entities around without changing them
+		std::reverse(items.begin(), items.end());
+		auto current = Neshny::EntityDeltaCodec::ToSnapshot(items);
+
+		Neshny::EntityDeltaStats stats;
+		auto delta = codec.Encode(baseline, current, 1, &stats);
+		Expect("Some were created, deleted and changed", (stats.p_Created > 0) && (stats.p_Deleted > 0) && (stats.p_Changed > 0));
+		Expect(std::format("Delta is smaller than the snapshot ({} vs {} bytes)", delta.size(), current.size() * sizeof(int)), delta.size() < current.size() * sizeof(int));
+
+		auto threaded_delta = codec.Encode(baseline, current, 4, &stats);
+		Expect("Threads were used", stats.p_Threads > 1);
+		Expect("Threaded delta is byte for byte the same", threaded_delta == delta);
+
+		std::string err;
+		auto applied = baseline;
+		Expect("Delta applies", codec.Apply(applied, delta, err));
+		Expect("Exact delta reproduces every entity", SnapshotTestMatches(applied, current, 0.0f));
+		auto threaded_applied = baseline;
+		Expect("Threaded apply", codec.Apply(threaded_applied, delta, err, 4));
+		Expect("Threaded apply gives the same snapshot", threaded_applied == applied);
+
+		// the applied snapshot is laid out differently to current, but holds the same entities
+		auto empty_delta = codec.Encode(applied, current);
+		Expect(std::format("Nothing changed is a few bytes ({})", empty_delta.size()), empty_delta.size() < 64);
+
+		auto untouched = current;
+		Expect("A delta does not apply to the wrong baseline", !codec.Apply(untouched, delta, err));
+		Expect("Failing leaves the snapshot alone", untouched == current);
+		auto truncated = delta;
+		truncated.resize(truncated.size() / 2);
+		auto truncated_target = baseline;
+		Expect("A truncated delta does not apply", !codec.Apply(truncated_target, truncated, err));
+		Expect("Truncated leaves the snapshot alone", truncated_target == baseline);
+
+		auto keyframe = codec.Encode({}, current);
+		auto from_keyframe = untouched;
+		Expect("A keyframe applies to anything", codec.Apply(from_keyframe, keyframe, err));
+		Expect("Keyframe reproduces every entity", SnapshotTestMatches(from_keyframe, current, 0.0f));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityDeltaQuantisedOverflow(void) {
+
+		// a step this small puts both healths at the ends of the quantised range
+		Neshny::EntityDeltaCodec codec(SnapshotTestInfo(), "Id");
+		codec.SetQuantisation("Health", 1.0e-30f);
+		std::vector<SnapshotTestEntity> items(1);
+		items[0].p_Id = 0;
+		items[0].p_Health = 3.0e38f;
+		auto baseline = Neshny::EntityDeltaCodec::ToSnapshot(items);
+		items[0].p_Health = -3.0e38f;
+		auto current = Neshny::EntityDeltaCodec::ToSnapshot(items);
+
+		std::string err;
+		auto delta = codec.Encode(baseline, current);
+		auto applied = baseline;
+		Expect("The largest quantised change applies", codec.Apply(applied, delta, err));
+
+		// health is the last field, so its one payload ends the delta, the same length as one that would go past an int64
+		std::vector<unsigned char> too_far;
+		Neshny::DeltaCoding::PutVarint(too_far, Neshny::DeltaCoding::ZigZag(9000000000000000000));
+		auto damaged = delta;
+		std::copy(too_far.begin(), too_far.end(), damaged.end() - too_far.size());
+		auto damaged_target = baseline;
+		Expect("A change past the quantised range does not apply", !codec.Apply(damaged_target, damaged, err));
+		Expect("Overflowing leaves the snapshot alone", damaged_target == baseline);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityReplicationLoopback(void) {
+
+		const float step = 1.0f / 64.0f;
+		Neshny::EntityDeltaCodec codec(SnapshotTestInfo(), "Id");
+		codec.SetQuantisation("Pos", step);
+		codec.SetQuantisation("Vel", step);
+
+		Neshny::LoopbackTransport transport;
+		Neshny::EntityReplicationSender sender(codec, transport);
+		Neshny::EntityReplicationReceiver receiver(codec, transport);
+
+		Neshny::RandomGenerator generator((uint64_t)11);
+		int next_id = 0;
+		auto items = MakeSnapshotTestEntities(2000, generator, next_id);
+		bool in_step = true;
+		bool close = true;
+		bool received = true;
+		std::string err;
+		for (int frame = 0; frame < 60; frame++) {
+			StepSnapshotTestEntities(items, generator, next_id, 50);
+			auto current = Neshny::EntityDeltaCodec::ToSnapshot(items);
+			sender.Send(current);
+			// the receiver lags a frame behind now and then, and catches up on both packets at once
+			if (frame % 7 == 2) {
+				continue;
+			}
+			received = received && receiver.Receive(err);
+			in_step = in_step && (receiver.GetSnapshot() == sender.GetBaseline());
+			close = close && SnapshotTestMatches(receiver.GetSnapshot(), current, step * 0.5f + 0.0001f);
+		}
+		Expect("Every packet applied", received);
+		ExpectEqual("All sixty applied", (int)receiver.GetApplied(), 60);
+		Expect("Receiver matches the sender's baseline exactly", in_step);
+		Expect("Quantised positions are within half a step", close);
+
+		sender.Reset();
+		sender.Send(Neshny::EntityDeltaCodec::ToSnapshot(items));
+		Expect("A reset sends a keyframe the receiver takes", receiver.Receive(err) && (receiver.GetSnapshot() == sender.GetBaseline()));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityDeltaBenchmark(void) {
+
+		const int count = 200000;
+		const int frames = 10;
+		Neshny::EntityDeltaCodec codec(SnapshotTestInfo(), "Id");
+		codec.SetQuantisation("Pos", 1.0f / 64.0f);
+		codec.SetQuantisation("Vel", 1.0f / 64.0f);
+
+		Neshny::RandomGenerator generator((uint64_t)3);
+		int next_id = 0;
+		auto items = MakeSnapshotTestEntities(count, generator, next_id);
+		std::vector<std::vector<int>> snapshots = { Neshny::EntityDeltaCodec::ToSnapshot(items) };
+		for (int frame = 0; frame < frames; frame++) {
+			StepSnapshotTestEntities(items, generator, next_id, 10);
+			snapshots.push_back(Neshny::EntityDeltaCodec::ToSnapshot(items));
+		}
+
+		// the sender's side, encoding against what the receiver will have
+		auto time_run = [&](int thread_count, uint64_t& bytes, double& encode_ms, double& apply_ms) {
+			std::vector<int> baseline = snapshots[0];
+			std::string err;
+			bytes = 0;
+			encode_ms = 0.0;
+			apply_ms = 0.0;
+			for (int frame = 1; frame <= frames; frame++) {
+				auto start = std::chrono::steady_clock::now();
+				auto delta = codec.Encode(baseline, snapshots[frame], thread_count);
+				auto mid = std::chrono::steady_clock::now();
+				codec.Apply(baseline, delta, err, thread_count);
+				auto end = std::chrono::steady_clock::now();
+				bytes += delta.size();
+				encode_ms += std::chrono::duration<double, std::milli>(mid - start).count() / frames;
+				apply_ms += std::chrono::duration<double, std::milli>(end - mid).count() / frames;
+			}
+		};
+		uint64_t bytes, threaded_bytes;
+		double encode_ms, apply_ms, threaded_encode_ms, threaded_apply_ms;
+		time_run(1, bytes, encode_ms, apply_ms);
+		time_run(4, threaded_bytes, threaded_encode_ms, threaded_apply_ms);
+
+		const double full_bytes = (double)snapshots[0].size() * sizeof(int);
+		const double delta_bytes = (double)bytes / frames;
+		Neshny::Core::Log(std::format("Deltas of 200k entities with 10% moving are {:.0f} KB a frame against {:.0f} KB for the full snapshot", delta_bytes / 1024.0, full_bytes / 1024.0));
+		Neshny::Core::Log(std::format("Encode {:.2f} ms and apply {:.2f} ms a frame, {:.2f} ms and {:.2f} ms on 4 threads ({:.0f} MB/s of snapshot encoded)", encode_ms, apply_ms, threaded_encode_ms, threaded_apply_ms, full_bytes / 1048576.0 / (encode_ms / 1000.0)));
+		Expect("Deltas are a small part of the full snapshot", delta_bytes * 5.0 < full_bytes);
+		ExpectEqual("Threads do not change the deltas", threaded_bytes, bytes);
+	}
+
+}
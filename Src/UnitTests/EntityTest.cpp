@@ -190,18 +190,23 @@ namespace Test {
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
-	void GPUEntityTest(bool moving_compact_mode) {
+	void GPUEntityTest(bool moving_compact_mode, bool soa_layout = false, bool ordered_compaction = false) {
 
 #if defined(NESHNY_GL)
 		Neshny::GPUEntity::DeleteMode mode = moving_compact_mode ? Neshny::GPUEntity::DeleteMode::MOVING_COMPACT : Neshny::GPUEntity::DeleteMode::STABLE_WITH_GAPS;
 		Neshny::GPUEntity entities("Thing", mode, &GPUThing::p_Id, "Id");
 		Neshny::GPUEntity other_entities("Other", mode, &GPUOther::p_Id, "Id");
+		if (ordered_compaction) {
+			entities.SetCompactMode(Neshny::GPUEntity::CompactMode::PREFIX_SUM);
+			other_entities.SetCompactMode(Neshny::GPUEntity::CompactMode::PREFIX_SUM);
+		}
 #elif defined(NESHNY_WEBGPU)
 		if (moving_compact_mode) {
 			return;
 		}
-		Neshny::GPUEntity entities("Thing", &GPUThing::p_Id, "Id");
-		Neshny::GPUEntity other_entities("Other", &GPUOther::p_Id, "Id");
+		Neshny::EntityLayout layout = soa_layout ? Neshny::EntityLayout::SOA : Neshny::EntityLayout::AOS;
+		Neshny::GPUEntity entities("Thing", &GPUThing::p_Id, "Id", true, layout);
+		Neshny::GPUEntity other_entities("Other", &GPUOther::p_Id, "Id", true, layout);
 #endif
 
 		entities.Init(1000);
@@ -214,6 +219,43 @@ namespace Test {
 			GPUThing thing = GPUThing::Init(i);
 			expected.push_back(thing);
 		}
+#if defined(NESHNY_WEBGPU)
+		if (soa_layout) {
+			std::vector<GPUThing> too_many(1001);
+			int throws = 0;
+			try {
+				entities.SetInstances(too_many);
+			} catch (const std::invalid_argument&) {
+				throws++;
+			}
+			try {
+				entities.AddInstances(too_many);
+			} catch (const std::invalid_argument&) {
+				throws++;
+			}
+			ExpectEqual("Going over the SOA capacity throws", throws, 2);
+
+			// the bound has to count what is already placed, not just the new batch
+			std::vector<GPUThing> most(900);
+			std::vector<GPUThing> overflow(200);
+			std::vector<GPUThing> rest(100);
+			entities.SetInstances(most);
+			bool overfill_throws = false;
+			try {
+				entities.AddInstances(overflow);
+			} catch (const std::invalid_argument&) {
+				overfill_throws = true;
+			}
+			Expect("Adding past the SOA capacity of a filled entity throws", overfill_throws);
+			auto placements = entities.AddInstancesSync(rest);
+			bool all_placed = true;
+			for (const auto& placement : placements) {
+				all_placed = all_placed && (placement.p_Index >= 900) && (placement.p_Index < 1000);
+			}
+			Expect("Filling the SOA entity up to capacity places everything in its column", all_placed);
+			ExpectEqual("Filled SOA entity count", entities.GetCountSync(), 1000);
+		}
+#endif
 		entities.SetInstances(expected); // test needs creation order to be preserved
 
 		std::vector<int> buffer_values;
@@ -412,6 +454,9 @@ namespace Test {
 #endif
 
 		CompareEntities("After deletion", expected, gpu_values);
+		if (ordered_compaction) {
+			Expect("Ordered compaction keeps survivors in creation order", std::is_sorted(gpu_values.begin(), gpu_values.end(), [](const GPUThing& a, const GPUThing& b) { return a.p_Id < b.p_Id; }));
+		}
 
 		std::vector<GPUThing> entities_to_add;
 		for (int i = 0; i < 10; i++) {
@@ -453,7 +498,388 @@ namespace Test {
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
-	void GPUEntityCache2D(bool use_cursor) {
+	void UnitTest_GPUEntityMovingOrdered(void) {
+		GPUEntityTest(true, false, true);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GPUEntitySoA(void) {
+#if defined(NESHNY_WEBGPU)
+		GPUEntityTest(false, true);
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityLayoutTranspose(void) {
+#if defined(NESHNY_WEBGPU)
+		const int count = 37;
+		const int stride = 50;
+		const int floats_per = sizeof(GPUThing) / sizeof(int);
+
+		std::vector<GPUThing> things;
+		for (int i = 0; i < count; i++) {
+			things.push_back(GPUThing::Init(i));
+		}
+		std::vector<int> columns(floats_per * stride, -1);
+		Neshny::TransposeEntityToSoA((int*)things.data(), columns.data(), count, floats_per, stride);
+
+		ExpectEqual("First column is the ids", columns[5], 5);
+		ExpectEqual("Column padding untouched", columns[count], -1);
+		ExpectEqual("Second column starts at the stride", columns[stride + 7], things[7].p_Int);
+
+		std::vector<GPUThing> round_trip(count);
+		Neshny::TransposeEntityToAoS(columns.data(), (int*)round_trip.data(), count, floats_per, stride);
+		Expect("Round trip is byte identical", memcmp(things.data(), round_trip.data(), count * sizeof(GPUThing)) == 0);
+
+		// CPU reference for the bandwidth difference - a pass that only touches one member of a wide struct
+		const int big_count = 1 << 18;
+		std::vector<GPUThing> big_aos(big_count);
+		for (int i = 0; i < big_count; i++) {
+			big_aos[i] = GPUThing::Init(i);
+		}
+		std::vector<int> big_soa(floats_per * big_count);
+		Neshny::TransposeEntityToSoA((int*)big_aos.data(), big_soa.data(), big_count, floats_per, big_count);
+		const int float_column = offsetof(GPUThing, p_Float) / sizeof(int);
+
+		auto time_pass = [](auto&& pass) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int rep = 0; rep < 8; rep++) {
+				pass();
+			}
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+		double aos_ms = time_pass([&big_aos]() {
+			for (auto& item : big_aos) {
+				item.p_Float += 1.0f;
+			}
+		});
+		double soa_ms = time_pass([&big_soa, float_column, big_count]() {
+			float* column = (float*)(big_soa.data() + float_column * big_count);
+			for (int i = 0; i < big_count; i++) {
+				column[i] += 1.0f;
+			}
+		});
+		Neshny::TransposeEntityToAoS(big_soa.data(), (int*)round_trip.data(), 1, floats_per, big_count);
+		ExpectEqual("SOA column updated", round_trip[0].p_Float, big_aos[0].p_Float);
+		Neshny::Core::Log(std::format("Single member pass touches {}x fewer bytes as SOA ({:.2f}ms AOS, {:.2f}ms SOA)", floats_per, aos_ms, soa_ms));
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityDefragPlan(void) {
+
+		// holes at 1, 3, 4 and 8, live at the end
+		std::vector<int> ids = { 10, -1, 12, -1, -1, 15, 16, 17, -1, 19, 20 };
+		auto plan = Neshny::EntityDefragPlan::Create(ids);
+
+		ExpectEqual("Live count", plan.p_LiveCount, 7);
+		ExpectEqual("Fully compacted max index", plan.p_NewMaxIndex, 7);
+		Expect("Complete", plan.p_Complete);
+		Expect("No free slots left", plan.p_FreeList.empty());
+		ExpectEqual("Three moves", (int)plan.p_Moves.size(), 3);
+		ExpectEqual("Last entity into first hole", plan.p_Remap[10], 1);
+		ExpectEqual("Next into second hole", plan.p_Remap[9], 3);
+		ExpectEqual("Then third", plan.p_Remap[7], 4);
+		ExpectEqual("Untouched keeps index", plan.p_Remap[5], 5);
+		ExpectEqual("Holes remap to nothing", plan.p_Remap[8], -1);
+
+		const int floats_per = 3;
+		const int stride = 16;
+		std::vector<int> aos;
+		std::vector<int> soa(floats_per * stride, 0);
+		for (int i = 0; i < (int)ids.size(); i++) {
+			for (int f = 0; f < floats_per; f++) {
+				int value = f == 0 ? ids[i] : ids[i] * 100 + f;
+				aos.push_back(value);
+				soa[f * stride + i] = value;
+			}
+		}
+		plan.Apply(aos.data(), floats_per, 0);
+		plan.Apply(soa.data(), floats_per, 0, stride);
+		for (int old_index = 0; old_index < (int)ids.size(); old_index++) {
+			int new_index = plan.p_Remap[old_index];
+			if (new_index < 0) {
+				continue;
+			}
+			ExpectEqual("AOS entity moved with its data", aos[new_index * floats_per + 2], ids[old_index] * 100 + 2);
+			ExpectEqual("SOA entity moved with its data", soa[2 * stride + new_index], ids[old_index] * 100 + 2);
+		}
+		ExpectEqual("Vacated slot marked dead", aos[10 * floats_per], -1);
+
+		// budgeted passes converge on the same result
+		std::vector<int> budget_ids = ids;
+		int passes = 0;
+		while (true) {
+			auto step = Neshny::EntityDefragPlan::Create(budget_ids, 1);
+			step.Apply(budget_ids.data(), 1, 0);
+			budget_ids.resize(step.p_NewMaxIndex);
+			passes++;
+			if (step.p_Complete) {
+				break;
+			}
+			if (passes == 1) {
+				ExpectEqual("A partial pass frees the tail", step.p_NewMaxIndex, 10);
+				ExpectEqual("A partial pass leaves the lowest hole on top of the free list", step.p_FreeList.back(), 3);
+			}
+			Expect("Partial pass keeps a free list", !step.p_FreeList.empty());
+		}
+		ExpectEqual("One move per pass", passes, 3);
+		ExpectEqual("Budgeted size", (int)budget_ids.size(), 7);
+		for (int id : budget_ids) {
+			Expect("Budgeted passes leave no holes", id >= 0);
+		}
+
+		auto nothing = Neshny::EntityDefragPlan::Create({ 1, 2, 3 });
+		Expect("Already compact buffer needs no moves", nothing.p_Moves.empty() && (nothing.p_NewMaxIndex == 3));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// what the EntityCompact shader does, block by block and level by level, to check the levels add up to the reference
+	std::vector<int> EntityCompactionTestBlockedScan(const std::vector<int>& ids) {
+		const int block_size = Neshny::EntityCompaction::SCAN_BLOCK_SIZE;
+		const auto levels = Neshny::EntityCompaction::GetLevels((int)ids.size());
+		std::vector<int> scan(levels.back().p_Offset + 1, -999);
+		for (int level = 0; level < (int)levels.size() - 1; level++) {
+			const int offset = levels[level].p_Offset;
+			const int count = levels[level].p_Count;
+			for (int block = 0; block * block_size < count; block++) {
+				int sum = 0;
+				for (int i = block * block_size; i < std::min(count, (block + 1) * block_size); i++) {
+					const int value = level == 0 ? (ids[i] >= 0 ? 1 : 0) : scan[offset + i];
+					scan[offset + i] = sum;
+					sum += value;
+				}
+				scan[levels[level + 1].p_Offset + block] = sum;
+			}
+		}
+		for (int level = (int)levels.size() - 3; level >= 0; level--) {
+			for (int i = 0; i < levels[level].p_Count; i++) {
+				scan[levels[level].p_Offset + i] += scan[levels[level + 1].p_Offset + i / block_size];
+			}
+		}
+		scan.resize(ids.size() + 1);
+		scan.back() = ids.empty() ? 0 : scan[levels.back().p_Offset];
+		return scan;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// what Death.comp does, with its atomic counter as a plain int so each run follows the order of the death list
+	void EntityCompactionTestFillFromEnd(std::vector<int>& data, int floats_per, int count, const std::vector<int>& deaths) {
+		const int remain_goal = count - (int)deaths.size();
+		int end_counter = 0;
+		for (int dead_index : deaths) {
+			if (dead_index >= remain_goal) {
+				continue;
+			}
+			while (true) {
+				const int alive_index = count - (end_counter++) - 1;
+				if (data[alive_index * floats_per] >= 0) {
+					std::copy(data.begin() + alive_index * floats_per, data.begin() + (alive_index + 1) * floats_per, data.begin() + dead_index * floats_per);
+					break;
+				}
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityCompaction(void) {
+
+		std::vector<int> ids = { 10, -1, 12, -1, -1, 15, 16, 17, -1, 19, 20 };
+		auto compaction = Neshny::EntityCompaction::Create(ids);
+		ExpectEqual("Live count", compaction.p_LiveCount, 7);
+		Expect("Survivors keep their order", compaction.p_Remap == std::vector<int>{ 0, -1, 1, -1, -1, 2, 3, 4, -1, 5, 6 });
+
+		const int floats_per = 3;
+		const int stride = 16;
+		std::vector<int> aos;
+		std::vector<int> soa(floats_per * stride, 0);
+		for (int i = 0; i < (int)ids.size(); i++) {
+			for (int f = 0; f < floats_per; f++) {
+				int value = f == 0 ? ids[i] : ids[i] * 100 + f;
+				aos.push_back(value);
+				soa[f * stride + i] = value;
+			}
+		}
+		std::vector<int> before = aos;
+		compaction.Apply(aos.data(), floats_per);
+		compaction.Apply(soa.data(), floats_per, stride);
+		std::vector<int> survivors;
+		for (int i = 0; i < (int)ids.size(); i++) {
+			if (ids[i] >= 0) {
+				survivors.insert(survivors.end(), before.begin() + i * floats_per, before.begin() + (i + 1) * floats_per);
+			}
+		}
+		Expect("AOS survivors packed in order with their data", std::equal(survivors.begin(), survivors.end(), aos.begin()));
+		Expect("SOA survivors packed in order with their data", (soa[0] == 10) && (soa[6] == 20) && (soa[2 * stride + 6] == 2002));
+		Expect("Slots past the live count are left alone", std::equal(before.begin() + 7 * floats_per, before.end(), aos.begin() + 7 * floats_per));
+
+		// sizes either side of a block and of a second level, so every level the shaders use gets checked
+		Neshny::RandomGenerator generator((uint64_t)5);
+		const int block_size = Neshny::EntityCompaction::SCAN_BLOCK_SIZE;
+		for (int count : { 0, 1, block_size - 1, block_size, block_size + 1, 20000, block_size * block_size, block_size * block_size + 1 }) {
+			std::vector<int> random_ids(count);
+			for (int i = 0; i < count; i++) {
+				random_ids[i] = generator.NextBounded(3) == 0 ? -1 : i;
+			}
+			auto reference = Neshny::EntityCompaction::Create(random_ids);
+			auto scan = EntityCompactionTestBlockedScan(random_ids);
+			bool same = scan.back() == reference.p_LiveCount;
+			for (int i = 0; (i < count) && same; i++) {
+				same = (reference.p_Remap[i] < 0) || (reference.p_Remap[i] == scan[i]);
+			}
+			Expect(std::format("Blocked scan of {} matches the reference", count), same);
+		}
+		ExpectEqual("One block is a scan, the scatter and the copy", Neshny::EntityCompaction::GetPassCount(block_size), 3);
+		ExpectEqual("Two levels add a scan and an add", Neshny::EntityCompaction::GetPassCount(block_size + 1), 5);
+		ExpectEqual("Passes grow with the log of the count", Neshny::EntityCompaction::GetPassCount(block_size * block_size + 1), 7);
+
+		// the old way depends on the order deaths were recorded in, the prefix sum does not
+		std::vector<int> data(1000);
+		std::vector<int> deaths;
+		for (int i = 0; i < (int)data.size(); i++) {
+			data[i] = (i % 7 == 0) || (i > 900 && i < 950) ? -1 : i;
+			if (data[i] < 0) {
+				deaths.push_back(i);
+			}
+		}
+		std::vector<int> forward = data;
+		std::vector<int> backward = data;
+		EntityCompactionTestFillFromEnd(forward, 1, (int)data.size(), deaths);
+		std::reverse(deaths.begin(), deaths.end());
+		EntityCompactionTestFillFromEnd(backward, 1, (int)data.size(), deaths);
+		const int live_count = (int)data.size() - (int)deaths.size();
+		Expect("Filling from the end gives a different layout for a different death order", !std::equal(forward.begin(), forward.begin() + live_count, backward.begin()));
+		std::vector<int> ordered = data;
+		Neshny::EntityCompaction::Create(data).Apply(ordered.data(), 1);
+		Expect("Prefix sum compaction keeps the survivors sorted", std::is_sorted(ordered.begin(), ordered.begin() + live_count) && (ordered[live_count - 1] == 999));
+		std::sort(forward.begin(), forward.begin() + live_count);
+		Expect("Both keep the same survivors", std::equal(forward.begin(), forward.begin() + live_count, ordered.begin()));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_EntityCompactionBenchmark(void) {
+
+		// the CPU path of both, over entities of 16 floats with deaths spread at random
+		const int floats_per = 16;
+		Neshny::RandomGenerator generator((uint64_t)11);
+		std::string report;
+		bool same_survivors = true;
+		for (int count : { 10000, 100000, 1000000 }) {
+			for (int death_percent : { 1, 10, 50 }) {
+				std::vector<int> data(count * floats_per);
+				std::vector<int> ids(count);
+				std::vector<int> deaths;
+				for (int i = 0; i < count; i++) {
+					ids[i] = (int)generator.NextBounded(100) < death_percent ? -1 : i;
+					std::fill(data.begin() + i * floats_per, data.begin() + (i + 1) * floats_per, i);
+					data[i * floats_per] = ids[i];
+					if (ids[i] < 0) {
+						deaths.push_back(i);
+					}
+				}
+				// the shader appends deaths with an atomic so their order is arbitrary
+				for (int i = (int)deaths.size() - 1; i > 0; i--) {
+					std::swap(deaths[i], deaths[generator.NextBounded(i + 1)]);
+				}
+
+				std::vector<int> fill_data = data;
+				auto start = std::chrono::steady_clock::now();
+				EntityCompactionTestFillFromEnd(fill_data, floats_per, count, deaths);
+				double fill_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				std::vector<int> prefix_data = data;
+				start = std::chrono::steady_clock::now();
+				Neshny::EntityCompaction::Create(ids).Apply(prefix_data.data(), floats_per);
+				double prefix_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				const int live_count = count - (int)deaths.size();
+				std::vector<int> fill_ids(live_count);
+				for (int i = 0; i < live_count; i++) {
+					fill_ids[i] = fill_data[i * floats_per];
+					same_survivors = same_survivors && (fill_data[i * floats_per + 1] == fill_ids[i]) && (prefix_data[i * floats_per + 1] == prefix_data[i * floats_per]);
+				}
+				std::sort(fill_ids.begin(), fill_ids.end());
+				for (int i = 0; i < live_count; i++) {
+					same_survivors = same_survivors && (fill_ids[i] == prefix_data[i * floats_per]);
+				}
+				report += std::format("{}{}k at {}% {:.2f}/{:.2f}", report.empty() ? "" : ", ", count / 1000, death_percent, fill_ms, prefix_ms);
+			}
+		}
+		Neshny::Core::Log(std::format("Compaction ms filling from the end / by prefix sum - {}", report));
+		Expect("Both compactions keep the same survivors", same_survivors);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void GPUEntityDefrag(bool soa_layout) {
+
+		const int initial_count = 60;
+		std::vector<GPUThing> things;
+		for (int i = 0; i < initial_count; i++) {
+			things.push_back(GPUThing::Init(i));
+		}
+		auto is_hole = [](int i) { return (i % 3 == 0) || (i > 40 && i < 50); };
+
+#if defined(NESHNY_GL)
+		if (soa_layout) {
+			return;
+		}
+		Neshny::GPUEntity entities("Thing", Neshny::GPUEntity::DeleteMode::STABLE_WITH_GAPS, &GPUThing::p_Id, "Id");
+		entities.Init(100);
+		entities.AddInstances(things);
+		for (int i = 0; i < initial_count; i++) {
+			if (is_hole(i)) {
+				entities.DeleteInstance(i);
+			}
+		}
+#elif defined(NESHNY_WEBGPU)
+		Neshny::GPUEntity entities("Thing", &GPUThing::p_Id, "Id", true, soa_layout ? Neshny::EntityLayout::SOA : Neshny::EntityLayout::AOS);
+		entities.Init(100);
+		std::vector<GPUThing> with_holes = things;
+		for (int i = 0; i < initial_count; i++) {
+			if (is_hole(i)) {
+				with_holes[i].p_Id = -1;
+			}
+		}
+		entities.SetInstances(with_holes);
+#endif
+		int live_count = 0;
+		for (int i = 0; i < initial_count; i++) {
+			live_count += is_hole(i) ? 0 : 1;
+		}
+
+		auto partial = entities.Defragment(5);
+		ExpectEqual("Budget respected", (int)partial.p_Moves.size(), 5);
+		Expect("Partial defrag not complete", !partial.p_Complete);
+
+		auto plan = entities.Defragment();
+		Expect("Full defrag complete", plan.p_Complete);
+		ExpectEqual("Max index shrinks to live count", plan.p_NewMaxIndex, live_count);
+
+		std::vector<GPUThing> gpu_values;
+		entities.ExtractMultiple(gpu_values, live_count);
+		std::vector<int> seen(initial_count, 0);
+		for (const auto& item : gpu_values) {
+			Expect("No holes below max index", item.p_Id >= 0);
+			if ((item.p_Id < 0) || (item.p_Id >= initial_count)) {
+				continue;
+			}
+			seen[item.p_Id]++;
+			auto mismatch = things[item.p_Id].CloseEnough(item);
+			Expect(std::format("Defrag moved data intact [{}]", mismatch.value_or("")), !mismatch.has_value());
+		}
+		for (int i = 0; i < initial_count; i++) {
+			ExpectEqual("Every live entity survives exactly once", seen[i], is_hole(i) ? 0 : 1);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GPUEntityDefrag(void) {
+		GPUEntityDefrag(false);
+		GPUEntityDefrag(true);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void GPUEntityCache2D(bool use_cursor, bool upload_cpu_cache = false) {
 
 		const int prey_count = 50;
 		const int hunter_count = 20;
@@ -514,15 +940,35 @@ namespace Test {
 			}
 		}
 
+#if defined(NESHNY_GL)
 		// run the generation algorithm
 		cache.Generate2DCache(Neshny::iVec2(grids, grids), Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius));
 
 		// run again to make sure results are idempotent
 		cache.Generate2DCache(Neshny::iVec2(grids, grids), Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius));
 
-#if defined(NESHNY_GL)
 		// TODO: test here as well
 #elif defined(NESHNY_WEBGPU)
+		// the reference is built from the grid asked for, so a cache generated with the wrong bounds does not match it
+		std::vector<GPUThing> all_prey;
+		prey_entities.ExtractAll(all_prey);
+		Neshny::GridCacheBuilder builder(prey_entities.GetSpecs(), "TwoDim", std::nullopt, "Id");
+		Neshny::GridCacheLayout cpu_cache;
+		std::string err;
+		Expect("CPU reference cache builds", builder.Generate2D(Neshny::EntityDeltaCodec::ToSnapshot(all_prey), Neshny::iVec2(grids, grids), Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius), cpu_cache, err));
+
+		if (upload_cpu_cache) {
+			cache.Upload2DCache(cpu_cache, Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius));
+		} else {
+			// run the generation algorithm
+			cache.Generate2DCache(Neshny::iVec2(grids, grids), Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius));
+
+			// run again to make sure results are idempotent
+			cache.Generate2DCache(Neshny::iVec2(grids, grids), Neshny::Vec2(-map_radius, -map_radius), Neshny::Vec2(map_radius, map_radius));
+		}
+		bool valid = cache.Validate(cpu_cache, err);
+		Expect(std::format("Cache matches the CPU reference ({})", err), valid);
+
 		std::string shader_defines = "#define TWO_DIM\n";
 		if (use_cursor) {
 			shader_defines += "#define USE_CURSOR";
@@ -542,7 +988,7 @@ namespace Test {
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
-	void GPUEntityCache3D(bool use_cursor, bool use_radius = false) {
+	void GPUEntityCache3D(bool use_cursor, bool use_radius = false, bool upload_cpu_cache = false) {
 
 #if defined(NESHNY_WEBGPU)
 
@@ -601,11 +1047,24 @@ namespace Test {
 			}
 		}
 
-		// run the generation algorithm
-		cache.Generate3DCache(Neshny::iVec3(grids, grids, grids), Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius));
+		std::vector<GPUThing> all_prey;
+		prey_entities.ExtractAll(all_prey);
+		Neshny::GridCacheBuilder builder(prey_entities.GetSpecs(), "ThreeDim", use_radius ? std::optional<std::string_view>("Float") : std::nullopt, "Id");
+		Neshny::GridCacheLayout cpu_cache;
+		std::string err;
+		Expect("CPU reference cache builds", builder.Generate3D(Neshny::EntityDeltaCodec::ToSnapshot(all_prey), Neshny::iVec3(grids, grids, grids), Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius), cpu_cache, err));
 
-		// run again to make sure results are idempotent
-		cache.Generate3DCache(Neshny::iVec3(grids, grids, grids), Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius));
+		if (upload_cpu_cache) {
+			cache.Upload3DCache(cpu_cache, Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius));
+		} else {
+			// run the generation algorithm
+			cache.Generate3DCache(Neshny::iVec3(grids, grids, grids), Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius));
+
+			// run again to make sure results are idempotent
+			cache.Generate3DCache(Neshny::iVec3(grids, grids, grids), Neshny::Vec3(-map_radius, -map_radius, -map_radius), Neshny::Vec3(map_radius, map_radius, map_radius));
+		}
+		bool valid = cache.Validate(cpu_cache, err);
+		Expect(std::format("Cache matches the CPU reference ({})", err), valid);
 
 		std::string shader_defines;
 		if (use_cursor) {
@@ -653,6 +1112,15 @@ namespace Test {
 		GPUEntityCache3D(false, true);
 	}
 
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GPUEntityCacheUploaded(void) {
+#if defined(NESHNY_WEBGPU)
+		GPUEntityCache2D(false, true);
+		GPUEntityCache3D(false, false, true);
+		GPUEntityCache3D(false, true, true);
+#endif
+	}
+
 	////////////////////////////////////////////////////////////////////////////////
 	void UnitTest_Compute(void) {
 
@@ -719,4 +1187,64 @@ namespace Test {
 #endif
 	}
 
+#if defined(NESHNY_WEBGPU)
+	////////////////////////////////////////////////////////////////////////////////
+	// how Prepare assembled the insertion before it was written into a CodeBuilder
+	std::pair<std::string, std::string> LegacyAssembleInsertion(const Neshny::PipelineCode::ShaderInsertion& insertion) {
+		std::list<std::string> lines = insertion.p_Body;
+		lines.push_front(Neshny::JoinStrings(insertion.p_Buffers, "\n"));
+		lines.push_front(Neshny::JoinStrings(insertion.p_Immediate, "\n"));
+		std::string end_insertion_str;
+		if (!insertion.p_End.empty()) {
+			end_insertion_str = "\n//////////\n" + Neshny::JoinStrings(insertion.p_End, "\n");
+		}
+		return { Neshny::JoinStrings(lines, "\n"), end_insertion_str };
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::pair<std::string, std::string> AssembleInsertion(const Neshny::PipelineCode::ShaderInsertion& insertion) {
+		std::pair<std::string, std::string> result;
+		Neshny::PipelineCode::AssembleInsertion(insertion, result.first, result.second);
+		return result;
+	}
+#endif
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_PipelineInsertionMatchesLegacy(void) {
+
+#if defined(NESHNY_WEBGPU)
+		using ShaderInsertion = Neshny::PipelineCode::ShaderInsertion;
+		std::vector<std::pair<std::string, ShaderInsertion>> edge_cases = {
+			{ "Nothing at all", {} },
+			{ "No buffers", { { "#define ENTITY_OFFSET_INTS 0" }, {}, { "#define A", "////////////////" }, {} } },
+			{ "No body", { { "#define ENTITY_OFFSET_INTS 0" }, { "@group(0) @binding(0) var<uniform> Uniform: UniformStruct;" }, {}, {} } },
+			{ "Empty lines", { { "", "" }, { "" }, { "", "#define A", "" }, { "", "" } } },
+			{ "Only the end", { {}, {}, {}, { "@compute @workgroup_size(8, 8, 8)", "fn main() {}" } } }
+		};
+		for (const auto& [name, insertion] : edge_cases) {
+			Expect(std::format("{} assembles the same as joining", name), AssembleInsertion(insertion) == LegacyAssembleInsertion(insertion));
+		}
+
+		// laid out the way Prepare lays out an entity pipeline that reads a data vector
+		Neshny::PipelineCode::DataVector data_vect;
+		data_vect.p_Name = "Spawn";
+		data_vect.p_NumIntsPerItem = 4;
+		data_vect.p_Members = { { "Pos", Neshny::MemberSpec::T_VEC3, sizeof(float) * 3, false }, { "Kind", Neshny::MemberSpec::T_INT, sizeof(int), false } };
+		const std::string spawn_code = Neshny::PipelineCode::GetDataVectorStructCode(data_vect, true);
+		ShaderInsertion entity_like = {
+			{ "#define ENTITY_OFFSET_INTS 4", "#define FLOATS_PER_Thing 12" },
+			{ "@group(0) @binding(0) var<storage, read_write> b_Thing: array<atomic<i32>>;", "@group(0) @binding(1) var<storage, read> b_Control: array<i32>;" },
+			{ "const ioSpawnOffset: i32 = 0;", spawn_code, "////////////////" },
+			{ "@compute @workgroup_size(8, 8, 8)", "fn main(@builtin(global_invocation_id) global_id: vec3u) {", "}" }
+		};
+		auto assembled = AssembleInsertion(entity_like);
+		auto legacy = LegacyAssembleInsertion(entity_like);
+		ExpectEqual("Entity pipeline insertion is unchanged", assembled.first, legacy.first);
+		ExpectEqual("Entity pipeline end insertion is unchanged", assembled.second, legacy.second);
+		Expect("Insertion starts with the immediate code", assembled.first.starts_with("#define ENTITY_OFFSET_INTS 4\n#define FLOATS_PER_Thing 12\n@group(0)"));
+		Expect("Data vector code is carried over whole", assembled.first.find("\n" + spawn_code + "\n////////////////") != std::string::npos);
+		Expect("End insertion is marked off", assembled.second.starts_with("\n//////////\n@compute"));
+#endif
+	}
+
 } // namespace Test
\ No newline at end of file
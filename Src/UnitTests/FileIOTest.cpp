@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	struct FileIOBenchmarkResult {
+		Neshny::FileReadBackend	p_Backend;
+		bool					p_Cold;
+		double					p_Ms;
+		bool					p_Matches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	std::string WriteTestFiles(std::string_view dir_name, int count, std::vector<std::string>& paths, std::vector<std::string>& contents) {
+		auto dir = std::filesystem::temp_directory_path() / std::string(dir_name);
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		Neshny::RandomGenerator generator((uint64_t)count);
+		for (int i = 0; i < count; i++) {
+			// mostly small files like shaders and configs, with the occasional large one
+			int size = (i % 97 == 0) ? (int)generator.NextBounded(1 << 20) : (int)generator.NextBounded(4096);
+			std::string data(size, 0);
+			for (auto& c : data) {
+				c = (char)generator.Next();
+			}
+			std::string path = (dir / std::format("file_{}.bin", i)).string();
+			std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size());
+			paths.push_back(path);
+			contents.push_back(std::move(data));
+		}
+		return dir.string();
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// loads count files per backend, cold means the page cache is dropped for them first
+	// cold numbers need Linux, elsewhere they are the same as warm
+	std::vector<FileIOBenchmarkResult> BenchmarkFileLoading(int count) {
+		std::vector<std::string> paths;
+		std::vector<std::string> contents;
+		std::string dir = WriteTestFiles("neshny_file_bench", count, paths, contents);
+
+		auto evict = [&paths]() {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+			for (const auto& path : paths) {
+				int fd = open(path.c_str(), O_RDONLY);
+				if (fd >= 0) {
+					fdatasync(fd);
+					posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+					close(fd);
+				}
+			}
+#endif
+		};
+
+		std::vector<FileIOBenchmarkResult> results;
+		std::vector<Neshny::FileReadBackend> backends = { Neshny::FileReadBackend::SYNC, Neshny::FileReadBackend::THREAD_POOL };
+		if (Neshny::IOUringSupported()) {
+			backends.push_back(Neshny::FileReadBackend::IO_URING);
+		}
+		for (auto backend : backends) {
+			for (bool cold : { true, false }) {
+				if (cold) {
+					evict();
+				}
+				auto start = std::chrono::high_resolution_clock::now();
+				auto loaded = Neshny::ReadFilesBatched(paths, { backend });
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				bool matches = loaded.size() == contents.size();
+				for (int i = 0; matches && (i < (int)contents.size()); i++) {
+					matches = loaded[i].p_Success && (loaded[i].GetString() == contents[i]);
+				}
+				results.push_back({ backend, cold, ms, matches });
+			}
+		}
+		std::filesystem::remove_all(dir);
+		return results;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FileReadBatched(void) {
+		std::vector<std::string> paths;
+		std::vector<std::string> contents;
+		std::string dir = WriteTestFiles("neshny_file_test", 2000, paths, contents);
+		paths.push_back(dir + "/does_not_exist.bin");
+
+		std::vector<Neshny::FileReadBackend> backends = { Neshny::FileReadBackend::AUTO, Neshny::FileReadBackend::THREAD_POOL, Neshny::FileReadBackend::SYNC };
+		if (Neshny::IOUringSupported()) {
+			backends.push_back(Neshny::FileReadBackend::IO_URING);
+		}
+		for (auto backend : backends) {
+			Neshny::FileReadBackend used = Neshny::FileReadBackend::AUTO;
+			auto results = Neshny::ReadFilesBatched(paths, { backend, 16 }, &used);
+			Expect("A concrete backend was chosen", used != Neshny::FileReadBackend::AUTO);
+			ExpectEqual("One result per path", results.size(), paths.size());
+			bool all_match = true;
+			for (int i = 0; i < (int)contents.size(); i++) {
+				all_match = all_match && results[i].p_Success && (results[i].p_Path == paths[i]) && (results[i].GetString() == contents[i]);
+			}
+			Expect(std::format("Backend {} reads every file intact", (int)used), all_match);
+			Expect("Missing file fails on its own", !results.back().p_Success && !results.back().p_Error.empty());
+		}
+		std::filesystem::remove_all(dir);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_MappedFile(void) {
+		std::vector<std::string> paths;
+		std::vector<std::string> contents;
+		std::string dir = WriteTestFiles("neshny_mapped_test", 3, paths, contents);
+
+		Neshny::MappedFile mapped(paths[0]);
+		Expect("Mapped file opens", mapped.IsValid());
+		Expect("Mapped contents match", mapped.GetString() == contents[0]);
+
+		// the mapping is private - writing to it must never change the file
+		if (mapped.GetSize() > 0) {
+			mapped.GetMutableData()[0] ^= 0xFF;
+			std::vector<unsigned char> on_disk;
+			std::string err;
+			Expect("File still readable", Neshny::ReadWholeFile(paths[0], on_disk, err));
+			ExpectEqual("Writes stay private", (char)on_disk[0], contents[0][0]);
+		}
+
+		Neshny::MappedFile moved(std::move(mapped));
+		Expect("Moved from file is closed", !mapped.IsValid());
+		Expect("Moved to file keeps the data", moved.IsValid() && (moved.GetSize() == contents[0].size()));
+
+		std::string empty_path = dir + "/empty.bin";
+		std::ofstream(empty_path, std::ios::out | std::ios::binary | std::ios::trunc).close();
+		Neshny::MappedFile empty(empty_path);
+		Expect("Empty file is valid", empty.IsValid() && (empty.GetSize() == 0) && (empty.GetData().data() != nullptr));
+
+		Neshny::MappedFile missing(dir + "/does_not_exist.bin");
+		Expect("Missing file is invalid", !missing.IsValid());
+
+		moved.Close();
+		empty.Close();
+		std::filesystem::remove_all(dir);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FileReadBenchmark(void) {
+		for (const auto& result : BenchmarkFileLoading(2000)) {
+			std::string name = result.p_Backend == Neshny::FileReadBackend::IO_URING ? "io_uring" : (result.p_Backend == Neshny::FileReadBackend::THREAD_POOL ? "threads" : "sync");
+			Neshny::Core::Log(std::format("Loading 2000 files {} with {} takes {:.1f} ms", result.p_Cold ? "cold" : "warm", name, result.p_Ms));
+			Expect(std::format("Every file is read intact {} with {}", result.p_Cold ? "cold" : "warm", name), result.p_Matches);
+		}
+	}
+
+} // namespace Test
@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_LatencyHistogram(void) {
+		Neshny::LatencyHistogram histogram;
+		Expect("Empty histogram reports zero", (histogram.ValueAtPercentile(50.0) == 0) && (histogram.GetMean() == 0.0));
+
+		// long tailed frame times from 1ms up to a few hundred ms, like a real game
+		Neshny::RandomGenerator generator((uint64_t)35);
+		std::vector<int64_t> values;
+		for (int i = 0; i < 100000; i++) {
+			double ms = 1.0 + 15.0 * generator.Next() / (double)std::numeric_limits<unsigned int>::max();
+			if (generator.NextBounded(100) == 0) {
+				ms *= 1.0 + 20.0 * generator.Next() / (double)std::numeric_limits<unsigned int>::max();
+			}
+			values.push_back((int64_t)(ms * 1000000.0));
+			histogram.Record(values.back());
+		}
+		std::sort(values.begin(), values.end());
+
+		ExpectEqual("Every value counted", histogram.GetCount(), (int64_t)values.size());
+		ExpectEqual("Exact min", histogram.GetMin(), values.front());
+		ExpectEqual("Exact max", histogram.GetMax(), values.back());
+		bool within_precision = true;
+		for (double percentile : { 1.0, 10.0, 50.0, 90.0, 95.0, 99.0, 99.9, 100.0 }) {
+			int64_t exact = values[std::max(0, (int)std::ceil(percentile * 0.01 * values.size()) - 1)];
+			int64_t approx = histogram.ValueAtPercentile(percentile);
+			within_precision = within_precision && (approx >= exact) && ((double)(approx - exact) <= (double)exact / Neshny::LatencyHistogram::SUB_BUCKET_COUNT);
+		}
+		Expect("Percentiles are within one sub bucket and never under report", within_precision);
+
+		bool buckets_line_up = true;
+		for (int64_t value : std::vector<int64_t>{ 0, 1, 127, 128, 255, 256, 257, 1000000, 16666667, Neshny::LatencyHistogram::MAX_VALUE }) {
+			int index = Neshny::LatencyHistogram::BucketIndex(value);
+			buckets_line_up = buckets_line_up && (index < Neshny::LatencyHistogram::BUCKET_COUNT) && (Neshny::LatencyHistogram::BucketLowest(index) <= value) && (Neshny::LatencyHistogram::BucketHighest(index) >= value);
+		}
+		Expect("Every value lands in a bucket that covers it", buckets_line_up);
+
+		Neshny::LatencyHistogram other;
+		other.Record(Neshny::LatencyHistogram::MAX_VALUE * 2);
+		ExpectEqual("Huge values are clamped", other.GetClampedCount(), (int64_t)1);
+		histogram.Merge(other);
+		ExpectEqual("Merge adds counts", histogram.GetCount(), (int64_t)values.size() + 1);
+		ExpectEqual("Merge keeps the max", histogram.GetMax(), Neshny::LatencyHistogram::MAX_VALUE);
+		histogram.Reset();
+		Expect("Reset empties it", (histogram.GetCount() == 0) && (histogram.ValueAtPercentile(99.0) == 0));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FrameStatsBudgets(void) {
+		using namespace std::chrono_literals;
+		Neshny::FrameStats stats;
+		stats.SetInterval(1s);
+		stats.SetFrameBudget(20ms);
+		stats.SetBudget("Physics", 5ms);
+
+		for (int i = 0; i < 100; i++) {
+			bool spike = (i % 10) == 9;
+			stats.AddSubsystemTime("Physics", spike ? 8ms : 2ms);
+			stats.AddSubsystemTime("Physics", 1ms); // summed with the time above
+			if (i % 2 == 0) {
+				stats.AddSubsystemTime("Audio", 500us);
+			}
+			stats.EndFrame(spike ? 30ms : 16ms);
+		}
+
+		auto snapshot = stats.GetSnapshot();
+		ExpectEqual("All frames counted", snapshot.p_Frame.p_Count, (int64_t)100);
+		ExpectEqual("Frame spikes", snapshot.p_Frame.p_Spikes, (int64_t)10);
+		Expect("Frame p50", fabs(snapshot.p_Frame.p_P50Ms - 16.0) < 0.2);
+		Expect("Frame p95 sees the spikes", fabs(snapshot.p_Frame.p_P95Ms - 30.0) < 0.3);
+		ExpectEqual("Two subsystems", (int)snapshot.p_Subsystems.size(), 2);
+
+		const auto& physics = snapshot.p_Subsystems[0];
+		ExpectEqual("Physics name", physics.p_Name, std::string("Physics"));
+		ExpectEqual("Physics once per frame", physics.p_Count, (int64_t)100);
+		Expect("Physics times are summed per frame", (fabs(physics.p_P50Ms - 3.0) < 0.05) && (fabs(physics.p_MaxMs - 9.0) < 0.01));
+		ExpectEqual("Physics spikes", physics.p_Spikes, (int64_t)10);
+		Expect("Physics budget", fabs(physics.p_BudgetMs - 5.0) < 0.000001);
+		ExpectEqual("Audio only counted when it ran", snapshot.p_Subsystems[1].p_Count, (int64_t)50);
+		ExpectEqual("No audio budget means no spikes", snapshot.p_Subsystems[1].p_Spikes, (int64_t)0);
+
+		auto spikes = stats.GetRecentSpikes();
+		ExpectEqual("Spikes remembered", (int)spikes.size(), 20);
+		Expect("Spikes say what and when", (spikes.back().p_FrameIndex == 99) && (std::string(spikes.back().p_Label) == "Physics") && (spikes.back().p_Time == 9ms) && (spikes[spikes.size() - 2].p_Label == nullptr) && (spikes[spikes.size() - 2].p_Time == 30ms));
+
+		// 100 frames of about 17ms is a bit over a second, so exactly one interval has rolled over
+		const auto& interval = stats.GetLastIntervalSnapshot();
+		Expect("One interval finished", (interval.p_Frame.p_Count > 0) && (interval.p_Frame.p_Count < 100) && (interval.p_IntervalSeconds >= 1.0));
+		auto current = stats.GetSnapshot(true);
+		ExpectEqual("Intervals cover every frame", interval.p_Frame.p_Count + current.p_Frame.p_Count, (int64_t)100);
+
+		for (int i = 0; i < 10000; i++) {
+			stats.EndFrame(16ms);
+		}
+		Expect("Recent spikes stay bounded", stats.GetRecentSpikes().size() <= Neshny::FrameStats::MAX_RECENT_SPIKES);
+
+		stats.Reset();
+		Expect("Reset clears", (stats.GetSnapshot().p_Frame.p_Count == 0) && stats.GetRecentSpikes().empty() && (stats.GetFrameIndex() == 0));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_FrameStatsExport(void) {
+		using namespace std::chrono_literals;
+		auto csv_path = (std::filesystem::temp_directory_path() / "neshny_frame_stats.csv").string();
+		auto json_path = (std::filesystem::temp_directory_path() / "neshny_frame_stats.json").string();
+
+		for (auto format : { Neshny::FrameStatsFormat::CSV, Neshny::FrameStatsFormat::JSON }) {
+			std::string path = format == Neshny::FrameStatsFormat::CSV ? csv_path : json_path;
+			Neshny::FrameStats stats;
+			stats.SetInterval(100ms);
+			Expect("Export starts", stats.StartExport(path, format));
+			for (int i = 0; i < 30; i++) {
+				stats.AddSubsystemTime("Update", 1ms);
+				{
+					Neshny::FrameStats::Scope scope("Render, \"main\"", stats);
+				}
+				stats.EndFrame(10ms);
+			}
+			stats.StopExport();
+			Expect("Export stopped", !stats.IsExporting());
+
+			std::vector<std::string> lines;
+			std::ifstream file(path);
+			for (std::string line; std::getline(file, line);) {
+				lines.push_back(line);
+			}
+			if (format == Neshny::FrameStatsFormat::CSV) {
+				ExpectEqual("Header then three rows per interval", (int)lines.size(), 1 + 3 * 3);
+				ExpectEqual("Header", lines[0] + "\n", Neshny::FrameStats::ToCSVHeader());
+				Expect("Frame row", lines[1].starts_with("10,0.100000,0.100000,Frame,10,10.000000,"));
+				Expect("Names with commas and quotes are escaped", lines[3].find(",\"Render, \"\"main\"\"\",") != std::string::npos);
+			} else {
+				ExpectEqual("One line per interval", (int)lines.size(), 3);
+				auto json = nlohmann::json::parse(lines.back());
+				ExpectEqual("Frame index", json["Frame"].get<int64_t>(), (int64_t)30);
+				ExpectEqual("Interval count", json["Total"]["Count"].get<int64_t>(), (int64_t)10);
+				ExpectEqual("Subsystems", json["Subsystems"].size(), (size_t)2);
+				ExpectEqual("Subsystem name", json["Subsystems"][0]["Name"].get<std::string>(), std::string("Update"));
+				ExpectEqual("Subsystem names are escaped", json["Subsystems"][1]["Name"].get<std::string>(), std::string("Render, \"main\""));
+				Expect("Subsystem time", fabs(json["Subsystems"][0]["P99Ms"].get<double>() - 1.0) < 0.01);
+			}
+		}
+
+		std::string before = std::string(Neshny::MappedFile(csv_path).GetString());
+		Neshny::FrameStats stats;
+		Expect("Appending starts", stats.StartExport(csv_path, Neshny::FrameStatsFormat::CSV, true));
+		stats.StopExport();
+		ExpectEqual("Appending keeps the existing rows and adds no second header", std::string(Neshny::MappedFile(csv_path).GetString()), before);
+		std::filesystem::remove(csv_path);
+		std::filesystem::remove(json_path);
+	}
+
+} // namespace Test
@@ -0,0 +1,250 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct GridCacheTestEntity {
+		int					p_Id;
+		Neshny::fVec3		p_Pos;
+		float				p_Radius;
+		int					p_State;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// the same entity seen as 2D, where the z of the position is some other float
+	Neshny::StructInfo GridCacheTestInfo(bool is_3d) {
+		Neshny::StructInfo info;
+		if (is_3d) {
+			info.p_Members = {
+				{ "Id", Neshny::MemberSpec::T_INT, sizeof(int) },
+				{ "Pos", Neshny::MemberSpec::T_VEC3, sizeof(float) * 3 },
+				{ "Radius", Neshny::MemberSpec::T_FLOAT, sizeof(float) },
+				{ "State", Neshny::MemberSpec::T_INT, sizeof(int) }
+			};
+		} else {
+			info.p_Members = {
+				{ "Id", Neshny::MemberSpec::T_INT, sizeof(int) },
+				{ "Pos", Neshny::MemberSpec::T_VEC2, sizeof(float) * 2 },
+				{ "Depth", Neshny::MemberSpec::T_FLOAT, sizeof(float) },
+				{ "Radius", Neshny::MemberSpec::T_FLOAT, sizeof(float) },
+				{ "State", Neshny::MemberSpec::T_INT, sizeof(int) }
+			};
+		}
+		return info;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	float GridCacheTestRandom(Neshny::RandomGenerator& generator, float min_val, float max_val) {
+		return min_val + (float)((double)generator.Next() / 4294967296.0) * (max_val - min_val);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// a few are outside the grid and every seventh is a hole
+	std::vector<int> MakeGridCacheTestSnapshot(int count, float max_radius, Neshny::RandomGenerator& generator) {
+		std::vector<GridCacheTestEntity> items(count);
+		for (int i = 0; i < count; i++) {
+			auto& item = items[i];
+			item.p_Id = (i % 7 == 6) ? -1 : i;
+			item.p_Pos = Neshny::fVec3(GridCacheTestRandom(generator, -110.0f, 110.0f), GridCacheTestRandom(generator, -110.0f, 110.0f), GridCacheTestRandom(generator, -110.0f, 110.0f));
+			item.p_Radius = GridCacheTestRandom(generator, 0.0f, max_radius);
+			item.p_State = 0;
+		}
+		return Neshny::EntityDeltaCodec::ToSnapshot(items);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// every item against every cell one at a time, with the float operations of the shaders written out plainly
+	std::vector<std::vector<int>> GridCacheTestBruteForce(std::span<const int> snapshot, bool is_3d, bool radius, Neshny::iVec3 grid_size, Neshny::fVec3 grid_min, Neshny::fVec3 grid_max) {
+		std::vector<std::vector<int>> cells(grid_size.x * grid_size.y * grid_size.z);
+		const int ints = sizeof(GridCacheTestEntity) / sizeof(int);
+		for (int i = 0; i < (int)(snapshot.size() / ints); i++) {
+			GridCacheTestEntity item;
+			memcpy((void*)&item, snapshot.data() + i * ints, sizeof(item));
+			if (item.p_Id < 0) {
+				continue;
+			}
+			float pos[3] = { item.p_Pos.x, item.p_Pos.y, is_3d ? item.p_Pos.z : 0.0f };
+			float mins[3] = { grid_min.x, grid_min.y, grid_min.z };
+			float maxs[3] = { grid_max.x, grid_max.y, grid_max.z };
+			int sizes[3] = { grid_size.x, grid_size.y, grid_size.z };
+			int lo[3] = { 0, 0, 0 };
+			int hi[3] = { 0, 0, 0 };
+			for (int d = 0; d < (is_3d ? 3 : 2); d++) {
+				float inv_range = 1.0f / (maxs[d] - mins[d]);
+				if (radius) {
+					lo[d] = std::clamp((int)std::floor((float)sizes[d] * inv_range * (pos[d] - item.p_Radius - mins[d])), 0, sizes[d] - 1);
+					hi[d] = std::clamp((int)std::ceil((float)sizes[d] * inv_range * (pos[d] + item.p_Radius - mins[d])), 0, sizes[d] - 1);
+				} else {
+					lo[d] = hi[d] = std::clamp((int)std::floor((float)sizes[d] * ((pos[d] - mins[d]) * inv_range)), 0, sizes[d] - 1);
+				}
+			}
+			for (int x = lo[0]; x <= hi[0]; x++) {
+				for (int y = lo[1]; y <= hi[1]; y++) {
+					for (int z = lo[2]; z <= hi[2]; z++) {
+						cells[x + (y + z * sizes[1]) * sizes[0]].push_back(i);
+					}
+				}
+			}
+		}
+		return cells;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	bool GridCacheTestMatches(const Neshny::GridCacheLayout& layout, const std::vector<std::vector<int>>& cells) {
+		int total = 0;
+		for (int cell = 0; cell < (int)cells.size(); cell++) {
+			auto items = layout.GetCell(cell);
+			if (!std::equal(items.begin(), items.end(), cells[cell].begin(), cells[cell].end())) {
+				return false;
+			}
+			total += (int)cells[cell].size();
+		}
+		return (layout.p_TotalSize == total) && ((int)layout.p_Items.size() == total);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// what the GPU might leave - runs in a random order with gaps between them, items shuffled within each, and junk after the end
+	void MakeGridCacheTestGPULayout(const Neshny::GridCacheLayout& layout, Neshny::RandomGenerator& generator, std::vector<int>& indices, std::vector<int>& items) {
+		const int num_cells = layout.GetCellCount();
+		std::vector<int> order(num_cells);
+		for (int i = 0; i < num_cells; i++) {
+			order[i] = i;
+		}
+		for (int i = num_cells - 1; i > 0; i--) {
+			std::swap(order[i], order[generator.NextBounded(i + 1)]);
+		}
+		indices.assign(num_cells * 3, 0);
+		items.clear();
+		for (int cell : order) {
+			auto run = layout.GetCell(cell);
+			if (run.empty()) {
+				continue;
+			}
+			indices[cell * 3] = (int)run.size();
+			indices[cell * 3 + 1] = (int)items.size();
+			indices[cell * 3 + 2] = (int)run.size();
+			int start = (int)items.size();
+			items.insert(items.end(), run.begin(), run.end());
+			for (int i = (int)run.size() - 1; i > 0; i--) {
+				std::swap(items[start + i], items[start + generator.NextBounded(i + 1)]);
+			}
+		}
+		items.resize(items.size() + 100, -7);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GridCacheCPULayout(void) {
+
+		Neshny::RandomGenerator generator((uint64_t)11);
+		auto snapshot = MakeGridCacheTestSnapshot(20000, 12.0f, generator);
+		Neshny::fVec3 grid_min(-100.0f, -100.0f, -100.0f);
+		Neshny::fVec3 grid_max(100.0f, 60.0f, 80.0f);
+
+		for (bool is_3d : { false, true }) {
+			for (bool radius : { false, true }) {
+				std::string mode = std::format("{} {}", is_3d ? "3D" : "2D", radius ? "radius" : "point");
+				Neshny::GridCacheBuilder builder(GridCacheTestInfo(is_3d), "Pos", radius ? std::optional<std::string_view>("Radius") : std::nullopt, "Id");
+				Neshny::GridCacheLayout layout;
+				std::string err;
+				Neshny::iVec3 grid_size(23, 17, is_3d ? 9 : 1);
+				bool ok = is_3d ?
+					builder.Generate3D(snapshot, grid_size, Neshny::Vec3(grid_min.x, grid_min.y, grid_min.z), Neshny::Vec3(grid_max.x, grid_max.y, grid_max.z), layout, err) :
+					builder.Generate2D(snapshot, Neshny::iVec2(grid_size.x, grid_size.y), Neshny::Vec2(grid_min.x, grid_min.y), Neshny::Vec2(grid_max.x, grid_max.y), layout, err);
+				Expect(std::format("{} cache generates", mode), ok);
+
+				auto expected = GridCacheTestBruteForce(snapshot, is_3d, radius, grid_size, is_3d ? grid_min : Neshny::fVec3(grid_min.x, grid_min.y, 0.0f), is_3d ? grid_max : Neshny::fVec3(grid_max.x, grid_max.y, 0.0f));
+				Expect(std::format("{} cache holds each item in the cells the shader would put it", mode), GridCacheTestMatches(layout, expected));
+
+				bool holes_skipped = true;
+				for (int index : layout.p_Items) {
+					holes_skipped = holes_skipped && (index % 7 != 6);
+				}
+				Expect(std::format("{} cache skips holes", mode), holes_skipped);
+			}
+		}
+
+		Neshny::GridCacheBuilder wrong_dims(GridCacheTestInfo(true), "Pos", std::nullopt, "Id");
+		Neshny::GridCacheBuilder wrong_radius(GridCacheTestInfo(true), "Pos", "State", "Id");
+		Neshny::GridCacheLayout layout;
+		std::string err;
+		Expect("A vec3 position does not make a 2D cache", !wrong_dims.Generate2D(snapshot, Neshny::iVec2(4, 4), Neshny::Vec2(0.0, 0.0), Neshny::Vec2(1.0, 1.0), layout, err) && !err.empty());
+		Expect("The radius has to be a float", !wrong_radius.Generate3D(snapshot, Neshny::iVec3(4, 4, 4), Neshny::Vec3(0.0, 0.0, 0.0), Neshny::Vec3(1.0, 1.0, 1.0), layout, err));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GridCacheCPUThreaded(void) {
+
+		Neshny::RandomGenerator generator((uint64_t)12);
+		auto snapshot = MakeGridCacheTestSnapshot(150000, 6.0f, generator);
+		Neshny::GridCacheBuilder builder(GridCacheTestInfo(true), "Pos", "Radius", "Id");
+
+		Neshny::GridCacheLayout single;
+		Neshny::GridCacheLayout threaded;
+		std::string err;
+		builder.Generate3D(snapshot, Neshny::iVec3(32, 32, 32), Neshny::Vec3(-100.0, -100.0, -100.0), Neshny::Vec3(100.0, 100.0, 100.0), single, err);
+		builder.Generate3D(snapshot, Neshny::iVec3(32, 32, 32), Neshny::Vec3(-100.0, -100.0, -100.0), Neshny::Vec3(100.0, 100.0, 100.0), threaded, err, 4);
+		Expect("Threads give the same layout", (single.p_Indices == threaded.p_Indices) && (single.p_Items == threaded.p_Items) && (single.p_TotalSize == threaded.p_TotalSize));
+		Expect("Items in each cell are in index order", std::is_sorted(threaded.GetCell(threaded.GetCellIndex(Neshny::iVec3(16, 16, 16))).begin(), threaded.GetCell(threaded.GetCellIndex(Neshny::iVec3(16, 16, 16))).end()));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GridCacheCPUValidate(void) {
+
+		Neshny::RandomGenerator generator((uint64_t)13);
+		auto snapshot = MakeGridCacheTestSnapshot(8000, 15.0f, generator);
+		Neshny::GridCacheBuilder builder(GridCacheTestInfo(false), "Pos", "Radius", "Id");
+		Neshny::GridCacheLayout expected;
+		std::string err;
+		builder.Generate2D(snapshot, Neshny::iVec2(40, 30), Neshny::Vec2(-100.0, -100.0), Neshny::Vec2(100.0, 100.0), expected, err);
+
+		std::vector<int> indices;
+		std::vector<int> items;
+		MakeGridCacheTestGPULayout(expected, generator, indices, items);
+		Neshny::GridCacheLayout canonical;
+		Expect("A shuffled layout canonicalises", Neshny::GridCacheBuilder::Canonicalise(expected.p_GridSize, indices, items, canonical, err));
+		Expect("Canonical layout is byte for byte what the builder makes", (canonical.p_Indices == expected.p_Indices) && (canonical.p_Items == expected.p_Items) && (canonical.p_TotalSize == expected.p_TotalSize));
+		Expect("Shuffled layout validates", Neshny::GridCacheBuilder::Validate(expected, indices, items, err));
+
+		int cell = expected.GetCellIndex(Neshny::iVec3(20, 15, 0));
+		auto swapped = items;
+		swapped[indices[cell * 3 + 1]] = 1;
+		err.clear();
+		Expect("A wrong item is caught", !Neshny::GridCacheBuilder::Validate(expected, indices, swapped, err) && (err.find("(20, 15, 0)") != std::string::npos));
+
+		auto short_count = indices;
+		short_count[cell * 3]--;
+		Expect("A cell not completely filled is caught", !Neshny::GridCacheBuilder::Validate(expected, short_count, items, err));
+		auto overrun = indices;
+		overrun[cell * 3 + 1] = (int)items.size();
+		Expect("A run past the end is caught", !Neshny::GridCacheBuilder::Validate(expected, overrun, items, err));
+		Expect("A short index buffer is caught", !Neshny::GridCacheBuilder::Validate(expected, std::span<const int>(indices).subspan(3), items, err));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_GridCacheCPUBenchmark(void) {
+
+		Neshny::RandomGenerator generator((uint64_t)14);
+		auto snapshot = MakeGridCacheTestSnapshot(1000000, 0.5f, generator);
+		auto time_ms = [](auto&& fn) {
+			double best = std::numeric_limits<double>::max();
+			for (int attempt = 0; attempt < 3; attempt++) {
+				auto start = std::chrono::steady_clock::now();
+				fn();
+				best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			return best;
+		};
+
+		for (bool radius : { false, true }) {
+			Neshny::GridCacheBuilder builder(GridCacheTestInfo(false), "Pos", radius ? std::optional<std::string_view>("Radius") : std::nullopt, "Id");
+			Neshny::GridCacheLayout single;
+			Neshny::GridCacheLayout threaded;
+			std::string err;
+			double single_ms = time_ms([&]() { builder.Generate2D(snapshot, Neshny::iVec2(256, 256), Neshny::Vec2(-100.0, -100.0), Neshny::Vec2(100.0, 100.0), single, err); });
+			double threaded_ms = time_ms([&]() { builder.Generate2D(snapshot, Neshny::iVec2(256, 256), Neshny::Vec2(-100.0, -100.0), Neshny::Vec2(100.0, 100.0), threaded, err, 4); });
+			Neshny::Core::Log(std::format("{} cache of 1m items into 256x256 takes {:.1f} ms, {:.1f} ms on 4 threads", radius ? "Radius" : "Point", single_ms, threaded_ms));
+			Expect(std::format("{} cache is the same built on 4 threads", radius ? "Radius" : "Point"), single.p_Items == threaded.p_Items);
+		}
+	}
+
+}
@@ -0,0 +1,315 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	enum class HashTestMode : uint8_t {
+		IDLE = 0,
+		ACTIVE = 7
+	};
+
+	struct HashTestInner {
+		int					p_Int;
+		double				p_Double;
+		std::string			p_Name;
+	};
+
+	struct HashTestRecord {
+		int									p_Int;
+		float								p_Float;
+		bool								p_Flag;
+		HashTestMode						p_Mode;
+		Neshny::fVec3						p_Position;
+		std::string							p_Name;
+		std::vector<HashTestInner>			p_Items;
+		std::optional<int>					p_Maybe;
+		std::unordered_map<std::string, int>	p_Lookup;
+	};
+
+	// same members as HashTestInner but with wider types, should hash the same
+	struct HashTestWideInner {
+		int64_t				p_Int;
+		double				p_Double;
+		std::string			p_Name;
+	};
+}
+
+namespace meta {
+	template<> inline auto registerMembers<Test::HashTestInner>() {
+		return members(
+			member("Int", &Test::HashTestInner::p_Int)
+			,member("Double", &Test::HashTestInner::p_Double)
+			,member("Name", &Test::HashTestInner::p_Name)
+		);
+	}
+	template<> inline auto registerMembers<Test::HashTestRecord>() {
+		return members(
+			member("Int", &Test::HashTestRecord::p_Int)
+			,member("Float", &Test::HashTestRecord::p_Float)
+			,member("Flag", &Test::HashTestRecord::p_Flag)
+			,member("Mode", &Test::HashTestRecord::p_Mode)
+			,member("Position", &Test::HashTestRecord::p_Position)
+			,member("Name", &Test::HashTestRecord::p_Name)
+			,member("Items", &Test::HashTestRecord::p_Items)
+			,member("Maybe", &Test::HashTestRecord::p_Maybe)
+			,member("Lookup", &Test::HashTestRecord::p_Lookup)
+		);
+	}
+	template<> inline auto registerMembers<Test::HashTestWideInner>() {
+		return members(
+			member("Int", &Test::HashTestWideInner::p_Int)
+			,member("Double", &Test::HashTestWideInner::p_Double)
+			,member("Name", &Test::HashTestWideInner::p_Name)
+		);
+	}
+}
+
+namespace Test {
+
+	struct HashBenchmarkResult {
+		int		p_Size;
+		double	p_HashGBPerSec;
+		double	p_StdHashGBPerSec;
+		bool	p_StreamMatches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// not a unit test on its own - hashes total_bytes worth of buffers of each size with HashBytes64 and std::hash, best of a few runs
+	std::vector<HashBenchmarkResult> BenchmarkHashing(const std::vector<int>& sizes, size_t total_bytes = 1 << 26) {
+		std::vector<HashBenchmarkResult> results;
+		Neshny::RandomGenerator generator((uint64_t)99);
+		for (int size : sizes) {
+			std::string data(std::max<size_t>(size, 1 << 20), 0);
+			for (auto& c : data) {
+				c = (char)generator.Next();
+			}
+			const size_t per_buffer = data.size() / size;
+			const int repeats = (int)std::max<size_t>(1, total_bytes / (per_buffer * size));
+			auto gb_per_sec = [&](auto&& hash_func) {
+				double best_seconds = std::numeric_limits<double>::max();
+				uint64_t sink = 0;
+				for (int run = 0; run < 3; run++) {
+					auto start = std::chrono::high_resolution_clock::now();
+					for (int r = 0; r < repeats; r++) {
+						for (size_t b = 0; b < per_buffer; b++) {
+							sink += hash_func(std::string_view(data.data() + b * size, size), r);
+						}
+					}
+					best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+				}
+				// stops the compiler throwing the hashing away
+				data[0] ^= (char)(sink & 1);
+				return double(repeats) * double(per_buffer * size) / best_seconds / 1e9;
+			};
+			double ours = gb_per_sec([](std::string_view str, int r) { return Neshny::HashString64(str, r); });
+			double theirs = gb_per_sec([](std::string_view str, int r) { return (uint64_t)std::hash<std::string_view>()(str) + r; });
+			// the same buffer streamed through in pieces of this size has to give the one shot hash
+			Neshny::StreamingHasher hasher;
+			for (size_t b = 0; b < per_buffer; b++) {
+				hasher.Update(data.data() + b * size, size);
+			}
+			bool stream_matches = hasher.Digest64() == Neshny::HashBytes64(data.data(), per_buffer * size);
+			results.push_back({ size, ours, theirs, stream_matches });
+		}
+		return results;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	HashTestRecord MakeHashTestRecord(void) {
+		HashTestRecord record;
+		record.p_Int = -12;
+		record.p_Float = 1.5f;
+		record.p_Flag = true;
+		record.p_Mode = HashTestMode::ACTIVE;
+		record.p_Position = Neshny::fVec3(1.0f, -2.0f, 3.5f);
+		record.p_Name = "player one";
+		record.p_Items = { { 1, 0.25, "sword" }, { 2, -4.0, "shield" } };
+		record.p_Maybe = 77;
+		record.p_Lookup = { { "health", 100 }, { "mana", 40 }, { "gold", 1234 } };
+		return record;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_HashKnownValues(void) {
+		// reference values from the xxHash library, these must never change since hashes end up on disk
+		ExpectEqual("Empty 64 bit", Neshny::HashBytes64(nullptr, 0), (uint64_t)0x2D06800538D394C2ull);
+		Expect("Empty 128 bit", Neshny::HashBytes128(nullptr, 0) == Neshny::Hash128{ 0x6001C324468D497Full, 0x99AA06D3014798D8ull });
+
+		std::string_view fox = "The quick brown fox jumps over the lazy dog";
+		ExpectEqual("Sentence 64 bit", Neshny::HashString64(fox), (uint64_t)0xCE7D19A5418FB365ull);
+		ExpectEqual("Sentence 64 bit seeded", Neshny::HashString64(fox, 42), (uint64_t)0xB4A3F3C36B3C7D26ull);
+		Expect("Sentence 128 bit", Neshny::HashString128(fox) == Neshny::Hash128{ 0x24A1CC2E3A8A7651ull, 0xDDD650205CA3E7FAull });
+
+		std::vector<unsigned char> pattern(1000);
+		for (int i = 0; i < (int)pattern.size(); i++) {
+			pattern[i] = (unsigned char)(i * 31 + 7);
+		}
+		ExpectEqual("Long 64 bit", Neshny::HashBytes64(pattern.data(), pattern.size()), (uint64_t)0x989765D0EA7A5ECDull);
+		ExpectEqual("Long 64 bit seeded", Neshny::HashBytes64(pattern.data(), pattern.size(), 42), (uint64_t)0x210176AC002574ADull);
+		Expect("Long 128 bit seeded", Neshny::HashBytes128(pattern.data(), pattern.size(), 42) == Neshny::Hash128{ 0x210176AC002574ADull, 0x3A57F1243CCC56B5ull });
+
+		// one length from either side of every internal size boundary
+		std::vector<std::pair<int, uint64_t>> by_length = {
+			{ 1, 0x4C5CCA45D0F4811Full }, { 3, 0x15F7093B173D005Cull }, { 4, 0xDCA012F95811B6B9ull }, { 8, 0xDEC6A9A43575982Eull },
+			{ 9, 0xCBE393399F17FFBDull }, { 16, 0x7E484C18D74895D0ull }, { 17, 0x208BDE5EE2BED407ull }, { 128, 0xF92B70EAA21A6288ull },
+			{ 129, 0xF8F76713F2BB60FAull }, { 240, 0xCCC7375172C41F03ull }, { 241, 0x0B3B630948CE4A00ull }
+		};
+		for (const auto& [len, expected] : by_length) {
+			ExpectEqual(std::format("Length {}", len), Neshny::HashBytes64(pattern.data(), len), expected);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_HashStreaming(void) {
+		std::vector<unsigned char> data(20000);
+		Neshny::RandomGenerator generator((uint64_t)5);
+		for (auto& c : data) {
+			c = (unsigned char)generator.Next();
+		}
+		bool all_match = true;
+		for (uint64_t seed : { 0ull, 1ull, 0x9E3779B97F4A7C15ull }) {
+			for (int len : { 0, 1, 15, 100, 240, 241, 256, 257, 1024, 1025, 5000, 20000 }) {
+				uint64_t expected_64 = Neshny::HashBytes64(data.data(), len, seed);
+				Neshny::Hash128 expected_128 = Neshny::HashBytes128(data.data(), len, seed);
+				for (int chunk : { 1, 7, 64, 255, 256, 1000, 100000 }) {
+					Neshny::StreamingHasher hasher(seed);
+					for (int pos = 0; pos < len; pos += chunk) {
+						hasher.Update(data.data() + pos, std::min(chunk, len - pos));
+					}
+					all_match = all_match && (hasher.Digest64() == expected_64) && (hasher.Digest128() == expected_128) && (hasher.GetTotalSize() == (uint64_t)len);
+				}
+			}
+		}
+		Expect("Streaming in any chunk size matches hashing all at once", all_match);
+
+		Neshny::StreamingHasher hasher(123);
+		hasher.Update(data.data(), 3000);
+		uint64_t first = hasher.Digest64();
+		ExpectEqual("Digest does not disturb the state", hasher.Digest64(), first);
+		hasher.Reset();
+		hasher.Update(data.data(), 3000);
+		ExpectEqual("Reset starts over with the new seed", hasher.Digest64(), Neshny::HashBytes64(data.data(), 3000));
+
+		Neshny::StreamingHasher values;
+		values.UpdateValue((uint32_t)0x04030201);
+		values.UpdateValue(HashTestMode::ACTIVE);
+		unsigned char expected_bytes[] = { 1, 2, 3, 4, 7 };
+		ExpectEqual("Values are hashed as little endian bytes", values.Digest64(), Neshny::HashBytes64(expected_bytes, sizeof(expected_bytes)));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_HashStruct(void) {
+		HashTestRecord record = MakeHashTestRecord();
+		uint64_t hash = Neshny::HashStruct64(record);
+		ExpectEqual("Same struct hashes the same", Neshny::HashStruct64(MakeHashTestRecord()), hash);
+		// pinned so that any change to the canonical form, which would invalidate stored hashes, is caught
+		ExpectEqual("Struct hash is stable", hash, (uint64_t)0xF80978152850E502ull);
+
+		HashTestRecord reordered = record;
+		reordered.p_Lookup.clear();
+		reordered.p_Lookup["gold"] = 1234;
+		reordered.p_Lookup["mana"] = 40;
+		reordered.p_Lookup["health"] = 100;
+		ExpectEqual("Unordered map order does not matter", Neshny::HashStruct64(reordered), hash);
+
+		HashTestRecord negative_zero = record;
+		negative_zero.p_Position.y = -0.0f;
+		HashTestRecord positive_zero = record;
+		positive_zero.p_Position.y = 0.0f;
+		ExpectEqual("Negative zero hashes like zero", Neshny::HashStruct64(negative_zero), Neshny::HashStruct64(positive_zero));
+
+		auto changed = [&](auto&& modify) {
+			HashTestRecord other = record;
+			modify(other);
+			return Neshny::HashStruct64(other) != hash;
+		};
+		Expect("Int changes the hash", changed([](HashTestRecord& r) { r.p_Int++; }));
+		Expect("Float changes the hash", changed([](HashTestRecord& r) { r.p_Float = 1.5000001f; }));
+		Expect("Bool changes the hash", changed([](HashTestRecord& r) { r.p_Flag = false; }));
+		Expect("Enum changes the hash", changed([](HashTestRecord& r) { r.p_Mode = HashTestMode::IDLE; }));
+		Expect("Vector member changes the hash", changed([](HashTestRecord& r) { r.p_Position.z = 3.0f; }));
+		Expect("String changes the hash", changed([](HashTestRecord& r) { r.p_Name = "player two"; }));
+		Expect("Nested struct changes the hash", changed([](HashTestRecord& r) { r.p_Items[1].p_Name = "shielf"; }));
+		Expect("Empty optional changes the hash", changed([](HashTestRecord& r) { r.p_Maybe.reset(); }));
+		Expect("Map value changes the hash", changed([](HashTestRecord& r) { r.p_Lookup["mana"] = 41; }));
+		// length prefixes keep moving characters between neighbouring strings from colliding
+		Expect("String boundaries matter", changed([](HashTestRecord& r) { r.p_Items[0].p_Name = "swords"; r.p_Items[1].p_Name = "hield"; }));
+
+		HashTestInner narrow{ 5, 2.5, "same" };
+		HashTestWideInner wide{ 5, 2.5, "same" };
+		ExpectEqual("Widening an int member keeps the hash", Neshny::HashStruct64(wide), Neshny::HashStruct64(narrow));
+		Expect("Seed changes the struct hash", Neshny::HashStruct64(narrow, 1) != Neshny::HashStruct64(narrow));
+		Expect("128 bit struct hash is repeatable", Neshny::HashStruct128(record) == Neshny::HashStruct128(MakeHashTestRecord()));
+		Expect("128 bit struct hash sees changes too", Neshny::HashStruct128(record) != Neshny::HashStruct128(positive_zero));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_HashCollisions(void) {
+		const int count = 1000000;
+
+		auto count_collisions = [](std::vector<uint64_t>& hashes) {
+			Neshny::RadixSort(hashes);
+			int collisions = 0;
+			for (int i = 1; i < (int)hashes.size(); i++) {
+				collisions += hashes[i] == hashes[i - 1] ? 1 : 0;
+			}
+			return collisions;
+		};
+
+		// sequential integers are the worst case for weak hashes
+		std::vector<uint64_t> sequential(count);
+		for (int i = 0; i < count; i++) {
+			uint64_t key = i;
+			sequential[i] = Neshny::HashBytes64(&key, sizeof(key));
+		}
+		std::vector<int> low_bits(1024, 0);
+		for (uint64_t hash : sequential) {
+			low_bits[hash & 1023]++;
+		}
+		ExpectEqual("No collisions for sequential keys", count_collisions(sequential), 0);
+
+		// chi-squared over 1024 buckets should sit near 1023, well under 1200 unless the low bits are biased
+		double expected = double(count) / low_bits.size();
+		double chi_squared = 0.0;
+		for (int bucket_count : low_bits) {
+			chi_squared += (bucket_count - expected) * (bucket_count - expected) / expected;
+		}
+		Expect(std::format("Low bits are evenly spread (chi squared {:.1f})", chi_squared), chi_squared < 1200.0);
+
+		// short strings that only differ in a character or two
+		std::vector<uint64_t> strings(count);
+		for (int i = 0; i < count; i++) {
+			strings[i] = Neshny::HashString64(std::format("entity_{}", i));
+		}
+		ExpectEqual("No collisions for similar strings", count_collisions(strings), 0);
+
+		// avalanche - flipping any one input bit should flip about half of the output bits
+		Neshny::RandomGenerator generator((uint64_t)11);
+		double total_flipped = 0.0;
+		int trials = 0;
+		for (int len : { 4, 12, 40, 200, 1000 }) {
+			std::vector<unsigned char> input(len);
+			for (int t = 0; t < 50; t++) {
+				for (auto& c : input) {
+					c = (unsigned char)generator.Next();
+				}
+				uint64_t base = Neshny::HashBytes64(input.data(), len);
+				int bit = (int)generator.NextBounded(len * 8);
+				input[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+				total_flipped += std::popcount(base ^ Neshny::HashBytes64(input.data(), len));
+				trials++;
+			}
+		}
+		double average_flipped = total_flipped / trials;
+		Expect(std::format("One input bit flips about half the output ({:.1f} of 64)", average_flipped), (average_flipped > 30.0) && (average_flipped < 34.0));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_HashBenchmark(void) {
+		auto results = BenchmarkHashing({ 16, 64, 1 << 20 });
+		for (const auto& result : results) {
+			Neshny::Core::Log(std::format("Hashing {} byte buffers runs at {:.2f} GB/s against {:.2f} GB/s for std::hash", result.p_Size, result.p_HashGBPerSec, result.p_StdHashGBPerSec));
+			Expect(std::format("Streaming {} byte pieces matches hashing all at once", result.p_Size), result.p_StreamMatches);
+		}
+	}
+
+} // namespace Test
@@ -0,0 +1,220 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// when each job started and finished, as ticks of one shared counter
+	struct JobGraphTestTimes {
+		std::vector<int>	p_Start;
+		std::vector<int>	p_End;
+		std::atomic_int		p_Clock = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// spins for a little so jobs overlap when they are allowed to
+	void JobGraphTestSpin(int micros) {
+		auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+		while (std::chrono::steady_clock::now() < end) {
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_JobGraphOrdering(void) {
+
+		for (int threads : { 1, 4 }) {
+			Neshny::JobGraph graph(threads);
+			JobGraphTestTimes times;
+			times.p_Start.assign(8, -1);
+			times.p_End.assign(8, -1);
+			auto job = [&times](int index) {
+				return [&times, index]() {
+					times.p_Start[index] = times.p_Clock++;
+					JobGraphTestSpin(200);
+					times.p_End[index] = times.p_Clock++;
+				};
+			};
+
+			// a simulation frame - input and AI both feed movement, physics writes what rendering and audio read, and the save waits on audio by hand
+			int input = graph.AddJob("Input", job(0), { {}, { "Controls" } });
+			int ai = graph.AddJob("AI", job(1), { { "Positions" }, { "Intent" } });
+			int move = graph.AddJob("Move", job(2), { { "Controls", "Intent" }, { "Positions" } });
+			int physics = graph.AddJob("Physics", job(3), { {}, { "Positions", "Contacts" } });
+			int render = graph.AddJob("Render", job(4), { { "Positions" }, {} });
+			int audio = graph.AddJob("Audio", job(5), { { "Contacts" }, {} });
+			int stats = graph.AddJob("Stats", job(6));
+			int save = graph.AddJob("Save", job(7), { { "Positions" }, {} });
+			graph.AddDependency(audio, save);
+
+			bool ran = true;
+			for (int frame = 0; frame < 20; frame++) {
+				ran = ran && graph.Run();
+			}
+			Expect(std::format("{} thread graph runs", threads), ran);
+
+			auto after = [&times](int first, int second) { return times.p_End[first] < times.p_Start[second]; };
+			Expect("Readers wait on earlier writers", after(input, move) && after(ai, move) && after(physics, render) && after(physics, audio));
+			Expect("Writers wait on earlier readers", after(ai, move) && after(move, physics));
+			Expect("Explicit dependencies are kept", after(audio, save));
+			Expect("Jobs sharing nothing wait on nothing", graph.GetDependencies(stats).empty() && graph.GetDependencies(input).empty() && graph.GetDependencies(ai).empty());
+			Expect("Only direct dependencies are listed", graph.GetDependencies(render) == std::vector<int>{ physics });
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_JobGraphCycles(void) {
+
+		Neshny::JobGraph graph(2);
+		int runs = 0;
+		int first = graph.AddJob("First", [&runs]() { runs++; }, { {}, { "A" } });
+		int second = graph.AddJob("Second", [&runs]() { runs++; }, { { "A" }, { "B" } });
+		int third = graph.AddJob("Third", [&runs]() { runs++; }, { { "B" }, {} });
+		graph.AddJob("Bystander", [&runs]() { runs++; });
+		graph.AddDependency(third, first);
+
+		std::string err;
+		Expect("A cycle does not compile", !graph.Compile(err));
+		Expect(std::format("The error names the jobs in it - {}", err), (err.find("First") != std::string::npos) && (err.find("Third") != std::string::npos) && (err.find("Bystander") == std::string::npos));
+		Expect("A graph with a cycle never runs", !graph.Run() && (runs == 0) && !graph.GetError().empty());
+
+		graph.Clear();
+		first = graph.AddJob("First", [&runs]() { runs++; });
+		graph.AddDependency(first, first);
+		Expect("A job waiting on itself is a cycle", !graph.Run());
+
+		graph.Clear();
+		first = graph.AddJob("First", [&runs]() { runs++; });
+		second = graph.AddJob("Second", [&runs]() { runs++; });
+		graph.AddDependency(second, first);
+		Expect("Dependencies can point back past the order jobs were added", graph.Run() && (runs == 2) && graph.GetError().empty());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_JobGraphParallelFor(void) {
+
+		const int count = 100003;
+		std::vector<int> values(count, 0);
+		std::vector<int> visits(count, 0);
+		std::atomic_int64_t sum = 0;
+		Neshny::JobGraph graph(4);
+
+		int fill = graph.AddParallelFor("Fill", count, 1000, [&values, &visits](int start, int end) {
+			for (int i = start; i < end; i++) {
+				values[i] = i;
+				visits[i]++;
+			}
+		}, { {}, { "Values" } });
+		int total = graph.AddParallelFor("Sum", count, 777, [&values, &sum](int start, int end) {
+			int64_t part = 0;
+			for (int i = start; i < end; i++) {
+				part += values[i];
+			}
+			sum += part;
+		}, { { "Values" }, {} });
+
+		// fork into two halves then join
+		std::atomic_int forked = 0;
+		int joined_saw = -1;
+		int fork_a = graph.AddJob("ForkA", [&forked]() { forked++; });
+		int fork_b = graph.AddJob("ForkB", [&forked]() { forked++; });
+		int join = graph.AddJob("Join", [&forked, &joined_saw]() { joined_saw = forked; });
+		graph.AddDependency(total, fork_a);
+		graph.AddDependency(total, fork_b);
+		graph.AddDependency(fork_a, join);
+		graph.AddDependency(fork_b, join);
+
+		graph.Run();
+		Expect("Every item is visited once", std::all_of(visits.begin(), visits.end(), [](int val) { return val == 1; }));
+		Expect("Later jobs see every chunk of the parallel for", sum == (int64_t)count * (count - 1) / 2);
+		ExpectEqual("Join waits on both forks", joined_saw, 2);
+
+		sum = 0;
+		graph.SetCount(fill, 500);
+		graph.SetCount(total, 500);
+		graph.Run();
+		Expect("Count changes without rebuilding", (sum == 500 * 499 / 2) && (visits[499] == 2) && (visits[500] == 1));
+
+		graph.SetCount(fill, 0);
+		graph.SetCount(total, 0);
+		Expect("An empty parallel for does not hold up what follows", graph.Run() && (joined_saw == 6));
+
+		Neshny::JobGraph throwing(3);
+		std::atomic_int after_throw = 0;
+		int throws = throwing.AddParallelFor("Throws", 64, 1, [](int start, int end) {
+			if (start == 17) {
+				throw std::runtime_error("job failed");
+			}
+		}, { {}, { "X" } });
+		throwing.AddJob("After", [&after_throw]() { after_throw++; }, { { "X" }, {} });
+		bool caught = false;
+		try {
+			throwing.Run();
+		} catch (const std::runtime_error&) {
+			caught = true;
+		}
+		Expect("Exceptions from jobs reach the caller after the graph drains", caught && (after_throw == 1));
+		throwing.SetCount(throws, 17);
+		Expect("Graph runs again after an exception", throwing.Run() && (after_throw == 2));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_JobGraphBenchmark(void) {
+
+		// eight independent systems each over 200k items, then one that reads all of them
+		const int systems = 8;
+		const int count = 200000;
+		std::vector<std::vector<float>> data(systems, std::vector<float>(count, 1.0f));
+		std::atomic<double> checksum = 0.0;
+
+		auto build = [&](Neshny::JobGraph& graph) {
+			std::vector<std::string> all;
+			for (int s = 0; s < systems; s++) {
+				std::string name = std::format("System{}", s);
+				all.push_back(name);
+				graph.AddParallelFor(name, count, 4096, [&data, s](int start, int end) {
+					auto& values = data[s];
+					for (int i = start; i < end; i++) {
+						values[i] = std::sqrt(values[i] * values[i] + (float)(s + 1));
+					}
+				}, { {}, { name } });
+			}
+			graph.AddJob("Gather", [&data, &checksum]() {
+				double total = 0.0;
+				for (const auto& values : data) {
+					total += values[0];
+				}
+				checksum = total;
+			}, { all, {} });
+		};
+
+		std::string report;
+		int runs = 0;
+		for (int threads : { 1, 2, 4 }) {
+			Neshny::JobGraph graph(threads);
+			build(graph);
+			graph.Run();
+			auto start = std::chrono::steady_clock::now();
+			for (int frame = 0; frame < 10; frame++) {
+				graph.Run();
+			}
+			runs += 11;
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / 10.0;
+			report += std::format("{}{} threads {:.2f} ms", report.empty() ? "" : ", ", threads, ms);
+		}
+		Neshny::Core::Log(std::format("A frame of {} systems over {}k items - {} on {} cores", systems, count / 1000, report, std::thread::hardware_concurrency()));
+
+		// the step never settles, so every item has to have gone through every run exactly once for these to match
+		bool all_ran = true;
+		double expected_checksum = 0.0;
+		for (int s = 0; s < systems; s++) {
+			float expected = 1.0f;
+			for (int run = 0; run < runs; run++) {
+				expected = std::sqrt(expected * expected + (float)(s + 1));
+			}
+			all_ran = all_ran && std::all_of(data[s].begin(), data[s].end(), [expected](float value) { return value == expected; });
+			expected_checksum += expected;
+		}
+		Expect("Every range of every system ran once a frame", all_ran);
+		Expect("Gather ran after the systems it reads", checksum == expected_checksum);
+	}
+
+}
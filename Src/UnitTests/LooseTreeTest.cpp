@@ -0,0 +1,293 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	constexpr double LOOSE_TEST_WORLD = 1000.0;
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D>
+	typename Neshny::LooseTree<D>::VecType LooseTestVec(double x, double y, double z) {
+		if constexpr (D == 2) {
+			return Neshny::Vec2(x, y);
+		} else {
+			return Neshny::Vec3(x, y, z);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	double LooseTestRandom(Neshny::RandomGenerator& generator, double min_val, double max_val) {
+		return min_val + (max_val - min_val) * (generator.Next() / (double)std::numeric_limits<unsigned int>::max());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// sizes spread evenly over four orders of magnitude, so most are tiny and a few cover a good part of the world
+	template<int D>
+	std::pair<typename Neshny::LooseTree<D>::VecType, typename Neshny::LooseTree<D>::VecType> MakeLooseTestBox(Neshny::RandomGenerator& generator) {
+		double half = 0.05 * std::pow(10.0, LooseTestRandom(generator, 0.0, 4.0)) * 0.5;
+		auto centre = LooseTestVec<D>(LooseTestRandom(generator, -20.0, LOOSE_TEST_WORLD + 20.0), LooseTestRandom(generator, -20.0, LOOSE_TEST_WORLD + 20.0), LooseTestRandom(generator, -20.0, LOOSE_TEST_WORLD + 20.0));
+		auto extent = LooseTestVec<D>(half, half * LooseTestRandom(generator, 0.3, 1.0), half * LooseTestRandom(generator, 0.3, 1.0));
+		return { centre - extent, centre + extent };
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// clips the segment against each pair of planes in turn
+	bool LooseTestSegmentHits(Neshny::Vec3 min_pos, Neshny::Vec3 max_pos, Neshny::Vec3 start, Neshny::Vec3 end) {
+		double enter = 0.0;
+		double leave = 1.0;
+		double mins[3] = { min_pos.x, min_pos.y, min_pos.z };
+		double maxs[3] = { max_pos.x, max_pos.y, max_pos.z };
+		double from[3] = { start.x, start.y, start.z };
+		double to[3] = { end.x, end.y, end.z };
+		for (int axis = 0; axis < 3; axis++) {
+			double delta = to[axis] - from[axis];
+			if (delta == 0.0) {
+				if ((from[axis] < mins[axis]) || (from[axis] > maxs[axis])) {
+					return false;
+				}
+				continue;
+			}
+			double t0 = (mins[axis] - from[axis]) / delta;
+			double t1 = (maxs[axis] - from[axis]) / delta;
+			enter = std::max(enter, std::min(t0, t1));
+			leave = std::min(leave, std::max(t0, t1));
+		}
+		return enter <= leave;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// runs every kind of query on the tree and against every box one by one, true if all of them agree
+	template<int D>
+	bool LooseTestQueriesMatch(const Neshny::LooseTree<D>& tree, const std::vector<std::pair<typename Neshny::LooseTree<D>::VecType, typename Neshny::LooseTree<D>::VecType>>& boxes, const std::vector<bool>& alive, Neshny::RandomGenerator& generator, int& total_found) {
+
+		auto to_vec3 = [](typename Neshny::LooseTree<D>::VecType pos) {
+			if constexpr (D == 2) {
+				return Neshny::Vec3(pos.x, pos.y, 0.0);
+			} else {
+				return pos;
+			}
+		};
+		auto overlaps = [](auto min_a, auto max_a, auto min_b, auto max_b) {
+			auto low = decltype(min_a)::Max(min_a, min_b);
+			auto high = decltype(min_a)::Min(max_a, max_b);
+			return (decltype(min_a)::Min(low, high) == low);
+		};
+
+		// looking straight down at part of the world
+		Neshny::Matrix4 view = Neshny::Matrix4::Identity();
+		view.Translate(Neshny::Vec3(-300.0, -400.0, -(D == 2 ? 500.0 : LOOSE_TEST_WORLD + 200.0)));
+		Neshny::Frustum frustum = Neshny::Frustum::FromMatrix(Neshny::Matrix4::Perspective(60.0, 1.5, 1.0, 2000.0) * view);
+
+		std::vector<int> found;
+		std::vector<int> expected;
+		bool all_match = true;
+		for (int query = 0; query < 80; query++) {
+			auto centre = LooseTestVec<D>(LooseTestRandom(generator, 0.0, LOOSE_TEST_WORLD), LooseTestRandom(generator, 0.0, LOOSE_TEST_WORLD), LooseTestRandom(generator, 0.0, LOOSE_TEST_WORLD));
+			double size = LooseTestRandom(generator, 1.0, 150.0);
+			auto extent = LooseTestVec<D>(size, size * 0.5, size);
+			auto ray_end = LooseTestVec<D>(LooseTestRandom(generator, -50.0, LOOSE_TEST_WORLD + 50.0), LooseTestRandom(generator, -50.0, LOOSE_TEST_WORLD + 50.0), LooseTestRandom(generator, -50.0, LOOSE_TEST_WORLD + 50.0));
+			int kind = query % 4;
+			expected.clear();
+			for (int i = 0; i < (int)boxes.size(); i++) {
+				if (!alive[i]) {
+					continue;
+				}
+				const auto& [min_pos, max_pos] = boxes[i];
+				bool hit = false;
+				if (kind == 0) {
+					hit = overlaps(min_pos, max_pos, centre - extent, centre + extent);
+				} else if (kind == 1) {
+					hit = (decltype(centre)::Max(min_pos, decltype(centre)::Min(max_pos, centre)) - centre).LengthSquared() <= size * size;
+				} else if (kind == 2) {
+					hit = frustum.IntersectsAABB(to_vec3(min_pos), to_vec3(max_pos));
+				} else {
+					hit = LooseTestSegmentHits(to_vec3(min_pos), to_vec3(max_pos), to_vec3(centre), to_vec3(ray_end));
+				}
+				if (hit) {
+					expected.push_back(i);
+				}
+			}
+			if (kind == 0) {
+				tree.QueryAABB(centre - extent, centre + extent, found);
+			} else if (kind == 1) {
+				tree.QuerySphere(centre, size, found);
+			} else if (kind == 2) {
+				tree.QueryFrustum(frustum, found);
+			} else {
+				tree.QueryRay(centre, ray_end, found);
+			}
+			std::sort(found.begin(), found.end());
+			all_match = all_match && (found == expected);
+			total_found += (int)found.size();
+		}
+		return all_match;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D>
+	void LooseTestQueries(std::string_view name) {
+
+		Neshny::RandomGenerator generator((uint64_t)D);
+		Neshny::LooseTree<D> tree(LooseTestVec<D>(0.0, 0.0, 0.0), LooseTestVec<D>(LOOSE_TEST_WORLD, LOOSE_TEST_WORLD, LOOSE_TEST_WORLD));
+		std::vector<std::pair<typename Neshny::LooseTree<D>::VecType, typename Neshny::LooseTree<D>::VecType>> boxes;
+		for (int i = 0; i < 5000; i++) {
+			boxes.push_back(MakeLooseTestBox<D>(generator));
+			tree.Add(boxes.back().first, boxes.back().second);
+		}
+		// entirely outside the world and bigger than it
+		boxes.push_back({ LooseTestVec<D>(-500.0, -500.0, -500.0), LooseTestVec<D>(-400.0, -400.0, -400.0) });
+		tree.Add(boxes.back().first, boxes.back().second);
+		boxes.push_back({ LooseTestVec<D>(-100.0, -100.0, -100.0), LooseTestVec<D>(3000.0, 3000.0, 3000.0) });
+		tree.Add(boxes.back().first, boxes.back().second);
+		std::vector<bool> alive(boxes.size(), true);
+
+		auto stats = tree.GetStats();
+		int found = 0;
+		Expect(std::format("{} queries match a search of every box", name), LooseTestQueriesMatch<D>(tree, boxes, alive, generator, found));
+		Expect(std::format("{} queries found something ({})", name, found), found > 0);
+		Expect(std::format("{} uses {} nodes {} deep", name, stats.p_Nodes, stats.p_Depth), (stats.p_Objects == (int)boxes.size()) && (stats.p_Depth > 5));
+
+		std::vector<int> outside;
+		tree.QueryAABB(LooseTestVec<D>(-450.0, -450.0, -450.0), LooseTestVec<D>(-90.0, -90.0, -90.0), outside);
+		auto has = [&outside](int handle) { return std::find(outside.begin(), outside.end(), handle) != outside.end(); };
+		Expect(std::format("{} finds objects outside the world", name), has((int)boxes.size() - 2) && has((int)boxes.size() - 1));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_LooseTreeQueries(void) {
+		LooseTestQueries<2>("Quadtree");
+		LooseTestQueries<3>("Octree");
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template<int D>
+	void LooseTestMoves(std::string_view name) {
+
+		Neshny::RandomGenerator generator((uint64_t)(D + 10));
+		Neshny::LooseTree<D> tree(LooseTestVec<D>(0.0, 0.0, 0.0), LooseTestVec<D>(LOOSE_TEST_WORLD, LOOSE_TEST_WORLD, LOOSE_TEST_WORLD));
+		std::vector<std::pair<typename Neshny::LooseTree<D>::VecType, typename Neshny::LooseTree<D>::VecType>> boxes;
+		std::vector<int> handles;
+		for (int i = 0; i < 3000; i++) {
+			boxes.push_back(MakeLooseTestBox<D>(generator));
+			handles.push_back(tree.Add(boxes.back().first, boxes.back().second));
+		}
+		std::vector<bool> alive(boxes.size(), true);
+
+		// small steps mostly stay within the same cell
+		int relinked = 0;
+		auto step = LooseTestVec<D>(0.01, -0.01, 0.01);
+		for (int frame = 0; frame < 10; frame++) {
+			for (int i = 0; i < (int)boxes.size(); i++) {
+				boxes[i].first += step;
+				boxes[i].second += step;
+				relinked += tree.Move(handles[i], boxes[i].first, boxes[i].second) ? 1 : 0;
+			}
+		}
+		Expect(std::format("{} only relinks a few of {} small moves ({})", name, boxes.size() * 10, relinked), relinked < (int)boxes.size());
+
+		// jumps, growth and removal
+		for (int i = 0; i < (int)boxes.size(); i++) {
+			int action = (int)generator.NextBounded(4);
+			if (action == 0) {
+				tree.Remove(handles[i]);
+				alive[i] = false;
+			} else if (action == 1) {
+				boxes[i] = MakeLooseTestBox<D>(generator);
+				tree.Move(handles[i], boxes[i].first, boxes[i].second);
+			}
+		}
+		int found = 0;
+		Expect(std::format("{} queries still match after moves and removals", name), LooseTestQueriesMatch<D>(tree, boxes, alive, generator, found));
+
+		for (int i = 0; i < (int)boxes.size(); i++) {
+			tree.Remove(handles[i]);
+		}
+		auto stats = tree.GetStats();
+		Expect(std::format("{} gives every node but the root back when emptied", name), (stats.p_Objects == 0) && (stats.p_Nodes == 1));
+		int reused = tree.Add(LooseTestVec<D>(1.0, 1.0, 1.0), LooseTestVec<D>(2.0, 2.0, 2.0));
+		Expect(std::format("{} reuses handles", name), (reused < (int)handles.size()) && tree.IsValid(reused) && !tree.IsValid(handles[reused == 0 ? 1 : 0]));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_LooseTreeMoves(void) {
+		LooseTestMoves<2>("Quadtree");
+		LooseTestMoves<3>("Octree");
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_LooseTreeBenchmark(void) {
+
+		struct LooseTestItem {
+			Neshny::Vec2	p_Min;
+			Neshny::Vec2	p_Max;
+		};
+		const int count = 20000;
+		const int queries = 2000;
+		Neshny::RandomGenerator generator((uint64_t)77);
+		std::vector<LooseTestItem> items(count);
+		for (auto& item : items) {
+			auto [min_pos, max_pos] = MakeLooseTestBox<2>(generator);
+			item = { min_pos, max_pos };
+		}
+		std::vector<std::pair<Neshny::Vec2, Neshny::Vec2>> query_boxes(queries);
+		for (auto& query : query_boxes) {
+			Neshny::Vec2 centre(LooseTestRandom(generator, 0.0, LOOSE_TEST_WORLD), LooseTestRandom(generator, 0.0, LOOSE_TEST_WORLD));
+			double size = LooseTestRandom(generator, 2.0, 40.0);
+			query = { centre - Neshny::Vec2(size, size), centre + Neshny::Vec2(size, size) };
+		}
+
+		auto time_ms = [](auto&& fn) {
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		Neshny::LooseQuadtree tree(Neshny::Vec2(0.0, 0.0), Neshny::Vec2(LOOSE_TEST_WORLD, LOOSE_TEST_WORLD));
+		std::vector<int> handles(count);
+		double tree_build = time_ms([&]() {
+			for (int i = 0; i < count; i++) {
+				handles[i] = tree.Add(items[i].p_Min, items[i].p_Max);
+			}
+		});
+		int64_t tree_found = 0;
+		std::vector<int> found;
+		double tree_query = time_ms([&]() {
+			for (const auto& [min_pos, max_pos] : query_boxes) {
+				tree.QueryAABB(min_pos, max_pos, found);
+				tree_found += found.size();
+			}
+		});
+		std::string report = std::format("{}k boxes, {} queries finding {:.0f} each, loose quadtree {:.1f} ms build, {:.1f} ms query", count / 1000, queries, tree_found / (double)queries, tree_build, tree_query);
+		bool grids_agree = true;
+		for (double cell_size : { 4.0, 64.0 }) {
+			Neshny::Grid2DBoxCPUCache<LooseTestItem> grid(Neshny::Vec2(0.0, 0.0), Neshny::Vec2(LOOSE_TEST_WORLD, LOOSE_TEST_WORLD), cell_size, [](const LooseTestItem& item) {
+				return std::pair<Neshny::Vec2, Neshny::Vec2>(item.p_Min, item.p_Max);
+			});
+			// moving means rebuilding a grid
+			double grid_build = time_ms([&]() { grid.AddItems(items); });
+			int64_t grid_found = 0;
+			double grid_query = time_ms([&]() {
+				for (const auto& [min_pos, max_pos] : query_boxes) {
+					// the grid gives everything in the cells touched, so it needs the same exact test the tree makes
+					grid.Iterate(min_pos, max_pos, [&grid_found, min_pos, max_pos](LooseTestItem* item) {
+						grid_found += ((item->p_Min.x <= max_pos.x) && (min_pos.x <= item->p_Max.x) && (item->p_Min.y <= max_pos.y) && (min_pos.y <= item->p_Max.y)) ? 1 : 0;
+					});
+				}
+			});
+			grids_agree = grids_agree && (grid_found == tree_found);
+			report += std::format(", grid of {} {:.1f} ms build, {:.1f} ms query", cell_size, grid_build, grid_query);
+		}
+		Neshny::Vec2 step(0.1, 0.05);
+		double tree_move = time_ms([&]() {
+			for (int i = 0; i < count; i++) {
+				items[i].p_Min += step;
+				items[i].p_Max += step;
+				tree.Move(handles[i], items[i].p_Min, items[i].p_Max);
+			}
+		});
+
+		report += std::format(", moving all of them {:.1f} ms", tree_move);
+		Neshny::Core::Log(report);
+		Expect("Every grid finds the same boxes as the tree", grids_agree);
+	}
+
+}
@@ -181,4 +181,94 @@ namespace Test {
         }
 #endif
     }
-}
\ No newline at end of file
+
+    void UnitTest_ShaderDependencyGraph(void) {
+
+        // two permutations of the same shader pull in different includes depending on defines
+        auto loader = [] (std::string_view fname, std::string& err) -> std::string {
+            if (fname == "Main.wgsl") {
+                return "#include \"Common.wgsl\"\n#ifdef USE_EXTRA\n#include \"Extra.wgsl\"\n#endif\nfn main() {}";
+            } else if (fname == "Other.wgsl") {
+                return "#include \"Extra.wgsl\"\nfn other() {}";
+            } else if (fname == "Common.wgsl") {
+                return "#include \"Utils.wgsl\"\nfn common() {}";
+            } else if (fname == "Extra.wgsl") {
+                return "fn extra() {}";
+            } else if (fname == "Utils.wgsl") {
+                return "fn utils() {}";
+            }
+            err = "not found";
+            return std::string();
+        };
+
+        Neshny::ShaderDependencyGraph graph;
+        auto build = [&graph, &loader](int shader_id, std::string_view filename, std::string_view insertion) {
+            std::vector<std::string> loaded_files;
+            auto recording_loader = [&loader, &loaded_files](std::string_view path, std::string& err) -> std::string {
+                loaded_files.emplace_back(path);
+                return loader(path, err);
+            };
+            std::string err_msg;
+            Neshny::Preprocess(std::format("{}{}", insertion, recording_loader(filename, err_msg)), recording_loader, err_msg);
+            graph.SetDependencies(shader_id, loaded_files);
+        };
+        build(0, "Main.wgsl", "");
+        build(1, "Main.wgsl", "#define USE_EXTRA\n");
+        build(2, "Other.wgsl", "");
+
+        ExpectEqual("Three shader instances tracked", graph.GetNumShaders(), 3);
+        Expect("Nested include is tracked", graph.GetDependencies(0) == std::vector<std::string>{ "Common.wgsl", "Main.wgsl", "Utils.wgsl" });
+        Expect("Touching the top level file only affects its permutations", graph.GetAffectedShaders({ "Main.wgsl" }) == std::vector<int>{ 0, 1 });
+        Expect("Nested include affects every shader that reaches it", graph.GetAffectedShaders({ "Utils.wgsl" }) == std::vector<int>{ 0, 1 });
+        Expect("Include behind a define only affects that permutation", graph.GetAffectedShaders({ "Extra.wgsl" }) == std::vector<int>{ 1, 2 });
+        Expect("Unrelated file affects nothing", graph.GetAffectedShaders({ "Unknown.wgsl" }).empty());
+        Expect("Multiple changes are merged without duplicates", graph.GetAffectedShaders({ "Other.wgsl", "Extra.wgsl", "Common.wgsl" }) == std::vector<int>{ 0, 1, 2 });
+
+        // reloading a permutation replaces its edges
+        build(1, "Main.wgsl", "");
+        Expect("Rebuilt permutation drops stale dependencies", graph.GetAffectedShaders({ "Extra.wgsl" }) == std::vector<int>{ 2 });
+
+        graph.RemoveShader(2);
+        Expect("Removed shader no longer watched", !graph.IsWatched("Other.wgsl"));
+        Expect("Shared files stay watched", graph.IsWatched("Utils.wgsl"));
+    }
+
+    void UnitTest_FileWatcherDebounce(void) {
+
+        Neshny::FileWatcher watcher;
+        auto start = std::chrono::steady_clock::now();
+        auto ms = [start](int millis) { return start + std::chrono::milliseconds(millis); };
+
+        // an editor saving in several steps should only produce a single change once writes settle
+        watcher.NotifyChanged("Utils.wgsl", ms(0));
+        watcher.NotifyChanged("Utils.wgsl", ms(40));
+        watcher.NotifyChanged("Utils.wgsl", ms(80));
+        watcher.NotifyChanged("Other.wgsl", ms(10));
+
+        Expect("Nothing settled during the burst", watcher.TakeSettledChanges(std::chrono::milliseconds(100), ms(100)).empty());
+        Expect("Quiet file settles first", watcher.TakeSettledChanges(std::chrono::milliseconds(100), ms(150)) == std::vector<std::string>{ "Other.wgsl" });
+        Expect("Repeated writes settle once", watcher.TakeSettledChanges(std::chrono::milliseconds(100), ms(200)) == std::vector<std::string>{ "Utils.wgsl" });
+        Expect("Changes are only reported once", watcher.TakeSettledChanges(std::chrono::milliseconds(100), ms(1000)).empty());
+
+#ifndef __EMSCRIPTEN__
+        std::error_code err;
+        auto dir = std::filesystem::temp_directory_path(err) / std::format("neshny_watch_{}", Neshny::RandomInt(0, 1 << 30));
+        std::filesystem::create_directories(dir / "sub", err);
+        Expect("Could create temporary directory", !err);
+        Expect("Watcher starts", watcher.Start({ dir.string() }, std::chrono::milliseconds(20)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        {
+            std::ofstream file(dir / "sub" / "Changed.wgsl");
+            file << "fn changed() {}";
+        }
+        std::vector<std::string> changes;
+        for (int i = 0; (i < 200) && changes.empty(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            changes = watcher.TakeSettledChanges(std::chrono::milliseconds(0));
+        }
+        watcher.Stop();
+        std::filesystem::remove_all(dir, err);
+        Expect("Change in a subdirectory is reported relative to the watched directory", changes == std::vector<std::string>{ "sub/Changed.wgsl" });
+#endif
+    }
+}
@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	Neshny::Vec3 RayTestRandomPos(Neshny::RandomGenerator& generator, double spread) {
+		auto rand = [&generator, spread]() { return ((double)generator.Next() / 4294967296.0 * 2.0 - 1.0) * spread; };
+		double x = rand();
+		double y = rand();
+		return Neshny::Vec3(x, y, rand());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	Neshny::RayPrimitiveSet MakeRayTestPrimitives(int count, uint64_t seed) {
+		Neshny::RandomGenerator generator(seed);
+		Neshny::RayPrimitiveSet prims;
+		for (int i = 0; i < count; i++) {
+			Neshny::Vec3 pos = RayTestRandomPos(generator, 100.0);
+			double radius = 0.5 + generator.NextBounded(100) * 0.02;
+			Neshny::Vec3 offset = RayTestRandomPos(generator, 4.0);
+			switch (i % 3) {
+				case 0: prims.AddSphere(pos, radius); break;
+				case 1: prims.AddCapsule(pos, pos + offset, radius); break;
+				default: prims.AddCylinder(pos, pos + offset, radius); break;
+			}
+		}
+		return prims;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	bool SameRayHit(const Neshny::RayHit& a, const Neshny::RayHit& b) {
+		if (a.p_Primitive != b.p_Primitive) {
+			return false;
+		}
+		return (!a.IsHit()) || ((a.p_Frac == b.p_Frac) && (a.p_Pos == b.p_Pos) && (a.p_Normal == b.p_Normal));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_ShaderGeometry(void) {
+		using namespace Neshny::ShaderGeometry;
+		using Neshny::fVec3;
+
+		Expect("Sphere distance", fabs(SDFSphere(fVec3(3.0f, 4.0f, 0.0f), fVec3(0.0f, 0.0f, 0.0f), 2.0f) - 3.0f) < 0.0001);
+		Expect("Capsule distance beside", fabs(SDFCapsule(fVec3(0.0f, 3.0f, 5.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f) - 2.0f) < 0.0001);
+		Expect("Capsule distance past the end", fabs(SDFCapsule(fVec3(0.0f, 0.0f, 13.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f) - 2.0f) < 0.0001);
+		Expect("Cylinder distance beside", fabs(SDFCylinder(fVec3(0.0f, 3.0f, 5.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f) - 2.0f) < 0.0001);
+		Expect("Cylinder distance past the flat end", fabs(SDFCylinder(fVec3(0.5f, 0.0f, 12.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f) - 2.0f) < 0.0001);
+		Expect("Cylinder distance inside", fabs(SDFCylinder(fVec3(0.0f, 0.0f, 5.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f) + 1.0f) < 0.0001);
+
+		fVec3 hit_pos, normal;
+		float hit_frac;
+		Expect("Plane hit", RayPlane(fVec3(0.0f, 0.0f, 5.0f), fVec3(0.0f, 0.0f, 1.0f), fVec3(1.0f, 1.0f, 0.0f), fVec3(1.0f, 1.0f, 20.0f), hit_pos, hit_frac) && (fabs(hit_frac - 5.0f) < 0.0001) && hit_pos.Nearby(fVec3(1.0f, 1.0f, 5.0f), 0.0001f));
+		Expect("Parallel plane misses", !RayPlane(fVec3(0.0f, 0.0f, 5.0f), fVec3(0.0f, 0.0f, 1.0f), fVec3(0.0f, 0.0f, 0.0f), fVec3(1.0f, 0.0f, 0.0f), hit_pos, hit_frac));
+
+		fVec3 side_x, side_y;
+		CylinderSides(fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), side_x, side_y);
+		Expect("Sides are perpendicular", (fabs(side_x | side_y) < 0.0001) && (fabs(side_x | fVec3(0.0f, 0.0f, 1.0f)) < 0.0001) && (fabs(side_x.Length() - 1.0f) < 0.0001) && (fabs(side_y.Length() - 1.0f) < 0.0001));
+		Expect("Capsule body hit", RayCylinder(fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f, side_x, side_y, fVec3(-10.0f, 0.0f, 5.0f), fVec3(10.0f, 0.0f, 5.0f), true, hit_pos, normal, hit_frac)
+			&& (fabs(hit_frac - 0.45f) < 0.0001) && normal.Nearby(fVec3(-1.0f, 0.0f, 0.0f), 0.0001f));
+		Expect("Capsule cap hit", RayCylinder(fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f, side_x, side_y, fVec3(0.0f, -10.0f, 10.5f), fVec3(0.0f, 10.0f, 10.5f), true, hit_pos, normal, hit_frac)
+			&& hit_pos.Nearby(fVec3(0.0f, -sqrtf(0.75f), 10.5f), 0.0001f) && (fabs(normal.Length() - 1.0f) < 0.0001));
+		Expect("Cylinder misses where the capsule cap would be", !RayCylinder(fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f, side_x, side_y, fVec3(0.0f, -10.0f, 10.5f), fVec3(0.0f, 10.0f, 10.5f), false, hit_pos, normal, hit_frac));
+		Expect("Flat cap hit is a fraction", RayCylinder(fVec3(0.0f, 0.0f, 0.0f), fVec3(0.0f, 0.0f, 10.0f), 1.0f, side_x, side_y, fVec3(0.2f, 0.0f, 30.0f), fVec3(0.5f, 0.0f, -10.0f), false, hit_pos, normal, hit_frac)
+			&& (fabs(hit_frac - 0.5f) < 0.0001) && normal.Nearby(fVec3(0.0f, 0.0f, 1.0f), 0.0001f));
+
+		// the float port has to agree with the double version in Geometry.h
+		Neshny::RandomGenerator generator((uint64_t)40);
+		int disagreements = 0;
+		for (int i = 0; i < 10000; i++) {
+			Neshny::Vec3 centre = RayTestRandomPos(generator, 10.0);
+			Neshny::Vec3 origin = RayTestRandomPos(generator, 20.0);
+			Neshny::Vec3 end = RayTestRandomPos(generator, 20.0);
+			double radius = 1.0 + generator.NextBounded(50) * 0.1;
+			Neshny::Vec3 ref_pos, ref_normal;
+			double ref_frac = 0.0;
+			bool ref_hit = Neshny::RaySphere(centre, radius, origin, end, ref_pos, ref_frac, &ref_normal);
+			bool hit = RaySphere(centre.ToFloat3(), (float)radius, origin.ToFloat3(), end.ToFloat3(), hit_pos, normal, hit_frac);
+			if (ref_hit != hit) {
+				// only allowed when the ray barely grazes it
+				Neshny::Vec3 dir = (end - origin).NormalizeCopy();
+				Neshny::Vec3 to_centre = centre - origin;
+				double line_dist = (to_centre - dir * (to_centre | dir)).Length();
+				disagreements += (fabs(line_dist - radius) > 0.001) ? 1 : 0;
+			} else if (hit) {
+				disagreements += ((fabs(ref_frac - hit_frac) > 0.001) || !ref_pos.ToFloat3().Nearby(hit_pos, 0.01f) || !ref_normal.ToFloat3().Nearby(normal, 0.01f)) ? 1 : 0;
+			}
+		}
+		ExpectEqual("Float sphere matches double sphere", disagreements, 0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_RayQueriesMatchReference(void) {
+		auto prims = MakeRayTestPrimitives(600, 41);
+		Neshny::RandomGenerator generator((uint64_t)42);
+		std::vector<Neshny::Ray> rays;
+		for (int i = 0; i < 5000; i++) {
+			rays.push_back({ RayTestRandomPos(generator, 120.0).ToFloat3(), RayTestRandomPos(generator, 120.0).ToFloat3() });
+		}
+		rays.push_back({ Neshny::fVec3(1.0f, 2.0f, 3.0f), Neshny::fVec3(1.0f, 2.0f, 3.0f) });
+
+		std::vector<Neshny::RayHit> hits;
+		prims.CastRays(rays, hits);
+		int mismatches = 0;
+		int num_hits = 0;
+		int types_hit = 0;
+		for (int i = 0; i < (int)rays.size(); i++) {
+			auto reference = prims.CastRay(rays[i].p_Origin, rays[i].p_End);
+			mismatches += SameRayHit(hits[i], reference) ? 0 : 1;
+			if (reference.IsHit()) {
+				num_hits++;
+				types_hit |= 1 << (int)prims.Get(reference.p_Primitive).p_Type;
+			}
+		}
+		ExpectEqual("Batched hits are exactly the reference ones", mismatches, 0);
+		Expect("Plenty of rays hit something", num_hits > 500);
+		ExpectEqual("Every type gets hit", types_hit, 7);
+		Expect("Zero length ray hits nothing", !hits.back().IsHit());
+
+		std::vector<Neshny::RayHit> threaded;
+		prims.CastRays(rays, threaded, 6);
+		bool same_threaded = threaded.size() == hits.size();
+		for (int i = 0; same_threaded && (i < (int)hits.size()); i++) {
+			same_threaded = SameRayHit(hits[i], threaded[i]);
+		}
+		Expect("Threads give the same hits", same_threaded);
+
+		std::vector<Neshny::fVec3> points;
+		for (int i = 0; i < 5000; i++) {
+			points.push_back(RayTestRandomPos(generator, 120.0).ToFloat3());
+		}
+		std::vector<float> distances;
+		std::vector<int> nearest;
+		prims.SignedDistances(points, distances, &nearest, 3);
+		mismatches = 0;
+		int inside = 0;
+		for (int i = 0; i < (int)points.size(); i++) {
+			int ref_nearest;
+			float ref_dist = prims.SignedDistance(points[i], &ref_nearest);
+			mismatches += ((distances[i] == ref_dist) && (nearest[i] == ref_nearest)) ? 0 : 1;
+			inside += ref_dist < 0.0f ? 1 : 0;
+		}
+		ExpectEqual("Batched distances are exactly the reference ones", mismatches, 0);
+		Expect("Some points are inside", inside > 0);
+
+		Neshny::RayPrimitiveSet empty;
+		int none = 0;
+		Expect("Nothing to hit", !empty.CastRay(Neshny::fVec3(0.0f, 0.0f, 0.0f), Neshny::fVec3(1.0f, 0.0f, 0.0f)).IsHit());
+		Expect("Nothing to be near", std::isinf(empty.SignedDistance(Neshny::fVec3(0.0f, 0.0f, 0.0f), &none)) && (none == -1));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	struct RayBenchmarkResult {
+		double	p_ReferenceMs;
+		double	p_BatchedMs;
+		double	p_ThreadedMs;
+		int		p_Mismatches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// not a unit test on its own - casts the same rays one primitive at a time, batched, and batched on threads, best of a few runs
+	RayBenchmarkResult BenchmarkRayQueries(int num_prims, int num_rays, int threads) {
+		auto prims = MakeRayTestPrimitives(num_prims, 43);
+		Neshny::RandomGenerator generator((uint64_t)44);
+		std::vector<Neshny::Ray> rays;
+		for (int i = 0; i < num_rays; i++) {
+			Neshny::Vec3 origin = RayTestRandomPos(generator, 120.0);
+			rays.push_back({ origin.ToFloat3(), (origin + RayTestRandomPos(generator, 30.0)).ToFloat3() });
+		}
+		std::vector<Neshny::RayHit> hits(rays.size());
+		auto best_ms = [](auto&& cast_func) {
+			double best_seconds = std::numeric_limits<double>::max();
+			for (int run = 0; run < 3; run++) {
+				auto start = std::chrono::high_resolution_clock::now();
+				cast_func();
+				best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			return best_seconds * 1000.0;
+		};
+		double reference = best_ms([&]() {
+			for (int i = 0; i < num_rays; i++) {
+				hits[i] = prims.CastRay(rays[i].p_Origin, rays[i].p_End);
+			}
+		});
+		std::vector<Neshny::RayHit> reference_hits = hits;
+		int mismatches = 0;
+		auto count_mismatches = [&]() {
+			for (int i = 0; i < num_rays; i++) {
+				mismatches += ((hits[i].p_Primitive == reference_hits[i].p_Primitive) && (hits[i].p_Frac == reference_hits[i].p_Frac)) ? 0 : 1;
+			}
+		};
+		double batched = best_ms([&]() { prims.CastRays(rays, hits); });
+		count_mismatches();
+		double threaded = best_ms([&]() { prims.CastRays(rays, hits, threads); });
+		count_mismatches();
+		return { reference, batched, threaded, mismatches };
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_RayQueriesBenchmark(void) {
+		auto result = BenchmarkRayQueries(1000, 20000, 4);
+		Neshny::Core::Log(std::format("Casting 20k rays at 1k primitives takes {:.2f} ms one primitive at a time, {:.2f} ms batched and {:.2f} ms on 4 threads", result.p_ReferenceMs, result.p_BatchedMs, result.p_ThreadedMs));
+		ExpectEqual("Benchmarked batched hits are exactly the reference ones", result.p_Mismatches, 0);
+	}
+
+} // namespace Test
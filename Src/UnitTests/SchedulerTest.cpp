@@ -0,0 +1,134 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// a chaotic little system so any difference in step size or order shows up in the state
+	class SchedulerTestWorld : public Neshny::ISimulation {
+	public:
+		SchedulerTestWorld(double seed) : p_X(seed), p_Y(1.0 - seed) {}
+		void Step(double step_seconds, int64_t tick) override {
+			p_InOrder = p_InOrder && (tick == (int64_t)p_Ticks.size());
+			p_Ticks.push_back(tick);
+			p_SameStep = p_SameStep && (step_seconds == 1.0 / 60.0);
+			double dx = 10.0 * (p_Y - p_X);
+			double dy = p_X * (28.0 - p_Z) - p_Y;
+			double dz = p_X * p_Y - (8.0 / 3.0) * p_Z;
+			p_X += dx * step_seconds * 0.1;
+			p_Y += dy * step_seconds * 0.1;
+			p_Z += dz * step_seconds * 0.1;
+		}
+		double p_X;
+		double p_Y;
+		double p_Z = 10.0;
+		bool p_InOrder = true;
+		bool p_SameStep = true;
+		std::vector<int64_t> p_Ticks;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_SchedulerFixedRate(void) {
+		using namespace std::chrono_literals;
+		Neshny::FixedStepScheduler scheduler;
+		SchedulerTestWorld world(0.5);
+		scheduler.AddWorld(&world);
+
+		// one second in uneven frames of 5 to 25ms still adds up to exactly 60 ticks
+		Neshny::RandomGenerator generator((uint64_t)36);
+		int64_t remaining = 1000000000;
+		int ticks = 0;
+		bool alpha_in_range = true;
+		while (remaining > 0) {
+			int64_t frame = std::min(remaining, (int64_t)(5000000 + generator.NextBounded(20000000)));
+			remaining -= frame;
+			ticks += scheduler.Advance(Neshny::TimerNanos(frame));
+			alpha_in_range = alpha_in_range && (scheduler.GetAlpha() >= 0.0) && (scheduler.GetAlpha() < 1.0);
+		}
+		ExpectEqual("A second is exactly 60 ticks", ticks, 60);
+		ExpectEqual("Tick counter matches", scheduler.GetTick(), (int64_t)60);
+		Expect("Alpha stays within a tick", alpha_in_range);
+		Expect("Nothing left over", scheduler.GetAlpha() == 0.0);
+		Expect("Ticks in order with a fixed step", world.p_InOrder && world.p_SameStep);
+
+		scheduler.Advance(8333333ns);
+		Expect("Half a tick gives half alpha", fabs(scheduler.GetAlpha() - 0.5) < 0.000001);
+		ExpectEqual("No tick for half a frame", scheduler.GetTick(), (int64_t)60);
+		ExpectEqual("Negative time does nothing", scheduler.Advance(-5s), 0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_SchedulerCatchUp(void) {
+		using namespace std::chrono_literals;
+		Neshny::FixedStepScheduler scheduler({ 60, 4 });
+		SchedulerTestWorld world(0.5);
+		scheduler.AddWorld(&world);
+
+		ExpectEqual("A hitch only runs the catch up budget", scheduler.Advance(1s), 4);
+		ExpectEqual("The rest is dropped", scheduler.GetDroppedTicks(), (int64_t)56);
+		Expect("Alpha is still valid after a hitch", (scheduler.GetAlpha() >= 0.0) && (scheduler.GetAlpha() < 1.0));
+		ExpectEqual("Hours of hitch does not overflow", scheduler.Advance(std::chrono::hours(100000)), 4);
+		ExpectEqual("Back to normal straight after", scheduler.Advance(17ms), 1);
+		Expect("Ticks never skipped for the world", world.p_InOrder && (world.p_Ticks.size() == 9));
+
+		Neshny::FixedStepScheduler unthrottled({ 60, 100, true });
+		SchedulerTestWorld server_world(0.5);
+		unthrottled.AddWorld(&server_world);
+		ExpectEqual("Unthrottled ignores real time", unthrottled.Advance(0ns), 100);
+		unthrottled.RunTicks(50);
+		ExpectEqual("Run ticks directly", unthrottled.GetTick(), (int64_t)150);
+		ExpectEqual("Nothing is dropped when unthrottled", unthrottled.GetDroppedTicks(), (int64_t)0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_SchedulerDeterministic(void) {
+		using namespace std::chrono_literals;
+		const int num_worlds = 7;
+
+		// the same ten seconds split up differently, and stepped on different numbers of threads, must give the same worlds
+		auto run = [num_worlds](int threads, int frame_micros) {
+			Neshny::FixedStepScheduler scheduler({ 60, 8, false, threads });
+			std::vector<std::unique_ptr<SchedulerTestWorld>> worlds;
+			for (int i = 0; i < num_worlds; i++) {
+				worlds.push_back(std::make_unique<SchedulerTestWorld>(0.1 * i));
+				scheduler.AddWorld(worlds.back().get());
+			}
+			for (int64_t elapsed = 0; elapsed < 10000000; elapsed += frame_micros) {
+				scheduler.Advance(std::chrono::microseconds(frame_micros));
+			}
+			return worlds;
+		};
+		auto reference = run(1, 20000);
+		bool identical = true;
+		bool in_order = true;
+		for (auto [threads, frame_micros] : std::vector<std::pair<int, int>>{ { 1, 5000 }, { 4, 16000 }, { 3, 40000 }, { 16, 8000 } }) {
+			auto worlds = run(threads, frame_micros);
+			for (int i = 0; i < num_worlds; i++) {
+				identical = identical && (worlds[i]->p_Ticks == reference[i]->p_Ticks) && (worlds[i]->p_X == reference[i]->p_X) && (worlds[i]->p_Y == reference[i]->p_Y) && (worlds[i]->p_Z == reference[i]->p_Z);
+				in_order = in_order && worlds[i]->p_InOrder && worlds[i]->p_SameStep;
+			}
+		}
+		Expect("Every split and thread count gives bit identical worlds", identical);
+		Expect("Every world gets every tick in order", in_order);
+		ExpectEqual("Ten seconds of ticks", (int)reference[0]->p_Ticks.size(), 600);
+
+		class ThrowingWorld : public Neshny::ISimulation {
+		public:
+			void Step(double, int64_t tick) override { if (tick == 3) { throw std::runtime_error("world failed"); } }
+		};
+		Neshny::FixedStepScheduler scheduler({ 60, 8, true, 4 });
+		SchedulerTestWorld fine_world(0.5);
+		ThrowingWorld throwing_world;
+		scheduler.AddWorld(&fine_world);
+		scheduler.AddWorld(&throwing_world);
+		bool caught = false;
+		try {
+			scheduler.Advance(0ns);
+		} catch (const std::runtime_error&) {
+			caught = true;
+		}
+		Expect("Exceptions from worker threads reach the caller", caught);
+		scheduler.RemoveWorld(&throwing_world);
+		ExpectEqual("Scheduler still works afterwards", scheduler.Advance(0ns), 8);
+	}
+
+} // namespace Test
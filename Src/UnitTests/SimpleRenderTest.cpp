@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	using Render = Neshny::BaseSimpleRender;
+	using Neshny::Vec3;
+	using Neshny::Vec4;
+	using Neshny::fVec4;
+
+	void UnitTest_SimpleRenderBatching(void) {
+
+		std::vector<Render::SimpleLine> lines = {
+			{ Vec3(0, 0, 0), Vec3(1, 0, 0), Vec4(1, 0, 0, 1), false },
+			{ Vec3(0, 1, 0), Vec3(1, 1, 0), Vec4(0, 1, 0, 1), false }
+		};
+		std::vector<Render::SimplePoint> points = {
+			{ Vec3(2, 2, 0), "", Vec4(1, 1, 1, 1), false }
+		};
+		std::vector<Render::SimpleTriangle> triangles = {
+			{ Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(0, 1, 0), Vec4(0, 0, 1, 1) }
+		};
+		std::vector<Render::SimpleCircle> circles = {
+			{ Vec3(3, 4, 0), 2.0, Vec4(1, 1, 0, 1) }
+		};
+		std::vector<Render::SimpleSquare> squares = {
+			{ Vec3(0, 0, 0), Vec3(1, 1, 0), Vec4(1, 0, 1, 1), false },
+			{ Vec3(0, 0, 0), Vec3(1, 1, 0), Vec4(1, 0, 1, 1), true }
+		};
+
+		Render::GeometryBatcher batcher;
+		const Vec3 offset(1, 1, 0);
+		const double scale = 2.0;
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+
+		// 2 per line, 4 per point, 8 per outlined square; 3 per triangle, 6 per filled square; 1 per circle
+		ExpectEqual("Line batch vertex count", (int)batcher.GetVertices(Render::BATCH_LINES).size(), 2 * 2 + 4 + 8);
+		ExpectEqual("Triangle batch vertex count", (int)batcher.GetVertices(Render::BATCH_TRIANGLES).size(), 3 + 6);
+		ExpectEqual("Circle batch vertex count", (int)batcher.GetVertices(Render::BATCH_CIRCLES).size(), 1);
+		ExpectEqual("First build uploads all lines", batcher.GetDirtyRange(Render::BATCH_LINES).p_Count, 2 * 2 + 4 + 8);
+
+		const auto& line_verts = batcher.GetVertices(Render::BATCH_LINES);
+		Expect("Lines are offset and scaled", line_verts[1].p_Pos == fVec4(0, -2, 0, 1));
+		Expect("Points start at the transformed position", line_verts[4].p_Pos == fVec4(2, 2, 0, 1) && line_verts[6].p_Pos == fVec4(2, 2, 0, 1));
+		const auto& circle = batcher.GetVertices(Render::BATCH_CIRCLES)[0];
+		Expect("Circles pack position and scaled radius", circle.p_Pos == fVec4(4, 6, 4, 4));
+
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+		Expect("Identical rebuild is clean", !batcher.IsDirty());
+
+		lines.push_back({ Vec3(5, 5, 5), Vec3(6, 6, 6), Vec4(1, 1, 1, 1), false });
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+		auto range = batcher.GetDirtyRange(Render::BATCH_LINES);
+		ExpectEqual("Appending a line dirties from the insertion point", range.p_Start, 4);
+		ExpectEqual("Appending a line dirties to the end", range.p_Start + range.p_Count, (int)batcher.GetVertices(Render::BATCH_LINES).size());
+		ExpectEqual("Other batches untouched by a line", batcher.GetDirtyRange(Render::BATCH_TRIANGLES).p_Count, 0);
+
+		triangles.push_back({ Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(0, 1, 0), Vec4(0, 0, 1, 1) });
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+		triangles[0].p_B = Vec3(2, 0, 0);
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+		range = batcher.GetDirtyRange(Render::BATCH_TRIANGLES);
+		ExpectEqual("Changing one vertex dirties only that vertex", range.p_Start, 6 + 1);
+		ExpectEqual("Changing one vertex dirties a single vertex", range.p_Count, 1);
+		ExpectEqual("Lines untouched by a triangle", batcher.GetDirtyRange(Render::BATCH_LINES).p_Count, 0);
+
+		circles.clear();
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale, 0.5);
+		ExpectEqual("Shrinking leaves nothing to upload", batcher.GetDirtyRange(Render::BATCH_CIRCLES).p_Count, 0);
+		ExpectEqual("Shrinking empties the batch", (int)batcher.GetVertices(Render::BATCH_CIRCLES).size(), 0);
+
+		batcher.Build(lines, points, triangles, circles, squares, offset, scale * 2.0, 0.5);
+		ExpectEqual("Rescaling dirties every line", batcher.GetDirtyRange(Render::BATCH_LINES).p_Count, (int)batcher.GetVertices(Render::BATCH_LINES).size());
+	}
+
+	void UnitTest_SimpleRenderPointJitter(void) {
+
+		bool in_range = true;
+		bool deterministic = true;
+		int distinct = 0;
+		for (int i = 0; i < 1000; i++) {
+			Vec3 pos(i * 0.37, i * -1.1, i * 2.0);
+			Vec3 a = Render::PointJitter(pos, 0);
+			Vec3 b = Render::PointJitter(pos, 1);
+			for (double v : { a.x, a.y, a.z, b.x, b.y, b.z }) {
+				in_range = in_range && (v >= -0.5) && (v < 0.5);
+			}
+			deterministic = deterministic && (a == Render::PointJitter(pos, 0)) && (b == Render::PointJitter(pos, 1));
+			distinct += (a == b) ? 0 : 1;
+		}
+		Expect("Jitter is within half a unit", in_range);
+		Expect("Jitter is stable for the same point", deterministic);
+		ExpectEqual("The two jitter lines of a point differ", distinct, 1000);
+	}
+
+} // namespace Test
@@ -0,0 +1,186 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	struct SortBenchmarkResult {
+		int		p_Count;
+		double	p_RadixMs;
+		double	p_StdSortMs;
+		bool	p_Matches;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// not a unit test on its own - call with larger sizes (up to 100M fits in a few GB) to compare against std::sort on a given machine
+	template <class K>
+	std::vector<SortBenchmarkResult> BenchmarkRadixSort(const std::vector<int>& counts, int max_threads = -1) {
+		std::vector<SortBenchmarkResult> results;
+		Neshny::RandomGenerator generator((uint64_t)1234);
+		for (int count : counts) {
+			std::vector<K> source(count);
+			for (auto& key : source) {
+				uint64_t bits = (uint64_t(generator.Next()) << 32) | generator.Next();
+				if constexpr (std::is_floating_point_v<K>) {
+					key = K(int64_t(bits) >> 16) * K(0.001);
+				} else {
+					key = K(bits);
+				}
+			}
+			auto time_ms = [&source](std::vector<K>& keys, auto&& sort_func) {
+				keys = source;
+				auto start = std::chrono::high_resolution_clock::now();
+				sort_func(keys);
+				return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			};
+			std::vector<K> radix_keys;
+			std::vector<K> std_keys;
+			double radix_ms = time_ms(radix_keys, [max_threads](std::vector<K>& keys) { Neshny::RadixSort(keys, max_threads); });
+			double std_ms = time_ms(std_keys, [](std::vector<K>& keys) { std::sort(keys.begin(), keys.end()); });
+			results.push_back({ count, radix_ms, std_ms, radix_keys == std_keys });
+		}
+		return results;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	template <class K>
+	void CheckRadixSort(const char* type_name, int count, int max_threads) {
+		Neshny::RandomGenerator generator((uint64_t)count);
+		std::vector<K> keys(count);
+		for (int i = 0; i < count; i++) {
+			uint64_t bits = (uint64_t(generator.Next()) << 32) | generator.Next();
+			if constexpr (std::is_floating_point_v<K>) {
+				keys[i] = K(int64_t(bits) >> 20) * K(0.01);
+			} else if (i % 3 == 0) {
+				keys[i] = K(bits % 16); // plenty of duplicates and keys that only differ in the low byte
+			} else {
+				keys[i] = K(bits);
+			}
+		}
+		std::vector<K> expected = keys;
+		std::sort(expected.begin(), expected.end());
+		Neshny::RadixSort(keys, max_threads);
+		Expect(std::format("Radix sort of {} {} keys on {} threads matches std::sort", count, type_name, max_threads), keys == expected);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_RadixSortKeys(void) {
+		for (int count : { 0, 1, 2, 17, 1000, 100000 }) {
+			for (int max_threads : { 1, 4 }) {
+				CheckRadixSort<uint32_t>("uint32", count, max_threads);
+				CheckRadixSort<int32_t>("int32", count, max_threads);
+				CheckRadixSort<uint64_t>("uint64", count, max_threads);
+				CheckRadixSort<int64_t>("int64", count, max_threads);
+				CheckRadixSort<float>("float", count, max_threads);
+				CheckRadixSort<double>("double", count, max_threads);
+			}
+		}
+
+		std::vector<float> special = { 0.0f, -0.0f, 1.0f, -1.0f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::denorm_min() };
+		Neshny::RadixSort(special);
+		Expect("Floats sort across the sign, infinities at the ends", std::is_sorted(special.begin(), special.end()) && (special.front() == -std::numeric_limits<float>::infinity()) && (special.back() == std::numeric_limits<float>::infinity()));
+		ExpectEqual("Negative zero sorts before positive zero", std::signbit(special[3]) && !std::signbit(special[4]), true);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_RadixSortPairs(void) {
+		for (int max_threads : { 1, 4 }) {
+			const int count = 200000;
+			std::vector<int> keys(count);
+			std::vector<int> values(count);
+			for (int i = 0; i < count; i++) {
+				keys[i] = ((i * 7919) % 1000) - 500;
+				values[i] = i;
+			}
+			std::vector<std::pair<int, int>> expected;
+			for (int i = 0; i < count; i++) {
+				expected.push_back({ keys[i], values[i] });
+			}
+			std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+			Neshny::RadixSort(keys, values, max_threads);
+			bool matches = true;
+			for (int i = 0; i < count; i++) {
+				matches = matches && (keys[i] == expected[i].first) && (values[i] == expected[i].second);
+			}
+			Expect(std::format("Key value radix sort is stable on {} threads", max_threads), matches);
+		}
+
+		std::vector<uint64_t> keys = { 3, 1, 2 };
+		std::vector<std::string> names = { "three", "one", "two" };
+		Neshny::RadixSort(keys, names);
+		Expect("Non-trivial values follow their keys", names == std::vector<std::string>{ "one", "two", "three" });
+
+		std::vector<int> mismatched(2);
+		bool threw = false;
+		try {
+			Neshny::RadixSort(keys, mismatched);
+		} catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		Expect("Mismatched key and value counts throw", threw);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_RadixSortBenchmark(void) {
+		auto results = BenchmarkRadixSort<uint32_t>({ 1000, 10000, 100000, 1000000 });
+		for (const auto& result : results) {
+			Neshny::Core::Log(std::format("Radix sort of {} keys takes {:.2f}ms against {:.2f}ms for std::sort", result.p_Count, result.p_RadixMs, result.p_StdSortMs));
+			Expect(std::format("Radix sort of {} keys matches std::sort", result.p_Count), result.p_Matches);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_Shuffle(void) {
+
+		std::vector<int> original(1000);
+		for (int i = 0; i < (int)original.size(); i++) {
+			original[i] = i;
+		}
+
+		std::vector<int> first = original;
+		std::vector<int> second = original;
+		Neshny::Shuffle(first, uint64_t(42));
+		Neshny::Shuffle(second, uint64_t(42));
+		Expect("Seeded shuffle is deterministic", first == second);
+		Expect("Shuffle actually moves things", first != original);
+		std::vector<int> sorted = first;
+		std::sort(sorted.begin(), sorted.end());
+		Expect("Shuffle is a permutation", sorted == original);
+
+		std::vector<int> other_seed = original;
+		Neshny::Shuffle(other_seed, uint64_t(43));
+		Expect("Different seeds give different orders", other_seed != first);
+
+		// every position should see every value about equally often
+		const int size = 4;
+		const int trials = 40000;
+		int position_counts[size][size] = {};
+		Neshny::RandomGenerator generator((uint64_t)7);
+		for (int t = 0; t < trials; t++) {
+			std::vector<int> small = { 0, 1, 2, 3 };
+			Neshny::Shuffle(small, generator);
+			for (int pos = 0; pos < size; pos++) {
+				position_counts[pos][small[pos]]++;
+			}
+		}
+		bool uniform = true;
+		for (int pos = 0; pos < size; pos++) {
+			for (int val = 0; val < size; val++) {
+				uniform = uniform && (abs(position_counts[pos][val] - trials / size) < trials / 50);
+			}
+		}
+		Expect("Shuffle is unbiased", uniform);
+
+		std::vector<bool> flags = { true, false, false, false };
+		Neshny::Shuffle(flags, uint64_t(1));
+		ExpectEqual("Shuffle works on bool vectors", (int)std::count(flags.begin(), flags.end(), true), 1);
+
+		bool bounded = true;
+		for (unsigned int bound : { 1u, 2u, 3u, 7u, 1000u, 0x80000001u }) {
+			for (int i = 0; i < 1000; i++) {
+				bounded = bounded && (generator.NextBounded(bound) < bound);
+			}
+		}
+		Expect("NextBounded stays below the bound", bounded);
+	}
+
+} // namespace Test
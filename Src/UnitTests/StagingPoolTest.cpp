@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// stands in for a graphics device, mappings only complete when Complete is called like they would on a device tick
+	struct StagingMockDevice {
+
+		Neshny::StagingDevice Get(void) {
+			return {
+				[this](int size_bytes) -> void* {
+					p_Buffers[(void*)p_NextHandle] = std::vector<unsigned char>(size_bytes);
+					return (void*)p_NextHandle++;
+				}
+				,[this](void* handle) {
+					p_Buffers.erase(handle);
+				}
+				,[this](void* handle, int size_bytes, std::function<void(const unsigned char* data)>&& callback) {
+					p_MapSizes.push_back(size_bytes);
+					p_PendingMaps.push_back({ handle, std::move(callback) });
+				}
+			};
+		}
+
+		// what a GPU copy into the staging buffer would do
+		void Copy(Neshny::StagingPool::Target target, int value) {
+			memcpy(p_Buffers[target.p_Handle].data() + target.p_Offset, &value, sizeof(int));
+		}
+
+		void Complete(void) {
+			auto pending = std::move(p_PendingMaps);
+			p_PendingMaps.clear();
+			for (auto& [handle, callback] : pending) {
+				callback(p_Fail ? nullptr : p_Buffers[handle].data());
+			}
+		}
+
+		std::map<void*, std::vector<unsigned char>>								p_Buffers;
+		std::vector<std::pair<void*, std::function<void(const unsigned char*)>>>	p_PendingMaps;
+		std::vector<int>															p_MapSizes;
+		uintptr_t																	p_NextHandle = 1;
+		bool																		p_Fail = false;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StagingPoolSharedMaps(void) {
+		StagingMockDevice device;
+		Neshny::StagingPool pool(device.Get());
+
+		std::vector<int> results;
+		std::set<void*> handles;
+		bool aligned = true;
+		for (int i = 0; i < 10; i++) {
+			auto target = pool.Read(sizeof(int), [&results](const unsigned char* data, int size) {
+				results.push_back(*(const int*)data);
+			});
+			device.Copy(target, i * 100);
+			handles.insert(target.p_Handle);
+			aligned = aligned && (target.p_Offset == i * 8);
+		}
+		Expect("Small reads share one block", (handles.size() == 1) && aligned);
+		ExpectEqual("Nothing is mapped before a flush", (int)device.p_PendingMaps.size(), 0);
+		pool.Flush();
+		ExpectEqual("One mapping for all of them", (int)device.p_PendingMaps.size(), 1);
+		ExpectEqual("Only the used part is mapped", device.p_MapSizes.back(), 80);
+		device.Complete();
+		Expect("Every read called back in order", results == std::vector<int>{ 0, 100, 200, 300, 400, 500, 600, 700, 800, 900 });
+		auto stats = pool.GetStats();
+		Expect("Stats count the sharing", (stats.p_Reads == 10) && (stats.p_Maps == 1) && (stats.p_BlocksCreated == 1) && (stats.p_InFlightBlocks == 0) && (stats.p_FreeBlocks == 1));
+
+		// a full shared block gets mapped as soon as the next read starts a new one
+		results.clear();
+		pool.EndFrame();
+		for (int i = 0; i < 5; i++) {
+			device.Copy(pool.Read(1024, [&results](const unsigned char* data, int size) { results.push_back(*(const int*)data); }), i);
+		}
+		ExpectEqual("Full block mapped straight away", (int)device.p_PendingMaps.size(), 1);
+		pool.Flush();
+		device.Complete();
+		Expect("Reads across blocks all arrive", results == std::vector<int>{ 0, 1, 2, 3, 4 });
+
+		// big reads get their own block, sized by class, and still wait for the flush since the copy comes after Read
+		auto target = pool.Read(5000, [&results](const unsigned char* data, int size) { results.push_back(size); });
+		device.Copy(target, 7);
+		ExpectEqual("Big read has its own block", target.p_Offset, 0);
+		ExpectEqual("Big read waits for the flush", (int)device.p_PendingMaps.size(), 0);
+		pool.Flush();
+		device.Complete();
+		ExpectEqual("Big read gets its size", results.back(), 5000);
+		ExpectEqual("Size class is the next power of two", (int)device.p_Buffers[target.p_Handle].size(), 8192);
+
+		// a callback that reads again lands in the next mapping
+		bool inner_done = false;
+		device.Copy(pool.Read(sizeof(int), [&pool, &device, &inner_done](const unsigned char* data, int size) {
+			device.Copy(pool.Read(sizeof(int), [&inner_done](const unsigned char* data, int size) { inner_done = true; }), 1);
+		}), 0);
+		pool.Flush();
+		device.Complete();
+		pool.Flush();
+		device.Complete();
+		Expect("Reads from inside callbacks work", inner_done);
+
+		device.p_Fail = true;
+		bool got_null = false;
+		device.Copy(pool.Read(sizeof(int), [&got_null](const unsigned char* data, int size) { got_null = data == nullptr; }), 0);
+		pool.Flush();
+		device.Complete();
+		Expect("Failed mappings call back with no data", got_null);
+		ExpectEqual("Failed mappings still give the block back", pool.GetStats().p_InFlightBlocks, 0);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StagingPoolReuse(void) {
+		StagingMockDevice device;
+		{
+			Neshny::StagingPoolParams params;
+			params.p_MaxPooledBytes = 1 << 16;
+			params.p_ReuseAfterFrames = 1;
+			params.p_TrimAfterFrames = 3;
+			Neshny::StagingPool pool(device.Get(), params);
+
+			ExpectEqual("Smallest class", pool.GetSizeClass(1), 0);
+			ExpectEqual("Exact class", pool.GetSizeClass(256), 0);
+			ExpectEqual("Next class up", pool.GetSizeClass(257), 1);
+			ExpectEqual("Too big to pool", pool.GetSizeClass((1 << 16) + 1), -1);
+
+			auto read = [&pool, &device]() {
+				device.Copy(pool.Read(sizeof(int), [](const unsigned char* data, int size) {}), 0);
+				pool.Flush();
+				device.Complete();
+			};
+			read();
+			read();
+			ExpectEqual("Released blocks wait for the frame to end", pool.GetStats().p_BlocksCreated, (int64_t)2);
+			for (int frame = 0; frame < 60; frame++) {
+				pool.EndFrame();
+				read();
+				read();
+			}
+			auto stats = pool.GetStats();
+			Expect("Steady reads stop creating buffers", (stats.p_BlocksCreated == 2) && (stats.p_BlocksReused == 120) && (stats.p_LiveBlocks == 2));
+
+			// a frame of lots of reads, then back to normal, trims the extras
+			std::vector<int> sizes{ 5000, 5000, 5000, 300 };
+			for (int size : sizes) {
+				device.Copy(pool.Read(size, [](const unsigned char* data, int size) {}), 0);
+			}
+			pool.Flush();
+			device.Complete();
+			ExpectEqual("Spike creates buffers", pool.GetStats().p_LiveBlocks, 2 + 4);
+			for (int frame = 0; frame < 10; frame++) {
+				pool.EndFrame();
+				read();
+			}
+			ExpectEqual("Unused buffers get trimmed", pool.GetStats().p_LiveBlocks, 1);
+			ExpectEqual("Live bytes follow", pool.GetStats().p_LiveBytes, (int64_t)pool.GetParams().p_SharedBlockBytes);
+
+			device.Copy(pool.Read(100000, [](const unsigned char* data, int size) {}), 0);
+			pool.Flush();
+			device.Complete();
+			stats = pool.GetStats();
+			Expect("Oversized reads are destroyed afterwards", (stats.p_OversizedReads == 1) && (stats.p_LiveBlocks == 1) && (stats.p_PeakLiveBytes >= 100000));
+		}
+		Expect("Destroying the pool destroys every buffer", device.p_Buffers.empty());
+	}
+
+#if defined(NESHNY_WEBGPU)
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StagingReadsWebGPU(void) {
+		std::vector<int> values;
+		for (int i = 0; i < 64; i++) {
+			values.push_back(i);
+		}
+		Neshny::WebGPUBuffer buffer(WGPUBufferUsage_Storage, (unsigned char*)values.data(), (int)(values.size() * sizeof(int)));
+
+		auto& pool = Neshny::WebGPUBuffer::GetStagingPool();
+		pool.Flush();
+		auto before = pool.GetStats();
+		std::vector<Neshny::WebGPUBuffer::AsyncToken<int>> tokens;
+		for (int i = 0; i < 16; i++) {
+			tokens.push_back(buffer.Read<int>(i * 4 * sizeof(int), sizeof(int), [](unsigned char* data, int size, Neshny::WebGPUBuffer::AsyncToken<int> token) {
+				return std::make_shared<int>(*(int*)data);
+			}));
+		}
+		tokens.back().Wait();
+		bool all_correct = true;
+		for (int i = 0; i < 16; i++) {
+			all_correct = all_correct && tokens[i].IsFinished() && (*tokens[i].GetPayload() == i * 4);
+		}
+		Expect("Shared reads all arrive together", all_correct);
+		auto after = pool.GetStats();
+		Expect("Sixteen reads in one mapping", (after.p_Reads - before.p_Reads == 16) && (after.p_Maps - before.p_Maps == 1));
+
+		std::vector<int> read_back;
+		buffer.GetAllValues(read_back);
+		Expect("Synchronous reads go through the pool", read_back == values);
+	}
+#endif
+
+} // namespace Test
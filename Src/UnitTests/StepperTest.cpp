@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	void RecordStepperRun(Neshny::AlgorithmStepper& stepper, int steps) {
+		for (int i = 0; i < steps; i++) {
+			NESHNY_STEP(stepper, Add2DPointToMain(Neshny::Vec2(i, -i), Neshny::Vec4(1, 0, 0, 1), Neshny::AlgorithmStepper::PointType::P_CROSS, "p"));
+			NESHNY_STEP(stepper, Add2DLineToScrap(Neshny::Vec2(0, 0), Neshny::Vec2(i, 1), Neshny::Vec4(0, 1, 0, 1)));
+			NESHNY_STEP(stepper, Add3DLineToScrap(Neshny::Vec3(0, 0, 0), Neshny::Vec3(i, 2, 3), Neshny::Vec4(0, 0, 1, 0.5)));
+			NESHNY_STEP(stepper, AddInfo(std::format("iteration {}", i)));
+			stepper.EndStep(std::format("Step {}", i), Neshny::Vec2(i, 0));
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StepperRecordingBounded(void) {
+		const size_t capacity = 4096;
+		Neshny::AlgorithmStepper stepper;
+		stepper.StartRecording(capacity);
+		RecordStepperRun(stepper, 1000);
+
+		const auto& recording = *stepper.p_Recording;
+		Expect("Recording never grows past its capacity", (recording.GetCapacity() == capacity) && (recording.GetUsedBytes() <= capacity));
+		Expect("Oldest steps were dropped", recording.GetDroppedSteps() > 0);
+		ExpectEqual("Every step is either kept or dropped", recording.GetKeptSteps() + recording.GetDroppedSteps(), 1000);
+		ExpectEqual("Nothing is added to the normal steps while recording", (int)stepper.p_Steps.size(), 1);
+
+		int kept = recording.GetKeptSteps();
+		stepper.StopRecording();
+		Expect("Recording is gone once stopped", !stepper.p_Recording);
+		ExpectEqual("Kept steps are decoded plus the unfinished one", (int)stepper.p_Steps.size(), kept + 1);
+
+		const auto& last = stepper.p_Steps[stepper.p_Steps.size() - 2];
+		ExpectEqual("Newest step is kept", last.p_SourceIndex, 999);
+		ExpectEqual("Header survives", last.p_Header, std::string("Step 999"));
+		Expect("Highlight survives", last.p_MainHighlight.has_value() && (*last.p_MainHighlight == Neshny::Vec2(999, 0)));
+		Expect("Point survives", (last.p_Main2DPoints.size() == 1) && (last.p_Main2DPoints[0].p_Pos == Neshny::Vec2(999, -999)) && (last.p_Main2DPoints[0].p_Type == Neshny::AlgorithmStepper::PointType::P_CROSS) && (last.p_Main2DPoints[0].p_Text == "p"));
+		Expect("Colour survives", last.p_Main2DPoints[0].p_Color == Neshny::Vec4(1, 0, 0, 1));
+		Expect("2D line survives", (last.p_Scrap2DLines.size() == 1) && (last.p_Scrap2DLines[0].p_End == Neshny::Vec2(999, 1)));
+		Expect("3D line survives", (last.p_Scrap3DLines.size() == 1) && (last.p_Scrap3DLines[0].p_End == Neshny::Vec3(999, 2, 3)) && (fabs(last.p_Scrap3DLines[0].p_Color.w - 0.5) < 0.01));
+		Expect("Info survives", (last.p_Info.size() == 1) && (last.p_Info[0] == "iteration 999"));
+
+		bool consecutive = true;
+		for (int i = 1; i < (int)stepper.p_Steps.size() - 1; i++) {
+			consecutive = consecutive && (stepper.p_Steps[i].p_SourceIndex == stepper.p_Steps[i - 1].p_SourceIndex + 1);
+		}
+		Expect("Only whole steps from the front are dropped", consecutive);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StepperSampling(void) {
+		Neshny::AlgorithmStepper every_tenth;
+		every_tenth.StartRecording(1 << 20, 10);
+		int evaluated = 0;
+		for (int i = 0; i < 100; i++) {
+			NESHNY_STEP(every_tenth, AddInfo(std::to_string(evaluated++)));
+			every_tenth.EndStep();
+		}
+		ExpectEqual("Arguments are only evaluated for sampled steps", evaluated, 10);
+		every_tenth.StopRecording();
+		ExpectEqual("Every tenth step is kept", (int)every_tenth.p_Steps.size(), 11);
+		ExpectEqual("Sampled steps keep their original index", every_tenth.p_Steps[3].p_SourceIndex, 30);
+
+		Neshny::AlgorithmStepper predicate;
+		predicate.StartRecording(1 << 20, 1, [](int step) { return (step >= 40) && (step < 45); });
+		RecordStepperRun(predicate, 100);
+		predicate.StopRecording();
+		ExpectEqual("Predicate picks the steps", (int)predicate.p_Steps.size(), 6);
+		ExpectEqual("First predicate step", predicate.p_Steps[0].p_SourceIndex, 40);
+
+		Neshny::AlgorithmStepper normal;
+		Expect("Normal mode always samples", normal.IsSampling());
+		RecordStepperRun(normal, 3);
+		ExpectEqual("Normal mode still fills steps directly", (int)normal.p_Steps.size(), 4);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StepperOversizedStep(void) {
+		Neshny::AlgorithmStepper stepper;
+		stepper.StartRecording(Neshny::AlgorithmStepper::Recording::MIN_CAPACITY);
+		RecordStepperRun(stepper, 2);
+		for (int i = 0; i < 1000; i++) {
+			stepper.Add2DPointToScrap(Neshny::Vec2(i, i), Neshny::Vec4(1, 1, 1, 1));
+		}
+		stepper.EndStep("Huge");
+
+		auto steps = stepper.p_Recording->Decode();
+		const auto& huge = steps[steps.size() - 2];
+		ExpectEqual("Oversized step is still recorded", huge.p_Header, std::string("Huge"));
+		Expect("Oversized step keeps what fit", !huge.p_Scrap2DPoints.empty() && (huge.p_Scrap2DPoints.size() < 1000));
+		Expect("Oversized step is marked as cut short", !huge.p_Info.empty());
+		Expect("Oversized step pushed out everything older", steps.size() == 2);
+
+		RecordStepperRun(stepper, 1);
+		stepper.StopRecording();
+		ExpectEqual("Steps after it are fine", stepper.p_Steps[stepper.p_Steps.size() - 2].p_Header, std::string("Step 0"));
+		ExpectEqual("Steps after it are complete", stepper.p_Steps[stepper.p_Steps.size() - 2].p_Info.size(), (size_t)1);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StepperSaveLoad(void) {
+		auto path = (std::filesystem::temp_directory_path() / "neshny_stepper_test.bin").string();
+
+		Neshny::AlgorithmStepper stepper;
+		stepper.StartRecording(8192, 2);
+		RecordStepperRun(stepper, 500);
+		Expect("Recording saves", stepper.SaveRecording(path));
+		stepper.StopRecording();
+		Expect("Nothing to save once stopped", !stepper.SaveRecording(path + ".none"));
+
+		Neshny::AlgorithmStepper replay;
+		Expect("Recording loads", replay.LoadRecording(path));
+		ExpectEqual("Same number of steps", replay.p_Steps.size(), stepper.p_Steps.size());
+		bool identical = true;
+		for (int i = 0; i < (int)stepper.p_Steps.size(); i++) {
+			const auto& a = stepper.p_Steps[i];
+			const auto& b = replay.p_Steps[i];
+			identical = identical && (a.p_Header == b.p_Header) && (a.p_SourceIndex == b.p_SourceIndex) && (a.p_Info == b.p_Info) && (a.p_Main2DPoints.size() == b.p_Main2DPoints.size());
+		}
+		Expect("Loaded steps match the recorded ones", identical);
+		ExpectEqual("Displays the newest step", replay.p_DisplayedStep, (int)replay.p_Steps.size() - 2);
+
+		std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc) << "not a recording";
+		Expect("Garbage does not load", !replay.LoadRecording(path));
+		std::filesystem::remove(path);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_StepperCorruptRecording(void) {
+		using Recording = Neshny::AlgorithmStepper::Recording;
+		auto path = (std::filesystem::temp_directory_path() / "neshny_stepper_corrupt.bin").string();
+
+		Neshny::AlgorithmStepper stepper;
+		stepper.StartRecording(8192);
+		RecordStepperRun(stepper, 20);
+		NESHNY_STEP(stepper, AddInfo("a step that has not ended"));
+		Expect("Recording saves mid step", stepper.SaveRecording(path));
+		Neshny::AlgorithmStepper replay;
+		Expect("Only the finished steps are saved, so it loads", replay.LoadRecording(path));
+		ExpectEqual("Every finished step is there", (int)replay.p_Steps.size(), 21);
+
+		std::vector<unsigned char> saved;
+		{
+			std::ifstream file(path, std::ios::in | std::ios::binary);
+			saved.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		const size_t first_record = sizeof(Neshny::StepperFileHeader);
+		auto load_changed = [&path, &saved, first_record](auto&& change, size_t size) {
+			std::vector<unsigned char> bytes(saved.begin(), saved.begin() + size);
+			change(bytes.data() + first_record);
+			std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc).write((const char*)bytes.data(), bytes.size());
+			Neshny::AlgorithmStepper corrupt;
+			return corrupt.LoadRecording(path);
+		};
+		Expect("A record longer than the file does not load", !load_changed([](unsigned char* record) {
+			Recording::RecordHeader header;
+			memcpy(&header, record, sizeof(header));
+			header.p_TextLength = std::numeric_limits<uint16_t>::max();
+			memcpy(record, &header, sizeof(header));
+		}, saved.size()));
+		Expect("An unknown record type does not load", !load_changed([](unsigned char* record) { record[0] = 200; }, saved.size()));
+
+		// the first step is a point, a line, a line and an info then the end, cut the stream off before its end
+		Neshny::StepperFileHeader header;
+		memcpy(&header, saved.data(), sizeof(header));
+		header.p_Used = sizeof(Recording::RecordHeader) + sizeof(uint32_t) * 3 + 1;
+		Expect("A stream that stops mid step does not load", !load_changed([&header, first_record](unsigned char* record) { memcpy(record - first_record, &header, sizeof(header)); }, first_record + header.p_Used));
+		std::filesystem::remove(path);
+	}
+
+} // namespace Test
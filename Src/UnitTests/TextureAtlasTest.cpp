@@ -0,0 +1,206 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	////////////////////////////////////////////////////////////////////////////////
+	// mostly small icons and tiles, a few larger sprites
+	std::vector<Neshny::AtlasInput> MakeAtlasTestInputs(int count, uint64_t seed) {
+		Neshny::RandomGenerator generator(seed);
+		std::vector<Neshny::AtlasInput> inputs(count);
+		for (int i = 0; i < count; i++) {
+			int max_size = (generator.NextBounded(50) == 0) ? 128 : 32;
+			inputs[i].p_Name = std::format("sprite_{}", i);
+			inputs[i].p_Width = 4 + (int)generator.NextBounded(max_size - 3);
+			inputs[i].p_Height = 4 + (int)generator.NextBounded(max_size - 3);
+		}
+		return inputs;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// every sprite with its padding is on its page and clear of every other
+	bool AtlasTestLayoutValid(const Neshny::TextureAtlas& atlas) {
+		const auto& params = atlas.GetParams();
+		const int pad = params.p_Padding;
+		std::vector<std::pair<int, Neshny::AtlasRect>> padded;
+		for (int handle = 0; handle < (int)atlas.GetUVTable().size(); handle++) {
+			if (!atlas.IsValid(handle)) {
+				continue;
+			}
+			const auto& sprite = atlas.Get(handle);
+			Neshny::AtlasRect rect{ sprite.p_Rect.p_X - pad, sprite.p_Rect.p_Y - pad, sprite.p_Rect.p_Width + pad * 2, sprite.p_Rect.p_Height + pad * 2 };
+			if ((rect.p_X < 0) || (rect.p_Y < 0) || (rect.p_X + rect.p_Width > params.p_PageWidth) || (rect.p_Y + rect.p_Height > params.p_PageHeight)) {
+				return false;
+			}
+			padded.push_back({ sprite.p_Page, rect });
+		}
+		for (int i = 0; i < (int)padded.size(); i++) {
+			for (int j = i + 1; j < (int)padded.size(); j++) {
+				if ((padded[i].first == padded[j].first) && padded[i].second.Overlaps(padded[j].second)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_TextureAtlasPacking(void) {
+
+		for (auto method : { Neshny::AtlasPackMethod::SKYLINE, Neshny::AtlasPackMethod::MAX_RECTS }) {
+			std::string name = method == Neshny::AtlasPackMethod::SKYLINE ? "Skyline" : "Max rects";
+			Neshny::TextureAtlas atlas({ 512, 512, 4, 2, 2, method });
+			auto inputs = MakeAtlasTestInputs(600, 21);
+			std::string err;
+			Expect(std::format("{} packs 600 sprites", name), atlas.Build(inputs, err));
+			ExpectEqual(std::format("{} has them all", name), atlas.GetSpriteCount(), 600);
+			Expect(std::format("{} sprites are on their pages and do not overlap", name), AtlasTestLayoutValid(atlas));
+
+			// handles follow the inputs and UVs are the rect over the page size
+			const auto& sprite = atlas.Get(7);
+			ExpectEqual("Size is kept", sprite.p_Rect.p_Width, inputs[7].p_Width);
+			ExpectEqual("Name finds the handle", atlas.Find("sprite_7"), 7);
+			ExpectEqual("U is over the page width", sprite.p_UV.x, sprite.p_Rect.p_X / 512.0f);
+			auto table = atlas.GetUVTable();
+			Expect("UV table is by handle", (table.size() == inputs.size()) && (table[7].p_Page == sprite.p_Page) && (table[7].p_UV.w == sprite.p_UV.w));
+
+			// shuffled inputs land in the same places
+			auto shuffled = inputs;
+			std::reverse(shuffled.begin(), shuffled.end());
+			Neshny::TextureAtlas shuffled_atlas({ 512, 512, 4, 2, 2, method });
+			shuffled_atlas.Build(shuffled, err);
+			bool same = true;
+			for (int i = 0; i < (int)inputs.size(); i++) {
+				const auto& a = atlas.Get(i);
+				const auto& b = shuffled_atlas.Get(shuffled_atlas.Find(inputs[i].p_Name));
+				same = same && (a.p_Page == b.p_Page) && (a.p_Rect == b.p_Rect);
+			}
+			Expect(std::format("{} layout does not depend on input order", name), same);
+
+			Neshny::TextureAtlas tiny({ 64, 64, 1, 1, 1, method });
+			Expect("Too many sprites for the pages fails", !tiny.Build(inputs, err) && (tiny.GetSpriteCount() == 0));
+			Expect("Duplicate names fail", !tiny.Build({ { "a", 4, 4 }, { "a", 4, 4 } }, err));
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_TextureAtlasIncremental(void) {
+
+		for (auto method : { Neshny::AtlasPackMethod::SKYLINE, Neshny::AtlasPackMethod::MAX_RECTS }) {
+			Neshny::TextureAtlas atlas({ 256, 256, 2, 1, 1, method });
+			std::string err;
+			atlas.Build(MakeAtlasTestInputs(100, 5), err);
+
+			int added = atlas.Add("extra", 20, 30);
+			Expect("Adds to a built atlas", atlas.IsValid(added) && (atlas.Find("extra") == added));
+			ExpectEqual("Same name is refused", atlas.Add("extra", 4, 4), -1);
+			auto before = atlas.Get(3);
+			Expect("Removes", atlas.Remove(3) && !atlas.IsValid(3) && (atlas.Find("sprite_3") == -1));
+			Expect("Only once", !atlas.Remove(3));
+			int reused = atlas.Add("same_size", before.p_Rect.p_Width, before.p_Rect.p_Height);
+			ExpectEqual("Freed handle is reused", reused, 3);
+			Expect("Freed space is reused", (atlas.Get(reused).p_Page == before.p_Page) && (atlas.Get(reused).p_Rect == before.p_Rect));
+
+			// churn until the pages are full, nothing may ever overlap
+			Neshny::RandomGenerator generator((uint64_t)9);
+			std::vector<int> live;
+			for (int i = 0; i < 2000; i++) {
+				if (!live.empty() && (generator.NextBounded(3) == 0)) {
+					int index = (int)generator.NextBounded((uint32_t)live.size());
+					atlas.Remove(live[index]);
+					live[index] = live.back();
+					live.pop_back();
+				} else {
+					int handle = atlas.Add(std::format("churn_{}", i), 2 + (int)generator.NextBounded(24), 2 + (int)generator.NextBounded(24));
+					if (handle >= 0) {
+						live.push_back(handle);
+					}
+				}
+			}
+			Expect("Churned layout stays valid", AtlasTestLayoutValid(atlas));
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_TextureAtlasBleed(void) {
+
+		Neshny::TextureAtlas atlas({ 64, 64, 1, 3, 2 });
+		std::string err;
+		atlas.Build({ { "a", 4, 3 }, { "b", 5, 5 } }, err);
+		// each pixel is its own colour
+		std::vector<uint32_t> pixels(4 * 3);
+		for (int i = 0; i < (int)pixels.size(); i++) {
+			pixels[i] = 0xFF000000 | (i + 1);
+		}
+		atlas.Blit(0, (const unsigned char*)pixels.data(), 4 * sizeof(uint32_t));
+
+		const auto& page = atlas.GetPagePixels(0);
+		auto page_pixel = [&page](int x, int y) {
+			uint32_t val;
+			memcpy(&val, page.data() + (y * 64 + x) * 4, 4);
+			return val;
+		};
+		const Neshny::AtlasRect rect = atlas.Get(0).p_Rect;
+		Expect("Sprite is copied", (page_pixel(rect.p_X, rect.p_Y) == pixels[0]) && (page_pixel(rect.p_X + 3, rect.p_Y + 2) == pixels[11]));
+		Expect("Top edge bleeds up", (page_pixel(rect.p_X + 1, rect.p_Y - 1) == pixels[1]) && (page_pixel(rect.p_X + 1, rect.p_Y - 2) == pixels[1]));
+		Expect("Right edge bleeds out", page_pixel(rect.p_X + 5, rect.p_Y + 1) == pixels[7]);
+		Expect("Corners bleed diagonally", (page_pixel(rect.p_X - 2, rect.p_Y - 2) == pixels[0]) && (page_pixel(rect.p_X + 5, rect.p_Y + 4) == pixels[11]));
+		Expect("Padding past the bleed stays clear", (page_pixel(rect.p_X - 3, rect.p_Y) == 0) && (page_pixel(rect.p_X, rect.p_Y + 5) == 0));
+
+		atlas.Remove(0);
+		Expect("Removing clears the pixels", (page_pixel(rect.p_X, rect.p_Y) == 0) && (page_pixel(rect.p_X - 2, rect.p_Y - 2) == 0));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_TextureAtlasCache(void) {
+
+		std::string path = (std::filesystem::temp_directory_path() / "neshny_atlas_cache.bin").string();
+		std::filesystem::remove(path);
+		auto inputs = MakeAtlasTestInputs(300, 17);
+		std::string err;
+		bool from_cache = true;
+
+		Neshny::TextureAtlas first({ 512, 512, 2, 1, 1 });
+		Expect("First build packs", first.BuildCached(inputs, path, err, &from_cache) && !from_cache);
+		Neshny::TextureAtlas second({ 512, 512, 2, 1, 1 });
+		Expect("Second build loads the cache", second.BuildCached(inputs, path, err, &from_cache) && from_cache);
+		bool same = first.GetPageCount() == second.GetPageCount();
+		for (int i = 0; i < (int)inputs.size(); i++) {
+			same = same && (first.Get(i).p_Page == second.Get(i).p_Page) && (first.Get(i).p_Rect == second.Get(i).p_Rect);
+		}
+		Expect("Cached layout is the same", same);
+		int added = second.Add("after_cache", 16, 16);
+		Expect("A cached atlas still takes more sprites", second.IsValid(added) && AtlasTestLayoutValid(second));
+
+		inputs[10].p_Width++;
+		Neshny::TextureAtlas changed({ 512, 512, 2, 1, 1 });
+		Expect("Changed inputs pack again", changed.BuildCached(inputs, path, err, &from_cache) && !from_cache);
+		Neshny::TextureAtlas other_params({ 512, 512, 2, 2, 1 });
+		Expect("Changed params pack again", other_params.BuildCached(inputs, path, err, &from_cache) && !from_cache);
+		std::filesystem::remove(path);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	void UnitTest_TextureAtlasBenchmark(void) {
+
+		auto inputs = MakeAtlasTestInputs(10000, 33);
+		for (auto method : { Neshny::AtlasPackMethod::SKYLINE, Neshny::AtlasPackMethod::MAX_RECTS }) {
+			std::string name = method == Neshny::AtlasPackMethod::SKYLINE ? "Skyline" : "Max rects";
+			double best = std::numeric_limits<double>::max();
+			Neshny::TextureAtlas atlas({ 2048, 2048, 8, 1, 1, method });
+			bool built = true;
+			std::string err;
+			for (int attempt = 0; attempt < 3; attempt++) {
+				auto start = std::chrono::steady_clock::now();
+				built = built && atlas.Build(inputs, err);
+				best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			double occupancy = 0.0;
+			for (int page = 0; page < atlas.GetPageCount(); page++) {
+				occupancy += atlas.GetOccupancy(page) / atlas.GetPageCount();
+			}
+			Neshny::Core::Log(std::format("{} packs 10k sprites in {:.1f} ms onto {} pages of 2048, {:.0f}% full", name, best, atlas.GetPageCount(), occupancy * 100.0));
+			Expect(std::format("{} packs every sprite ({})", name, err), built);
+		}
+	}
+
+}
@@ -0,0 +1,158 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Test {
+
+	void UnitTest_MainThreadQueueLoaders(void) {
+
+		constexpr int num_loaders = 300;
+		constexpr int tasks_per_loader = 8;
+
+		Neshny::MainThreadQueue queue;
+		std::vector<std::vector<int>> executed(num_loaders);
+		std::atomic_int loaders_finished = 0;
+		std::atomic_int bad_results = 0;
+
+		// each loader thread hands work to the "main" thread and waits on the futures, like a resource upload would
+		std::vector<std::thread> loaders;
+		for (int loader = 0; loader < num_loaders; loader++) {
+			loaders.emplace_back([&queue, &executed, &loaders_finished, &bad_results, loader]() {
+				std::vector<std::future<int>> results;
+				for (int i = 0; i < tasks_per_loader; i++) {
+					results.push_back(queue.Submit([&executed, loader, i]() -> int {
+						executed[loader].push_back(i);
+						return loader * tasks_per_loader + i;
+					}));
+				}
+				for (int i = 0; i < tasks_per_loader; i++) {
+					if (results[i].get() != loader * tasks_per_loader + i) {
+						bad_results++;
+					}
+				}
+				loaders_finished++;
+			});
+		}
+
+		int total_executed = 0;
+		int lowest_pending = 0;
+		while (loaders_finished.load() < num_loaders) {
+			total_executed += queue.Drain(std::chrono::microseconds(200));
+			lowest_pending = std::min(lowest_pending, queue.GetLastFrameStats().p_Remaining);
+			std::this_thread::yield();
+		}
+		for (auto& loader : loaders) {
+			loader.join();
+		}
+		total_executed += queue.DrainAll();
+
+		ExpectEqual("All queued tasks execute", total_executed, num_loaders * tasks_per_loader);
+		ExpectEqual("Futures return task results", bad_results.load(), 0);
+		ExpectEqual("Nothing left pending", queue.GetPendingCount(), 0);
+		ExpectEqual("Tasks are counted as pending before they can run", lowest_pending, 0);
+		for (int loader = 0; loader < num_loaders; loader++) {
+			std::vector<int> expected;
+			for (int i = 0; i < tasks_per_loader; i++) {
+				expected.push_back(i);
+			}
+			Expect("Tasks from a single producer run in submission order", executed[loader] == expected);
+		}
+	}
+
+	void UnitTest_MainThreadQueuePriorities(void) {
+
+		Neshny::MainThreadQueue queue;
+		std::vector<std::string> order;
+		queue.Push([&order]() { order.push_back("low"); }, Neshny::MainThreadQueue::Priority::LOW);
+		queue.Push([&order]() { order.push_back("normal1"); });
+		queue.Push([&order]() { order.push_back("high"); }, Neshny::MainThreadQueue::Priority::HIGH);
+		queue.Push([&order]() { order.push_back("normal2"); });
+
+		ExpectEqual("Four tasks pending", queue.GetPendingCount(), 4);
+		queue.DrainAll();
+		Expect("Higher priorities run first, in order within a priority", order == std::vector<std::string>{ "high", "normal1", "normal2", "low" });
+
+		auto stats = queue.GetLastFrameStats();
+		ExpectEqual("Stats count submissions", stats.p_Submitted, 4);
+		ExpectEqual("Stats count executions", stats.p_Executed, 4);
+		ExpectEqual("Stats count remaining", stats.p_Remaining, 0);
+	}
+
+	void UnitTest_MainThreadQueueBudget(void) {
+
+		Neshny::MainThreadQueue queue;
+		int normal_count = 0;
+		int high_count = 0;
+		for (int i = 0; i < 20; i++) {
+			queue.Push([&normal_count]() { normal_count++; std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+			queue.Push([&high_count]() { high_count++; }, Neshny::MainThreadQueue::Priority::HIGH);
+		}
+
+		// a zero budget still guarantees progress, but high priority work is never deferred
+		int executed = queue.Drain(Neshny::TimerNanos(0));
+		ExpectEqual("High priority ignores the budget", high_count, 20);
+		ExpectEqual("Normal priority deferred once over budget", normal_count, 0);
+		ExpectEqual("Only high priority executed", executed, 20);
+
+		queue.Drain(Neshny::TimerNanos(0));
+		ExpectEqual("At least one task runs per drain", normal_count, 1);
+
+		int frames = 0;
+		while (queue.GetPendingCount() > 0) {
+			queue.Drain(std::chrono::milliseconds(4));
+			Expect("Deferred work is spread across frames", queue.GetLastFrameStats().p_Executed < 19);
+			frames++;
+		}
+		ExpectEqual("All normal tasks eventually run", normal_count, 20);
+		Expect("Took more than one frame", frames > 1);
+	}
+
+	void UnitTest_MainThreadQueueClose(void) {
+
+		Neshny::MainThreadQueue queue;
+		int count = 0;
+		queue.Push([&count]() { count++; });
+		queue.Close();
+		ExpectEqual("Closing runs queued work", count, 1);
+		Expect("Pushing to a closed queue fails", !queue.Push([&count]() { count++; }));
+
+		auto future = queue.Submit([]() { return 7; });
+		ExpectEqual("Submitting to a closed queue runs inline", future.get(), 7);
+		ExpectEqual("Rejected task never ran", count, 1);
+	}
+
+	void UnitTest_ParallelFor(void) {
+
+		std::vector<int> ran(8, 0);
+		std::vector<std::thread::id> first_ids(8);
+		Neshny::ParallelFor(8, [&ran, &first_ids](int t) { ran[t]++; first_ids[t] = std::this_thread::get_id(); });
+		Expect("Every job runs once", std::all_of(ran.begin(), ran.end(), [](int count) { return count == 1; }));
+		ExpectEqual("The first job runs on the calling thread", first_ids[0], std::this_thread::get_id());
+
+		// the jobs wait on each other, which only finishes if each has a thread of its own
+		std::set<std::thread::id> ids(first_ids.begin(), first_ids.end());
+		for (int round = 0; round < 20; round++) {
+			std::barrier sync(8);
+			std::vector<std::thread::id> round_ids(8);
+			Neshny::ParallelFor(8, [&sync, &round_ids](int t) {
+				round_ids[t] = std::this_thread::get_id();
+				sync.arrive_and_wait();
+				sync.arrive_and_wait();
+			});
+			ids.insert(round_ids.begin(), round_ids.end());
+		}
+		ExpectEqual("Workers are kept between calls", (int)ids.size(), 8);
+
+		bool thrown = false;
+		try {
+			Neshny::ParallelFor(4, [](int t) { if (t == 3) { throw std::runtime_error("job failed"); } });
+		} catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		Expect("A job's exception reaches the caller", thrown);
+
+		int single = 0;
+		Neshny::ParallelFor(1, [&single](int) { single++; });
+		Neshny::ParallelFor(0, [&single](int) { single++; });
+		ExpectEqual("One job runs inline and none runs nothing", single, 1);
+	}
+
+} // namespace Test
@@ -3,11 +3,72 @@
 
 namespace Neshny {
 
+////////////////////////////////////////////////////////////////////////////////
+void TransposeEntityToSoA(const int* aos, int* soa, int count, int floats_per, int stride) {
+	for (int f = 0; f < floats_per; f++) {
+		int* column = soa + f * stride;
+		const int* src = aos + f;
+		for (int i = 0; i < count; i++, src += floats_per) {
+			column[i] = *src;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TransposeEntityToAoS(const int* soa, int* aos, int count, int floats_per, int stride) {
+	for (int f = 0; f < floats_per; f++) {
+		const int* column = soa + f * stride;
+		int* dest = aos + f;
+		for (int i = 0; i < count; i++, dest += floats_per) {
+			*dest = column[i];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string GPUEntity::GetBaseSyntax(void) const {
+	if (m_Layout == EntityLayout::SOA) {
+		return "\tlet base = index + ENTITY_OFFSET_INTS;";
+	}
+	return std::format("\tlet base = index * FLOATS_PER_{} + ENTITY_OFFSET_INTS;", m_Name);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string GPUEntity::GetLookupSyntax(void) const {
+	if (m_Layout == EntityLayout::SOA) {
+		return std::format("(base) + (index) * {}_STRIDE", m_Name);
+	}
+	return "(base) + (index)";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void GPUEntity::UpdateGPUInsertions(void) {
+	// the SOA stride is the capacity, so this needs rebuilding whenever the buffers are resized
+	std::string lookup = GetLookupSyntax();
+	std::vector<std::string> insertion;
+	insertion.push_back(std::format("#define FLOATS_PER_{} {}", m_Name, m_NumDataFloats));
+	if (m_Layout == EntityLayout::SOA) {
+		insertion.push_back(std::format("#define {}_STRIDE {}", m_Name, std::max(1, m_MaxItems)));
+	}
+	insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (b_{0}[{1}])", m_Name, lookup));
+	std::vector<std::string> insertion_double_buffer = insertion;
+	insertion.push_back(std::format("#define {0}_SET(base, index, value) atomicStore(&b_{0}[{1}], value)", m_Name, lookup));
+	insertion_double_buffer.push_back(std::format("#define {0}_SET(base, index, value) b_Output{0}[{1}] = (value)", m_Name, lookup));
+	std::string previous_insertion = std::move(m_GPUInsertion);
+	m_GPUInsertion = JoinStrings(insertion, "\n");
+	m_GPUInsertionDoubleBuffer = JoinStrings(insertion_double_buffer, "\n");
+	if (!previous_insertion.empty() && (previous_insertion != m_GPUInsertion)) {
+		// pipelines already built with the old stride would index the resized buffers wrongly
+		Core::Singleton().UnloadPipelinesUsingEntity(m_Name);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 bool GPUEntity::Init(int expected_max_count) {
 
 	Destroy();
 	m_MaxItems = expected_max_count;
+	UpdateGPUInsertions();
 
 	int max_size = (expected_max_count * m_NumDataFloats + ENTITY_OFFSET_INTS) * sizeof(int);
 	m_SSBO = new SSBO(WGPUBufferUsage_Storage, max_size);
@@ -61,6 +122,14 @@ void GPUEntity::Destroy(void) {
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::AddInstancesInternal(unsigned char* data, int item_count, int item_size, std::vector<PlacementInfo>* sync_placements) {
 
+	// the creation shader fills free slots first and places the rest past the max index
+	const int reused_count = std::min(std::max(m_LastKnownInfo.p_FreeCount, 0), item_count);
+	const int appended_count = item_count - reused_count;
+	if ((m_Layout == EntityLayout::SOA) && (m_LastKnownInfo.p_MaxIndex + appended_count > m_MaxItems)) {
+		// columns are spaced by capacity, so going over it would write into the next column
+		throw std::invalid_argument("Adding more instances than the entity has capacity for");
+	}
+
 	int data_size = item_count * item_size;
 	int index_id_size = sizeof(PlacementInfo) * item_count;
 
@@ -87,11 +156,13 @@ void GPUEntity::AddInstancesInternal(unsigned char* data, int item_count, int it
 		int p_Count;
 		int p_ItemInts;
 		int m_IdOffsetInts;
+		int p_Stride; // zero for AOS
 	};
 	Info info = {
 		item_count,
 		item_size / (int)sizeof(int),
-		m_IdOffset / (int)sizeof(int)
+		m_IdOffset / (int)sizeof(int),
+		m_Layout == EntityLayout::SOA ? m_MaxItems : 0
 	};
 
 	create_obj->p_Data.EnsureSizeBytes(sizeof(Info) + data_size, false);
@@ -110,6 +181,8 @@ void GPUEntity::AddInstancesInternal(unsigned char* data, int item_count, int it
 	create_obj->p_Pipe.Compute(item_count, iVec3(256, 1, 1));
 
 	m_LastKnownInfo.p_Count += item_count;
+	m_LastKnownInfo.p_FreeCount -= reused_count;
+	m_LastKnownInfo.p_MaxIndex += appended_count;
 
 	if (sync_placements && (item_count > 0)) {
 		sync_placements->resize(item_count);
@@ -123,6 +196,10 @@ void GPUEntity::SetInstancesInternal(unsigned char* data, int item_count, int it
 	if (!m_SSBO) {
 		return;
 	}
+	if ((m_Layout == EntityLayout::SOA) && (item_count > m_MaxItems)) {
+		// the AOS write below throws on its own, but transposing would overlap the columns before getting there
+		throw std::invalid_argument("Setting more instances than the entity has capacity for");
+	}
 	m_LastKnownInfo.p_Count = item_count;
 	m_LastKnownInfo.p_MaxIndex = item_count;
 	m_LastKnownInfo.p_NextId = item_count;
@@ -131,6 +208,15 @@ void GPUEntity::SetInstancesInternal(unsigned char* data, int item_count, int it
 #pragma msg("might be good to auto-assign ids here, otherwise user is responsible for setting it from 0...N - would need offset though")
 
 	int data_size = item_count * item_size;
+	if (m_Layout == EntityLayout::SOA) {
+		// columns are spaced by capacity, so everything up to the last column has to be written
+		int ints_per = item_size / (int)sizeof(int);
+		std::vector<int> buffer(ENTITY_OFFSET_INTS + std::max(0, ints_per - 1) * m_MaxItems + item_count, 0);
+		memcpy(buffer.data(), &m_LastKnownInfo, sizeof(EntityInfo));
+		TransposeEntityToSoA((int*)data, buffer.data() + ENTITY_OFFSET_INTS, item_count, ints_per, m_MaxItems);
+		m_SSBO->Write((unsigned char*)buffer.data(), 0, (int)buffer.size() * sizeof(int));
+		return;
+	}
 	int total_size = sizeof(EntityInfo) + data_size;
 	std::vector<std::byte> buffer(total_size, std::byte(0));
 	memcpy(buffer.data(), &m_LastKnownInfo, sizeof(EntityInfo));
@@ -139,6 +225,17 @@ void GPUEntity::SetInstancesInternal(unsigned char* data, int item_count, int it
 	m_SSBO->Write((unsigned char*)buffer.data(), 0, buffer.size());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void GPUEntity::PlaceSoA(const int* items, int item_count, int first_index) {
+	std::vector<int> column(item_count);
+	for (int f = 0; f < m_NumDataFloats; f++) {
+		for (int i = 0; i < item_count; i++) {
+			column[i] = items[i * m_NumDataFloats + f];
+		}
+		m_SSBO->Write((unsigned char*)column.data(), (ENTITY_OFFSET_INTS + f * m_MaxItems + first_index) * sizeof(int), item_count * sizeof(int));
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::DeleteInstance(int index) {
 
@@ -147,6 +244,73 @@ void GPUEntity::DeleteInstance(int index) {
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+EntityDefragPlan GPUEntity::Defragment(int max_moves) {
+
+	if (!m_SSBO) {
+		return EntityDefragPlan{};
+	}
+	SyncInfo();
+	EntityInfo info;
+	MakeCopyIn((unsigned char*)&info, 0, sizeof(EntityInfo));
+	if (info.p_MaxIndex <= 0) {
+		return EntityDefragPlan{};
+	}
+
+	// only the ID member is needed to find the holes, as SOA that is one column
+	// as AOS the whole live range comes back since the IDs are strided through it
+	const int id_offset_ints = m_IdOffset / (int)sizeof(int);
+	std::vector<int> ids(info.p_MaxIndex);
+	if (m_Layout == EntityLayout::SOA) {
+		MakeCopyIn((unsigned char*)ids.data(), (ENTITY_OFFSET_INTS + id_offset_ints * m_MaxItems) * sizeof(int), info.p_MaxIndex * sizeof(int));
+	} else {
+		std::vector<int> data(info.p_MaxIndex * m_NumDataFloats);
+		MakeCopyIn((unsigned char*)data.data(), ENTITY_OFFSET_INTS * sizeof(int), (int)data.size() * sizeof(int));
+		for (int i = 0; i < info.p_MaxIndex; i++) {
+			ids[i] = data[i * m_NumDataFloats + id_offset_ints];
+		}
+	}
+	EntityDefragPlan plan = EntityDefragPlan::Create(ids, max_moves);
+
+	if (!plan.p_Moves.empty()) {
+		struct DefragPipeObjects {
+			DefragPipeObjects(void) : p_Moves(WGPUBufferUsage_Storage, sizeof(int)) {}
+			WebGPUPipeline	p_Pipe;
+			WebGPUBuffer	p_Moves;
+		};
+
+		// global per-thread object since this will get reused many times
+		static thread_local DefragPipeObjects* defrag_obj = nullptr; // leaks at end of run, not important
+		if (!defrag_obj) {
+			defrag_obj = new DefragPipeObjects();
+			defrag_obj->p_Pipe
+				.AddBuffer(*m_SSBO, WGPUShaderStage_Compute, false)
+				.AddBuffer(defrag_obj->p_Moves, WGPUShaderStage_Compute, true)
+				.FinalizeCompute("EntityDefrag", std::format("#define ENTITY_OFFSET_INTS {}\n", ENTITY_OFFSET_INTS));
+		}
+
+		int header[4] = { (int)plan.p_Moves.size(), m_NumDataFloats, id_offset_ints, m_Layout == EntityLayout::SOA ? m_MaxItems : 0 };
+		int moves_size = (int)(plan.p_Moves.size() * sizeof(EntityDefragPlan::Move));
+		defrag_obj->p_Moves.EnsureSizeBytes(sizeof(header) + moves_size, false);
+		defrag_obj->p_Moves.Write((unsigned char*)header, 0, sizeof(header));
+		defrag_obj->p_Moves.Write((unsigned char*)plan.p_Moves.data(), sizeof(header), moves_size);
+
+		defrag_obj->p_Pipe.ReplaceBuffer(0, *m_SSBO);
+		defrag_obj->p_Pipe.ReplaceBuffer(1, defrag_obj->p_Moves);
+		defrag_obj->p_Pipe.Compute((int)plan.p_Moves.size(), iVec3(256, 1, 1));
+	}
+
+	if (!plan.p_FreeList.empty()) {
+		m_FreeList->Write((unsigned char*)plan.p_FreeList.data(), 0, (int)plan.p_FreeList.size() * sizeof(int));
+	}
+	m_LastKnownInfo.p_Count = plan.p_LiveCount;
+	m_LastKnownInfo.p_FreeCount = (int)plan.p_FreeList.size();
+	m_LastKnownInfo.p_NextId = info.p_NextId;
+	m_LastKnownInfo.p_MaxIndex = plan.p_NewMaxIndex;
+	m_SSBO->Write((unsigned char*)&m_LastKnownInfo, 0, sizeof(EntityInfo));
+	return plan;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GPUEntity::SwapInputOutputSSBOs(void) {
 	if (!m_DoubleBuffering) {
@@ -164,6 +328,11 @@ std::shared_ptr<unsigned char[]> GPUEntity::MakeCopySync(void) {
 	const int size = m_MaxItems * entity_size + offset_size;
 	unsigned char* ptr = new unsigned char[size];
 	MakeCopyIn(ptr, 0, size);
+	if (m_Layout == EntityLayout::SOA) {
+		// copies are always handed out as AOS so viewers and callers don't need to know the layout
+		std::vector<int> columns((int*)(ptr + offset_size), (int*)(ptr + size));
+		TransposeEntityToAoS(columns.data(), (int*)(ptr + offset_size), m_MaxItems, m_NumDataFloats, m_MaxItems);
+	}
 	auto result = std::shared_ptr<unsigned char[]>(ptr);
 	return result;
 }
@@ -178,6 +347,13 @@ void GPUEntity::AccessData(std::function<void(unsigned char* data, int size_byte
 		const int offset_size = ENTITY_OFFSET_INTS * sizeof(int);
 		const int useful_size = info.p_MaxIndex * entity_size + offset_size;
 
+		if (m_Layout == EntityLayout::SOA) {
+			std::vector<int> aos(useful_size / sizeof(int));
+			memcpy(aos.data(), data, offset_size);
+			TransposeEntityToAoS((int*)(data + offset_size), aos.data() + ENTITY_OFFSET_INTS, info.p_MaxIndex, m_NumDataFloats, m_MaxItems);
+			callback((unsigned char*)aos.data(), useful_size, info);
+			return nullptr;
+		}
 		callback(data, useful_size, info);
 		return nullptr;
 	});
@@ -12,6 +12,16 @@ struct EntityInfo {
 
 const int ENTITY_OFFSET_INTS = 4;
 
+// AOS stores each entity contiguously, SOA stores each float of the struct as its own column of GetMaxCount() items
+// SOA is better for passes that only touch a few members of a wide struct, the header ints are identical in both
+enum class EntityLayout {
+	AOS,
+	SOA
+};
+
+void TransposeEntityToSoA	( const int* aos, int* soa, int count, int floats_per, int stride );
+void TransposeEntityToAoS	( const int* soa, int* aos, int count, int floats_per, int stride );
+
 template<typename>
 struct is_std_array : std::false_type {};
 
@@ -55,98 +65,126 @@ private:
 	std::vector<MemberSpec>&	m_Specs;
 };
 
+// the struct definition, getters and setters for T, the read only insertion is also the start of the full insertion
 template<typename T>
-void SerializeStructInfo(StructInfo& info, std::string get_base_str, std::string entity_name) {
+void GenerateStructInfo(StructInfo& info, std::string_view get_base_str, const std::string& entity_name, EntityLayout layout) {
 	Serialiser<T> serializeFunc(info.p_Members);
 	meta::doForAllMembers<T>(serializeFunc);
 
-	std::vector<std::string> read_only_lines;
-	std::vector<std::string> lines;
+	// each insertion is its lines joined by newlines, so every line ends in one apart from the last
+	CodeBuilder code(4096);
+	CodeBuilder functions(2048);
+
+	// AOS: (index) * FLOATS_PER + pos, SOA: (index) + pos * STRIDE
+	auto add_access = [&entity_name, layout](CodeBuilder& builder, int pos, bool with_num) {
+		std::string_view num_str = with_num ? " + (num)" : "";
+		if (layout == EntityLayout::SOA) {
+			builder.Add("(b_", entity_name, "[(index) + (", pos, num_str, ") * ", entity_name, "_STRIDE + ENTITY_OFFSET_INTS])");
+		} else {
+			builder.Add("(b_", entity_name, "[(index) * FLOATS_PER_", entity_name, " + ", pos, " + ENTITY_OFFSET_INTS", num_str, "])");
+		}
+	};
 
-	read_only_lines.push_back(std::format("struct {} {{", entity_name));
-	{
-		std::vector<std::string> member_vars;
-		for (auto member : info.p_Members) {
-			auto type_str = MemberSpec::GetGPUType(member.p_Type);
-			member_vars.push_back(std::format("\t{}: {}", member.p_Name, member.p_ArrayCount.has_value() ? std::format("array<{}, {}>", type_str, *member.p_ArrayCount) : type_str));
+	code.Add("struct ", entity_name, " {\n");
+	CodeBuilder::Separator next_member(",\n");
+	for (const auto& member : info.p_Members) {
+		auto type_str = MemberSpec::GetGPUType(member.p_Type);
+		code.Add(next_member(), '\t', member.p_Name, ": ");
+		if (member.p_ArrayCount.has_value()) {
+			code.Add("array<", type_str, ", ", *member.p_ArrayCount, '>');
+		} else {
+			code.Add(type_str);
 		}
-		read_only_lines.push_back(JoinStrings(member_vars, ",\n"));
 	}
-	read_only_lines.push_back("}");
+	code.Add("\n}\n");
 
-	read_only_lines.push_back(std::format("fn Get{0}(index: i32) -> {0} {{", entity_name));
-	read_only_lines.push_back(get_base_str);
-	read_only_lines.push_back(std::format("\tvar result: {};", entity_name));
+	code.Add("fn Get", entity_name, "(index: i32) -> ", entity_name, " {\n");
+	code.Add(get_base_str, '\n');
+	code.Add("\tvar result: ", entity_name, ";\n");
 	int pos_index = 0;
-	std::vector<std::string> functions;
-	for (auto member : info.p_Members) {
-		auto member_name = member.p_Name;
+	CodeBuilder::Separator next_function("\n");
+	for (const auto& member : info.p_Members) {
+		const auto& member_name = member.p_Name;
+		bool is_int = (member.p_Type == MemberSpec::Type::T_INT) || (member.p_Type == MemberSpec::Type::T_UINT);
 
 		if (member.p_ArrayCount.has_value()) {
 			std::size_t num = *member.p_ArrayCount;
-			if ((member.p_Type == MemberSpec::Type::T_INT) || (member.p_Type == MemberSpec::Type::T_UINT)) {
-				functions.push_back(std::format("// defined macro Access{}{}(index, array_index)\n", entity_name, member_name));
-				functions.push_back(std::format("#define Access{2}{0}(index,num) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS + (num)])\n", member_name, pos_index, entity_name));
+			if (is_int) {
+				functions.Add(next_function(), "// defined macro Access", entity_name, member_name, "(index, array_index)\n");
+				functions.Add(next_function(), "#define Access", entity_name, member_name, "(index,num) ");
+				add_access(functions, pos_index, true);
+				functions.Add('\n');
 			}
 			for (std::size_t i = 0; i < num; i++) {
-				std::string get_syntax = MemberSpec::GetGPUGetSyntax(member.p_Type, pos_index, entity_name);
+				code.Add("\tresult.", member_name, '[', i, "] = ", MemberSpec::GetGPUGetSyntax(member.p_Type, pos_index, entity_name), ";\n");
 				pos_index += member.p_Size / sizeof(float);
-				read_only_lines.push_back(std::format("\tresult.{}[{}] = {};", member_name, i, get_syntax));
 			}
 			continue;
 		}
 
 		std::string get_syntax = MemberSpec::GetGPUGetSyntax(member.p_Type, pos_index, entity_name);
-		read_only_lines.push_back(std::format("\tresult.{} = {};", member_name, get_syntax));
-		functions.push_back(std::format("fn Get{2}{1}(index: i32) -> {0} {{\n", MemberSpec::GetGPUType(member.p_Type), member_name, entity_name) + get_base_str + std::format("\n\treturn {};\n}}", get_syntax));
-		if ((member.p_Type == MemberSpec::Type::T_INT) || (member.p_Type == MemberSpec::Type::T_UINT)) {
-			functions.push_back(std::format("// defined macro Access{}{}(index)\n", entity_name, member_name));
-			functions.push_back(std::format("#define Access{2}{0}(index) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS])\n", member_name, pos_index, entity_name));
+		code.Add("\tresult.", member_name, " = ", get_syntax, ";\n");
+		functions.Add(next_function(), "fn Get", entity_name, member_name, "(index: i32) -> ", MemberSpec::GetGPUType(member.p_Type), " {\n", get_base_str, "\n\treturn ", get_syntax, ";\n}");
+		if (is_int) {
+			functions.Add(next_function(), "// defined macro Access", entity_name, member_name, "(index)\n");
+			functions.Add(next_function(), "#define Access", entity_name, member_name, "(index) ");
+			add_access(functions, pos_index, false);
+			functions.Add('\n');
 		} else if ((member.p_Type == MemberSpec::Type::T_IVEC2) || (member.p_Type == MemberSpec::Type::T_IVEC3) || (member.p_Type == MemberSpec::Type::T_IVEC4)) {
-			functions.push_back(std::format("// defined macro Access{}{}_X/Y/Z/W(index)\n", entity_name, member_name));
-			functions.push_back(std::format("#define Access{2}{0}_X(index) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS])\n", member_name, pos_index, entity_name));
-			functions.push_back(std::format("#define Access{2}{0}_Y(index) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS])\n", member_name, pos_index + 1, entity_name));
-			if (member.p_Type != MemberSpec::Type::T_IVEC2) {
-				functions.push_back(std::format("#define Access{2}{0}_Z(index) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS])\n", member_name, pos_index + 2, entity_name));
-				if (member.p_Type == MemberSpec::Type::T_IVEC4) {
-					functions.push_back(std::format("#define Access{2}{0}_W(index) (b_{2}[(index) * FLOATS_PER_{2} + {1} + ENTITY_OFFSET_INTS])\n", member_name, pos_index + 3, entity_name));
-				}
+			int components = member.p_Type == MemberSpec::Type::T_IVEC2 ? 2 : (member.p_Type == MemberSpec::Type::T_IVEC3 ? 3 : 4);
+			functions.Add(next_function(), "// defined macro Access", entity_name, member_name, "_X/Y/Z/W(index)\n");
+			for (int c = 0; c < components; c++) {
+				functions.Add(next_function(), "#define Access", entity_name, member_name, '_', "XYZW"[c], "(index) ");
+				add_access(functions, pos_index + c, false);
+				functions.Add('\n');
 			}
 		}
 
 		pos_index += member.p_Size / sizeof(float);
 	}
-	read_only_lines.push_back("\treturn result;\n}");
-	read_only_lines.push_back(JoinStrings(functions, "\n"));
+	code.Add("\treturn result;\n}\n");
+	code.Add(functions.View());
+	info.p_GPUReadOnlyInsertion = code.ToString();
 
-	lines.push_back(std::format("fn Set{0}(item: {0}, index: i32) {{", entity_name)); // TODO: make this a ref?
-	lines.push_back(get_base_str);
+	code.Add("fn Set", entity_name, "(item: ", entity_name, ", index: i32) {\n"); // TODO: make this a ref?
+	code.Add(get_base_str, '\n');
 	pos_index = 0;
-	functions = {};
-	for (auto member : info.p_Members) {
+	functions.Clear();
+	next_function = CodeBuilder::Separator("\n");
+	for (const auto& member : info.p_Members) {
 
 		if (member.p_ArrayCount.has_value()) {
 			std::size_t num = *member.p_ArrayCount;
 			for (std::size_t i = 0; i < num; i++) {
-				auto [mod_str, value_mod_str] = MemberSpec::GetGPUSetSyntax(member.p_Type, pos_index, entity_name, std::format("{}[{}]", member.p_Name, i));
-				lines.push_back(mod_str);
+				auto [mod_str, value_mod_str] = MemberSpec::GetGPUSetSyntax(member.p_Type, pos_index, entity_name, member.p_Name + "[" + std::to_string(i) + "]");
+				code.Add(mod_str, '\n');
 				pos_index += member.p_Size / sizeof(float);
 			}
 			continue;
 		}
 
 		auto [mod_str, value_mod_str] = MemberSpec::GetGPUSetSyntax(member.p_Type, pos_index, entity_name, member.p_Name);
-		lines.push_back(mod_str);
-		functions.push_back(std::format("fn Set{2}{0}(index: i32, value: {1}) {{\n", member.p_Name, MemberSpec::GetGPUType(member.p_Type), entity_name) + get_base_str + std::format("\n{}\n}}", value_mod_str));
+		code.Add(mod_str, '\n');
+		functions.Add(next_function(), "fn Set", entity_name, member.p_Name, "(index: i32, value: ", MemberSpec::GetGPUType(member.p_Type), ") {\n", get_base_str, '\n', value_mod_str, "\n}");
 
 		pos_index += member.p_Size / sizeof(float);
 	}
 
-	lines.push_back("}");
-	lines.push_back(JoinStrings(functions, "\n"));
+	code.Add("}\n");
+	code.Add(functions.View());
+	info.p_GPUInsertion = code.Take();
+}
 
-	info.p_GPUReadOnlyInsertion = JoinStrings(read_only_lines, "\n");
-	info.p_GPUInsertion = std::format("{}{}", info.p_GPUReadOnlyInsertion, JoinStrings(lines, "\n"));
+template<typename T>
+void SerializeStructInfo(StructInfo& info, std::string get_base_str, std::string entity_name, EntityLayout layout = EntityLayout::AOS) {
+	// the code only depends on T and these arguments, so every entity and pipeline using the same struct shares one copy
+	static GeneratedCodeCache<StructInfo> cache;
+	std::string key = entity_name + '|' + std::to_string((int)layout) + '|' + get_base_str;
+	info = cache.Get(key, [&]() {
+		StructInfo generated;
+		GenerateStructInfo<T>(generated, get_base_str, entity_name, layout);
+		return generated;
+	});
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -162,15 +200,14 @@ public:
 	};
 
 	// TODO: figure out better way of passing in T, perhaps template entire class
-	template <typename T> GPUEntity(std::string name, int T::* id_ptr, std::string id_name, bool double_buffer = true) :
+	template <typename T> GPUEntity(std::string name, int T::* id_ptr, std::string id_name, bool double_buffer = true, EntityLayout layout = EntityLayout::AOS) :
 			m_Name(name)
 			,m_NumDataFloats(sizeof(T) / sizeof(float))
 			,m_IDName(id_name)
 			,m_DoubleBuffering(double_buffer)
+			,m_Layout(layout)
 		{
-		auto get_base_str = std::format("\tlet base = index * FLOATS_PER_{} + ENTITY_OFFSET_INTS;", m_Name);
-
-		SerializeStructInfo<T>(m_Specs, get_base_str, m_Name);
+		SerializeStructInfo<T>(m_Specs, std::string(GetBaseSyntax()), m_Name, m_Layout);
 
 		int pos_index = 0;
 		for (const auto& member : m_Specs.p_Members) {
@@ -180,15 +217,7 @@ public:
 			}
 			pos_index += member.p_Size;
 		}
-
-		std::vector<std::string> insertion;
-		insertion.push_back(std::format("#define FLOATS_PER_{} {}", m_Name, m_NumDataFloats));
-		insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (b_{0}[(base) + (index)])", m_Name));
-		std::vector<std::string> insertion_double_buffer = insertion;
-		insertion.push_back(std::format("#define {0}_SET(base, index, value) atomicStore(&b_{0}[(base) + (index)], value)", m_Name));
-		insertion_double_buffer.push_back(std::format("#define {0}_SET(base, index, value) b_Output{0}[(base) + (index)] = (value)", m_Name));
-		m_GPUInsertion = JoinStrings(insertion, "\n");
-		m_GPUInsertionDoubleBuffer = JoinStrings(insertion_double_buffer, "\n");
+		UpdateGPUInsertions();
 	}
 
 	~GPUEntity(void) { Destroy(); }
@@ -199,6 +228,12 @@ public:
 			return;
 		}
 		items.resize(count);
+		if (m_Layout == EntityLayout::SOA) {
+			std::vector<int> columns(m_NumDataFloats * m_MaxItems);
+			MakeCopyIn((unsigned char*)columns.data(), ENTITY_OFFSET_INTS * sizeof(int), (int)columns.size() * sizeof(int));
+			TransposeEntityToAoS(columns.data(), (int*)items.data(), count, m_NumDataFloats, m_MaxItems);
+			return;
+		}
 		MakeCopyIn((unsigned char*)items.data(), ENTITY_OFFSET_INTS * sizeof(int), count * m_NumDataFloats * sizeof(int));
 	}
 
@@ -210,22 +245,41 @@ public:
 		MakeCopyIn(buffer, 0, total_size);
 		int max_index = ((int*)buffer)[3];
 		items.resize(max_index);
-		memcpy(items.data(), buffer + size_offset, max_index * size_item);
+		if (m_Layout == EntityLayout::SOA) {
+			TransposeEntityToAoS((int*)(buffer + size_offset), (int*)items.data(), max_index, m_NumDataFloats, m_MaxItems);
+		} else {
+			memcpy(items.data(), buffer + size_offset, max_index * size_item);
+		}
 		delete[] buffer;
 	}
 
 	template <typename T> T ExtractSingle(int index) {
 		T item;
 		int size_item = m_NumDataFloats * sizeof(float);
+		if (m_Layout == EntityLayout::SOA) {
+			// one read spanning every column, from this item in the first to this item in the last
+			std::vector<int> span((m_NumDataFloats - 1) * m_MaxItems + 1);
+			MakeCopyIn((unsigned char*)span.data(), (index + ENTITY_OFFSET_INTS) * sizeof(int), (int)span.size() * sizeof(int));
+			TransposeEntityToAoS(span.data(), (int*)&item, 1, m_NumDataFloats, m_MaxItems);
+			return item;
+		}
 		MakeCopyIn((unsigned char*)&item, index * size_item + ENTITY_OFFSET_INTS * sizeof(int), size_item);
 		return item;
 	}
 
 	template <typename T> void PlaceAll(const std::vector<T>& items, int offset = 0) {
+		if (m_Layout == EntityLayout::SOA) {
+			PlaceSoA((const int*)items.data(), (int)items.size(), offset); // offset counts entities here
+			return;
+		}
 		m_SSBO->SetValues<T>(items, offset);
 	}
 
 	template <typename T> void PlaceSingle(int index, T item) {
+		if (m_Layout == EntityLayout::SOA) {
+			PlaceSoA((const int*)&item, 1, index);
+			return;
+		}
 		m_SSBO->SetSingleValue<T>(index, item);
 	}
 
@@ -243,6 +297,12 @@ public:
 
 	void												DeleteInstance			( int index );
 
+	// moves live entities into the holes left by deletions and shrinks the max index, max_moves < 0 compacts fully
+	// otherwise call it every frame as a budgeted background step, the plan's remap is old index to new index
+	EntityDefragPlan									Defragment				( int max_moves = -1 );
+	inline double										GetFragmentation		( void ) const { return m_LastKnownInfo.p_MaxIndex > 0 ? 1.0 - double(m_LastKnownInfo.p_Count) / m_LastKnownInfo.p_MaxIndex : 0.0; }
+
+	// both of these hand back AOS data regardless of layout
 	std::shared_ptr<unsigned char[]>					MakeCopySync			( void );
 	void												AccessData				( std::function<void(unsigned char* data, int size_bytes, EntityInfo item_info)>&& callback);
 	void												QueueInfoRead			( void );
@@ -262,6 +322,11 @@ public:
 	inline std::string_view								GetDoubleBufferGPUInsertion	( void ) const { return m_GPUInsertionDoubleBuffer; }
 	inline std::string_view								GetIDName				( void ) const { return m_IDName; }
 	inline bool											IsDoubleBuffering		( void ) const { return m_DoubleBuffering; };
+	inline EntityLayout									GetLayout				( void ) const { return m_Layout; }
+
+	// WGSL for the first int of entity "index", and the offset of member int "index" from that base, as used by the LOOKUP/SET macros
+	std::string											GetBaseSyntax			( void ) const;
+	std::string											GetLookupSyntax			( void ) const;
 
 	void												SwapInputOutputSSBOs	( void );
 
@@ -269,6 +334,8 @@ protected:
 
 	void												AddInstancesInternal	( unsigned char* data, int item_count, int item_size, std::vector<PlacementInfo>* sync_placements );
 	void												SetInstancesInternal	( unsigned char* data, int item_count, int item_size );
+	void												PlaceSoA				( const int* items, int item_count, int first_index );
+	void												UpdateGPUInsertions		( void );
 	void												MakeCopyIn				( unsigned char* ptr, int offset, int size );
 	void												Destroy					( void );
 
@@ -279,11 +346,12 @@ protected:
 	std::string											m_GPUInsertion;
 	std::string											m_GPUInsertionDoubleBuffer;
 	std::string											m_IDName;
-	int													m_MaxItems;
+	int													m_MaxItems = 0;
 	int													m_IdOffset = -1;
 	int													m_NumDataFloats = 0;
 
 	bool												m_DoubleBuffering = true;
+	EntityLayout										m_Layout = EntityLayout::AOS;
 	SSBO*												m_SSBO = nullptr;
 	SSBO*												m_OutputSSBO = nullptr;
 
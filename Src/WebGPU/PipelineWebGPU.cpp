@@ -55,105 +55,107 @@ bool EntityPipeline::OutputResults::GetValue(std::string_view name, int& value)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string EntityPipeline::GetDataVectorStructCode(const AddedDataVector& data_vect, bool read_only) {
+std::string PipelineCode::GetDataVectorStructCode(const DataVector& data_vect, bool read_only) {
 
-	std::vector<std::string> insertion;
-	insertion.push_back(std::format("struct {0} {{", data_vect.p_Name));
-
-	std::vector<std::string> function{ std::format("fn Get{0}(base_index: i32) -> {0} {{ // use io{0}Num for count\n\tvar item: {0};", data_vect.p_Name) };
-	std::vector<std::string> members;
-	if (read_only) {
-		function.push_back(std::format("\tlet index = io{0}Offset + (base_index * {1});", data_vect.p_Name, data_vect.p_NumIntsPerItem));
-	} else {
-		function.push_back(std::format("\tlet index = Get_io{0}Offset + (base_index * {1});", data_vect.p_Name, data_vect.p_NumIntsPerItem));
+	const std::string& name = data_vect.p_Name;
+	CodeBuilder code(1024);
+	code.Add("struct ", name, " {\n");
+	CodeBuilder::Separator next_member(",\n");
+	for (const auto& member : data_vect.p_Members) {
+		code.Add(next_member(), '\t', member.p_Name, ": ", MemberSpec::GetGPUType(member.p_Type));
 	}
+	code.Add("\n};\n");
+
+	code.Add("fn Get", name, "(base_index: i32) -> ", name, " { // use io", name, "Num for count\n\tvar item: ", name, ";\n");
+	code.Add("\tlet index = ", read_only ? "io" : "Get_io", name, "Offset + (base_index * ", data_vect.p_NumIntsPerItem, ");\n");
 
 	int pos_index = 0;
 	for (const auto& member : data_vect.p_Members) {
-		members.push_back(std::format("\t{}: {}", member.p_Name, MemberSpec::GetGPUType(member.p_Type)));
-
-		std::string name = member.p_Name;
-		if (read_only) {
-
-			if (member.p_Type == MemberSpec::T_INT) {
-				function.push_back(std::format("\titem.{0} = b_Control[index + {1}];", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_FLOAT) {
-				function.push_back(std::format("\titem.{0} = bitcast<f32>(b_Control[index + {1}]);", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC2) {
-				function.push_back(std::format("\titem.{0} = vec2f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC3) {
-				function.push_back(std::format("\titem.{0} = vec3f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]), bitcast<f32>(b_Control[index + {1} + 2]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC4) {
-				function.push_back(std::format("\titem.{0} = vec4f(bitcast<f32>(b_Control[index + {1}]), bitcast<f32>(b_Control[index + {1} + 1]), bitcast<f32>(b_Control[index + {1} + 2]), bitcast<f32>(b_Control[index + {1} + 3]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC2) {
-				function.push_back(std::format("\titem.{0} = vec2i(b_Control[index + {1}], b_Control[index + {1} + 1]);", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC3) {
-				function.push_back(std::format("\titem.{0} = vec3i(b_Control[index + {1}], b_Control[index + {1} + 1], b_Control[index + {1} + 2]);", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC4) {
-				function.push_back(std::format("\titem.{0} = vec4i(b_Control[index + {1}], b_Control[index + {1} + 1], b_Control[index + {1} + 2], b_Control[index + {1} + 3]);", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_MAT3) {
-				std::vector<std::string> items;
-				for (int i = 0; i < 9; i++) {
-					items.push_back(std::format("bitcast<f32>(b_Control[index + {} + {}])", pos_index, i));
-				}
-				function.push_back(std::format("\titem.{} = mat3x3f({});", name, JoinStrings(items, ", ")));
-			} else if (member.p_Type == MemberSpec::T_MAT4) {
-				std::vector<std::string> items;
-				for (int i = 0; i < 16; i++) {
-					items.push_back(std::format("bitcast<f32>(b_Control[index + {} + {}])", pos_index, i));
-				}
-				function.push_back(std::format("\titem.{} = mat4x4f({});", name, JoinStrings(items, ", ")));
+
+		// component < 0 leaves the offset off entirely, vectors do that for their first component but matrices do not
+		auto add_load = [&code, read_only, pos_index](int component, bool as_float) {
+			if (as_float) {
+				code.Add("bitcast<f32>(");
 			}
-		} else {
-			if (member.p_Type == MemberSpec::T_INT) {
-				function.push_back(std::format("\titem.{0} = atomicLoad(&b_Control[index + {1}]);", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_FLOAT) {
-				function.push_back(std::format("\titem.{0} = bitcast<f32>(atomicLoad(&b_Control[index + {1}]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC2) {
-				function.push_back(std::format("\titem.{0} = vec2f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC3) {
-				function.push_back(std::format("\titem.{0} = vec3f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 2])));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_VEC4) {
-				function.push_back(std::format("\titem.{0} = vec4f(bitcast<f32>(atomicLoad(&b_Control[index + {1}])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 1])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 2])), bitcast<f32>(atomicLoad(&b_Control[index + {1} + 3])));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC2) {
-				function.push_back(std::format("\titem.{0} = vec2i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC3) {
-				function.push_back(std::format("\titem.{0} = vec3i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]), atomicLoad(&b_Control[index + {1} + 2]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_IVEC4) {
-				function.push_back(std::format("\titem.{0} = vec4i(atomicLoad(&b_Control[index + {1}]), atomicLoad(&b_Control[index + {1} + 1]), atomicLoad(&b_Control[index + {1} + 2]), atomicLoad(&b_Control[index + {1} + 3]));", name, pos_index));
-			} else if (member.p_Type == MemberSpec::T_MAT3) {
-				std::vector<std::string> items;
-				for (int i = 0; i < 9; i++) {
-					items.push_back(std::format("bitcast<f32>(atomicLoad(&b_Control[index + {} + {}]))", pos_index, i));
-				}
-				function.push_back(std::format("\titem.{} = mat3x3f({});", name, JoinStrings(items, ", ")));
-			} else if (member.p_Type == MemberSpec::T_MAT4) {
-				std::vector<std::string> items;
-				for (int i = 0; i < 16; i++) {
-					items.push_back(std::format("bitcast<f32>(atomicLoad(&b_Control[index + {} + {}]))", pos_index, i));
-				}
-				function.push_back(std::format("\titem.{} = mat4x4f({});", name, JoinStrings(items, ", ")));
+			code.Add(read_only ? "b_Control[index + " : "atomicLoad(&b_Control[index + ", pos_index);
+			if (component >= 0) {
+				code.Add(" + ", component);
+			}
+			code.Add(read_only ? "]" : "])");
+			if (as_float) {
+				code.Add(')');
+			}
+		};
+		auto add_components = [&code, &member, &add_load](std::string_view type_str, int count, bool as_float, bool offset_first) {
+			code.Add("\titem.", member.p_Name, " = ", type_str, '(');
+			for (int i = 0; i < count; i++) {
+				code.Add(i > 0 ? ", " : "");
+				add_load(((i > 0) || offset_first) ? i : -1, as_float);
 			}
+			code.Add(");\n");
+		};
+
+		if ((member.p_Type == MemberSpec::T_INT) || (member.p_Type == MemberSpec::T_FLOAT)) {
+			code.Add("\titem.", member.p_Name, " = ");
+			add_load(-1, member.p_Type == MemberSpec::T_FLOAT);
+			code.Add(";\n");
+		} else if (member.p_Type == MemberSpec::T_VEC2) {
+			add_components("vec2f", 2, true, false);
+		} else if (member.p_Type == MemberSpec::T_VEC3) {
+			add_components("vec3f", 3, true, false);
+		} else if (member.p_Type == MemberSpec::T_VEC4) {
+			add_components("vec4f", 4, true, false);
+		} else if (member.p_Type == MemberSpec::T_IVEC2) {
+			add_components("vec2i", 2, false, false);
+		} else if (member.p_Type == MemberSpec::T_IVEC3) {
+			add_components("vec3i", 3, false, false);
+		} else if (member.p_Type == MemberSpec::T_IVEC4) {
+			add_components("vec4i", 4, false, false);
+		} else if (member.p_Type == MemberSpec::T_MAT3) {
+			add_components("mat3x3f", 9, true, true);
+		} else if (member.p_Type == MemberSpec::T_MAT4) {
+			add_components("mat4x4f", 16, true, true);
 		}
 		pos_index += member.p_Size / sizeof(int);
 	}
-	function.push_back("\treturn item;\n};");
+	code.Add("\treturn item;\n};");
 
-	insertion.push_back(JoinStrings(members, ",\n"));
-	insertion.push_back("};");
-	insertion.push_back(JoinStrings(function, "\n"));
+	return code.Take();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PipelineCode::AssembleInsertion(const ShaderInsertion& insertion, std::string& insertion_str, std::string& end_insertion_str) {
 
-	return JoinStrings(insertion, "\n");
+	// one pass into one buffer, rather than joining each list and then joining the results
+	CodeBuilder code(16384);
+	code.Join(insertion.p_Immediate, "\n").Add('\n').Join(insertion.p_Buffers, "\n");
+	for (const auto& line : insertion.p_Body) {
+		code.Add('\n', line);
+	}
+	insertion_str = code.Take();
+	end_insertion_str.clear();
+	if (!insertion.p_End.empty()) {
+		code.Add("\n//////////\n").Join(insertion.p_End, "\n");
+		end_insertion_str = code.Take();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Core::CachedPipeline> result) {
 
 	bool create_new = false;
-	if (!result) {
+	if (!result || result->IsStale()) { // stale ones were built from a shader that has since been hot reloaded
 		result = std::make_shared<Core::CachedPipeline>();
 		result->m_Identifier = m_Identifier;
 		result->m_Pipeline = new WebGPUPipeline();
+		if (m_Entity) {
+			result->m_EntityNames.emplace_back(m_Entity->GetName());
+		}
+		for (const auto& added : m_Entities) {
+			if (added.p_Entity) {
+				result->m_EntityNames.emplace_back(added.p_Entity->GetName());
+			}
+		}
 		create_new = true;
 	}
 
@@ -168,10 +170,11 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 	};
 
 	std::vector<BuffersToAdd> pipeline_buffers;
-	std::vector<std::string> immediate_insertion;
-	std::list<std::string> insertion;
-	std::vector<std::string> end_insertion;
-	std::vector<std::string> insertion_buffers;
+	PipelineCode::ShaderInsertion shader_insertion;
+	std::vector<std::string>& immediate_insertion = shader_insertion.p_Immediate;
+	std::list<std::string>& insertion = shader_insertion.p_Body;
+	std::vector<std::string>& end_insertion = shader_insertion.p_End;
+	std::vector<std::string>& insertion_buffers = shader_insertion.p_Buffers;
 	std::vector<std::string> defined_structs;
 	bool entity_processing = m_Entity && (m_RunType == RunType::ENTITY_PROCESS);
 	bool is_render = ((m_RunType == RunType::ENTITY_RENDER) || (m_RunType == RunType::BASIC_RENDER));
@@ -283,7 +286,7 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 		}
 		if (create_new) {
 			if (!input_read_only) {
-				insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (atomicLoad(&b_{0}[(base) + (index)]))", m_Entity->GetName()));
+				insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (atomicLoad(&b_{0}[{1}]))", m_Entity->GetName(), m_Entity->GetLookupSyntax()));
 			}
 
 			if (entity_processing) {
@@ -300,7 +303,7 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 			insertion_buffers.push_back(std::format("@group(0) @binding({0}) var<storage, read_write> b_FreeList: array<i32>;", insertion_buffers.size()));
 
 			insertion.push_back(std::format("fn Destroy{0}(index: i32) {{", m_Entity->GetName()));
-			insertion.push_back(std::format("\tlet base = index * FLOATS_PER_{0} + ENTITY_OFFSET_INTS;", m_Entity->GetName()));
+			insertion.push_back(m_Entity->GetBaseSyntax());
 			insertion.push_back(std::format("\t{0}_SET(base, 0, -1);",m_Entity->GetName()));
 			insertion.push_back("\tatomicAdd(&ioEntityDeaths, 1);");
 			insertion.push_back("\tatomicAdd(&ioEntityCount, -1);");
@@ -409,8 +412,8 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 
 				insertion.push_back(std::string(entity.GetGPUInsertion()));
 				// this will replace non-atomic getters and setters with atomic ones
-				insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (atomicLoad(&b_{0}[(base) + (index)]))", entity.GetName()));
-				insertion.push_back(std::format("#define {0}_SET(base, index, value) atomicStore(&b_{0}[(base) + (index)], (value))", entity.GetName()));
+				insertion.push_back(std::format("#define {0}_LOOKUP(base, index) (atomicLoad(&b_{0}[{1}]))", entity.GetName(), entity.GetLookupSyntax()));
+				insertion.push_back(std::format("#define {0}_SET(base, index, value) atomicStore(&b_{0}[{1}], (value))", entity.GetName(), entity.GetLookupSyntax()));
 				insertion.push_back(entity.GetSpecs().p_GPUInsertion);
 			}
 		}
@@ -595,9 +598,6 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 			insertion.push_back("////////////////");
 			insertion.push_back(m_ExtraCode);
 		}
-
-		insertion.push_front(JoinStrings(insertion_buffers, "\n"));
-		insertion.push_front(JoinStrings(immediate_insertion, "\n"));
 	}
 
 	if (create_new) {
@@ -605,11 +605,9 @@ std::shared_ptr<Core::CachedPipeline> EntityPipeline::Prepare(std::shared_ptr<Co
 			result->m_Pipeline->AddBuffer(buffer_to_add.p_Buffer, buffer_to_add.p_VisibilityFlags, buffer_to_add.p_ReadOnly);
 		}
 
-		std::string insertion_str = JoinStrings(insertion, "\n");
+		std::string insertion_str;
 		std::string end_insertion_str;
-		if (!end_insertion.empty()) {
-			end_insertion_str = "\n//////////\n" + JoinStrings(end_insertion, "\n");
-		}
+		PipelineCode::AssembleInsertion(shader_insertion, insertion_str, end_insertion_str);
 
 		if (is_render) {
 			result->m_Pipeline->FinalizeRender(m_ShaderName, *m_Buffer, m_RenderParams, m_MSAASamples, insertion_str, end_insertion_str);
@@ -674,7 +672,7 @@ EntityPipeline::AsyncOutputResults EntityPipeline::RunInternal(int iterations, R
 	if (!compute && m_Entity) {
 		int time_slider = Core::GetInterfaceData().p_BufferView.p_TimeSlider;
 		if (time_slider > 0) {
-			prepared->m_TemporaryFrame = BufferViewer::GetStoredFrameAt(m_Entity->GetName(), Core::GetTicks() - time_slider, iterations);
+			prepared->m_TemporaryFrame = BufferViewer::GetStoredFrameAt(m_Entity->GetName(), Core::GetTicks() - time_slider, iterations, m_Entity->GetLayout() == EntityLayout::SOA ? m_Entity->GetMaxCount() : 0);
 		}
 	}
 
@@ -866,7 +864,7 @@ void GridCache::Generate2DCache(iVec2 grid_size, Vec2 grid_min, Vec2 grid_max) {
 
 	m_GridSize = iVec3(grid_size.x, grid_size.y, 1);
 	m_GridMin = Vec3(grid_min.x, grid_min.y, 0.0);
-	m_GridMax = Vec3(grid_max.x, grid_min.y, 0.0);
+	m_GridMax = Vec3(grid_max.x, grid_max.y, 0.0);
 	m_Is3D = false;
 	GenerateCache();
 }
@@ -892,11 +890,7 @@ void GridCache::GenerateCache(void) {
 	std::string main_func = std::format("fn {0}Main(item_index: i32, item: {0}) {{ {1}; }}", m_Entity.GetName(), func_call);
 	std::string base_id = std::format("GridCache3D:{}:{}:{}", m_Entity.GetName(), m_PosName, m_RadiusName.value_or("-"));
 
-	GridCacheUniform uniform{
-		iVec4(m_GridSize.x, m_GridSize.y, m_GridSize.z, 0),
-		fVec4(m_GridMin.x, m_GridMin.y, m_GridMin.z, 0),
-		fVec4(m_GridMin.x, m_GridMin.y, m_GridMin.z, 0)
-	};
+	GridCacheUniform uniform = GetUniform();
 
 	std::string_view shader_name = m_Is3D ? "GridCache3D" : "GridCache2D";
 	while (true) {
@@ -947,6 +941,77 @@ void GridCache::GenerateCache(void) {
 	m_Uniform.SetSingleValue(0, uniform);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void GridCache::Upload2DCache(const GridCacheLayout& layout, Vec2 grid_min, Vec2 grid_max) {
+
+	m_GridSize = iVec3(layout.p_GridSize.x, layout.p_GridSize.y, 1);
+	m_GridMin = Vec3(grid_min.x, grid_min.y, 0.0);
+	m_GridMax = Vec3(grid_max.x, grid_max.y, 0.0);
+	m_Is3D = false;
+	UploadCache(layout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void GridCache::Upload3DCache(const GridCacheLayout& layout, Vec3 grid_min, Vec3 grid_max) {
+
+	m_GridSize = layout.p_GridSize;
+	m_GridMin = grid_min;
+	m_GridMax = grid_max;
+	m_Is3D = true;
+	UploadCache(layout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void GridCache::UploadCache(const GridCacheLayout& layout) {
+
+	// the canonical layout is packed, so the items in use are all there is and later generates still start from the full size
+	m_RequiredItemCacheSize = std::max(m_RequiredItemCacheSize, layout.p_TotalSize);
+	m_GridIndices.EnsureSizeBytes((int)layout.p_Indices.size() * sizeof(int), false);
+	m_GridIndices.Write((unsigned char*)layout.p_Indices.data(), 0, (int)layout.p_Indices.size() * sizeof(int));
+	m_GridItems.EnsureSizeBytes(std::max(1, layout.p_TotalSize) * sizeof(int), false);
+	if (layout.p_TotalSize > 0) {
+		m_GridItems.Write((unsigned char*)layout.p_Items.data(), 0, layout.p_TotalSize * sizeof(int));
+	}
+	m_Uniform.SetSingleValue(0, GetUniform());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+GridCacheUniform GridCache::GetUniform(void) const {
+	return GridCacheUniform{
+		iVec4(m_GridSize.x, m_GridSize.y, m_GridSize.z, 0),
+		fVec4(m_GridMin.x, m_GridMin.y, m_GridMin.z, 0),
+		fVec4(m_GridMax.x, m_GridMax.y, m_GridMax.z, 0)
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCache::Validate(std::span<const int> snapshot, std::string& err) {
+
+	GridCacheBuilder builder(m_Entity.GetSpecs(), m_PosName, m_RadiusName.has_value() ? std::optional<std::string_view>(*m_RadiusName) : std::nullopt, m_Entity.GetIDName());
+	GridCacheLayout expected;
+	bool generated = m_Is3D ?
+		builder.Generate3D(snapshot, m_GridSize, m_GridMin, m_GridMax, expected, err) :
+		builder.Generate2D(snapshot, iVec2(m_GridSize.x, m_GridSize.y), Vec2(m_GridMin.x, m_GridMin.y), Vec2(m_GridMax.x, m_GridMax.y), expected, err);
+	if (!generated) {
+		return false;
+	}
+	return Validate(expected, err);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GridCache::Validate(const GridCacheLayout& expected, std::string& err) {
+
+	if (expected.p_GridSize != m_GridSize) {
+		err = "The cache was made with a different grid size";
+		return false;
+	}
+	std::vector<int> indices;
+	std::vector<int> items;
+	m_GridIndices.GetValues(indices, expected.GetCellCount() * 3);
+	m_GridItems.GetAllValues(items);
+	return GridCacheBuilder::Validate(expected, indices, items, err);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GridCache::Bind(EntityPipeline& target_stage, bool initial_creation) {
 
@@ -4,6 +4,35 @@
 #if defined(NESHNY_WEBGPU)
 namespace Neshny {
 
+////////////////////////////////////////////////////////////////////////////////
+// the WGSL that EntityPipeline wraps around a shader, generated from plain inputs so it can be checked without a device
+////////////////////////////////////////////////////////////////////////////////
+struct PipelineCode {
+
+	struct DataVector {
+		std::string				p_Name;
+		int						p_NumIntsPerItem = 0;
+		unsigned char*			p_Data = nullptr;
+		int						p_NumItems = 0;
+		std::string				p_CountVar;
+		std::string				p_OffsetVar;
+		std::string				p_NumVar;
+		std::vector<MemberSpec>	p_Members;
+	};
+
+	// what Prepare puts before and after the shader's own code, kept in pieces until the pipeline is created
+	struct ShaderInsertion {
+		std::vector<std::string>	p_Immediate;
+		std::vector<std::string>	p_Buffers;
+		std::list<std::string>		p_Body;
+		std::vector<std::string>	p_End;
+	};
+
+	static std::string				GetDataVectorStructCode	( const DataVector& data_vect, bool read_only );
+	// the immediate code and the buffers are a line each even when empty, then one line per piece of the body, the same text as joining them all with newlines
+	static void						AssembleInsertion		( const ShaderInsertion& insertion, std::string& insertion_str, std::string& end_insertion_str );
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -154,16 +183,8 @@ protected:
 		std::vector<MemberSpec>		p_Spec;
 		std::span<unsigned char>	p_Data;
 	};
-	struct AddedDataVector {
-		std::string				p_Name;
-		int						p_NumIntsPerItem = 0;
-		unsigned char*			p_Data = nullptr;
-		int						p_NumItems = 0;
-		std::string				p_CountVar;
-		std::string				p_OffsetVar;
-		std::string				p_NumVar;
-		std::vector<MemberSpec>	p_Members;
-	};
+
+	using AddedDataVector = PipelineCode::DataVector;
 
 											EntityPipeline			(	RunType type,
 																		GPUEntity* entity,
@@ -173,7 +194,7 @@ protected:
 																		SSBO* control_ssbo = nullptr, int iterations = 0,
 																		WebGPUPipeline::RenderParams render_params = {} );
 
-	static std::string						GetDataVectorStructCode	( const AddedDataVector& data_vect, bool read_only );
+	static std::string						GetDataVectorStructCode	( const AddedDataVector& data_vect, bool read_only ) { return PipelineCode::GetDataVectorStructCode(data_vect, read_only); }
 	std::shared_ptr<Core::CachedPipeline>	Prepare					( std::shared_ptr<Core::CachedPipeline> result );
 	AsyncOutputResults						RunInternal				( int iterations, RTT* rtt, std::optional<std::function<void(const OutputResults& results)>>&& callback );
 
@@ -279,12 +300,23 @@ public:
 								GridCache		( GPUEntity& entity, std::string_view pos_name, std::optional<std::string_view> radius_name = std::nullopt );
 	void						Generate2DCache	( iVec2 grid_size, Vec2 grid_min, Vec2 grid_max );
 	void						Generate3DCache	( iVec3 grid_size, Vec3 grid_min, Vec3 grid_max );
+	// uploads a cache GridCacheBuilder made on the CPU instead of generating one, for small entities or when a snapshot is on the CPU anyway
+	// the layout has to have been built from the entity as it is now, with the same grid
+	void						Upload2DCache	( const GridCacheLayout& layout, Vec2 grid_min, Vec2 grid_max );
+	void						Upload3DCache	( const GridCacheLayout& layout, Vec3 grid_min, Vec3 grid_max );
+	// reads both buffers back and checks them against GridCacheBuilder run over the entity as ExtractAll gave it after the last generate
+	// stalls on the GPU, so for tests and debugging
+	bool						Validate		( std::span<const int> snapshot, std::string& err );
+	// the same against a layout built elsewhere, so the grid the cache was generated with is checked too
+	bool						Validate		( const GridCacheLayout& expected, std::string& err );
 
 	virtual void				Bind			( EntityPipeline& target_stage, bool initial_creation ) override;
 
 private:
 
 	void						GenerateCache	( void );
+	void						UploadCache		( const GridCacheLayout& layout );
+	GridCacheUniform			GetUniform		( void ) const;
 
 	GPUEntity&					m_Entity;
 	std::string					m_PosName;
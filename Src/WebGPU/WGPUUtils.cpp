@@ -213,52 +213,71 @@ void WebGPUBuffer::ClearBuffer() {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void WebGPUBuffer::ReadSync(unsigned char* buffer, int offset, int size) {
-	size = size >= 0 ? size : m_Size - offset;
-	if (size <= 0) {
-		return;
-	}
-	DebugTiming debug_func("WebGPUBuffer::ReadSync");
-	WGPUBufferDescriptor desc = {};
-	desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
-	desc.size = size;
-	desc.nextInChain = nullptr;
+StagingPool& WebGPUBuffer::GetStagingPool(void) {
+	static StagingPool pool({
+		[](int size_bytes) -> void* {
+			WGPUBufferDescriptor desc = {};
+			desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
+			desc.size = size_bytes;
+			desc.nextInChain = nullptr;
 #ifdef __EMSCRIPTEN__
-	desc.label = nullptr;
+			desc.label = nullptr;
 #else
-	desc.label = { nullptr, 0 };
+			desc.label = { nullptr, 0 };
 #endif
-	desc.mappedAtCreation = false;
-	WGPUBuffer copy_buffer = wgpuDeviceCreateBuffer(Core::Singleton().GetWebGPUDevice(), &desc);
-	CopyBufferToBuffer(m_Buffer, copy_buffer, offset, 0, size);
-
+			desc.mappedAtCreation = false;
+			return wgpuDeviceCreateBuffer(GlobalWebGPUDevice(), &desc);
+		}
+		,[](void* handle) {
+			wgpuBufferDestroy((WGPUBuffer)handle);
+		}
+		,[](void* handle, int size_bytes, std::function<void(const unsigned char* data)>&& callback) {
+			struct MapInfo {
+				WGPUBuffer									p_Buffer;
+				int											p_Size;
+				std::function<void(const unsigned char*)>	p_Callback;
+
+				void Finish(bool success) {
+					if (success) {
+						p_Callback((const unsigned char*)wgpuBufferGetConstMappedRange(p_Buffer, 0, p_Size));
+						wgpuBufferUnmap(p_Buffer);
+					} else {
+						p_Callback(nullptr);
+					}
+					delete this;
+				}
+			};
+			MapInfo* info = new MapInfo{ (WGPUBuffer)handle, size_bytes, std::move(callback) };
 #ifdef __EMSCRIPTEN__
-	std::optional<WGPUBufferMapAsyncStatus> status;
-	wgpuBufferMapAsync(copy_buffer, WGPUMapMode_Read, 0, size, [](WGPUBufferMapAsyncStatus status, void* user_data) {
-		auto info = (std::optional<WGPUBufferMapAsyncStatus>*)user_data;
-		*info = status;
-	}, &status);
+			wgpuBufferMapAsync(info->p_Buffer, WGPUMapMode_Read, 0, size_bytes, [](WGPUBufferMapAsyncStatus status, void* userdata) {
+				((MapInfo*)userdata)->Finish(status == WGPUBufferMapAsyncStatus_Success);
+			}, info);
 #else
-	std::optional<WGPUMapAsyncStatus> status;
-	WGPUBufferMapCallbackInfo callback_info = {
-		nullptr, DEFAULT_CALLBACK_MODE,
-		[] (WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void* userdata2) {
-			auto info = (std::optional<WGPUMapAsyncStatus>*)userdata1;
-			*info = status;
-		}, &status, nullptr
-	};
-
-	// since you are copying from a temp buffer that already took the offset into account, offset must be set to zero
-	wgpuBufferMapAsync(copy_buffer, WGPUMapMode_Read, 0, size, std::move(callback_info));
+			WGPUBufferMapCallbackInfo callback_info = {
+				nullptr, DEFAULT_CALLBACK_MODE,
+				[](WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void* userdata2) {
+					((MapInfo*)userdata1)->Finish(status == WGPUMapAsyncStatus_Success);
+				}, info, nullptr
+			};
+			wgpuBufferMapAsync(info->p_Buffer, WGPUMapMode_Read, 0, size_bytes, std::move(callback_info));
 #endif
+		}
+	});
+	return pool;
+}
 
-	Core::WaitForCommandsToFinish();
-
-	auto buffer_data = wgpuBufferGetConstMappedRange(copy_buffer, 0, size);
-	memcpy(buffer, buffer_data, size);
-	wgpuBufferUnmap(copy_buffer);
-
-	wgpuBufferDestroy(copy_buffer);
+////////////////////////////////////////////////////////////////////////////////
+void WebGPUBuffer::ReadSync(unsigned char* buffer, int offset, int size) {
+	size = size >= 0 ? size : m_Size - offset;
+	if (size <= 0) {
+		return;
+	}
+	DebugTiming debug_func("WebGPUBuffer::ReadSync");
+	// goes through the pool like any other read, so it also completes whatever small reads were waiting to share its mapping
+	Read<void>(offset, size, [buffer](unsigned char* data, int size, AsyncToken<void> token) -> std::shared_ptr<void> {
+		memcpy(buffer, data, size);
+		return nullptr;
+	}).Wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -360,6 +379,20 @@ void WebGPURenderBuffer::Init(std::vector<WGPUVertexFormat> attributes, WGPUPrim
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void WebGPURenderBuffer::UpdateVertices(unsigned char* vertex_data, int offset_bytes, int size_bytes, int total_vertices) {
+
+	int vertex_bytes = 0;
+	for (const auto& attr : m_Attributes) {
+		vertex_bytes += attr.p_Size;
+	}
+	m_VertexBuffer->EnsureSizeBytes(std::max(total_vertices * vertex_bytes, offset_bytes + size_bytes), false);
+	if (vertex_data && (size_bytes > 0)) {
+		m_VertexBuffer->Write(vertex_data, offset_bytes, size_bytes);
+	}
+	m_NumVertices = total_vertices;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 WebGPURenderBuffer::~WebGPURenderBuffer(void) {
 	delete m_VertexBuffer;
@@ -726,6 +759,7 @@ void WebGPUPipeline::Reset(void) {
 	m_Type = Type::UNKNOWN;
 
 	m_RenderBuffer = nullptr;
+	m_Shader = nullptr;
 	m_Buffers.clear();
 	m_Textures.clear();
 	m_Samplers.clear();
@@ -815,7 +849,8 @@ void WebGPUPipeline::FinalizeRender(std::string_view shader_name, WebGPURenderBu
 	m_RenderBuffer = &render_buffer;
 	m_MSAASamples = msaa_samples;
 
-	WGPUShaderModule shader = Core::GetShader(shader_name, insertion, end_insertion)->Get();
+	m_Shader = Core::GetShader(shader_name, insertion, end_insertion);
+	WGPUShaderModule shader = m_Shader->Get();
 	if (shader == nullptr) {
 		throw std::logic_error("Cannot find shader");
 	}
@@ -940,7 +975,8 @@ void WebGPUPipeline::FinalizeCompute(std::string_view shader_name, std::string_v
 	m_RenderBuffer = nullptr;
 
 	CreateBindGroupLayout();
-	WGPUShaderModule shader = Core::GetShader(shader_name, insertion, end_insertion)->Get();
+	m_Shader = Core::GetShader(shader_name, insertion, end_insertion);
+	WGPUShaderModule shader = m_Shader->Get();
 	if (!shader) {
 		throw std::logic_error("Could not load shader");
 	}
@@ -69,6 +69,8 @@ public:
 		AsyncToken(const AsyncToken& other): m_Internals(other.m_Internals) {}
 		bool operator==(const AsyncToken& other) const { return other.m_Internals.get() == m_Internals.get(); }
 		AsyncToken& Wait() {
+			// pooled reads are only mapped once flushed
+			WebGPUBuffer::GetStagingPool().Flush();
 			while (!m_Internals->m_Finished) {
 #ifndef __EMSCRIPTEN__
 				wgpuDeviceTick(GlobalWebGPUDevice());
@@ -159,28 +161,29 @@ public:
 		return std::move(token);
 	}
 
+	// copies into a pooled staging buffer, small reads share one mapping with the other reads made before the next flush
 	template<typename T>
 	AsyncToken<T>									Read					( int offset, int size, std::function<std::shared_ptr<T>(unsigned char* data, int size, AsyncToken<T> token)>&& callback ) {
 		if ((offset + size) > m_Size) {
 			throw std::invalid_argument("Attempt to read past end of buffer");
 		}
 
-		WGPUBufferDescriptor desc = {};
-		desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
-		desc.size = size;
-		desc.nextInChain = nullptr;
-#ifdef __EMSCRIPTEN__
-		desc.label = nullptr;
-#else
-		desc.label = WGPUStringView{ nullptr, 0 };
-#endif
-		desc.mappedAtCreation = false;
-		WGPUBuffer copy_buffer = wgpuDeviceCreateBuffer(GlobalWebGPUDevice(), &desc);
-		CopyBufferToBuffer(m_Buffer, copy_buffer, offset, 0, size);
-
-		return ReadFrom(copy_buffer, offset, size, std::move(callback));
+		AsyncToken<T> token;
+		auto target = GetStagingPool().Read(size, [token, callback = std::move(callback)](const unsigned char* data, int size) {
+			if (data) {
+				token.m_Internals->m_Payload = callback((unsigned char*)data, size, token);
+			} else {
+				token.m_Internals->m_Error = true;
+			}
+			token.m_Internals->m_Finished = true;
+		});
+		CopyBufferToBuffer(m_Buffer, (WGPUBuffer)target.p_Handle, offset, target.p_Offset, size);
+		return token;
 	}
 
+	// shared by every buffer, flushed and advanced once a frame by Core
+	static StagingPool&								GetStagingPool			( void );
+
 	void											Write					( unsigned char* buffer, int offset, int size );
 	std::shared_ptr<unsigned char[]>				MakeCopy				( int max_size = -1 );
 
@@ -251,6 +254,8 @@ public:
 
 	void											Init					( WGPUVertexFormat attribute, WGPUPrimitiveTopology topology, unsigned char* vertex_data, int vertex_data_size, std::vector<uint32_t> index_data = {} ) { Init(std::vector<WGPUVertexFormat>{ attribute }, topology, vertex_data, vertex_data_size, index_data); }
 	void											Init					( std::vector<WGPUVertexFormat> attributes, WGPUPrimitiveTopology topology, unsigned char* vertex_data, int vertex_data_size, std::vector<uint32_t> index_data = {} );
+	// writes a sub-range of vertices in place, growing the buffer if needed, without recreating it like Init does
+	void											UpdateVertices			( unsigned char* vertex_data, int offset_bytes, int size_bytes, int total_vertices );
 
 			 										~WebGPURenderBuffer		( void );
 
@@ -530,6 +535,7 @@ public:
 	inline WGPURenderPipeline	GetRenderPipeline		( void ) { return m_RenderPipeline; }
 	inline WGPUBindGroup		GetBindGroup			( void ) { return m_BindGroup; }
 	inline int					GetMSAASamples			( void ) { return m_MSAASamples; }
+	inline const WebGPUShader*	GetShader				( void ) const { return m_Shader; }
 
 protected:
 
@@ -543,6 +549,7 @@ protected:
 	
 	std::vector<const WebGPUSampler*>	m_Samplers;
 	int									m_MSAASamples = 0;
+	const WebGPUShader*					m_Shader = nullptr; // only used to identify pipelines that need rebuilding on hot reload
 
 	WGPURenderPipeline			m_RenderPipeline = nullptr;
 	WGPUComputePipeline			m_ComputePipeline = nullptr;